@@ -0,0 +1,401 @@
+#!/usr/bin/env python3
+"""
+ThousChannel binary log decoder
+把 Logger::setBinaryLogFile 写出的二进制日志还原成文本日志，格式见 src/core/BinaryLog.h
+也能读 Logger::setLogCompression 写出的 .lz4 日志（文本或二进制），格式见 CompressedLogSink
+"""
+
+import sys
+import struct
+import argparse
+from datetime import datetime
+
+MAGIC = b"TCBLOG1\0"
+FORMAT_RECORD = 1
+EVENT_RECORD = 2
+
+ARG_INT = 1
+ARG_UINT = 2
+ARG_DOUBLE = 3
+ARG_STRING = 4
+ARG_BOOL = 5
+ARG_POINTER = 6
+
+LEVELS = ["TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"]
+CATEGORIES = ["general", "rte", "ui", "token", "layout"]
+
+LZ4_FRAME_MAGIC = 0x184D2204
+LZ4_SKIPPABLE_MAGIC = 0x184D2A50
+# CompressedLogSink::FrameIndex: firstUs, lastUs, rawBytes, frameBytes
+FRAME_INDEX = struct.Struct("<qqII")
+TEXT_TIME_FORMAT = "%Y-%m-%d %H:%M:%S.%f"
+
+
+class DecodeError(Exception):
+    pass
+
+
+class Reader:
+    """按字节读取记录"""
+
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def at_end(self):
+        return self.pos >= len(self.data)
+
+    def byte(self):
+        if self.pos >= len(self.data):
+            raise DecodeError("truncated record")
+        value = self.data[self.pos]
+        self.pos += 1
+        return value
+
+    def bytes(self, size):
+        if self.pos + size > len(self.data):
+            raise DecodeError("truncated record")
+        value = self.data[self.pos:self.pos + size]
+        self.pos += size
+        return value
+
+    def varint(self):
+        value = 0
+        shift = 0
+        while True:
+            b = self.byte()
+            value |= (b & 0x7F) << shift
+            if b < 0x80:
+                return value
+            shift += 7
+
+    def signed(self):
+        value = self.varint()
+        return (value >> 1) ^ -(value & 1)
+
+    def fixed64(self):
+        return struct.unpack("<Q", self.bytes(8))[0]
+
+    def text(self):
+        return self.bytes(self.varint()).decode("utf-8", errors="replace")
+
+
+def read_arg(reader):
+    """返回 (显示文本, 原始值)"""
+    kind = reader.byte()
+    if kind == ARG_INT:
+        value = reader.signed()
+        return str(value), value
+    if kind == ARG_UINT:
+        value = reader.varint()
+        return str(value), value
+    if kind == ARG_DOUBLE:
+        value = struct.unpack("<d", reader.bytes(8))[0]
+        return format(value, ".6g"), value
+    if kind == ARG_STRING:
+        value = reader.text()
+        return value, value
+    if kind == ARG_BOOL:
+        # 与 std::ostream 一致，输出 1/0
+        value = reader.byte() != 0
+        return ("1" if value else "0"), value
+    if kind == ARG_POINTER:
+        value = reader.varint()
+        return "0x%016X" % value, value
+    raise DecodeError("unknown argument type %d" % kind)
+
+
+def render(fmt, args):
+    """与 StringFormat::format 一致：依次替换 {}，多余参数忽略"""
+    result = fmt
+    pos = 0
+    for arg in args:
+        index = result.find("{}", pos)
+        if index < 0:
+            break
+        result = result[:index] + arg + result[index + 2:]
+        pos = index + len(arg)
+    return result
+
+
+def decode(data):
+    """逐条产出事件 dict：time, thread, level, category, file, line, message, values"""
+    reader = Reader(data)
+    formats = {}
+    wall_us = 0
+    steady_us = 0
+    last_us = 0
+    while not reader.at_end():
+        if data[reader.pos] == 0:
+            # 未正常关闭的分段，后面是预分配的零
+            break
+        if data.startswith(MAGIC, reader.pos):
+            # 每次会话重新写头部和格式表
+            reader.bytes(len(MAGIC))
+            wall_us = reader.fixed64()
+            steady_us = reader.fixed64()
+            last_us = steady_us
+            formats = {}
+            continue
+
+        kind = reader.byte()
+        if kind == FORMAT_RECORD:
+            format_id = reader.varint()
+            level = reader.byte()
+            category = reader.byte()
+            line = reader.varint()
+            file = reader.text()
+            fmt = reader.text()
+            formats[format_id] = (level, category, file, line, fmt)
+        elif kind == EVENT_RECORD:
+            last_us += reader.signed()
+            thread = reader.varint()
+            format_id = reader.varint()
+            count = reader.varint()
+            args = [read_arg(reader) for _ in range(count)]
+            if format_id not in formats:
+                raise DecodeError("event refers to unknown format %d" % format_id)
+            level, category, file, line, fmt = formats[format_id]
+            yield {
+                "time": (wall_us + last_us - steady_us) / 1e6,
+                "thread": thread,
+                "level": level,
+                "category": category,
+                "file": file,
+                "line": line,
+                "message": render(fmt, [text for text, _ in args]),
+                "values": [value for _, value in args],
+            }
+        else:
+            raise DecodeError("unknown record type %d at offset %d" % (kind, reader.pos - 1))
+
+
+def lz4_block(data, pos, end):
+    """解压一个 LZ4 块 data[pos:end]"""
+    out = bytearray()
+    while pos < end:
+        token = data[pos]
+        pos += 1
+        length = token >> 4
+        if length == 15:
+            while True:
+                b = data[pos]
+                pos += 1
+                length += b
+                if b != 255:
+                    break
+        out += data[pos:pos + length]
+        pos += length
+        if pos >= end:
+            break
+        offset = data[pos] | (data[pos + 1] << 8)
+        pos += 2
+        if offset == 0 or offset > len(out):
+            raise DecodeError("bad lz4 match offset")
+        length = token & 15
+        if length == 15:
+            while True:
+                b = data[pos]
+                pos += 1
+                length += b
+                if b != 255:
+                    break
+        length += 4
+        start = len(out) - offset
+        if length <= offset:
+            out += out[start:start + length]
+        else:
+            # 重叠的匹配按字节复制
+            for i in range(length):
+                out.append(out[start + i])
+    return bytes(out)
+
+
+def lz4_frame(data, pos):
+    """解压从 pos 开始的 LZ4 帧，返回 (内容, 帧结束位置)"""
+    flags = data[pos + 4]
+    if flags >> 6 != 1:
+        raise DecodeError("unsupported lz4 frame version")
+    pos += 7 + (8 if flags & 0x08 else 0) + (4 if flags & 0x01 else 0)
+    out = []
+    while True:
+        if pos + 4 > len(data):
+            raise DecodeError("truncated lz4 frame")
+        size = struct.unpack_from("<I", data, pos)[0]
+        pos += 4
+        if size == 0:
+            break
+        end = pos + (size & 0x7FFFFFFF)
+        if end > len(data):
+            raise DecodeError("truncated lz4 frame")
+        out.append(data[pos:end] if size & 0x80000000 else lz4_block(data, pos, end))
+        pos = end + (4 if flags & 0x10 else 0)
+    if flags & 0x04:
+        pos += 4
+    return b"".join(out), pos
+
+
+def lz4_frames(data):
+    """逐帧产出 (索引, 帧位置)；索引为 (firstUs, lastUs, rawBytes, frameBytes)，没有索引时为 None"""
+    pos = 0
+    index = None
+    while pos + 8 <= len(data):
+        magic, size = struct.unpack_from("<II", data, pos)
+        if magic & 0xFFFFFFF0 == LZ4_SKIPPABLE_MAGIC:
+            if magic == LZ4_SKIPPABLE_MAGIC and size == FRAME_INDEX.size:
+                index = FRAME_INDEX.unpack_from(data, pos + 8)
+            pos += 8 + size
+        elif magic == LZ4_FRAME_MAGIC:
+            yield index, pos
+            if index is None or index[3] == 0:
+                _, pos = lz4_frame(data, pos)
+            else:
+                pos += index[3]
+            index = None
+        else:
+            raise DecodeError("not an lz4 frame at offset %d" % pos)
+
+
+def read_lz4(data, since, until, binary):
+    """解压时间范围内的帧；二进制日志的格式表可能在更早的帧里，只能跳过 until 之后的帧"""
+    out = []
+    for index, pos in lz4_frames(data):
+        if index is not None:
+            # 行的时间戳略早于写入时间，留一秒余量
+            if until is not None and index[0] / 1e6 >= until + 1:
+                break
+            if not binary and since is not None and index[1] / 1e6 < since:
+                continue
+        out.append(lz4_frame(data, pos)[0])
+    return b"".join(out)
+
+
+def is_lz4(data):
+    return len(data) >= 4 and struct.unpack_from("<I", data)[0] in (LZ4_FRAME_MAGIC, LZ4_SKIPPABLE_MAGIC)
+
+
+def first_frame(data):
+    """第一帧的内容，用于判断是文本日志还是二进制日志"""
+    for _, pos in lz4_frames(data):
+        return lz4_frame(data, pos)[0]
+    return b""
+
+
+def text_lines(data, since, until):
+    """文本日志按行首的时间戳筛选，没有时间戳的行跟随上一行"""
+    keep = since is None and until is None
+    for line in data.decode("utf-8", errors="replace").lstrip("\ufeff").splitlines():
+        if line.startswith("[") and (since is not None or until is not None):
+            try:
+                stamp = datetime.strptime(line[1:24], TEXT_TIME_FORMAT).timestamp()
+                keep = (since is None or stamp >= since) and (until is None or stamp < until)
+            except ValueError:
+                pass
+        if keep:
+            yield line
+
+
+def load(path, since=None, until=None):
+    """返回 (是否文本日志, 内容)"""
+    with open(path, "rb") as f:
+        data = f.read()
+    if not is_lz4(data):
+        return False, data
+    binary = first_frame(data).startswith(MAGIC)
+    return not binary, read_lz4(data, since, until, binary)
+
+
+def decode_files(paths, since=None, until=None):
+    """每个分段自带头部和格式表，依次解码；.lz4 文本日志跳过"""
+    for path in paths:
+        text, data = load(path, since, until)
+        if text:
+            continue
+        for event in decode(data):
+            yield event
+
+
+def list_frames(paths):
+    for path in paths:
+        with open(path, "rb") as f:
+            data = f.read()
+        print(path)
+        for index, pos in lz4_frames(data):
+            if index is None:
+                print("  @%d (no index)" % pos)
+                continue
+            print("  @%d %s .. %s raw %d lz4 %d" % (
+                pos, datetime.fromtimestamp(index[0] / 1e6), datetime.fromtimestamp(index[1] / 1e6),
+                index[2], index[3]))
+
+
+def format_event(event, show_thread):
+    """输出与文本日志相同的行格式"""
+    stamp = datetime.fromtimestamp(event["time"])
+    text = "[%s.%03d] [ThousChannel] [%s] " % (
+        stamp.strftime("%Y-%m-%d %H:%M:%S"), stamp.microsecond // 1000, LEVELS[event["level"]])
+    if event["category"] != 0:
+        text += "[%s] " % CATEGORIES[event["category"]]
+    if show_thread:
+        text += "[%d] " % event["thread"]
+    return text + event["message"]
+
+
+def parse_time(text):
+    try:
+        return datetime.fromisoformat(text).timestamp()
+    except ValueError:
+        raise argparse.ArgumentTypeError("expected a time like 2024-05-01 12:30:00")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode a ThousChannel binary log to text")
+    parser.add_argument("files", nargs="+",
+                        help="binary log or its segments, in order (e.g. logs/ThousChannel.*.tclog); "
+                             ".lz4 text logs are printed with --since/--until applied")
+    parser.add_argument("--level", choices=[name.lower() for name in LEVELS],
+                        help="lowest level shown")
+    parser.add_argument("--category", choices=CATEGORIES, action="append",
+                        help="only these categories (repeatable)")
+    parser.add_argument("--since", type=parse_time, help="local time, e.g. '2024-05-01 12:30:00'")
+    parser.add_argument("--until", type=parse_time, help="local time, exclusive")
+    parser.add_argument("--user", help="only events with this user id among their arguments")
+    parser.add_argument("--threads", action="store_true", help="show the thread id of each event")
+    parser.add_argument("--frames", action="store_true", help="list the frames of .lz4 logs and their times")
+    args = parser.parse_args()
+
+    if args.frames:
+        list_frames(args.files)
+        return 0
+
+    min_level = LEVELS.index(args.level.upper()) if args.level else 0
+    categories = set(CATEGORIES.index(name) for name in args.category) if args.category else None
+
+    try:
+        for path in args.files:
+            text, data = load(path, args.since, args.until)
+            if text:
+                for line in text_lines(data, args.since, args.until):
+                    print(line)
+                continue
+            for event in decode(data):
+                if event["level"] < min_level:
+                    continue
+                if categories is not None and event["category"] not in categories:
+                    continue
+                if args.since is not None and event["time"] < args.since:
+                    continue
+                if args.until is not None and event["time"] >= args.until:
+                    continue
+                if args.user is not None and not any(str(value) == args.user for value in event["values"]):
+                    continue
+                print(format_event(event, args.threads))
+    except DecodeError as e:
+        # 崩溃时最后一条记录可能不完整
+        print("decode stopped: %s" % e, file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
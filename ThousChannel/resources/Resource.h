@@ -79,9 +79,7 @@
 #define ID_VIEW_APPLOOK_OFF_2007_SILVER	217
 #define ID_VIEW_APPLOOK_OFF_2007_AQUA	218
 #define ID_VIEW_APPLOOK_WINDOWS_7	219
-#define IDS_BUILD_TAB				300
-#define IDS_DEBUG_TAB				301
-#define IDS_FIND_TAB				302
+#define IDS_LOG_TAB				300
 #define IDS_EXPLORER				305
 #define IDS_EDIT_MENU				306
 
@@ -111,6 +109,8 @@
 #define IDC_BTN_PREV_PAGE           1025
 #define IDC_BTN_NEXT_PAGE           1026
 #define IDC_STATIC_CURRENT_PAGE     1027
+#define IDC_SCROLL_VIDEO_WALL       1028
+#define IDC_OVERVIEW_MOSAIC         1029
 
 // 视频窗格控件ID范围 (1050-1150)
 #define IDC_VIDEO_WINDOW_BASE       1050
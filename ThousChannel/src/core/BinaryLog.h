@@ -0,0 +1,190 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Record layout of the binary log (see Logger::setBinaryLogFile and
+// decode_log.py). All integers are LEB128 varints, signed ones zigzag encoded.
+//
+//   file    := magic header record*
+//   header  := wallClockUs steadyUs               (both fixed 8 bytes, little endian)
+//   record  := kFormatRecord id level category line file format
+//            | kEventRecord  deltaUs threadId formatId argCount arg*
+//   arg     := type payload
+//
+// A format record is written once per call site, before its first event, and
+// again at the top of every new file. deltaUs is the signed distance to the
+// previous event's steady timestamp, or to steadyUs for the first one.
+namespace BinaryLog {
+
+constexpr char kMagic[8] = { 'T', 'C', 'B', 'L', 'O', 'G', '1', '\0' };
+
+enum RecordType : uint8_t {
+    kFormatRecord = 1,
+    kEventRecord = 2
+};
+
+enum ArgType : uint8_t {
+    kArgInt = 1,            // zigzag varint
+    kArgUInt = 2,           // varint
+    kArgDouble = 3,         // 8 bytes
+    kArgString = 4,         // varint length, bytes
+    kArgBool = 5,           // 1 byte
+    kArgPointer = 6         // varint
+};
+
+inline void AppendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+inline void AppendSigned(std::string& out, int64_t value) {
+    AppendVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+inline void AppendFixed64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>(value >> (i * 8)));
+    }
+}
+
+inline void AppendBytes(std::string& out, std::string_view bytes) {
+    AppendVarint(out, bytes.size());
+    out.append(bytes.data(), bytes.size());
+}
+
+// One argument with its type tag. Types the decoder does not know are
+// rendered to text here, as the text logger would.
+template<typename T>
+void AppendArg(std::string& out, const T& value) {
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, bool>) {
+        out.push_back(static_cast<char>(kArgBool));
+        out.push_back(value ? 1 : 0);
+    } else if constexpr (std::is_same_v<U, char>) {
+        out.push_back(static_cast<char>(kArgString));
+        AppendBytes(out, std::string_view(&value, 1));
+    } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+        out.push_back(static_cast<char>(kArgInt));
+        AppendSigned(out, static_cast<int64_t>(value));
+    } else if constexpr (std::is_integral_v<U> || std::is_enum_v<U>) {
+        out.push_back(static_cast<char>(kArgUInt));
+        AppendVarint(out, static_cast<uint64_t>(value));
+    } else if constexpr (std::is_floating_point_v<U>) {
+        double number = static_cast<double>(value);
+        uint64_t bits;
+        memcpy(&bits, &number, sizeof(bits));
+        out.push_back(static_cast<char>(kArgDouble));
+        AppendFixed64(out, bits);
+    } else if constexpr (std::is_convertible_v<const U&, std::string_view>) {
+        out.push_back(static_cast<char>(kArgString));
+        AppendBytes(out, std::string_view(value));
+    } else if constexpr (std::is_pointer_v<U>) {
+        out.push_back(static_cast<char>(kArgPointer));
+        AppendVarint(out, reinterpret_cast<uintptr_t>(value));
+    } else {
+        std::ostringstream text;
+        text << value;
+        out.push_back(static_cast<char>(kArgString));
+        AppendBytes(out, text.str());
+    }
+}
+
+inline void AppendArgs(std::string&) {
+}
+
+template<typename T, typename... Rest>
+void AppendArgs(std::string& out, const T& value, const Rest&... rest) {
+    AppendArg(out, value);
+    AppendArgs(out, rest...);
+}
+
+// Reading back, for a consumer inside the process (LogStore). Each returns
+// false when the bytes run out.
+inline bool ReadVarint(std::string_view& in, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && !in.empty(); shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(in.front());
+        in.remove_prefix(1);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (byte < 0x80) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Text of one encoded argument as the text logger writes it
+inline bool ReadArgText(std::string_view& in, std::string& text) {
+    if (in.empty()) {
+        return false;
+    }
+    uint8_t type = static_cast<uint8_t>(in.front());
+    in.remove_prefix(1);
+    uint64_t value = 0;
+    char number[32];
+    switch (type) {
+        case kArgInt:
+            if (!ReadVarint(in, value)) return false;
+            text = std::to_string(static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1));
+            return true;
+        case kArgUInt:
+            if (!ReadVarint(in, value)) return false;
+            text = std::to_string(value);
+            return true;
+        case kArgDouble: {
+            if (in.size() < 8) return false;
+            for (int i = 0; i < 8; ++i) {
+                value |= static_cast<uint64_t>(static_cast<uint8_t>(in[i])) << (i * 8);
+            }
+            in.remove_prefix(8);
+            double number64;
+            memcpy(&number64, &value, sizeof(number64));
+            snprintf(number, sizeof(number), "%g", number64);
+            text = number;
+            return true;
+        }
+        case kArgString:
+            if (!ReadVarint(in, value) || value > in.size()) return false;
+            text.assign(in.data(), static_cast<size_t>(value));
+            in.remove_prefix(static_cast<size_t>(value));
+            return true;
+        case kArgBool:
+            if (in.empty()) return false;
+            text.assign(1, in.front() ? '1' : '0');
+            in.remove_prefix(1);
+            return true;
+        case kArgPointer:
+            if (!ReadVarint(in, value)) return false;
+            snprintf(number, sizeof(number), "0x%016llX", static_cast<unsigned long long>(value));
+            text = number;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// `format` with its {} replaced by the encoded arguments, like decode_log.py
+inline void Render(std::string& out, std::string_view format, std::string_view args, size_t argCount) {
+    out.assign(format.data(), format.size());
+    std::string text;
+    size_t pos = 0;
+    for (size_t i = 0; i < argCount && ReadArgText(args, text); ++i) {
+        size_t index = out.find("{}", pos);
+        if (index == std::string::npos) {
+            break;
+        }
+        out.replace(index, 2, text);
+        pos = index + text.size();
+    }
+}
+
+} // namespace BinaryLog
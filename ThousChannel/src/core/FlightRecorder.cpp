@@ -0,0 +1,367 @@
+#include "pch.h"
+#include "FlightRecorder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+FlightRecorder::Ring FlightRecorder::s_rings[FlightRecorder::kMaxThreads];
+
+namespace {
+
+const int kRingMask = FlightRecorder::kEventsPerThread - 1;
+static_assert((FlightRecorder::kEventsPerThread & kRingMask) == 0, "ring size must be a power of two");
+
+// The first crash handler to run dumps; the ones it chains into do not
+std::atomic<bool> s_crashDumped(false);
+std::terminate_handler s_previousTerminate = nullptr;
+#ifdef _WIN32
+LPTOP_LEVEL_EXCEPTION_FILTER s_previousFilter = nullptr;
+#endif
+
+int64_t SteadyNowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t SteadyNowMs() {
+    return SteadyNowUs() / 1000;
+}
+
+uint32_t CurrentThreadId() {
+#ifdef _WIN32
+    return GetCurrentThreadId();
+#else
+    return static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+#endif
+}
+
+const char* KindName(FlightEventKind kind) {
+    switch (kind) {
+        case FlightEventKind::SdkCallback: return "sdk";
+        case FlightEventKind::TaskStart: return "task-start";
+        case FlightEventKind::TaskEnd: return "task-end";
+        case FlightEventKind::UiMessage: return "ui";
+        case FlightEventKind::Watchdog: return "watchdog";
+        case FlightEventKind::Crash: return "crash";
+        default: return "?";
+    }
+}
+
+// Raw file handle: usable from a crash handler, no CRT buffering
+class DumpFile {
+public:
+    explicit DumpFile(const char* path) {
+#ifdef _WIN32
+        m_handle = CreateFileA(path, GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+#else
+        m_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    }
+
+    ~DumpFile() {
+#ifdef _WIN32
+        if (m_handle != INVALID_HANDLE_VALUE) {
+            FlushFileBuffers(m_handle);
+            CloseHandle(m_handle);
+        }
+#else
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
+#endif
+    }
+
+    bool IsOpen() const {
+#ifdef _WIN32
+        return m_handle != INVALID_HANDLE_VALUE;
+#else
+        return m_fd >= 0;
+#endif
+    }
+
+    void Write(const char* data, int size) {
+        if (size <= 0) {
+            return;
+        }
+#ifdef _WIN32
+        DWORD written = 0;
+        WriteFile(m_handle, data, static_cast<DWORD>(size), &written, nullptr);
+#else
+        while (size > 0) {
+            ssize_t written = write(m_fd, data, static_cast<size_t>(size));
+            if (written <= 0) {
+                return;
+            }
+            data += written;
+            size -= static_cast<int>(written);
+        }
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE m_handle;
+#else
+    int m_fd;
+#endif
+};
+
+#ifdef _WIN32
+LONG WINAPI OnUnhandledException(EXCEPTION_POINTERS* info) {
+    if (!s_crashDumped.exchange(true)) {
+        FlightRecorder::Record(FlightEventKind::Crash, "unhandled exception",
+            static_cast<int64_t>(info->ExceptionRecord->ExceptionCode),
+            static_cast<int64_t>(reinterpret_cast<uintptr_t>(info->ExceptionRecord->ExceptionAddress)));
+        FlightRecorder::Instance().Dump("crash");
+    }
+    return s_previousFilter ? s_previousFilter(info) : EXCEPTION_CONTINUE_SEARCH;
+}
+#else
+void OnFatalSignal(int signal) {
+    if (!s_crashDumped.exchange(true)) {
+        FlightRecorder::Record(FlightEventKind::Crash, "signal", signal);
+        FlightRecorder::Instance().Dump("crash");
+    }
+    // Installed with SA_RESETHAND: the default action runs now
+    raise(signal);
+}
+#endif
+
+void OnTerminate() {
+    if (!s_crashDumped.exchange(true)) {
+        FlightRecorder::Record(FlightEventKind::Crash, "std::terminate");
+        FlightRecorder::Instance().Dump("terminate");
+    }
+    if (s_previousTerminate) {
+        s_previousTerminate();
+    }
+    std::abort();
+}
+
+} // namespace
+
+// Gives the thread's ring back when the thread exits
+struct FlightRingOwner {
+    FlightRecorder::Ring* ring = nullptr;
+    bool claimed = false;
+
+    ~FlightRingOwner() {
+        if (ring) {
+            FlightRecorder::ReleaseRing(ring);
+        }
+    }
+};
+
+static thread_local FlightRingOwner t_ringOwner;
+
+FlightRecorder::FlightRecorder()
+    : m_dumpCount(0), m_dumping(false), m_lastBeatMs(0), m_watchdogStopping(false) {
+    snprintf(m_directory, sizeof(m_directory), "logs");
+}
+
+FlightRecorder::~FlightRecorder() {
+    StopWatchdog();
+}
+
+FlightRecorder& FlightRecorder::Instance() {
+    static FlightRecorder instance;
+    return instance;
+}
+
+void FlightRecorder::Record(FlightEventKind kind, const char* name, int64_t a, int64_t b) {
+    FlightRingOwner& owner = t_ringOwner;
+    if (!owner.claimed) {
+        owner.claimed = true;
+        owner.ring = ClaimRing();
+    }
+    Ring* ring = owner.ring;
+    if (!ring) {
+        return;
+    }
+
+    // Only this thread writes the ring; the release store publishes the slot to Dump
+    uint64_t seq = ring->next.load(std::memory_order_relaxed);
+    FlightEvent& event = ring->events[seq & kRingMask];
+    event.timeUs = SteadyNowUs();
+    event.threadId = CurrentThreadId();
+    event.kind = kind;
+    event.name = name;
+    event.a = a;
+    event.b = b;
+    ring->next.store(seq + 1, std::memory_order_release);
+}
+
+// Unused rings first, so an exited thread's events survive as long as possible
+FlightRecorder::Ring* FlightRecorder::ClaimRing() {
+    for (int pass = 0; pass < 2; ++pass) {
+        for (Ring& ring : s_rings) {
+            if (pass == 0 && ring.next.load(std::memory_order_relaxed) != 0) {
+                continue;
+            }
+            int expected = 0;
+            if (ring.owned.load(std::memory_order_relaxed) == 0 &&
+                ring.owned.compare_exchange_strong(expected, 1, std::memory_order_acquire)) {
+                return &ring;
+            }
+        }
+    }
+    return nullptr;
+}
+
+// The events stay: a dump still shows what an exited thread did last
+void FlightRecorder::ReleaseRing(Ring* ring) {
+    ring->owned.store(0, std::memory_order_release);
+}
+
+void FlightRecorder::SetDumpDirectory(const std::string& directory) {
+    snprintf(m_directory, sizeof(m_directory), "%s", directory.c_str());
+}
+
+bool FlightRecorder::Dump(const char* reason) {
+    // A crash while dumping must not dump again
+    if (m_dumping.exchange(true, std::memory_order_acquire)) {
+        return false;
+    }
+
+    long long wallSeconds = static_cast<long long>(std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    int dumpIndex = m_dumpCount.fetch_add(1, std::memory_order_relaxed) + 1;
+    char path[400];
+    snprintf(path, sizeof(path), "%s/flight_%lld_%d_%s.txt", m_directory, wallSeconds, dumpIndex, reason);
+
+    DumpFile file(path);
+    if (!file.IsOpen()) {
+        m_dumping.store(false, std::memory_order_release);
+        return false;
+    }
+
+    // Snapshot every ring's window. The slot being overwritten right now is
+    // the oldest one of a full ring, so that one is left out.
+    uint64_t cursor[kMaxThreads];
+    uint64_t end[kMaxThreads];
+    uint64_t total = 0;
+    for (int i = 0; i < kMaxThreads; ++i) {
+        end[i] = s_rings[i].next.load(std::memory_order_acquire);
+        cursor[i] = end[i] >= static_cast<uint64_t>(kEventsPerThread) ? end[i] - kEventsPerThread + 1 : 0;
+        total += end[i] - cursor[i];
+    }
+
+    int64_t nowUs = SteadyNowUs();
+    char line[256];
+    int length = snprintf(line, sizeof(line), "ThousChannel flight recorder: %s, unix time %lld, %llu events\n"
+        "age(s)      thread  kind        name / values\n", reason, wallSeconds, static_cast<unsigned long long>(total));
+    file.Write(line, length);
+
+    // Each ring is in time order; merge them oldest first
+    while (true) {
+        int next = -1;
+        int64_t nextTimeUs = 0;
+        for (int i = 0; i < kMaxThreads; ++i) {
+            if (cursor[i] == end[i]) {
+                continue;
+            }
+            int64_t timeUs = s_rings[i].events[cursor[i] & kRingMask].timeUs;
+            if (next < 0 || timeUs < nextTimeUs) {
+                next = i;
+                nextTimeUs = timeUs;
+            }
+        }
+        if (next < 0) {
+            break;
+        }
+
+        FlightEvent event = s_rings[next].events[cursor[next] & kRingMask];
+        ++cursor[next];
+        int64_t ageUs = (std::max)(nowUs - event.timeUs, int64_t(0));
+        length = snprintf(line, sizeof(line), "-%3lld.%06lld  %6u  %-10s  %s %lld %lld\n",
+            static_cast<long long>(ageUs / 1000000), static_cast<long long>(ageUs % 1000000),
+            event.threadId, KindName(event.kind), event.name ? event.name : "-",
+            static_cast<long long>(event.a), static_cast<long long>(event.b));
+        file.Write(line, length < static_cast<int>(sizeof(line)) ? length : static_cast<int>(sizeof(line)) - 1);
+    }
+
+    m_dumping.store(false, std::memory_order_release);
+    return true;
+}
+
+void FlightRecorder::InstallCrashHandlers() {
+#ifdef _WIN32
+    s_previousFilter = SetUnhandledExceptionFilter(OnUnhandledException);
+#else
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = OnFatalSignal;
+    action.sa_flags = SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+    const int signals[] = { SIGSEGV, SIGABRT, SIGBUS, SIGFPE, SIGILL };
+    for (int signal : signals) {
+        sigaction(signal, &action, nullptr);
+    }
+#endif
+    s_previousTerminate = std::set_terminate(OnTerminate);
+}
+
+void FlightRecorder::StartWatchdog(int timeoutMs) {
+    std::lock_guard<std::mutex> lock(m_watchdogMutex);
+    if (m_watchdog.joinable() || timeoutMs <= 0) {
+        return;
+    }
+    m_watchdogStopping = false;
+    m_watchdog = std::thread(&FlightRecorder::RunWatchdog, this, timeoutMs);
+}
+
+void FlightRecorder::StopWatchdog() {
+    std::thread watchdog;
+    {
+        std::lock_guard<std::mutex> lock(m_watchdogMutex);
+        m_watchdogStopping = true;
+        watchdog = std::move(m_watchdog);
+        m_watchdogCv.notify_all();
+    }
+    if (watchdog.joinable()) {
+        watchdog.join();
+    }
+}
+
+void FlightRecorder::Heartbeat() {
+    // Never 0, which means disarmed
+    m_lastBeatMs.store(SteadyNowMs() | 1, std::memory_order_relaxed);
+}
+
+void FlightRecorder::Disarm() {
+    m_lastBeatMs.store(0, std::memory_order_relaxed);
+}
+
+void FlightRecorder::RunWatchdog(int timeoutMs) {
+    int64_t dumpedBeatMs = 0;
+    std::unique_lock<std::mutex> lock(m_watchdogMutex);
+    while (!m_watchdogStopping) {
+        m_watchdogCv.wait_for(lock, std::chrono::milliseconds((std::max)(timeoutMs / 4, 1)));
+        if (m_watchdogStopping) {
+            break;
+        }
+        int64_t lastBeatMs = m_lastBeatMs.load(std::memory_order_relaxed);
+        int64_t stalledMs = SteadyNowMs() - lastBeatMs;
+        // Once per stall: the next dump needs a beat in between
+        if (lastBeatMs == 0 || stalledMs < timeoutMs || lastBeatMs == dumpedBeatMs) {
+            continue;
+        }
+        dumpedBeatMs = lastBeatMs;
+        lock.unlock();
+        Record(FlightEventKind::Watchdog, "heartbeat missed", stalledMs);
+        Dump("watchdog");
+        lock.lock();
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+enum class FlightEventKind : uint8_t {
+    SdkCallback,            // a: item count
+    TaskStart,              // Strand task about to run; a: wait us
+    TaskEnd,                // a: run us
+    UiMessage,              // a: message, b: wParam
+    Watchdog,               // a: ms since the last heartbeat
+    Crash                   // a: exception code or signal
+};
+
+struct FlightEvent {
+    int64_t timeUs;         // Steady clock
+    uint32_t threadId;
+    FlightEventKind kind;
+    const char* name;       // Static string, e.g. a task label
+    int64_t a;
+    int64_t b;
+};
+
+// Last events of every thread, kept in memory and written to a file only when
+// something went wrong: from the crash handlers, on LOG_FATAL, or when the
+// watchdog sees the UI thread stop beating. Each thread records into its own
+// ring, so Record takes no lock and does not allocate; a ring is reused by a
+// later thread once its owner exits. Rings live in static storage and Dump
+// neither allocates nor locks, so it can run inside a crash handler. An event
+// being recorded while Dump runs may come out torn.
+class FlightRecorder {
+public:
+    static const int kEventsPerThread = 256;    // Power of two
+    static const int kMaxThreads = 64;          // Threads past this record nothing
+
+    static FlightRecorder& Instance();
+
+    // `name` must be a string literal or otherwise live forever
+    static void Record(FlightEventKind kind, const char* name, int64_t a = 0, int64_t b = 0);
+
+    // Dumps go to <directory>/flight_<unix time>_<n>_<reason>.txt
+    void SetDumpDirectory(const std::string& directory);
+    // Merges the rings by time; returns false if the file could not be written
+    bool Dump(const char* reason);
+
+    // Unhandled exceptions / fatal signals and std::terminate dump first
+    void InstallCrashHandlers();
+
+    // The watchdog dumps once per stall when Heartbeat has not been called for
+    // `timeoutMs`. It is armed by the first Heartbeat and disarmed by Disarm,
+    // e.g. while no window is beating.
+    void StartWatchdog(int timeoutMs);
+    void StopWatchdog();
+    void Heartbeat();
+    void Disarm();
+
+private:
+    struct Ring {
+        std::atomic<int> owned;
+        std::atomic<uint64_t> next;         // Events recorded so far
+        FlightEvent events[kEventsPerThread];
+    };
+
+    FlightRecorder();
+    ~FlightRecorder();
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    static Ring* ClaimRing();
+    static void ReleaseRing(Ring* ring);
+    void RunWatchdog(int timeoutMs);
+
+    friend struct FlightRingOwner;
+
+    static Ring s_rings[kMaxThreads];
+    char m_directory[260];
+    std::atomic<int> m_dumpCount;
+    std::atomic<bool> m_dumping;
+
+    std::atomic<int64_t> m_lastBeatMs;          // 0 while disarmed
+    std::mutex m_watchdogMutex;
+    std::condition_variable m_watchdogCv;
+    bool m_watchdogStopping;
+    std::thread m_watchdog;
+};
@@ -0,0 +1,543 @@
+#include "pch.h"
+#include "HttpClient.h"
+#define LOG_CATEGORY LogCategory::Token
+#include "Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <winhttp.h>
+#pragma comment(lib, "winhttp.lib")
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef _WIN32
+
+// One WinHTTP session for the process. WinHTTP pools the TCP/TLS connections
+// of a session, so keeping the session and a connect handle per server open
+// is what lets a request reuse the previous request's connection.
+class WinHttpTransport : public IHttpTransport {
+public:
+    WinHttpTransport() : m_session(nullptr) {}
+
+    ~WinHttpTransport() override {
+        for (auto& entry : m_connections) {
+            WinHttpCloseHandle(entry.second);
+        }
+        if (m_session) {
+            WinHttpCloseHandle(m_session);
+        }
+    }
+
+    bool Post(const std::string& url, const std::string& contentType, const std::string& body,
+              int timeoutMs, HttpResponse& response, std::string& errorMsg) override {
+        URL_COMPONENTS urlComp = { 0 };
+        urlComp.dwStructSize = sizeof(urlComp);
+        urlComp.dwSchemeLength = -1;
+        urlComp.dwHostNameLength = -1;
+        urlComp.dwUrlPathLength = -1;
+        urlComp.dwExtraInfoLength = -1;
+
+        std::wstring urlWide(url.begin(), url.end());
+        if (!WinHttpCrackUrl(urlWide.c_str(), static_cast<DWORD>(urlWide.length()), 0, &urlComp)) {
+            errorMsg = "解析URL失败";
+            return false;
+        }
+        std::wstring hostWide(urlComp.lpszHostName, urlComp.dwHostNameLength);
+        std::wstring pathWide(urlComp.lpszUrlPath, urlComp.dwUrlPathLength);
+        if (urlComp.dwExtraInfoLength > 0) {
+            pathWide.append(urlComp.lpszExtraInfo, urlComp.dwExtraInfoLength);
+        }
+
+        HINTERNET hConnect = GetConnection(hostWide, urlComp.nPort, errorMsg);
+        if (!hConnect) {
+            return false;
+        }
+
+        DWORD flags = urlComp.nScheme == INTERNET_SCHEME_HTTPS ? WINHTTP_FLAG_SECURE : 0;
+        HINTERNET hRequest = WinHttpOpenRequest(hConnect, L"POST", pathWide.c_str(), nullptr,
+                                                WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES, flags);
+        if (!hRequest) {
+            errorMsg = "创建HTTP请求失败";
+            return false;
+        }
+        bool success = SendRequest(hRequest, contentType, body, timeoutMs, response, errorMsg);
+        // Closing the request after its body has been read returns the connection to the session's pool
+        WinHttpCloseHandle(hRequest);
+        return success;
+    }
+
+private:
+    HINTERNET GetConnection(const std::wstring& host, INTERNET_PORT port, std::string& errorMsg) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_session) {
+            m_session = WinHttpOpen(L"ThousChannel/1.0", WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+                                    WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, 0);
+            if (!m_session) {
+                errorMsg = "创建HTTP会话失败";
+                return nullptr;
+            }
+        }
+        std::wstring key = host + L":" + std::to_wstring(port);
+        auto it = m_connections.find(key);
+        if (it != m_connections.end()) {
+            return it->second;
+        }
+        HINTERNET hConnect = WinHttpConnect(m_session, host.c_str(), port, 0);
+        if (!hConnect) {
+            errorMsg = "连接服务器失败";
+            return nullptr;
+        }
+        m_connections[key] = hConnect;
+        return hConnect;
+    }
+
+    static bool SendRequest(HINTERNET hRequest, const std::string& contentType, const std::string& body,
+                            int timeoutMs, HttpResponse& response, std::string& errorMsg) {
+        WinHttpSetTimeouts(hRequest, timeoutMs, timeoutMs, timeoutMs, timeoutMs);
+
+        std::string headerText = "Content-Type: " + contentType + "\r\n";
+        std::wstring headers(headerText.begin(), headerText.end());
+        WinHttpAddRequestHeaders(hRequest, headers.c_str(), static_cast<DWORD>(headers.length()),
+                                 WINHTTP_ADDREQ_FLAG_ADD);
+
+        if (!WinHttpSendRequest(hRequest, WINHTTP_NO_ADDITIONAL_HEADERS, 0,
+                                (LPVOID)body.c_str(), (DWORD)body.length(), (DWORD)body.length(), 0)) {
+            errorMsg = "发送HTTP请求失败";
+            return false;
+        }
+        if (!WinHttpReceiveResponse(hRequest, nullptr)) {
+            errorMsg = "接收HTTP响应失败";
+            return false;
+        }
+
+        DWORD statusCode = 0;
+        DWORD statusCodeSize = sizeof(statusCode);
+        WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                            WINHTTP_HEADER_NAME_BY_INDEX, &statusCode, &statusCodeSize, WINHTTP_NO_HEADER_INDEX);
+        response.statusCode = static_cast<int>(statusCode);
+        response.body.clear();
+
+        char buffer[8192];
+        while (true) {
+            DWORD bytesRead = 0;
+            if (!WinHttpReadData(hRequest, buffer, sizeof(buffer), &bytesRead)) {
+                errorMsg = "读取响应数据失败";
+                return false;
+            }
+            if (bytesRead == 0) {
+                break;
+            }
+            response.body.append(buffer, bytesRead);
+        }
+        return true;
+    }
+
+    std::mutex m_mutex;
+    HINTERNET m_session;
+    std::map<std::wstring, HINTERNET> m_connections;    // "host:port"
+};
+
+#else
+
+// HTTP/1.1 over plain sockets with a pool of idle keep-alive connections per
+// server. No TLS: https URLs fail, so this is for local stand-in servers.
+class SocketHttpTransport : public IHttpTransport {
+public:
+    static const size_t kMaxIdlePerServer = 4;
+
+    ~SocketHttpTransport() override {
+        for (auto& entry : m_idle) {
+            close(entry.second);
+        }
+    }
+
+    bool Post(const std::string& url, const std::string& contentType, const std::string& body,
+              int timeoutMs, HttpResponse& response, std::string& errorMsg) override {
+        std::string host, port, path;
+        if (!ParseUrl(url, host, port, path, errorMsg)) {
+            return false;
+        }
+        std::string key = host + ":" + port;
+        std::string request = "POST " + path + " HTTP/1.1\r\nHost: " + key +
+            "\r\nContent-Type: " + contentType +
+            "\r\nContent-Length: " + std::to_string(body.size()) +
+            "\r\nConnection: keep-alive\r\n\r\n" + body;
+
+        // An idle connection may have been closed by the server in the
+        // meantime. Only that is retried, on a new connection: the send fails,
+        // or the connection turns out closed or reset before any response
+        // byte. A timeout is not retried, as the server may have received
+        // the POST and be acting on it.
+        while (true) {
+            bool reused = false;
+            int fd = TakeIdle(key);
+            if (fd >= 0) {
+                reused = true;
+            } else {
+                fd = Connect(host, port, timeoutMs, errorMsg);
+                if (fd < 0) {
+                    return false;
+                }
+            }
+            SetTimeout(fd, timeoutMs);
+
+            bool keepAlive = false;
+            ReadState state;
+            bool sent = SendAll(fd, request);
+            if (sent && ReadResponse(fd, response, keepAlive, state, errorMsg)) {
+                if (keepAlive) {
+                    GiveBack(key, fd);
+                } else {
+                    close(fd);
+                }
+                return true;
+            }
+            close(fd);
+            if (!reused || (sent && (!state.closed || state.gotBytes))) {
+                if (errorMsg.empty()) {
+                    errorMsg = sent ? "接收HTTP响应失败" : "发送HTTP请求失败";
+                }
+                return false;
+            }
+            errorMsg.clear();
+        }
+    }
+
+private:
+    struct ReadState {
+        bool gotBytes = false;
+        bool closed = false;    // Closed or reset by the server, not timed out
+    };
+
+    static bool ParseUrl(const std::string& url, std::string& host, std::string& port, std::string& path,
+                         std::string& errorMsg) {
+        const std::string scheme = "http://";
+        if (url.compare(0, scheme.size(), scheme) != 0) {
+            errorMsg = "只支持http:// URL: " + url;
+            return false;
+        }
+        size_t hostStart = scheme.size();
+        size_t pathStart = url.find('/', hostStart);
+        std::string authority = url.substr(hostStart, pathStart == std::string::npos ? std::string::npos
+                                                                                   : pathStart - hostStart);
+        path = pathStart == std::string::npos ? "/" : url.substr(pathStart);
+        size_t colon = authority.rfind(':');
+        host = colon == std::string::npos ? authority : authority.substr(0, colon);
+        port = colon == std::string::npos ? "80" : authority.substr(colon + 1);
+        if (host.empty()) {
+            errorMsg = "解析URL失败";
+            return false;
+        }
+        return true;
+    }
+
+    static int Connect(const std::string& host, const std::string& port, int timeoutMs, std::string& errorMsg) {
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* addresses = nullptr;
+        if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+            errorMsg = "解析服务器地址失败: " + host;
+            return -1;
+        }
+        int fd = -1;
+        for (addrinfo* address = addresses; address; address = address->ai_next) {
+            fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (fd < 0) {
+                continue;
+            }
+            // The send timeout also bounds connect on Linux
+            SetTimeout(fd, timeoutMs);
+            if (connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+                break;
+            }
+            close(fd);
+            fd = -1;
+        }
+        freeaddrinfo(addresses);
+        if (fd < 0) {
+            errorMsg = "连接服务器失败";
+            return -1;
+        }
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        LOG_DEBUG_FMT("HttpClient: new connection to {}:{}", host, port);
+        return fd;
+    }
+
+    static void SetTimeout(int fd, int timeoutMs) {
+        timeval timeout;
+        timeout.tv_sec = timeoutMs / 1000;
+        timeout.tv_usec = (timeoutMs % 1000) * 1000;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    }
+
+    static bool SendAll(int fd, const std::string& data) {
+        for (size_t sent = 0; sent < data.size(); ) {
+            ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return false;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // Reads more of the response into `buffer`; false on error, timeout or close
+    static bool Receive(int fd, std::string& buffer, ReadState& state) {
+        char chunk[8192];
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            state.closed = n == 0 || errno == ECONNRESET;
+            return false;
+        }
+        state.gotBytes = true;
+        buffer.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+
+    static bool ReadResponse(int fd, HttpResponse& response, bool& keepAlive, ReadState& state,
+                             std::string& errorMsg) {
+        std::string buffer;
+        size_t headerEnd;
+        while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+            if (!Receive(fd, buffer, state)) {
+                return false;
+            }
+        }
+
+        std::string headers = buffer.substr(0, headerEnd + 2);
+        std::string lower = headers;
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+        size_t space = headers.find(' ');
+        if (headers.compare(0, 7, "HTTP/1.") != 0 || space == std::string::npos) {
+            errorMsg = "无效的HTTP响应";
+            return false;
+        }
+        response.statusCode = atoi(headers.c_str() + space + 1);
+        keepAlive = headers.compare(0, 8, "HTTP/1.1") == 0 && lower.find("\r\nconnection: close") == std::string::npos;
+
+        std::string body = buffer.substr(headerEnd + 4);
+        size_t lengthPos = lower.find("\r\ncontent-length:");
+        if (lower.find("\r\ntransfer-encoding: chunked") != std::string::npos) {
+            response.body.clear();
+            size_t pos = 0;
+            while (true) {
+                size_t lineEnd;
+                while ((lineEnd = body.find("\r\n", pos)) == std::string::npos) {
+                    if (!Receive(fd, body, state)) {
+                        return false;
+                    }
+                }
+                size_t size = strtoul(body.c_str() + pos, nullptr, 16);
+                size_t dataStart = lineEnd + 2;
+                while (body.size() < dataStart + size + 2) {
+                    if (!Receive(fd, body, state)) {
+                        return false;
+                    }
+                }
+                if (size == 0) {
+                    break;
+                }
+                response.body.append(body, dataStart, size);
+                pos = dataStart + size + 2;
+            }
+        } else if (lengthPos != std::string::npos) {
+            size_t length = strtoul(lower.c_str() + lengthPos + 17, nullptr, 10);
+            while (body.size() < length) {
+                if (!Receive(fd, body, state)) {
+                    return false;
+                }
+            }
+            response.body = body.substr(0, length);
+        } else {
+            // Body runs to the end of the connection
+            while (Receive(fd, body, state)) {
+            }
+            response.body = body;
+            keepAlive = false;
+        }
+        return true;
+    }
+
+    int TakeIdle(const std::string& key) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_idle.find(key);
+        if (it == m_idle.end()) {
+            return -1;
+        }
+        int fd = it->second;
+        m_idle.erase(it);
+        return fd;
+    }
+
+    void GiveBack(const std::string& key, int fd) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_idle.count(key) >= kMaxIdlePerServer) {
+            close(fd);
+            return;
+        }
+        m_idle.insert(std::make_pair(key, fd));
+    }
+
+    std::mutex m_mutex;
+    std::multimap<std::string, int> m_idle;     // "host:port" -> idle connection
+};
+
+#endif
+
+} // namespace
+
+std::unique_ptr<IHttpTransport> CreateHttpTransport() {
+#ifdef _WIN32
+    return std::unique_ptr<IHttpTransport>(new WinHttpTransport());
+#else
+    return std::unique_ptr<IHttpTransport>(new SocketHttpTransport());
+#endif
+}
+
+namespace {
+
+// Set once Instance() has created the client
+std::atomic<HttpClient*> g_instance(nullptr);
+
+} // namespace
+
+HttpClient& HttpClient::Instance() {
+    // Leaked on purpose: workers that Shutdown abandons after its timeout
+    // still use the client and its transport while the process exits
+    static HttpClient* client = []() {
+        HttpClient* created = new HttpClient(CreateHttpTransport());
+        g_instance.store(created);
+        return created;
+    }();
+    return *client;
+}
+
+void HttpClient::ShutdownInstance(int timeoutMs) {
+    HttpClient* client = g_instance.load();
+    if (client) {
+        client->Shutdown(timeoutMs);
+    }
+}
+
+HttpClient::HttpClient(std::unique_ptr<IHttpTransport> transport, int workers, size_t maxQueued)
+    : m_transport(std::move(transport)), m_workerCount((std::max)(workers, 1)),
+      m_maxQueued((std::max)(maxQueued, static_cast<size_t>(1))), m_running(0), m_stopping(false) {
+}
+
+HttpClient::~HttpClient() {
+    Shutdown(0);
+}
+
+bool HttpClient::Post(const std::string& url, const std::string& contentType, const std::string& body,
+                      int timeoutMs, HttpResponse& response, std::string& errorMsg) {
+    auto start = std::chrono::steady_clock::now();
+    bool success = m_transport->Post(url, contentType, body, timeoutMs, response, errorMsg);
+    LOG_DEBUG_FMT("HttpClient: POST {} -> {} in {}ms", url, response.statusCode,
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+    return success;
+}
+
+bool HttpClient::PostAsync(const std::string& url, const std::string& contentType, const std::string& body,
+                           int timeoutMs, Callback callback) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stopping) {
+        return false;
+    }
+    if (m_requests.size() >= m_maxQueued) {
+        LOG_WARN_FMT("HttpClient: {} requests queued, refusing POST {}", m_requests.size(), url);
+        return false;
+    }
+
+    // Workers are started lazily, at the first asynchronous request
+    if (m_workers.empty()) {
+        for (int i = 0; i < m_workerCount; ++i) {
+            m_workers.push_back(std::thread(&HttpClient::WorkerLoop, this));
+        }
+    }
+
+    Request request;
+    request.url = url;
+    request.contentType = contentType;
+    request.body = body;
+    request.timeoutMs = timeoutMs;
+    request.callback = callback;
+    m_requests.push_back(std::move(request));
+    m_requestCv.notify_one();
+    return true;
+}
+
+void HttpClient::Shutdown(int timeoutMs) {
+    bool idle;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        idle = m_idleCv.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+            [this]() { return m_requests.empty() && m_running == 0; });
+        m_stopping = true;
+        m_requestCv.notify_all();
+    }
+
+    for (auto& worker : m_workers) {
+        if (!worker.joinable()) {
+            continue;
+        }
+        if (idle) {
+            worker.join();
+        } else {
+            // Joining would hang the caller on an unresponsive server
+            worker.detach();
+        }
+    }
+    if (!idle) {
+        LOG_ERROR_FMT("HttpClient: requests still running after {}ms, abandoning them", timeoutMs);
+    }
+    m_workers.clear();
+}
+
+void HttpClient::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_requestCv.wait(lock, [this]() { return !m_requests.empty() || m_stopping; });
+        if (m_requests.empty()) {
+            break;
+        }
+
+        Request request = std::move(m_requests.front());
+        m_requests.pop_front();
+        ++m_running;
+
+        lock.unlock();
+        HttpResponse response;
+        std::string errorMsg;
+        bool success = Post(request.url, request.contentType, request.body, request.timeoutMs, response, errorMsg);
+        try {
+            request.callback(success, response, errorMsg);
+        } catch (const std::exception& e) {
+            LOG_ERROR_FMT("HttpClient: callback for {} threw: {}", request.url, e.what());
+        }
+        lock.lock();
+
+        --m_running;
+        if (m_requests.empty() && m_running == 0) {
+            m_idleCv.notify_all();
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct HttpResponse {
+    int statusCode = 0;
+    std::string body;
+};
+
+// Sends HTTP requests, keeping connections open between calls so that a
+// request to a server already talked to costs one round trip instead of a
+// TCP and TLS handshake. Implementations are safe to call from several
+// threads at once.
+class IHttpTransport {
+public:
+    virtual ~IHttpTransport() {}
+
+    // False with errorMsg if no response arrived; any status code is a response
+    virtual bool Post(const std::string& url, const std::string& contentType, const std::string& body,
+                      int timeoutMs, HttpResponse& response, std::string& errorMsg) = 0;
+};
+
+// WinHTTP with one session for the process on Windows; elsewhere a plain
+// socket client with a keep-alive pool that speaks http:// only, enough to
+// run the token path against a local stand-in server
+std::unique_ptr<IHttpTransport> CreateHttpTransport();
+
+// Process wide HTTP client: one transport, so connections are shared by every
+// caller, and a small fixed set of worker threads for asynchronous requests.
+// The queue is bounded; PostAsync refuses requests instead of piling them up
+// behind an unreachable server.
+class HttpClient {
+public:
+    typedef std::function<void(bool success, const HttpResponse& response, const std::string& errorMsg)> Callback;
+
+    static const int kDefaultWorkers = 2;
+    static const size_t kDefaultMaxQueued = 32;
+
+    // Never destroyed: workers abandoned by Shutdown may still use it during exit
+    static HttpClient& Instance();
+    // Shutdown of Instance(), if anything ever created it; for application exit
+    static void ShutdownInstance(int timeoutMs);
+
+    HttpClient(std::unique_ptr<IHttpTransport> transport, int workers = kDefaultWorkers,
+               size_t maxQueued = kDefaultMaxQueued);
+    ~HttpClient();
+
+    // Runs on the calling thread
+    bool Post(const std::string& url, const std::string& contentType, const std::string& body,
+              int timeoutMs, HttpResponse& response, std::string& errorMsg);
+
+    // Queues the request; the callback runs on a worker thread. Returns false,
+    // without calling the callback, if the queue is full or the client is shut down.
+    bool PostAsync(const std::string& url, const std::string& contentType, const std::string& body,
+                   int timeoutMs, Callback callback);
+
+    // Finish queued requests for up to timeoutMs and stop the workers. Called on
+    // application exit; a request still stuck after the timeout is abandoned.
+    void Shutdown(int timeoutMs);
+
+private:
+    struct Request {
+        std::string url;
+        std::string contentType;
+        std::string body;
+        int timeoutMs;
+        Callback callback;
+    };
+
+    HttpClient(const HttpClient&) = delete;
+    HttpClient& operator=(const HttpClient&) = delete;
+
+    void WorkerLoop();
+
+    std::unique_ptr<IHttpTransport> m_transport;
+    const int m_workerCount;
+    const size_t m_maxQueued;
+
+    std::mutex m_mutex;
+    std::condition_variable m_requestCv;
+    std::condition_variable m_idleCv;
+    std::deque<Request> m_requests;
+    int m_running;
+    bool m_stopping;
+    std::vector<std::thread> m_workers;
+};
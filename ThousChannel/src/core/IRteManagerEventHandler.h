@@ -1,18 +1,33 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <memory>
+
+#include "UserIdInterner.h"
+
+// Error passed to OnError when automatic reconnect gave up
+const int kRteManagerErrorReconnectFailed = -1001;
 
 class IRteManagerEventHandler {
 public:
     virtual ~IRteManagerEventHandler() {}
 
+    // state is the local user link state (rte::LocalUserLinkState)
     virtual void OnConnectionStateChanged(int state) = 0;
-    virtual void OnUserJoined(const std::string& userId) = 0;
-    virtual void OnUserLeft(const std::string& userId) = 0;
+    // The channel was rejoined after a connection loss; all view bindings must be re-applied
+    virtual void OnConnectionRestored(long long outageMs, int attempts) = 0;
+    // Remote users are identified by their interned handle, see UserIdString()
+    virtual void OnUserJoined(UserHandle user) = 0;
+    virtual void OnUserLeft(UserHandle user) = 0;
     virtual void OnLocalAudioStateChanged(int state) = 0;
     virtual void OnLocalVideoStateChanged(int state, int reason) = 0;
-    virtual void OnRemoteAudioStateChanged(const std::string& userId, int state) = 0;
-    virtual void OnRemoteVideoStateChanged(const std::string& userId, int state) = 0;
+    virtual void OnRemoteAudioStateChanged(UserHandle user, int state) = 0;
+    virtual void OnRemoteVideoStateChanged(UserHandle user, int state) = 0;
     virtual void OnError(int error) = 0;
     virtual void OnUserListChanged() = 0;
+    // Many remote users arrived at once (presence snapshot on join, large join
+    // batch) and got no OnUserJoined each. `roster` is every remote user at that
+    // point, so the handler needs no call back into RteManager.
+    virtual void OnUserSnapshot(std::shared_ptr<const std::vector<UserHandle>> roster) = 0;
 };
\ No newline at end of file
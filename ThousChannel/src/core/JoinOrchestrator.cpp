@@ -0,0 +1,268 @@
+#include "pch.h"
+#include "JoinOrchestrator.h"
+#define LOG_CATEGORY LogCategory::Rte
+#include "Logger.h"
+#include <thread>
+#include <sstream>
+#include <algorithm>
+
+JoinOrchestrator::JoinOrchestrator()
+    : m_unfinishedSteps(0), m_totalMs(0) {
+}
+
+JoinOrchestrator::~JoinOrchestrator() {
+}
+
+void JoinOrchestrator::AddStep(const std::string& name, const std::vector<std::string>& dependencies,
+                               StepFunc func, bool required) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Step step;
+    step.name = name;
+    step.dependencyNames = dependencies;
+    step.func = func;
+    step.required = required;
+    step.status = JoinStepStatus::Pending;
+    step.unfinishedDependencies = 0;
+    step.startMs = -1;
+    step.endMs = -1;
+    m_steps.push_back(step);
+}
+
+// Also clears what an earlier Run() left in the steps, so an orchestrator can
+// run again
+bool JoinOrchestrator::ResolveDependencies() {
+    for (Step& step : m_steps) {
+        step.dependents.clear();
+        step.status = JoinStepStatus::Pending;
+        step.startMs = -1;
+        step.endMs = -1;
+    }
+    for (size_t i = 0; i < m_steps.size(); ++i) {
+        Step& step = m_steps[i];
+        step.dependencies.clear();
+        for (const auto& depName : step.dependencyNames) {
+            auto it = std::find_if(m_steps.begin(), m_steps.end(),
+                [&depName](const Step& s) { return s.name == depName; });
+            if (it == m_steps.end()) {
+                LOG_ERROR_FMT("JoinOrchestrator: step {} depends on unknown step {}", step.name, depName);
+                return false;
+            }
+            size_t depIndex = static_cast<size_t>(it - m_steps.begin());
+            step.dependencies.push_back(depIndex);
+            m_steps[depIndex].dependents.push_back(i);
+        }
+        step.unfinishedDependencies = step.dependencies.size();
+    }
+    return true;
+}
+
+bool JoinOrchestrator::Run() {
+    std::vector<std::thread> threads;
+    std::vector<size_t> ready;
+    size_t runningSteps = 0;
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_startTime = std::chrono::steady_clock::now();
+        m_failedStep.clear();
+        m_totalMs = 0;
+        m_unfinishedSteps = m_steps.size();
+
+        if (!ResolveDependencies()) {
+            m_failedStep = "<graph>";
+            return false;
+        }
+
+        for (size_t i = 0; i < m_steps.size(); ++i) {
+            if (m_steps[i].unfinishedDependencies == 0) {
+                ready.push_back(i);
+            }
+        }
+
+        while (m_unfinishedSteps > 0) {
+            // Launch every step that became ready since the last wake-up
+            for (size_t index : ready) {
+                m_steps[index].status = JoinStepStatus::Running;
+                m_steps[index].startMs = ElapsedMs();
+                ++runningSteps;
+                threads.emplace_back([this, index, &ready, &runningSteps]() {
+                    bool ok = false;
+                    try {
+                        ok = m_steps[index].func ? m_steps[index].func() : true;
+                    } catch (const std::exception& e) {
+                        LOG_ERROR_FMT("JoinOrchestrator: step {} threw: {}", m_steps[index].name, e.what());
+                    }
+
+                    std::lock_guard<std::mutex> stepLock(m_mutex);
+                    --runningSteps;
+                    FinishStep(index, ok ? JoinStepStatus::Succeeded : JoinStepStatus::Failed, ready);
+                    m_cv.notify_all();
+                });
+            }
+            ready.clear();
+
+            if (m_unfinishedSteps == 0) {
+                break;
+            }
+
+            if (runningSteps == 0) {
+                // Nothing running and nothing ready: the remaining steps form a cycle
+                for (size_t i = 0; i < m_steps.size(); ++i) {
+                    if (m_steps[i].status == JoinStepStatus::Pending) {
+                        LOG_ERROR_FMT("JoinOrchestrator: step {} is part of a dependency cycle", m_steps[i].name);
+                        m_steps[i].status = JoinStepStatus::Skipped;
+                        --m_unfinishedSteps;
+                        if (m_failedStep.empty() && m_steps[i].required) {
+                            m_failedStep = m_steps[i].name;
+                        }
+                    }
+                }
+                break;
+            }
+
+            m_cv.wait(lock, [&]() { return !ready.empty() || m_unfinishedSteps == 0 || runningSteps == 0; });
+        }
+
+        m_totalMs = ElapsedMs();
+    }
+
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    LogTimeline();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_failedStep.empty();
+}
+
+// Must be called with m_mutex held
+void JoinOrchestrator::FinishStep(size_t index, JoinStepStatus status, std::vector<size_t>& ready) {
+    Step& step = m_steps[index];
+    step.status = status;
+    step.endMs = ElapsedMs();
+    --m_unfinishedSteps;
+
+    if (status != JoinStepStatus::Succeeded && step.required && m_failedStep.empty()) {
+        m_failedStep = step.name;
+    }
+
+    for (size_t dependentIndex : step.dependents) {
+        Step& dependent = m_steps[dependentIndex];
+        if (--dependent.unfinishedDependencies > 0) {
+            continue;
+        }
+
+        bool blocked = false;
+        for (size_t depIndex : dependent.dependencies) {
+            const Step& dep = m_steps[depIndex];
+            if (dep.required && dep.status != JoinStepStatus::Succeeded) {
+                blocked = true;
+                break;
+            }
+        }
+
+        if (blocked) {
+            LOG_WARN_FMT("JoinOrchestrator: skipping step {}, a required dependency did not succeed", dependent.name);
+            FinishStep(dependentIndex, JoinStepStatus::Skipped, ready);
+        } else {
+            ready.push_back(dependentIndex);
+        }
+    }
+}
+
+long long JoinOrchestrator::ElapsedMs() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - m_startTime).count();
+}
+
+std::vector<JoinStepRecord> JoinOrchestrator::GetTimeline() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<JoinStepRecord> timeline;
+    for (const auto& step : m_steps) {
+        JoinStepRecord record;
+        record.name = step.name;
+        record.status = step.status;
+        record.startMs = step.startMs;
+        record.endMs = step.endMs;
+        timeline.push_back(record);
+    }
+    return timeline;
+}
+
+std::vector<std::string> JoinOrchestrator::GetCriticalPath() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<std::string> path;
+
+    // Start from the step that finished last, then keep following the
+    // dependency that finished last until reaching a step with no dependencies
+    long long latestEnd = -1;
+    size_t current = m_steps.size();
+    for (size_t i = 0; i < m_steps.size(); ++i) {
+        if (m_steps[i].startMs >= 0 && m_steps[i].endMs > latestEnd) {
+            latestEnd = m_steps[i].endMs;
+            current = i;
+        }
+    }
+
+    while (current < m_steps.size()) {
+        path.push_back(m_steps[current].name);
+        size_t next = m_steps.size();
+        long long nextEnd = -1;
+        for (size_t depIndex : m_steps[current].dependencies) {
+            if (m_steps[depIndex].startMs >= 0 && m_steps[depIndex].endMs > nextEnd) {
+                nextEnd = m_steps[depIndex].endMs;
+                next = depIndex;
+            }
+        }
+        current = next;
+    }
+
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+std::string JoinOrchestrator::GetFailedStep() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_failedStep;
+}
+
+long long JoinOrchestrator::GetTotalMs() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_totalMs;
+}
+
+void JoinOrchestrator::LogTimeline() const {
+    std::vector<JoinStepRecord> timeline = GetTimeline();
+    for (const auto& record : timeline) {
+        std::ostringstream oss;
+        oss << "Join step " << record.name << ": " << GetStatusString(record.status);
+        if (record.startMs >= 0) {
+            oss << " [" << record.startMs << "ms -> " << record.endMs << "ms, "
+                << (record.endMs - record.startMs) << "ms]";
+        }
+        LOG_INFO(oss.str());
+    }
+
+    std::vector<std::string> path = GetCriticalPath();
+    std::ostringstream oss;
+    for (size_t i = 0; i < path.size(); ++i) {
+        if (i > 0) oss << " -> ";
+        oss << path[i];
+    }
+    LOG_INFO_FMT("Join finished in {}ms, critical path: {}", GetTotalMs(), oss.str());
+}
+
+const char* JoinOrchestrator::GetStatusString(JoinStepStatus status) {
+    switch (status) {
+        case JoinStepStatus::Pending:   return "pending";
+        case JoinStepStatus::Running:   return "running";
+        case JoinStepStatus::Succeeded: return "ok";
+        case JoinStepStatus::Failed:    return "failed";
+        case JoinStepStatus::Skipped:   return "skipped";
+        default:                        return "unknown";
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+// Execution status of a single join step
+enum class JoinStepStatus {
+    Pending,
+    Running,
+    Succeeded,
+    Failed,
+    Skipped     // Not run because a required dependency failed or was skipped
+};
+
+// Timeline entry recorded for every step of a join
+struct JoinStepRecord {
+    std::string name;
+    JoinStepStatus status;
+    long long startMs;      // Offset from the start of Run(), -1 if never started
+    long long endMs;        // Offset from the start of Run(), -1 if never finished
+};
+
+// Runs the steps of a channel join as a dependency graph.
+// Every step whose dependencies are finished is started on its own thread, so
+// independent steps (token HTTP and engine init, mic and camera open) overlap.
+// A failed required step skips everything that depends on it; a failed optional
+// step only marks itself failed and its dependents still run.
+class JoinOrchestrator {
+public:
+    typedef std::function<bool()> StepFunc;
+
+    JoinOrchestrator();
+    ~JoinOrchestrator();
+
+    // Register a step. Dependencies are referenced by name and must be added before Run().
+    void AddStep(const std::string& name, const std::vector<std::string>& dependencies,
+                 StepFunc func, bool required = true);
+
+    // Run all steps and block until every step is finished or skipped.
+    // Returns true if all required steps succeeded. Each Run() starts over:
+    // every step runs again and the timeline is replaced.
+    bool Run();
+
+    // Per-step timeline of the last Run(), in registration order
+    std::vector<JoinStepRecord> GetTimeline() const;
+
+    // Chain of steps that determined the total join time, first to last
+    std::vector<std::string> GetCriticalPath() const;
+
+    // Name of the first required step that failed, empty if none
+    std::string GetFailedStep() const;
+
+    // Total wall time of the last Run() in milliseconds
+    long long GetTotalMs() const;
+
+    void LogTimeline() const;
+
+private:
+    struct Step {
+        std::string name;
+        std::vector<std::string> dependencyNames;
+        std::vector<size_t> dependencies;
+        std::vector<size_t> dependents;
+        StepFunc func;
+        bool required;
+        JoinStepStatus status;
+        size_t unfinishedDependencies;
+        long long startMs;
+        long long endMs;
+    };
+
+    JoinOrchestrator(const JoinOrchestrator&) = delete;
+    JoinOrchestrator& operator=(const JoinOrchestrator&) = delete;
+
+    bool ResolveDependencies();
+    void FinishStep(size_t index, JoinStepStatus status, std::vector<size_t>& ready);
+    long long ElapsedMs() const;
+
+    static const char* GetStatusString(JoinStepStatus status);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<Step> m_steps;
+    size_t m_unfinishedSteps;
+    std::string m_failedStep;
+    std::chrono::steady_clock::time_point m_startTime;
+    long long m_totalMs;
+};
@@ -0,0 +1,528 @@
+#include "pch.h"
+#include "LogSink.h"
+#include "Lz4.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::string SegmentPath(const std::string& directory, const std::string& stem, const std::string& extension,
+                        uint64_t sequence) {
+    char number[24];
+    snprintf(number, sizeof(number), "%06llu", static_cast<unsigned long long>(sequence));
+    return (std::filesystem::path(directory) / (stem + "." + number + extension)).string();
+}
+
+// <stem>.<digits><extension>
+bool ParseSegmentName(const std::string& name, const std::string& stem, const std::string& extension,
+                      uint64_t& sequence) {
+    if (name.size() <= stem.size() + 1 + extension.size() || name.compare(0, stem.size(), stem) != 0 ||
+        name[stem.size()] != '.' || name.compare(name.size() - extension.size(), extension.size(), extension) != 0) {
+        return false;
+    }
+    std::string digits = name.substr(stem.size() + 1, name.size() - stem.size() - 1 - extension.size());
+    if (digits.empty() || digits.size() > 18 || digits.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    sequence = std::stoull(digits);
+    return true;
+}
+
+// Deletes the oldest segments of the log until the rest, `newest` included,
+// fit in `keepBytes`. The newest segment is never deleted.
+void RemoveSegmentsOver(const std::string& directory, const std::string& stem, const std::string& extension,
+                        uint64_t newest, uint64_t keepBytes) {
+    std::vector<std::pair<uint64_t, std::filesystem::path>> segments;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        uint64_t sequence = 0;
+        if (ParseSegmentName(entry.path().filename().string(), stem, extension, sequence) && sequence <= newest) {
+            segments.emplace_back(sequence, entry.path());
+        }
+    }
+    std::sort(segments.begin(), segments.end(),
+        [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    uint64_t total = 0;
+    bool full = false;
+    for (const auto& segment : segments) {
+        uint64_t size = std::filesystem::file_size(segment.second, error);
+        if (error) {
+            size = 0;
+        }
+        full = full || (segment.first != newest && total + size > keepBytes);
+        if (full) {
+            std::filesystem::remove(segment.second, error);
+        } else {
+            total += size;
+        }
+    }
+}
+
+int64_t WallClockUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Spare frame buffers kept for reuse
+const size_t kFreeFrameBuffers = 4;
+
+} // namespace
+
+FileLogSink::FileLogSink(size_t bufferBytes)
+    : m_bufferBytes(bufferBytes), m_size(0) {
+    m_buffer.reserve(bufferBytes);
+}
+
+FileLogSink::~FileLogSink() {
+    Close();
+}
+
+bool FileLogSink::Open(const std::string& path, bool truncate) {
+    Close();
+
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(parent, error);
+    }
+
+    m_file.open(path, std::ios::binary | (truncate ? std::ios::trunc : std::ios::app));
+    if (!m_file.is_open()) {
+        return false;
+    }
+    m_file.seekp(0, std::ios::end);
+    m_size = static_cast<uint64_t>(m_file.tellp());
+    return true;
+}
+
+void FileLogSink::Close() {
+    if (m_file.is_open()) {
+        Flush();
+        m_file.close();
+    }
+    m_size = 0;
+}
+
+void FileLogSink::Write(const char* data, size_t size) {
+    if (!m_file.is_open()) {
+        return;
+    }
+    m_size += size;
+    if (m_bufferBytes == 0) {
+        m_file.write(data, size);
+        m_file.flush();
+        return;
+    }
+    if (m_buffer.size() + size > m_bufferBytes) {
+        Flush();
+    }
+    if (size >= m_bufferBytes) {
+        m_file.write(data, size);
+        return;
+    }
+    m_buffer.append(data, size);
+}
+
+void FileLogSink::Flush() {
+    if (!m_file.is_open()) {
+        return;
+    }
+    if (!m_buffer.empty()) {
+        m_file.write(m_buffer.data(), m_buffer.size());
+        m_buffer.clear();
+    }
+    m_file.flush();
+}
+
+MappedLogSink::MappedLogSink(uint64_t segmentBytes, uint64_t keepBytes)
+    : m_segmentBytes((std::max)(segmentBytes, static_cast<uint64_t>(64 * 1024))),
+      m_keepBytes(keepBytes), m_sequence(0),
+#ifdef _WIN32
+      m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr),
+#else
+      m_file(-1),
+#endif
+      m_view(nullptr), m_position(0), m_flushedPosition(0), m_headerEnd(0), m_inHandler(false), m_droppedBytes(0) {
+}
+
+MappedLogSink::~MappedLogSink() {
+    Close();
+}
+
+bool MappedLogSink::Open(const std::string& basePath) {
+    Close();
+
+    std::filesystem::path base(basePath);
+    m_directory = base.has_parent_path() ? base.parent_path().string() : ".";
+    m_stem = base.stem().string();
+    m_extension = base.extension().string();
+
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+
+    // Continue after the newest segment of earlier sessions
+    m_sequence = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(m_directory, error)) {
+        uint64_t sequence = 0;
+        if (ParseSegmentName(entry.path().filename().string(), m_stem, m_extension, sequence)) {
+            m_sequence = (std::max)(m_sequence, sequence);
+        }
+    }
+
+    if (!OpenSegment()) {
+        return false;
+    }
+    if (m_segmentHandler) {
+        m_inHandler = true;
+        m_segmentHandler();
+        m_inHandler = false;
+    }
+    m_headerEnd = m_position;
+    return true;
+}
+
+void MappedLogSink::Close() {
+    CloseSegment();
+}
+
+bool MappedLogSink::OpenSegment() {
+    ++m_sequence;
+    m_segmentPath = SegmentPath(m_directory, m_stem, m_extension, m_sequence);
+    m_position = 0;
+    m_flushedPosition = 0;
+    m_headerEnd = 0;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(m_segmentPath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                              CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    size.QuadPart = static_cast<LONGLONG>(m_segmentBytes);
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, size.HighPart, size.LowPart, nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, static_cast<SIZE_T>(m_segmentBytes)) : nullptr;
+    if (!view) {
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return false;
+    }
+    m_file = file;
+    m_mapping = mapping;
+#else
+    int file = open(m_segmentPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file < 0) {
+        return false;
+    }
+    void* view = MAP_FAILED;
+    if (ftruncate(file, static_cast<off_t>(m_segmentBytes)) == 0) {
+        view = mmap(nullptr, static_cast<size_t>(m_segmentBytes), PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    }
+    if (view == MAP_FAILED) {
+        close(file);
+        return false;
+    }
+    m_file = file;
+#endif
+    m_view = static_cast<char*>(view);
+    RemoveOldSegments();
+    return true;
+}
+
+void MappedLogSink::CloseSegment() {
+    if (!m_view) {
+        return;
+    }
+
+    // The file shrinks to what was written
+#ifdef _WIN32
+    UnmapViewOfFile(m_view);
+    CloseHandle(m_mapping);
+    LARGE_INTEGER size;
+    size.QuadPart = static_cast<LONGLONG>(m_position);
+    SetFilePointerEx(m_file, size, nullptr, FILE_BEGIN);
+    SetEndOfFile(m_file);
+    CloseHandle(m_file);
+    m_file = INVALID_HANDLE_VALUE;
+    m_mapping = nullptr;
+#else
+    munmap(m_view, static_cast<size_t>(m_segmentBytes));
+    if (ftruncate(m_file, static_cast<off_t>(m_position)) != 0) {
+        // Left at full size; readers stop at the zero tail
+    }
+    close(m_file);
+    m_file = -1;
+#endif
+    m_view = nullptr;
+}
+
+void MappedLogSink::Rotate() {
+    CloseSegment();
+    if (!OpenSegment()) {
+        return;
+    }
+    if (m_segmentHandler) {
+        m_inHandler = true;
+        m_segmentHandler();
+        m_inHandler = false;
+    }
+    m_headerEnd = m_position;
+}
+
+void MappedLogSink::Write(const char* data, size_t size) {
+    // Keep a record in one segment when it fits in an empty one
+    if (m_view && !m_inHandler && size > m_segmentBytes - m_position && m_position > m_headerEnd &&
+        size <= m_segmentBytes - m_headerEnd) {
+        Rotate();
+    }
+
+    while (size > 0) {
+        if (!m_view) {
+            m_droppedBytes += size;
+            return;
+        }
+        uint64_t room = m_segmentBytes - m_position;
+        if (room == 0) {
+            if (m_inHandler) {
+                m_droppedBytes += size;
+                return;
+            }
+            Rotate();
+            continue;
+        }
+        size_t chunk = static_cast<size_t>((std::min)(room, static_cast<uint64_t>(size)));
+        memcpy(m_view + m_position, data, chunk);
+        m_position += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+void MappedLogSink::Flush() {
+    if (!m_view || m_position == m_flushedPosition) {
+        return;
+    }
+#ifdef _WIN32
+    FlushViewOfFile(m_view + m_flushedPosition, static_cast<SIZE_T>(m_position - m_flushedPosition));
+#else
+    // msync wants a page aligned start
+    uint64_t start = m_flushedPosition & ~static_cast<uint64_t>(4095);
+    msync(m_view + start, static_cast<size_t>(m_position - start), MS_ASYNC);
+#endif
+    m_flushedPosition = m_position;
+}
+
+// The open segment counts at its full mapped size
+void MappedLogSink::RemoveOldSegments() {
+    RemoveSegmentsOver(m_directory, m_stem, m_extension, m_sequence, m_keepBytes);
+}
+
+CompressedLogSink::CompressedLogSink(size_t frameBytes, uint64_t segmentBytes, uint64_t keepBytes)
+    : m_frameBytes((std::min)((std::max)(frameBytes, static_cast<size_t>(4096)), Lz4::kMaxBlockBytes)),
+      m_segmentBytes(segmentBytes), m_keepBytes(keepBytes), m_sequence(0),
+      m_segmentRaw(0), m_headerEnd(0), m_inHandler(false), m_open(false), m_continuing(false),
+      m_stopping(false), m_rawBytes(0), m_compressedBytes(0), m_file(0) {
+}
+
+CompressedLogSink::~CompressedLogSink() {
+    Close();
+}
+
+bool CompressedLogSink::Open(const std::string& basePath) {
+    Close();
+
+    std::filesystem::path base(basePath);
+    m_directory = base.has_parent_path() ? base.parent_path().string() : ".";
+    m_stem = base.stem().string();
+    m_extension = base.extension().string() + ".lz4";
+    m_singlePath = basePath + ".lz4";
+
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+
+    if (m_segmentBytes > 0) {
+        m_sequence = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(m_directory, error)) {
+            uint64_t sequence = 0;
+            if (ParseSegmentName(entry.path().filename().string(), m_stem, m_extension, sequence)) {
+                m_sequence = (std::max)(m_sequence, sequence);
+            }
+        }
+    }
+    if (!OpenSegment()) {
+        return false;
+    }
+    m_continuing = m_segmentBytes == 0 && m_file.GetSize() > 0;
+
+    m_stopping = false;
+    m_writer = std::thread(&CompressedLogSink::RunWriter, this);
+    m_open = true;
+    m_segmentRaw = 0;
+    if (m_segmentHandler) {
+        m_inHandler = true;
+        m_segmentHandler();
+        m_inHandler = false;
+    }
+    m_headerEnd = m_segmentRaw;
+    return true;
+}
+
+void CompressedLogSink::Close() {
+    if (!m_open) {
+        return;
+    }
+    SealFrame();
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_stopping = true;
+        m_queueCv.notify_all();
+    }
+    m_writer.join();
+    m_file.Close();
+    m_open = false;
+    m_frame = Frame();
+}
+
+// Opens the single file or the next segment. Open calls it before the writer
+// starts; after that only the writer does, before the first frame of a
+// rotated segment.
+bool CompressedLogSink::OpenSegment() {
+    if (m_segmentBytes == 0) {
+        return m_file.Open(m_singlePath, false);
+    }
+    ++m_sequence;
+    if (!m_file.Open(SegmentPath(m_directory, m_stem, m_extension, m_sequence), true)) {
+        return false;
+    }
+    RemoveOldSegments();
+    return true;
+}
+
+// The new segment is still empty: the previous ones have all of keepBytes
+void CompressedLogSink::RemoveOldSegments() {
+    RemoveSegmentsOver(m_directory, m_stem, m_extension, m_sequence, m_keepBytes);
+}
+
+void CompressedLogSink::Write(const char* data, size_t size) {
+    if (!m_open) {
+        return;
+    }
+    // Segments are cut by uncompressed size, keeping a record in one segment
+    if (m_segmentBytes > 0 && !m_inHandler && m_segmentRaw + size > m_segmentBytes && m_segmentRaw > m_headerEnd) {
+        Rotate();
+    }
+    if (m_frame.data.empty()) {
+        m_frame.firstUs = WallClockUs();
+    }
+    m_frame.data.append(data, size);
+    m_segmentRaw += size;
+    if (m_frame.data.size() >= m_frameBytes) {
+        SealFrame();
+    }
+}
+
+void CompressedLogSink::Flush() {
+    if (m_open) {
+        SealFrame();
+    }
+}
+
+void CompressedLogSink::Rotate() {
+    SealFrame();
+    // The writer starts the next segment before the first frame written from here
+    m_frame.rotate = true;
+    m_segmentRaw = 0;
+    if (m_segmentHandler) {
+        m_inHandler = true;
+        m_segmentHandler();
+        m_inHandler = false;
+    }
+    m_headerEnd = m_segmentRaw;
+}
+
+void CompressedLogSink::SealFrame() {
+    if (m_frame.data.empty()) {
+        return;
+    }
+    m_frame.lastUs = WallClockUs();
+
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    m_queueCv.wait(lock, [this]() { return m_queue.size() < kMaxQueuedFrames; });
+    m_queue.push_back(std::move(m_frame));
+    m_frame = Frame();
+    if (!m_freeBuffers.empty()) {
+        m_frame.data.swap(m_freeBuffers.back());
+        m_freeBuffers.pop_back();
+    } else {
+        m_frame.data.reserve(m_frameBytes + m_frameBytes / 8);
+    }
+    m_queueCv.notify_all();
+}
+
+void CompressedLogSink::RunWriter() {
+    std::string out;
+    std::string scratch;
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    while (true) {
+        m_queueCv.wait(lock, [this]() { return !m_queue.empty() || m_stopping; });
+        if (m_queue.empty()) {
+            break;
+        }
+        Frame frame = std::move(m_queue.front());
+        m_queue.pop_front();
+        m_queueCv.notify_all();
+        lock.unlock();
+
+        if (frame.rotate && m_segmentBytes > 0) {
+            m_file.Close();
+            OpenSegment();
+        }
+
+        // The index goes first; its frame size is filled in once the frame is compressed
+        FrameIndex index;
+        index.firstUs = frame.firstUs;
+        index.lastUs = frame.lastUs;
+        index.rawBytes = static_cast<uint32_t>(frame.data.size());
+        index.frameBytes = 0;
+        out.clear();
+        Lz4::AppendSkippableFrame(out, &index, sizeof(index));
+        size_t frameStart = out.size();
+        Lz4::AppendFrame(out, frame.data.data(), frame.data.size(), scratch);
+        index.frameBytes = static_cast<uint32_t>(out.size() - frameStart);
+        memcpy(&out[frameStart - sizeof(index)], &index, sizeof(index));
+        m_file.Write(out.data(), out.size());
+
+        lock.lock();
+        m_rawBytes += frame.data.size();
+        m_compressedBytes += out.size();
+        if (m_freeBuffers.size() < kFreeFrameBuffers) {
+            frame.data.clear();
+            m_freeBuffers.push_back(std::move(frame.data));
+        }
+    }
+}
+
+uint64_t CompressedLogSink::GetRawBytes() const {
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    return m_rawBytes;
+}
+
+uint64_t CompressedLogSink::GetCompressedBytes() const {
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    return m_compressedBytes;
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Destination of the logger's bytes, text lines or binary records alike.
+// Calls are serialized by the logger.
+class ILogSink {
+public:
+    virtual ~ILogSink() {}
+
+    virtual void Write(const char* data, size_t size) = 0;
+    // Push buffered bytes to the OS
+    virtual void Flush() = 0;
+};
+
+// Appends to one file. With a buffer, bytes reach the file when it fills up
+// or on Flush; without one every Write is written and flushed at once.
+class FileLogSink : public ILogSink {
+public:
+    explicit FileLogSink(size_t bufferBytes = 0);
+    ~FileLogSink() override;
+
+    // Creates the parent directory if needed. `truncate` starts the file over.
+    bool Open(const std::string& path, bool truncate);
+    void Close();
+    bool IsOpen() const { return m_file.is_open(); }
+    // Bytes in the file, buffered ones included
+    uint64_t GetSize() const { return m_size; }
+
+    void Write(const char* data, size_t size) override;
+    void Flush() override;
+
+private:
+    std::ofstream m_file;
+    std::string m_buffer;
+    size_t m_bufferBytes;
+    uint64_t m_size;
+};
+
+// Text or binary log split into memory-mapped segment files of a fixed size.
+// Each segment is allocated at full size when it opens, so a Write is a
+// memcpy and a pointer bump with no system call. A record that does not fit
+// in the current segment starts the next one, unless it is larger than a
+// whole segment, in which case it is split. Segments are named
+// <stem>.<sequence><extension> after the base path. Every session starts a
+// new one; the newest segments are kept up to `keepBytes` on disk in all, so
+// short sessions do not push out the earlier ones. Close trims the last
+// segment to its data. After a crash the segment keeps its zero-filled tail,
+// which readers treat as the end.
+class MappedLogSink : public ILogSink {
+public:
+    MappedLogSink(uint64_t segmentBytes, uint64_t keepBytes);
+    ~MappedLogSink() override;
+
+    // Called at the start of every segment, e.g. to write a file header. It
+    // may Write; those bytes must fit in one segment.
+    void SetSegmentHandler(std::function<void()> handler) { m_segmentHandler = handler; }
+
+    bool Open(const std::string& basePath);
+    void Close();
+    bool IsOpen() const { return m_view != nullptr; }
+    std::string GetSegmentPath() const { return m_segmentPath; }
+    // Bytes that could not be written because no segment could be mapped
+    uint64_t GetDroppedBytes() const { return m_droppedBytes; }
+
+    void Write(const char* data, size_t size) override;
+    // Starts writing the dirty pages back without waiting for the disk
+    void Flush() override;
+
+private:
+    bool OpenSegment();
+    void CloseSegment();
+    void Rotate();
+    void RemoveOldSegments();
+
+    uint64_t m_segmentBytes;
+    uint64_t m_keepBytes;
+    std::function<void()> m_segmentHandler;
+
+    std::string m_directory;
+    std::string m_stem;
+    std::string m_extension;
+    uint64_t m_sequence;
+    std::string m_segmentPath;
+
+#ifdef _WIN32
+    void* m_file;
+    void* m_mapping;
+#else
+    int m_file;
+#endif
+    char* m_view;
+    uint64_t m_position;
+    uint64_t m_flushedPosition;
+    uint64_t m_headerEnd;       // Bytes written by the segment handler
+    bool m_inHandler;
+    uint64_t m_droppedBytes;
+};
+
+// Log bytes in LZ4 frames, for verbose sessions. Write only appends to the
+// open frame; a full frame (or Flush) is handed to the sink's writer thread,
+// which compresses and writes it, so the logging threads never pay for
+// compression. At most kMaxQueuedFrames wait for the writer; past that Write
+// blocks until it catches up. Frames still queued are lost if the process
+// dies; Close writes them all.
+//
+// Each LZ4 frame is preceded by a skippable frame with the wall clock range
+// of its bytes and both sizes (FrameIndex), so a reader can jump from frame to
+// frame and decompress only the time range it needs. The files decompress
+// with the stock `lz4 -d` as well.
+//
+// With segmentBytes > 0 output is split like MappedLogSink's segments, by
+// uncompressed size: <stem>.<sequence><extension>.lz4, the newest kept up to
+// `keepBytes` of compressed files. Otherwise frames are appended to
+// <base path>.lz4.
+class CompressedLogSink : public ILogSink {
+public:
+#pragma pack(push, 1)
+    struct FrameIndex {
+        int64_t firstUs;        // Wall clock of the first byte
+        int64_t lastUs;         // Wall clock when the frame was closed
+        uint32_t rawBytes;
+        uint32_t frameBytes;    // Size of the LZ4 frame that follows
+    };
+#pragma pack(pop)
+
+    static const size_t kDefaultFrameBytes = 256 * 1024;
+    static const size_t kMaxQueuedFrames = 16;
+
+    CompressedLogSink(size_t frameBytes, uint64_t segmentBytes, uint64_t keepBytes);
+    ~CompressedLogSink() override;
+
+    // Called at the start of every segment, as MappedLogSink's handler
+    void SetSegmentHandler(std::function<void()> handler) { m_segmentHandler = handler; }
+
+    bool Open(const std::string& basePath);
+    void Close();
+    // True when Open appended to a single file that already held frames, so
+    // a header in the first segment is already there
+    bool IsContinuingFile() const { return m_continuing; }
+    // Totals of the frames written so far
+    uint64_t GetRawBytes() const;
+    uint64_t GetCompressedBytes() const;
+
+    void Write(const char* data, size_t size) override;
+    // Hands the open frame to the writer; does not wait for it
+    void Flush() override;
+
+private:
+    struct Frame {
+        std::string data;
+        int64_t firstUs = 0;
+        int64_t lastUs = 0;
+        bool rotate = false;    // Start the next segment before this frame
+    };
+
+    void SealFrame();
+    void Rotate();
+    void RunWriter();
+    bool OpenSegment();
+    void RemoveOldSegments();
+
+    const size_t m_frameBytes;
+    const uint64_t m_segmentBytes;
+    const uint64_t m_keepBytes;
+    std::function<void()> m_segmentHandler;
+
+    std::string m_directory;
+    std::string m_stem;
+    std::string m_extension;
+    std::string m_singlePath;
+    uint64_t m_sequence;
+
+    // Producer side, serialized by the logger
+    Frame m_frame;
+    uint64_t m_segmentRaw;      // Uncompressed bytes in the current segment
+    uint64_t m_headerEnd;
+    bool m_inHandler;
+    bool m_open;
+    bool m_continuing;
+
+    mutable std::mutex m_queueMutex;
+    std::condition_variable m_queueCv;
+    std::deque<Frame> m_queue;
+    std::vector<std::string> m_freeBuffers;
+    bool m_stopping;
+    uint64_t m_rawBytes;
+    uint64_t m_compressedBytes;
+
+    // Writer thread only
+    FileLogSink m_file;
+    std::thread m_writer;
+};
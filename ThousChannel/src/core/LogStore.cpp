@@ -0,0 +1,259 @@
+#include "pch.h"
+#include "LogStore.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Longer lines are cut, so one line never takes a large share of the text ring
+const size_t kMaxLineBytes = 16 * 1024;
+
+} // namespace
+
+LogStore& LogStore::Instance() {
+    static LogStore store;
+    return store;
+}
+
+LogStore::LogStore(size_t maxLines, size_t maxTextBytes)
+    : m_maxLines((std::max)(maxLines, size_t(1))), m_maxTextBytes((std::max)(maxTextBytes, kMaxLineBytes)),
+      m_firstSeq(0), m_textEnd(0), m_changePending(false) {
+}
+
+void LogStore::Append(int64_t timeUs, uint32_t threadId, LogLevel level, LogCategory category, UserHandle user,
+                      std::string_view text) {
+    text = text.substr(0, kMaxLineBytes);
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        while (m_lines.size() >= m_maxLines ||
+               (!m_lines.empty() && m_textEnd + text.size() - m_lines.front().textPos > m_maxTextBytes)) {
+            EvictOldestLocked();
+        }
+
+        // The ring grows like a vector until it reaches its budget, then wraps
+        size_t offset = static_cast<size_t>(m_textEnd % m_maxTextBytes);
+        if (m_textEnd + text.size() <= m_maxTextBytes) {
+            if (m_text.size() < m_textEnd + text.size()) {
+                m_text.resize((std::min)(m_maxTextBytes, (std::max)(m_text.size() * 2, static_cast<size_t>(m_textEnd) + text.size())));
+            }
+        } else if (m_text.size() < m_maxTextBytes) {
+            m_text.resize(m_maxTextBytes);
+        }
+        size_t head = (std::min)(text.size(), m_maxTextBytes - offset);
+        memcpy(m_text.data() + offset, text.data(), head);
+        memcpy(m_text.data(), text.data() + head, text.size() - head);
+
+        Line line;
+        line.timeUs = timeUs;
+        line.textPos = m_textEnd;
+        line.textSize = static_cast<uint32_t>(text.size());
+        line.threadId = threadId;
+        line.user = user;
+        line.level = level;
+        line.category = category;
+        m_textEnd += text.size();
+
+        uint64_t seq = m_firstSeq + m_lines.size();
+        m_lines.push_back(line);
+        m_byLevel[static_cast<int>(level)].push_back(seq);
+        m_byCategory[static_cast<int>(category)].push_back(seq);
+        if (user != kInvalidUserHandle) {
+            m_byUser[user].push_back(seq);
+        }
+    }
+
+    if (!m_changePending.exchange(true, std::memory_order_acq_rel)) {
+        std::lock_guard<std::mutex> lock(m_handlerMutex);
+        if (m_changeHandler) {
+            m_changeHandler();
+        }
+    }
+}
+
+// The oldest line is at the front of every list it is in
+void LogStore::EvictOldestLocked() {
+    const Line& line = m_lines.front();
+    m_byLevel[static_cast<int>(line.level)].pop_front();
+    m_byCategory[static_cast<int>(line.category)].pop_front();
+    if (line.user != kInvalidUserHandle) {
+        auto it = m_byUser.find(line.user);
+        it->second.pop_front();
+        if (it->second.empty()) {
+            m_byUser.erase(it);
+        }
+    }
+    m_lines.pop_front();
+    ++m_firstSeq;
+}
+
+void LogStore::Clear() {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_firstSeq += m_lines.size();
+    m_lines.clear();
+    for (SeqList& list : m_byLevel) {
+        list.clear();
+    }
+    for (SeqList& list : m_byCategory) {
+        list.clear();
+    }
+    m_byUser.clear();
+    m_text.clear();
+    m_text.shrink_to_fit();
+    m_textEnd = 0;
+}
+
+std::string_view LogStore::TextLocked(const Line& line, std::string& scratch) const {
+    size_t offset = static_cast<size_t>(line.textPos % m_maxTextBytes);
+    if (offset + line.textSize <= m_maxTextBytes) {
+        return std::string_view(m_text.data() + offset, line.textSize);
+    }
+    size_t head = m_maxTextBytes - offset;
+    scratch.assign(m_text.data() + offset, head);
+    scratch.append(m_text.data(), line.textSize - head);
+    return scratch;
+}
+
+bool LogStore::MatchesLocked(const Line& line, const LogFilter& filter, std::string& scratch) const {
+    if (line.level < filter.minLevel) {
+        return false;
+    }
+    if ((filter.categoryMask & (1u << static_cast<int>(line.category))) == 0) {
+        return false;
+    }
+    if (filter.user != kInvalidUserHandle && line.user != filter.user) {
+        return false;
+    }
+    return filter.text.empty() || TextLocked(line, scratch).find(filter.text) != std::string_view::npos;
+}
+
+uint64_t LogStore::Query(const LogFilter& filter, uint64_t fromSeq, std::vector<uint64_t>& out) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    uint64_t endSeq = m_firstSeq + m_lines.size();
+    uint64_t from = (std::max)(fromSeq, m_firstSeq);
+    if (from >= endSeq) {
+        return endSeq;
+    }
+
+    // Walk the smallest candidate set: one user, the selected categories, the
+    // levels from the minimum up, or every line
+    std::vector<const SeqList*> lists;
+    size_t candidates = static_cast<size_t>(endSeq - from);
+    bool scanAll = true;
+    auto consider = [&](const std::vector<const SeqList*>& option) {
+        size_t size = 0;
+        for (const SeqList* list : option) {
+            size += list->size();
+        }
+        if (size < candidates) {
+            candidates = size;
+            lists = option;
+            scanAll = false;
+        }
+    };
+    if (filter.user != kInvalidUserHandle) {
+        auto it = m_byUser.find(filter.user);
+        if (it == m_byUser.end()) {
+            return endSeq;
+        }
+        consider({ &it->second });
+    }
+    if ((filter.categoryMask & LogFilter::kAllCategories) != LogFilter::kAllCategories) {
+        std::vector<const SeqList*> option;
+        for (int i = 0; i < kCategoryCount; ++i) {
+            if (filter.categoryMask & (1u << i)) {
+                option.push_back(&m_byCategory[i]);
+            }
+        }
+        consider(option);
+    }
+    if (filter.minLevel > LogLevel::Trace) {
+        std::vector<const SeqList*> option;
+        for (int i = static_cast<int>(filter.minLevel); i < kLevelCount; ++i) {
+            option.push_back(&m_byLevel[i]);
+        }
+        consider(option);
+    }
+
+    std::string scratch;
+    auto test = [&](uint64_t seq) {
+        if (MatchesLocked(m_lines[static_cast<size_t>(seq - m_firstSeq)], filter, scratch)) {
+            out.push_back(seq);
+        }
+    };
+    if (scanAll) {
+        for (uint64_t seq = from; seq < endSeq; ++seq) {
+            test(seq);
+        }
+    } else if (lists.size() == 1) {
+        const SeqList& list = *lists[0];
+        for (auto it = std::lower_bound(list.begin(), list.end(), from); it != list.end(); ++it) {
+            test(*it);
+        }
+    } else {
+        // Several lists: collect, then restore line order
+        std::vector<uint64_t> merged;
+        merged.reserve(candidates);
+        for (const SeqList* list : lists) {
+            merged.insert(merged.end(), std::lower_bound(list->begin(), list->end(), from), list->end());
+        }
+        std::sort(merged.begin(), merged.end());
+        for (uint64_t seq : merged) {
+            test(seq);
+        }
+    }
+    return endSeq;
+}
+
+bool LogStore::GetRecord(uint64_t seq, LogStoreRecord& record) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    if (seq < m_firstSeq || seq >= m_firstSeq + m_lines.size()) {
+        return false;
+    }
+    const Line& line = m_lines[static_cast<size_t>(seq - m_firstSeq)];
+    std::string scratch;
+    std::string_view text = TextLocked(line, scratch);
+    record.seq = seq;
+    record.timeUs = line.timeUs;
+    record.threadId = line.threadId;
+    record.level = line.level;
+    record.category = line.category;
+    record.user = line.user;
+    record.text.assign(text.data(), text.size());
+    return true;
+}
+
+uint64_t LogStore::GetFirstSeq() const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_firstSeq;
+}
+
+uint64_t LogStore::GetNextSeq() const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_firstSeq + m_lines.size();
+}
+
+size_t LogStore::GetMemoryUsage() const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    size_t seqs = 0;
+    for (const SeqList& list : m_byLevel) {
+        seqs += list.size();
+    }
+    for (const SeqList& list : m_byCategory) {
+        seqs += list.size();
+    }
+    for (const auto& entry : m_byUser) {
+        seqs += entry.second.size();
+    }
+    return sizeof(*this) + m_lines.size() * sizeof(Line) + m_text.capacity() + seqs * sizeof(uint64_t) +
+           m_byUser.size() * (sizeof(UserHandle) + sizeof(SeqList) + 2 * sizeof(void*));
+}
+
+void LogStore::SetChangeHandler(std::function<void()> handler) {
+    std::lock_guard<std::mutex> lock(m_handlerMutex);
+    m_changeHandler = std::move(handler);
+    m_changePending.store(false, std::memory_order_release);
+}
+
+void LogStore::AcknowledgeChange() {
+    m_changePending.store(false, std::memory_order_release);
+}
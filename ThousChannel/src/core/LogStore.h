@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Logger.h"
+#include "UserIdInterner.h"
+
+// One line read back from the store
+struct LogStoreRecord {
+    uint64_t seq;
+    int64_t timeUs;             // Wall clock
+    uint32_t threadId;
+    LogLevel level;
+    LogCategory category;
+    UserHandle user;            // kInvalidUserHandle if the line is about no user
+    std::string text;
+};
+
+struct LogFilter {
+    LogLevel minLevel = LogLevel::Trace;
+    uint32_t categoryMask = kAllCategories;     // Bit per LogCategory
+    UserHandle user = kInvalidUserHandle;       // kInvalidUserHandle matches every line
+    std::string text;                           // Substring, case sensitive; empty matches every line
+
+    static const uint32_t kAllCategories = (1u << static_cast<int>(LogCategory::Count)) - 1;
+};
+
+// The newest log lines of the session in memory, for the log pane. Lines are
+// numbered by a sequence that never repeats; the oldest ones are dropped once
+// either the line or the text budget is used, so memory does not grow with
+// the session. Besides the lines the store keeps the sequence numbers of every
+// level, category and user in order, and a query walks the smallest of those
+// lists instead of the whole session.
+//
+// A line's user comes from its call site (a LogUser argument, see Logger.h);
+// the text is not searched for ids.
+class LogStore {
+public:
+    static const size_t kDefaultMaxLines = 1000000;
+    static const size_t kDefaultMaxTextBytes = 64 * 1024 * 1024;
+
+    static LogStore& Instance();
+
+    LogStore(size_t maxLines = kDefaultMaxLines, size_t maxTextBytes = kDefaultMaxTextBytes);
+
+    void Append(int64_t timeUs, uint32_t threadId, LogLevel level, LogCategory category, UserHandle user,
+                std::string_view text);
+    void Clear();
+
+    // Appends the sequence numbers of lines at or after `fromSeq` that pass
+    // `filter`, in order, and returns the sequence to continue from
+    uint64_t Query(const LogFilter& filter, uint64_t fromSeq, std::vector<uint64_t>& out) const;
+    bool GetRecord(uint64_t seq, LogStoreRecord& record) const;
+
+    // Lines [GetFirstSeq(), GetNextSeq()) are held
+    uint64_t GetFirstSeq() const;
+    uint64_t GetNextSeq() const;
+    size_t GetMemoryUsage() const;
+
+    // Called on the appending thread (the logger's store thread) after new
+    // lines arrive, once until AcknowledgeChange; the log pane posts itself a
+    // message from it
+    void SetChangeHandler(std::function<void()> handler);
+    void AcknowledgeChange();
+
+private:
+    struct Line {
+        int64_t timeUs;
+        uint64_t textPos;       // Position in the text ring, counting every byte ever written
+        uint32_t textSize;
+        uint32_t threadId;
+        UserHandle user;
+        LogLevel level;
+        LogCategory category;
+    };
+
+    typedef std::deque<uint64_t> SeqList;
+
+    static const int kLevelCount = static_cast<int>(LogLevel::Fatal) + 1;
+    static const int kCategoryCount = static_cast<int>(LogCategory::Count);
+
+    void EvictOldestLocked();
+    std::string_view TextLocked(const Line& line, std::string& scratch) const;
+    bool MatchesLocked(const Line& line, const LogFilter& filter, std::string& scratch) const;
+
+    const size_t m_maxLines;
+    const size_t m_maxTextBytes;
+
+    mutable std::shared_mutex m_mutex;
+    std::deque<Line> m_lines;
+    uint64_t m_firstSeq;
+    std::vector<char> m_text;   // Grows to m_maxTextBytes, then wraps
+    uint64_t m_textEnd;         // Bytes ever written
+    SeqList m_byLevel[kLevelCount];
+    SeqList m_byCategory[kCategoryCount];
+    std::unordered_map<UserHandle, SeqList> m_byUser;
+
+    std::mutex m_handlerMutex;
+    std::function<void()> m_changeHandler;
+    std::atomic<bool> m_changePending;
+};
@@ -1,16 +1,510 @@
 #include "Logger.h"
+#include "FlightRecorder.h"
+#include "LogStore.h"
 #include <iostream>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
-#include <direct.h>
-#include <io.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <functional>
+#include <thread>
 
 #ifdef _WIN32
 #include <windows.h>
 #endif
 
-std::string Logger::formatMessage(LogLevel level, const std::string& message) {
+namespace {
+
+// Drop counts of quiet call sites are reported at most this often
+const int64_t kSuppressedFlushIntervalMs = 5000;
+
+// Lines waiting for the log store; past this they are dropped and counted
+const size_t kMaxStoreQueueBytes = 16 * 1024 * 1024;
+
+int64_t SteadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char* FileName(const char* path) {
+    const char* name = path;
+    for (const char* p = path; *p; ++p) {
+        if (*p == '/' || *p == '\\') {
+            name = p + 1;
+        }
+    }
+    return name;
+}
+
+int64_t WallClockUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int64_t SteadyNowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t CurrentThreadId() {
+#ifdef _WIN32
+    thread_local uint32_t id = GetCurrentThreadId();
+#else
+    thread_local uint32_t id = static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+#endif
+    return id;
+}
+
+bool ParseLevel(const std::string& text, LogLevel& level) {
+    static const char* const kNames[] = { "trace", "debug", "info", "warn", "error", "fatal" };
+    for (int i = 0; i < 6; ++i) {
+        if (text == kNames[i]) {
+            level = static_cast<LogLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+LogSiteLimiter::LogSiteLimiter(const char* file, int line, LogCategory category, LogLevel level, int burst, int perSecond)
+    : m_file(file), m_line(line), m_category(category), m_level(level),
+      m_burst((std::max)(burst, 1)), m_perSecond((std::max)(perSecond, 0)),
+      m_tokens(m_burst), m_lastRefillMs(SteadyNowMs()), m_suppressed(0) {
+    Logger::instance().registerSite(this);
+}
+
+LogSiteLimiter::~LogSiteLimiter() {
+    Logger::instance().unregisterSite(this);
+}
+
+bool LogSiteLimiter::acquire(uint32_t& suppressed) {
+    int64_t now = SteadyNowMs();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tokens = (std::min)(m_burst, m_tokens + (now - m_lastRefillMs) * m_perSecond / 1000.0);
+    m_lastRefillMs = now;
+    if (m_tokens < 1.0) {
+        ++m_suppressed;
+        suppressed = 0;
+        return false;
+    }
+    m_tokens -= 1.0;
+    suppressed = m_suppressed;
+    m_suppressed = 0;
+    return true;
+}
+
+uint32_t LogSiteLimiter::takeSuppressed() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t suppressed = m_suppressed;
+    m_suppressed = 0;
+    return suppressed;
+}
+
+Logger::Logger() : m_textSinkFailed(false), m_binary(false), m_lastEventUs(0), m_lastFlushMs(SteadyNowMs()) {
+    setLogLevel(LogLevel::Debug);
+    for (auto& formats : m_internalFormats) {
+        for (auto& format : formats) {
+            format.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+Logger::~Logger() {
+    setLogStore(nullptr);
+}
+
+void Logger::log(LogCategory category, LogLevel level, const std::string& message, UserHandle user) {
+    if (!isEnabled(category, level)) return;
+    flushSuppressedIfDue();
+    write(category, level, message, user);
+}
+
+void Logger::write(LogCategory category, LogLevel level, const std::string& message, UserHandle user) {
+    if (isBinary()) {
+        // Not logBinary's buffer: writeEvent may write a suppressed summary through here
+        std::string argBytes;
+        BinaryLog::AppendArgs(argBytes, message);
+        writeEvent(internalFormat(category, level), level, 1, argBytes, user);
+        return;
+    }
+
+    // Format with basic info
+    auto formatted = formatMessage(category, level, message);
+
+    // Thread-safe write
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        writeToFile(formatted);
+        writeToDebug(formatted);
+    }
+    if (m_storeAttached.load(std::memory_order_acquire)) {
+        StoreEntry entry = {};
+        entry.timeUs = WallClockUs();
+        entry.threadId = CurrentThreadId();
+        entry.user = user;
+        entry.level = level;
+        entry.category = category;
+        queueForStore(entry, message);
+    }
+    if (level == LogLevel::Fatal) {
+        dumpFlightRecorder();
+    }
+}
+
+// What led up to a fatal error, next to the log
+void Logger::dumpFlightRecorder() {
+    flush();
+    FlightRecorder::Instance().Dump("fatal");
+}
+
+bool Logger::admit(LogSiteLimiter& site) {
+    uint32_t suppressed = 0;
+    if (!site.acquire(suppressed)) {
+        return false;
+    }
+    if (suppressed > 0) {
+        write(site.getCategory(), site.getLevel(), StringFormat::format("Suppressed {} similar messages at {}:{}",
+            suppressed, FileName(site.getFile()), site.getLine()), kInvalidUserHandle);
+    }
+    return true;
+}
+
+void Logger::registerSite(LogSiteLimiter* site) {
+    std::lock_guard<std::mutex> lock(m_sitesMutex);
+    m_sites.push_back(site);
+}
+
+void Logger::unregisterSite(LogSiteLimiter* site) {
+    std::lock_guard<std::mutex> lock(m_sitesMutex);
+    m_sites.erase(std::remove(m_sites.begin(), m_sites.end(), site), m_sites.end());
+}
+
+bool Logger::setBinaryLogFile(const std::string& path) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_binarySink) {
+        m_binarySink->Flush();
+        m_binarySink.reset();
+    }
+    m_binary.store(false, std::memory_order_relaxed);
+    if (path.empty()) {
+        return true;
+    }
+
+    // Every file and segment starts with its own header and format table, so
+    // appended sessions and rotated segments decode on their own
+    m_lastEventUs = SteadyNowUs();
+    m_binarySink = openSink(path, [this](ILogSink& sink) { writeBinaryHeader(sink); });
+    if (!m_binarySink) {
+        return false;
+    }
+    m_binary.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+std::unique_ptr<ILogSink> Logger::openSink(const std::string& path, std::function<void(ILogSink&)> onSegment) {
+    if (m_compress) {
+        std::unique_ptr<CompressedLogSink> compressed(new CompressedLogSink(
+            CompressedLogSink::kDefaultFrameBytes, m_segmentBytes, m_keepBytes));
+        CompressedLogSink* sink = compressed.get();
+        compressed->SetSegmentHandler([sink, onSegment]() { onSegment(*sink); });
+        if (compressed->Open(path)) {
+            return compressed;
+        }
+    }
+    if (m_segmentBytes > 0) {
+        std::unique_ptr<MappedLogSink> mapped(new MappedLogSink(m_segmentBytes, m_keepBytes));
+        MappedLogSink* sink = mapped.get();
+        mapped->SetSegmentHandler([sink, onSegment]() { onSegment(*sink); });
+        if (mapped->Open(path)) {
+            return mapped;
+        }
+    }
+
+    // Unbuffered append, the single file layout; also when mapping failed.
+    // Buffered sinks are flushed at errors and on flush().
+    std::unique_ptr<FileLogSink> file(new FileLogSink(0));
+    if (!file->Open(path, false)) {
+        return nullptr;
+    }
+    onSegment(*file);
+    return file;
+}
+
+// Header of a binary log segment, anchored at the last event so the next
+// event's delta holds across a rotation
+void Logger::writeBinaryHeader(ILogSink& sink) {
+    int64_t wallClockUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count() - (SteadyNowUs() - m_lastEventUs);
+    std::string header(BinaryLog::kMagic, sizeof(BinaryLog::kMagic));
+    BinaryLog::AppendFixed64(header, static_cast<uint64_t>(wallClockUs));
+    BinaryLog::AppendFixed64(header, static_cast<uint64_t>(m_lastEventUs));
+    sink.Write(header.data(), header.size());
+    for (size_t i = 0; i < m_formats.size(); ++i) {
+        writeFormatRecord(sink, static_cast<uint32_t>(i + 1), m_formats[i]);
+    }
+}
+
+uint32_t Logger::registerFormat(LogCategory category, LogLevel level, const char* format, const char* file, int line) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    FormatSite site;
+    site.category = category;
+    site.level = level;
+    site.format = format;
+    site.file = FileName(file);
+    site.line = line;
+    m_formats.push_back(site);
+    uint32_t id = static_cast<uint32_t>(m_formats.size());
+    if (m_binarySink) {
+        writeFormatRecord(*m_binarySink, id, site);
+    }
+    return id;
+}
+
+uint32_t Logger::internalFormat(LogCategory category, LogLevel level) {
+    std::atomic<uint32_t>& slot = m_internalFormats[static_cast<size_t>(category)][static_cast<size_t>(level)];
+    uint32_t id = slot.load(std::memory_order_acquire);
+    if (id == 0) {
+        // A race registers the format twice, which only costs a record
+        id = registerFormat(category, level, "{}", __FILE__, __LINE__);
+        slot.store(id, std::memory_order_release);
+    }
+    return id;
+}
+
+// Not through m_record: a rotation may write the format table while an event is being written
+void Logger::writeFormatRecord(ILogSink& sink, uint32_t id, const FormatSite& site) {
+    std::string record;
+    record.push_back(static_cast<char>(BinaryLog::kFormatRecord));
+    BinaryLog::AppendVarint(record, id);
+    record.push_back(static_cast<char>(site.level));
+    record.push_back(static_cast<char>(site.category));
+    BinaryLog::AppendVarint(record, static_cast<uint32_t>(site.line));
+    BinaryLog::AppendBytes(record, site.file);
+    BinaryLog::AppendBytes(record, site.format);
+    sink.Write(record.data(), record.size());
+}
+
+void Logger::writeEvent(uint32_t formatId, LogLevel level, size_t argCount, const std::string& argBytes, UserHandle user) {
+    flushSuppressedIfDue();
+
+    int64_t nowUs = SteadyNowUs();
+    uint32_t threadId = CurrentThreadId();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_binarySink) {
+        return;
+    }
+    const FormatSite& site = m_formats[formatId - 1];
+    const char* format = site.format;
+    LogCategory category = site.category;
+    m_record.clear();
+    m_record.push_back(static_cast<char>(BinaryLog::kEventRecord));
+    BinaryLog::AppendSigned(m_record, nowUs - m_lastEventUs);
+    BinaryLog::AppendVarint(m_record, threadId);
+    BinaryLog::AppendVarint(m_record, formatId);
+    BinaryLog::AppendVarint(m_record, argCount);
+    m_record.append(argBytes);
+    m_binarySink->Write(m_record.data(), m_record.size());
+    m_lastEventUs = nowUs;
+    if (level >= LogLevel::Error) {
+        m_binarySink->Flush();
+    }
+    lock.unlock();
+
+    // Rendered on the store's thread, not here
+    if (m_storeAttached.load(std::memory_order_acquire)) {
+        StoreEntry entry = {};
+        entry.timeUs = WallClockUs();
+        entry.format = format;
+        entry.argCount = static_cast<uint32_t>(argCount);
+        entry.threadId = threadId;
+        entry.user = user;
+        entry.level = level;
+        entry.category = category;
+        queueForStore(entry, argBytes);
+    }
+    if (level == LogLevel::Fatal) {
+        dumpFlightRecorder();
+    }
+}
+
+void Logger::setLogStore(LogStore* store) {
+    // The old feeder appends what is queued before it exits
+    std::thread feeder;
+    {
+        std::lock_guard<std::mutex> lock(m_storeMutex);
+        m_storeAttached.store(false, std::memory_order_release);
+        m_storeStopping = true;
+        feeder.swap(m_storeThread);
+    }
+    m_storeCv.notify_all();
+    if (feeder.joinable()) {
+        feeder.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_storeMutex);
+    m_store = store;
+    m_storeStopping = false;
+    m_storeDropped = 0;
+    if (store) {
+        m_storeThread = std::thread(&Logger::runStoreFeeder, this);
+        m_storeAttached.store(true, std::memory_order_release);
+    }
+}
+
+void Logger::queueForStore(const StoreEntry& entry, std::string_view bytes) {
+    std::lock_guard<std::mutex> lock(m_storeMutex);
+    if (!m_store || m_storeStopping) {
+        return;
+    }
+    if (m_storeQueue.size() + sizeof(entry) + bytes.size() > kMaxStoreQueueBytes) {
+        ++m_storeDropped;
+        return;
+    }
+    bool wasEmpty = m_storeQueue.empty();
+    StoreEntry queued = entry;
+    queued.size = static_cast<uint32_t>(bytes.size());
+    m_storeQueue.append(reinterpret_cast<const char*>(&queued), sizeof(queued));
+    m_storeQueue.append(bytes.data(), bytes.size());
+    if (wasEmpty) {
+        m_storeCv.notify_one();
+    }
+}
+
+// Takes the whole queue at once, so the logging threads keep appending to an
+// empty buffer while a batch goes into the store
+void Logger::runStoreFeeder() {
+    std::string batch;
+    std::string text;
+    std::unique_lock<std::mutex> lock(m_storeMutex);
+    for (;;) {
+        m_storeCv.wait(lock, [this]() { return !m_storeQueue.empty() || m_storeStopping; });
+        if (m_storeQueue.empty()) {
+            return;
+        }
+        batch.clear();
+        batch.swap(m_storeQueue);
+        uint64_t dropped = m_storeDropped;
+        m_storeDropped = 0;
+        LogStore* store = m_store;
+        lock.unlock();
+
+        size_t pos = 0;
+        while (pos < batch.size()) {
+            StoreEntry entry;
+            memcpy(&entry, batch.data() + pos, sizeof(entry));
+            pos += sizeof(entry);
+            std::string_view bytes(batch.data() + pos, entry.size);
+            pos += entry.size;
+            if (entry.format) {
+                BinaryLog::Render(text, entry.format, bytes, entry.argCount);
+                bytes = text;
+            }
+            store->Append(entry.timeUs, entry.threadId, entry.level, entry.category, entry.user, bytes);
+        }
+        if (dropped > 0) {
+            store->Append(WallClockUs(), CurrentThreadId(), LogLevel::Warn, LogCategory::General, kInvalidUserHandle,
+                StringFormat::format("Log pane fell behind, {} lines not shown", dropped));
+        }
+        lock.lock();
+    }
+}
+
+void Logger::flush() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_textSink) {
+        m_textSink->Flush();
+    }
+    if (m_binarySink) {
+        m_binarySink->Flush();
+    }
+}
+
+void Logger::flushSuppressedIfDue() {
+    int64_t now = SteadyNowMs();
+    int64_t last = m_lastFlushMs.load(std::memory_order_relaxed);
+    if (now - last < kSuppressedFlushIntervalMs) return;
+    // One thread flushes per interval
+    if (!m_lastFlushMs.compare_exchange_strong(last, now, std::memory_order_relaxed)) return;
+    flushSuppressed();
+    flush();
+}
+
+void Logger::flushSuppressed() {
+    std::vector<std::pair<LogSiteLimiter*, uint32_t>> pending;
+    {
+        std::lock_guard<std::mutex> lock(m_sitesMutex);
+        for (LogSiteLimiter* site : m_sites) {
+            uint32_t suppressed = site->takeSuppressed();
+            if (suppressed > 0) {
+                pending.emplace_back(site, suppressed);
+            }
+        }
+    }
+    for (const auto& item : pending) {
+        LogSiteLimiter* site = item.first;
+        write(site->getCategory(), site->getLevel(), StringFormat::format("Suppressed {} similar messages at {}:{}",
+            item.second, FileName(site->getFile()), site->getLine()), kInvalidUserHandle);
+    }
+}
+
+void Logger::setLogLevel(LogLevel level) {
+    for (size_t i = 0; i < static_cast<size_t>(LogCategory::Count); ++i) {
+        setCategoryLevel(static_cast<LogCategory>(i), level);
+    }
+}
+
+bool Logger::setCategoryLevels(const std::string& spec) {
+    bool ok = true;
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) end = spec.size();
+        std::string item = spec.substr(start, end - start);
+        start = end + 1;
+
+        item.erase(std::remove_if(item.begin(), item.end(), [](unsigned char c) { return std::isspace(c) != 0; }), item.end());
+        std::transform(item.begin(), item.end(), item.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (item.empty()) continue;
+
+        size_t equals = item.find('=');
+        LogLevel level;
+        if (equals == std::string::npos || !ParseLevel(item.substr(equals + 1), level)) {
+            ok = false;
+            continue;
+        }
+        std::string name = item.substr(0, equals);
+        if (name == "*") {
+            setLogLevel(level);
+            continue;
+        }
+        bool known = false;
+        for (size_t i = 0; i < static_cast<size_t>(LogCategory::Count); ++i) {
+            if (name == getCategoryName(static_cast<LogCategory>(i))) {
+                setCategoryLevel(static_cast<LogCategory>(i), level);
+                known = true;
+            }
+        }
+        ok = ok && known;
+    }
+    return ok;
+}
+
+const char* Logger::getCategoryName(LogCategory category) {
+    switch (category) {
+        case LogCategory::General: return "general";
+        case LogCategory::Rte:     return "rte";
+        case LogCategory::Ui:      return "ui";
+        case LogCategory::Token:   return "token";
+        case LogCategory::Layout:  return "layout";
+        default:                   return "unknown";
+    }
+}
+
+std::string Logger::formatMessage(LogCategory category, LogLevel level, const std::string& message) {
     std::ostringstream oss;
     
     // Timestamp
@@ -21,6 +515,11 @@ std::string Logger::formatMessage(LogLevel level, const std::string& message) {
     
     // Log level (fixed spacing - no extra space after level)
     oss << "[" << getLevelString(level) << "] ";
+
+    // Category, untagged lines are general
+    if (category != LogCategory::General) {
+        oss << "[" << getCategoryName(category) << "] ";
+    }
     
     // Message
     oss << message;
@@ -29,33 +528,30 @@ std::string Logger::formatMessage(LogLevel level, const std::string& message) {
 }
 
 void Logger::writeToFile(const std::string& message) {
-    // Ensure log directory exists
-    std::string logPath = m_logPath;
-    size_t lastSlash = logPath.find_last_of("/\\");
-    if (lastSlash != std::string::npos) {
-        std::string logDir = logPath.substr(0, lastSlash);
-        if (!logDir.empty()) {
-            // Create directory using Windows API
-            _mkdir(logDir.c_str());
-        }
-    }
-    
-    // Open file if not already open
-    if (!m_logFile.is_open()) {
-        m_logFile.open(m_logPath, std::ios::app | std::ios::binary);
-        if (m_logFile.tellp() == 0) {
-            // Write UTF-8 BOM for new files
-            m_logFile.write("\xEF\xBB\xBF", 3);
-        }
+    // Open file if not already open; an open failure is not retried
+    if (!m_textSink && !m_textSinkFailed) {
+        m_textSink = openSink(m_logPath, [](ILogSink& sink) {
+            // Every new file and segment starts with a UTF-8 BOM, compressed
+            // ones too, so each opens on its own once decompressed. A file
+            // continued from an earlier session already has one.
+            FileLogSink* file = dynamic_cast<FileLogSink*>(&sink);
+            CompressedLogSink* compressed = dynamic_cast<CompressedLogSink*>(&sink);
+            if ((!file || file->GetSize() == 0) && (!compressed || !compressed->IsContinuingFile())) {
+                sink.Write("\xEF\xBB\xBF", 3);
+            }
+        });
+        m_textSinkFailed = !m_textSink;
     }
-    
-    if (m_logFile.is_open()) {
-        m_logFile << message << std::endl;
-        m_logFile.flush();
+    if (!m_textSink) {
+        return;
     }
+
+    std::string line = message;
+    line.push_back('\n');
+    m_textSink->Write(line.data(), line.size());
 }
 
-void Logger::writeToDebug(const std::string& message) {
+void Logger::writeToDebug([[maybe_unused]] const std::string& message) {
 #ifdef _DEBUG
 #ifdef _WIN32
     // Windows debug output
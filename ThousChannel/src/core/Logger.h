@@ -7,6 +7,17 @@
 #include <sstream>
 #include <chrono>
 #include <iomanip>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "LogSink.h"
+#include "BinaryLog.h"
+#include "UserIdInterner.h"
 
 // Simple string formatting for C++17 compatibility
 namespace StringFormat {
@@ -110,6 +121,36 @@ namespace StringFormat {
     }
 }
 
+class LogStore;
+
+// User id argument of the LOG_* macros, e.g. LOG_INFO_FMT("User left: {}",
+// LogUser(user)). Written like the id string; the log pane also files the
+// line under that user.
+struct LogUser {
+    explicit LogUser(UserHandle user) : handle(user) {}
+    operator std::string_view() const { return UserIdString(handle); }
+
+    UserHandle handle;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const LogUser& user) {
+    return out << UserIdString(user.handle);
+}
+
+// Handle of the first LogUser argument, or kInvalidUserHandle
+inline UserHandle LogUserOf() {
+    return kInvalidUserHandle;
+}
+
+template<typename T, typename... Rest>
+UserHandle LogUserOf(const T& first, const Rest&... rest) {
+    if constexpr (std::is_same_v<T, LogUser>) {
+        return first.handle;
+    } else {
+        return LogUserOf(rest...);
+    }
+}
+
 // Modern C++ logging levels
 enum class LogLevel : uint8_t {
     Trace = 0,
@@ -120,6 +161,50 @@ enum class LogLevel : uint8_t {
     Fatal = 5
 };
 
+// Subsystems whose levels are set separately at runtime
+enum class LogCategory : uint8_t {
+    General = 0,
+    Rte = 1,
+    Ui = 2,
+    Token = 3,
+    Layout = 4,
+    Count
+};
+
+// Token bucket of one log call site: `burst` lines at once, then `perSecond`.
+// Lines over the limit are only counted; the count is reported by a
+// "suppressed N similar messages" line when the site is allowed to write
+// again, or by the logger's periodic flush if it stays quiet.
+class LogSiteLimiter {
+public:
+    LogSiteLimiter(const char* file, int line, LogCategory category, LogLevel level, int burst, int perSecond);
+    ~LogSiteLimiter();
+
+    // True if the line may be written. `suppressed` gets the lines dropped
+    // since the last one written and is reset.
+    bool acquire(uint32_t& suppressed);
+    // Drop count not reported yet, reset
+    uint32_t takeSuppressed();
+
+    const char* getFile() const { return m_file; }
+    int getLine() const { return m_line; }
+    LogCategory getCategory() const { return m_category; }
+    LogLevel getLevel() const { return m_level; }
+
+private:
+    const char* m_file;
+    int m_line;
+    LogCategory m_category;
+    LogLevel m_level;
+    double m_burst;
+    double m_perSecond;
+
+    std::mutex m_mutex;
+    double m_tokens;
+    int64_t m_lastRefillMs;
+    uint32_t m_suppressed;
+};
+
 // Thread-safe singleton logger
 class Logger {
 public:
@@ -129,19 +214,45 @@ public:
     }
 
     // Simple string logging for C++17 compatibility
-    void log(LogLevel level, const std::string& message) {
-        if (level < m_minLevel) return;
-        
-        // Format with basic info
-        auto formatted = formatMessage(level, message);
-        
-        // Thread-safe write
-        {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            writeToFile(formatted);
-            writeToDebug(formatted);
-        }
+    void log(LogLevel level, const std::string& message) { log(LogCategory::General, level, message); }
+    void log(LogCategory category, LogLevel level, const std::string& message, UserHandle user = kInvalidUserHandle);
+
+    // Checked by the macros before the message is formatted
+    bool isEnabled(LogCategory category, LogLevel level) const {
+        return static_cast<uint8_t>(level) >=
+               m_categoryLevels[static_cast<size_t>(category)].load(std::memory_order_relaxed);
+    }
+
+    // Rate limit check of a call site; writes the suppressed summary of the site if it has one
+    bool admit(LogSiteLimiter& site);
+    void registerSite(LogSiteLimiter* site);
+    void unregisterSite(LogSiteLimiter* site);
+    // Report the drop counts of every call site now, e.g. before exit
+    void flushSuppressed();
+
+    // Binary log: the macros write compact records (BinaryLog.h) to `path`
+    // instead of text lines to the log file, without formatting anything.
+    // Render it with decode_log.py. An empty path goes back to text.
+    bool setBinaryLogFile(const std::string& path);
+    bool isBinary() const { return m_binary.load(std::memory_order_relaxed); }
+    // Id of a call site's format string; the macros call it once per site
+    uint32_t registerFormat(LogCategory category, LogLevel level, const char* format, const char* file, int line);
+    template<typename... Args>
+    void logBinary(uint32_t formatId, LogLevel level, const Args&... args) {
+        thread_local std::string argBytes;
+        argBytes.clear();
+        BinaryLog::AppendArgs(argBytes, args...);
+        writeEvent(formatId, level, sizeof...(Args), argBytes, LogUserOf(args...));
     }
+    // Push buffered log bytes to disk
+    void flush();
+    // Every line written also goes to `store` (the log pane), in text and
+    // binary mode. The logging threads only queue the line; a thread of the
+    // logger renders binary records and appends them, so the store's change
+    // handler runs there. nullptr detaches, after the queued lines are in
+    // the store; detach before the store is destroyed. Not thread-safe,
+    // call from one thread.
+    void setLogStore(LogStore* store);
 
     // Convenience methods
     void trace(const std::string& message) { log(LogLevel::Trace, message); }
@@ -151,43 +262,180 @@ public:
     void error(const std::string& message) { log(LogLevel::Error, message); }
     void fatal(const std::string& message) { log(LogLevel::Fatal, message); }
 
-    // Configuration
-    void setLogLevel(LogLevel level) { m_minLevel = level; }
+    // Configuration. setLogLevel sets every category.
+    void setLogLevel(LogLevel level);
+    void setCategoryLevel(LogCategory category, LogLevel level) {
+        m_categoryLevels[static_cast<size_t>(category)].store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+    }
+    LogLevel getCategoryLevel(LogCategory category) const {
+        return static_cast<LogLevel>(m_categoryLevels[static_cast<size_t>(category)].load(std::memory_order_relaxed));
+    }
+    // Comma separated "category=level" pairs, e.g. "rte=debug,ui=warn"; "*" sets
+    // every category. Returns false if any pair was not understood.
+    bool setCategoryLevels(const std::string& spec);
     void setLogFile(const std::string& path) { m_logPath = path; }
+    // Text and binary logs go to memory-mapped segments of `segmentBytes`,
+    // keeping the newest up to `keepBytes` in all (see MappedLogSink). 0
+    // appends to the log file itself. Applies to files opened afterwards.
+    void setLogRotation(uint64_t segmentBytes, uint64_t keepBytes) {
+        m_segmentBytes = segmentBytes;
+        m_keepBytes = keepBytes;
+    }
+    // Text and binary logs are written as LZ4 frames by a writer thread (see
+    // CompressedLogSink), split by the rotation above; files get ".lz4"
+    // appended. Applies to files opened afterwards.
+    void setLogCompression(bool compress) { m_compress = compress; }
+
+    static const char* getCategoryName(LogCategory category);
 
 private:
-    Logger() = default;
-    ~Logger() = default;
+    Logger();
+    ~Logger();
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
 
-    std::string formatMessage(LogLevel level, const std::string& message);
+    struct FormatSite {
+        LogCategory category;
+        LogLevel level;
+        const char* format;
+        const char* file;
+        int line;
+    };
+
+    // A line queued for the log store, followed by its bytes: the text, or
+    // the encoded arguments of `format`
+    struct StoreEntry {
+        int64_t timeUs;
+        const char* format;     // nullptr for a text line
+        uint32_t size;
+        uint32_t argCount;
+        uint32_t threadId;
+        UserHandle user;
+        LogLevel level;
+        LogCategory category;
+    };
+
+    void write(LogCategory category, LogLevel level, const std::string& message, UserHandle user);
+    void writeEvent(uint32_t formatId, LogLevel level, size_t argCount, const std::string& argBytes, UserHandle user);
+    void queueForStore(const StoreEntry& entry, std::string_view bytes);
+    void runStoreFeeder();
+    void writeFormatRecord(ILogSink& sink, uint32_t id, const FormatSite& site);
+    void writeBinaryHeader(ILogSink& sink);
+    std::unique_ptr<ILogSink> openSink(const std::string& path, std::function<void(ILogSink&)> onSegment);
+    uint32_t internalFormat(LogCategory category, LogLevel level);
+    void flushSuppressedIfDue();
+    void dumpFlightRecorder();
+    std::string formatMessage(LogCategory category, LogLevel level, const std::string& message);
     void writeToFile(const std::string& message);
     void writeToDebug(const std::string& message);
     std::string getCurrentTime();
     std::string getLevelString(LogLevel level);
 
     std::mutex m_mutex;
-    std::ofstream m_logFile;
+    std::unique_ptr<ILogSink> m_textSink;     // Opened by the first text line
+    bool m_textSinkFailed;
     std::string m_logPath = "logs/modern_log.txt";
-    LogLevel m_minLevel = LogLevel::Debug;
+    uint64_t m_segmentBytes = 16 * 1024 * 1024;
+    uint64_t m_keepBytes = 256 * 1024 * 1024;
+    bool m_compress = false;
+
+    // Binary log, guarded by m_mutex
+    std::atomic<bool> m_binary;
+    std::unique_ptr<ILogSink> m_binarySink;
+    std::vector<FormatSite> m_formats;      // Format id - 1 -> call site
+    int64_t m_lastEventUs;
+    std::string m_record;
+    std::atomic<uint32_t> m_internalFormats[static_cast<size_t>(LogCategory::Count)][6];    // Logger's own lines
+    std::atomic<uint8_t> m_categoryLevels[static_cast<size_t>(LogCategory::Count)];
+
+    std::mutex m_sitesMutex;
+    std::vector<LogSiteLimiter*> m_sites;
+    std::atomic<int64_t> m_lastFlushMs;
+
+    // Log store feed, guarded by m_storeMutex. Logging threads append
+    // entries to m_storeQueue; m_storeThread takes the whole queue at once.
+    std::atomic<bool> m_storeAttached{false};   // Checked before taking the mutex
+    std::mutex m_storeMutex;
+    std::condition_variable m_storeCv;
+    LogStore* m_store = nullptr;
+    bool m_storeStopping = false;
+    std::string m_storeQueue;
+    uint64_t m_storeDropped = 0;                // Lines not queued because the queue was full
+    std::thread m_storeThread;
 };
 
-// Simple macro definitions for C++17 compatibility
-#define LOG_TRACE(msg) Logger::instance().trace(msg)
-#define LOG_DEBUG(msg) Logger::instance().debug(msg)
-#define LOG_INFO(msg)  Logger::instance().info(msg)
-#define LOG_WARN(msg)  Logger::instance().warn(msg)
-#define LOG_ERROR(msg) Logger::instance().error(msg)
-#define LOG_FATAL(msg) Logger::instance().fatal(msg)
+// Category of the LOG_* macros; define it before including this header to
+// tag every line of a file, e.g. LogCategory::Rte
+#ifndef LOG_CATEGORY
+#define LOG_CATEGORY LogCategory::General
+#endif
+
+// Default limit of LOG_*_LIMITED call sites
+#define LOG_SITE_BURST 10
+#define LOG_SITE_PER_SECOND 2
+
+// Simple macro definitions for C++17 compatibility. The level is checked
+// before the message is built; in binary mode nothing is formatted and each
+// expansion registers its format string once.
+#define LOG_CAT(category, level, msg) \
+    do { \
+        Logger& logger_ = Logger::instance(); \
+        if (logger_.isEnabled(category, level)) { \
+            if (logger_.isBinary()) { \
+                static const uint32_t logFormat_ = logger_.registerFormat(category, level, "{}", __FILE__, __LINE__); \
+                logger_.logBinary(logFormat_, level, msg); \
+            } else { \
+                logger_.log(category, level, msg); \
+            } \
+        } \
+    } while(0)
+
+// Body of the formatted macros, for a logger whose level check passed
+#define LOG_EMIT_FMT_(logger, category, level, fmt, ...) \
+    if (logger.isBinary()) { \
+        static const uint32_t logFormat_ = logger.registerFormat(category, level, fmt, __FILE__, __LINE__); \
+        logger.logBinary(logFormat_, level, __VA_ARGS__); \
+    } else { \
+        logger.log(category, level, StringFormat::format(fmt, __VA_ARGS__), LogUserOf(__VA_ARGS__)); \
+    }
+
+#define LOG_TRACE(msg) LOG_CAT(LOG_CATEGORY, LogLevel::Trace, msg)
+#define LOG_DEBUG(msg) LOG_CAT(LOG_CATEGORY, LogLevel::Debug, msg)
+#define LOG_INFO(msg)  LOG_CAT(LOG_CATEGORY, LogLevel::Info, msg)
+#define LOG_WARN(msg)  LOG_CAT(LOG_CATEGORY, LogLevel::Warn, msg)
+#define LOG_ERROR(msg) LOG_CAT(LOG_CATEGORY, LogLevel::Error, msg)
+#define LOG_FATAL(msg) LOG_CAT(LOG_CATEGORY, LogLevel::Fatal, msg)
 
 // Formatted logging macros
-#define LOG_TRACE_FMT(fmt, ...) Logger::instance().trace(StringFormat::format(fmt, __VA_ARGS__))
-#define LOG_DEBUG_FMT(fmt, ...) Logger::instance().debug(StringFormat::format(fmt, __VA_ARGS__))
-#define LOG_INFO_FMT(fmt, ...)  Logger::instance().info(StringFormat::format(fmt, __VA_ARGS__))
-#define LOG_WARN_FMT(fmt, ...)  Logger::instance().warn(StringFormat::format(fmt, __VA_ARGS__))
-#define LOG_ERROR_FMT(fmt, ...) Logger::instance().error(StringFormat::format(fmt, __VA_ARGS__))
-#define LOG_FATAL_FMT(fmt, ...) Logger::instance().fatal(StringFormat::format(fmt, __VA_ARGS__))
+#define LOG_CAT_FMT(category, level, fmt, ...) \
+    do { \
+        Logger& logger_ = Logger::instance(); \
+        if (logger_.isEnabled(category, level)) { \
+            LOG_EMIT_FMT_(logger_, category, level, fmt, __VA_ARGS__) \
+        } \
+    } while(0)
+
+#define LOG_TRACE_FMT(fmt, ...) LOG_CAT_FMT(LOG_CATEGORY, LogLevel::Trace, fmt, __VA_ARGS__)
+#define LOG_DEBUG_FMT(fmt, ...) LOG_CAT_FMT(LOG_CATEGORY, LogLevel::Debug, fmt, __VA_ARGS__)
+#define LOG_INFO_FMT(fmt, ...)  LOG_CAT_FMT(LOG_CATEGORY, LogLevel::Info, fmt, __VA_ARGS__)
+#define LOG_WARN_FMT(fmt, ...)  LOG_CAT_FMT(LOG_CATEGORY, LogLevel::Warn, fmt, __VA_ARGS__)
+#define LOG_ERROR_FMT(fmt, ...) LOG_CAT_FMT(LOG_CATEGORY, LogLevel::Error, fmt, __VA_ARGS__)
+#define LOG_FATAL_FMT(fmt, ...) LOG_CAT_FMT(LOG_CATEGORY, LogLevel::Fatal, fmt, __VA_ARGS__)
+
+// Rate limited call sites, for lines written per user or per window on hot
+// paths. Every expansion is its own site with its own token bucket.
+#define LOG_CAT_LIMITED_FMT(category, level, fmt, ...) \
+    do { \
+        static LogSiteLimiter logSite_(__FILE__, __LINE__, category, level, LOG_SITE_BURST, LOG_SITE_PER_SECOND); \
+        Logger& logger_ = Logger::instance(); \
+        if (logger_.isEnabled(category, level) && logger_.admit(logSite_)) { \
+            LOG_EMIT_FMT_(logger_, category, level, fmt, __VA_ARGS__) \
+        } \
+    } while(0)
+
+#define LOG_DEBUG_LIMITED_FMT(fmt, ...) LOG_CAT_LIMITED_FMT(LOG_CATEGORY, LogLevel::Debug, fmt, __VA_ARGS__)
+#define LOG_INFO_LIMITED_FMT(fmt, ...)  LOG_CAT_LIMITED_FMT(LOG_CATEGORY, LogLevel::Info, fmt, __VA_ARGS__)
+#define LOG_WARN_LIMITED_FMT(fmt, ...)  LOG_CAT_LIMITED_FMT(LOG_CATEGORY, LogLevel::Warn, fmt, __VA_ARGS__)
 
 // Conditional logging macros
 #define LOG_DEBUG_IF(condition, msg) \
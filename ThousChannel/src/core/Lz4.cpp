@@ -0,0 +1,193 @@
+#include "pch.h"
+#include "Lz4.h"
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const uint32_t kPrime1 = 2654435761u;
+const uint32_t kPrime2 = 2246822519u;
+const uint32_t kPrime3 = 3266489917u;
+const uint32_t kPrime4 = 668265263u;
+const uint32_t kPrime5 = 374761393u;
+
+// Block format limits: a match is at least 4 bytes, the last match starts at
+// least 12 bytes before the end and the last 5 bytes are always literals
+const size_t kMinMatch = 4;
+const size_t kMatchStartLimit = 12;
+const size_t kLastLiterals = 5;
+const size_t kMaxOffset = 65535;
+
+const int kHashLog = 16;
+
+// Misses in a row before the search starts skipping, as in LZ4's fast mode
+const int kSkipTrigger = 6;
+
+uint32_t Read32(const char* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint32_t RotateLeft(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+uint32_t Round(uint32_t acc, uint32_t input) {
+    return RotateLeft(acc + input * kPrime2, 13) * kPrime1;
+}
+
+uint32_t Hash(uint32_t sequence) {
+    return (sequence * kPrime1) >> (32 - kHashLog);
+}
+
+void PutLength(char*& out, size_t length) {
+    while (length >= 255) {
+        *out++ = static_cast<char>(255);
+        length -= 255;
+    }
+    *out++ = static_cast<char>(length);
+}
+
+void PutLe32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>(value >> (i * 8)));
+    }
+}
+
+// One sequence: literals, then a match of `matchLength` at `offset` (none for the last)
+void PutSequence(char*& out, const char* literals, size_t literalLength, size_t offset, size_t matchLength) {
+    char* token = out++;
+    size_t matchCode = matchLength ? matchLength - kMinMatch : 0;
+    *token = static_cast<char>(((literalLength < 15 ? literalLength : 15) << 4) | (matchCode < 15 ? matchCode : 15));
+    if (literalLength >= 15) {
+        PutLength(out, literalLength - 15);
+    }
+    memcpy(out, literals, literalLength);
+    out += literalLength;
+    if (matchLength == 0) {
+        return;
+    }
+    *out++ = static_cast<char>(offset);
+    *out++ = static_cast<char>(offset >> 8);
+    if (matchCode >= 15) {
+        PutLength(out, matchCode - 15);
+    }
+}
+
+} // namespace
+
+namespace Lz4 {
+
+uint32_t XxHash32(const void* data, size_t size, uint32_t seed) {
+    const char* p = static_cast<const char*>(data);
+    const char* end = p + size;
+    uint32_t hash;
+    if (size >= 16) {
+        uint32_t v1 = seed + kPrime1 + kPrime2;
+        uint32_t v2 = seed + kPrime2;
+        uint32_t v3 = seed;
+        uint32_t v4 = seed - kPrime1;
+        for (; p + 16 <= end; p += 16) {
+            v1 = Round(v1, Read32(p));
+            v2 = Round(v2, Read32(p + 4));
+            v3 = Round(v3, Read32(p + 8));
+            v4 = Round(v4, Read32(p + 12));
+        }
+        hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+    } else {
+        hash = seed + kPrime5;
+    }
+    hash += static_cast<uint32_t>(size);
+    for (; p + 4 <= end; p += 4) {
+        hash = RotateLeft(hash + Read32(p) * kPrime3, 17) * kPrime4;
+    }
+    for (; p < end; ++p) {
+        hash = RotateLeft(hash + static_cast<uint8_t>(*p) * kPrime5, 11) * kPrime1;
+    }
+    hash ^= hash >> 15;
+    hash *= kPrime2;
+    hash ^= hash >> 13;
+    hash *= kPrime3;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+size_t CompressBlock(const char* src, size_t size, char* dst) {
+    char* out = dst;
+    size_t anchor = 0;
+    if (size > kMatchStartLimit) {
+        // Positions + 1 of the last 4-byte sequence with each hash, 0 for none
+        thread_local std::vector<uint32_t> table;
+        table.assign(size_t(1) << kHashLog, 0);
+
+        const size_t matchStartLimit = size - kMatchStartLimit;
+        const size_t matchEndLimit = size - kLastLiterals;
+        size_t pos = 0;
+        int misses = 0;
+        while (pos < matchStartLimit) {
+            uint32_t sequence = Read32(src + pos);
+            uint32_t& slot = table[Hash(sequence)];
+            size_t candidate = slot;
+            slot = static_cast<uint32_t>(pos + 1);
+            if (candidate == 0 || pos - (candidate - 1) > kMaxOffset || Read32(src + candidate - 1) != sequence) {
+                pos += 1 + (misses++ >> kSkipTrigger);
+                continue;
+            }
+            misses = 0;
+            size_t match = candidate - 1;
+
+            // Grow the match backwards over pending literals, then forwards
+            while (pos > anchor && match > 0 && src[pos - 1] == src[match - 1]) {
+                --pos;
+                --match;
+            }
+            size_t length = kMinMatch;
+            while (pos + length < matchEndLimit && src[pos + length] == src[match + length]) {
+                ++length;
+            }
+
+            PutSequence(out, src + anchor, pos - anchor, pos - match, length);
+            pos += length;
+            anchor = pos;
+            // Positions inside the match are not hashed; the one before the end is
+            if (pos - 2 < matchStartLimit) {
+                table[Hash(Read32(src + pos - 2))] = static_cast<uint32_t>(pos - 2 + 1);
+            }
+        }
+    }
+    PutSequence(out, src + anchor, size - anchor, 0, 0);
+    return static_cast<size_t>(out - dst);
+}
+
+void AppendFrame(std::string& out, const char* data, size_t size, std::string& scratch) {
+    // FLG: version 01, independent blocks; BD: 4MB blocks
+    const char descriptor[2] = { 0x60, 0x70 };
+    PutLe32(out, kFrameMagic);
+    out.append(descriptor, sizeof(descriptor));
+    out.push_back(static_cast<char>(XxHash32(descriptor, sizeof(descriptor), 0) >> 8));
+
+    for (size_t done = 0; done < size; ) {
+        size_t blockSize = (size - done < kMaxBlockBytes) ? size - done : kMaxBlockBytes;
+        scratch.resize(CompressBound(blockSize));
+        size_t compressed = CompressBlock(data + done, blockSize, &scratch[0]);
+        if (compressed < blockSize) {
+            PutLe32(out, static_cast<uint32_t>(compressed));
+            out.append(scratch.data(), compressed);
+        } else {
+            // High bit: stored uncompressed
+            PutLe32(out, static_cast<uint32_t>(blockSize) | 0x80000000u);
+            out.append(data + done, blockSize);
+        }
+        done += blockSize;
+    }
+    PutLe32(out, 0);
+}
+
+void AppendSkippableFrame(std::string& out, const void* data, uint32_t size) {
+    PutLe32(out, kSkippableMagic);
+    PutLe32(out, size);
+    out.append(static_cast<const char*>(data), size);
+}
+
+} // namespace Lz4
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// The parts of LZ4 the compressed log sink needs, written against the LZ4
+// block and frame format specifications so the files open with the stock
+// `lz4` tool: a block compressor (greedy, one hash table, the speed class of
+// LZ4's default level), xxHash32 for the frame descriptor checksum, and
+// writers for the frame layout.
+namespace Lz4 {
+
+constexpr uint32_t kFrameMagic = 0x184D2204;
+// Skippable frames are ignored by LZ4 decoders; 0x184D2A50..5F are allowed
+constexpr uint32_t kSkippableMagic = 0x184D2A50;
+// Largest block of the frames written here (block maximum size id 7)
+constexpr size_t kMaxBlockBytes = 4 * 1024 * 1024;
+
+uint32_t XxHash32(const void* data, size_t size, uint32_t seed);
+
+// Worst case compressed size of `size` bytes
+inline size_t CompressBound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+// Compresses `size` bytes (at most kMaxBlockBytes) into `dst`, which must hold
+// CompressBound(size). Returns the compressed size.
+size_t CompressBlock(const char* src, size_t size, char* dst);
+
+// Appends one LZ4 frame holding `size` bytes: independent blocks, no content
+// checksum. Blocks that do not shrink are stored as they are.
+void AppendFrame(std::string& out, const char* data, size_t size, std::string& scratch);
+
+// Appends a skippable frame carrying `size` bytes of user data
+void AppendSkippableFrame(std::string& out, const void* data, uint32_t size);
+
+} // namespace Lz4
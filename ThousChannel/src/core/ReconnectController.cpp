@@ -0,0 +1,180 @@
+#include "pch.h"
+#include "ReconnectController.h"
+#define LOG_CATEGORY LogCategory::Rte
+#include "Logger.h"
+#include <algorithm>
+#include <cmath>
+
+ReconnectController::ReconnectController()
+    : m_inOutage(false), m_loopRunning(false), m_stopping(false),
+      m_rng(std::random_device()()) {
+}
+
+ReconnectController::~ReconnectController() {
+    Stop();
+}
+
+void ReconnectController::SetPolicy(const ReconnectPolicy& policy) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_policy = policy;
+}
+
+void ReconnectController::SetCallbacks(AttemptFunc attempt, RestoredFunc onRestored, GaveUpFunc onGaveUp) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_attempt = attempt;
+    m_onRestored = onRestored;
+    m_onGaveUp = onGaveUp;
+}
+
+void ReconnectController::OnLinkLost(bool sdkRetrying) {
+    std::thread finished;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping) {
+            return;
+        }
+
+        if (!m_inOutage) {
+            m_inOutage = true;
+            m_outageStart = std::chrono::steady_clock::now();
+            LOG_WARN_FMT("ReconnectController: connection lost, sdk retrying={}", sdkRetrying);
+        }
+
+        if (sdkRetrying || m_loopRunning) {
+            return;
+        }
+
+        // Reap the thread of a previous outage before starting a new one
+        finished = std::move(m_thread);
+        m_loopRunning = true;
+    }
+
+    if (finished.joinable()) {
+        finished.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stopping || !m_loopRunning) {
+        return;     // Stop() ran while the old thread was being joined
+    }
+    m_thread = std::thread(&ReconnectController::AttemptLoop, this);
+}
+
+void ReconnectController::OnLinkRestored() {
+    RestoredFunc onRestored;
+    long long outageMs = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_inOutage || m_loopRunning || m_stopping) {
+            return;
+        }
+        m_inOutage = false;
+        outageMs = OutageMs();
+        onRestored = m_onRestored;
+    }
+
+    LOG_INFO_FMT("ReconnectController: sdk reconnected after {}ms", outageMs);
+    if (onRestored) {
+        onRestored(outageMs, 0);
+    }
+}
+
+bool ReconnectController::IsInOutage() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_inOutage;
+}
+
+void ReconnectController::Stop() {
+    std::thread thread;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        thread = std::move(m_thread);
+        m_cv.notify_all();
+    }
+
+    if (thread.joinable()) {
+        thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = false;
+    m_inOutage = false;
+    m_loopRunning = false;
+}
+
+int ReconnectController::ComputeDelayMs(const ReconnectPolicy& policy, int attempt, std::mt19937& rng) {
+    double cap = policy.initialDelayMs * std::pow(policy.multiplier, attempt);
+    cap = std::min(cap, static_cast<double>(policy.maxDelayMs));
+    int capMs = std::max(1, static_cast<int>(cap));
+
+    // Keep half of the delay fixed so a retry never fires immediately,
+    // and randomize the other half so many clients do not retry in lockstep
+    std::uniform_int_distribution<int> jitter(std::max(1, capMs / 2), capMs);
+    return jitter(rng);
+}
+
+long long ReconnectController::OutageMs() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - m_outageStart).count();
+}
+
+void ReconnectController::AttemptLoop() {
+    int attempt = 0;
+    while (true) {
+        AttemptFunc attemptFunc;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            int delayMs = ComputeDelayMs(m_policy, attempt, m_rng);
+            LOG_INFO_FMT("ReconnectController: attempt {} in {}ms", attempt + 1, delayMs);
+
+            m_cv.wait_for(lock, std::chrono::milliseconds(delayMs), [this]() { return m_stopping; });
+            if (m_stopping) {
+                m_loopRunning = false;
+                return;
+            }
+            attemptFunc = m_attempt;
+        }
+
+        bool ok = attemptFunc ? attemptFunc(attempt) : false;
+        ++attempt;
+
+        RestoredFunc onRestored;
+        GaveUpFunc onGaveUp;
+        long long outageMs = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopping) {
+                m_loopRunning = false;
+                return;
+            }
+
+            bool gaveUp = !ok && m_policy.maxAttempts > 0 && attempt >= m_policy.maxAttempts;
+            if (!ok && !gaveUp) {
+                continue;
+            }
+
+            m_inOutage = false;
+            m_loopRunning = false;
+            outageMs = OutageMs();
+            if (ok) {
+                onRestored = m_onRestored;
+            } else {
+                onGaveUp = m_onGaveUp;
+            }
+        }
+
+        if (ok) {
+            LOG_INFO_FMT("ReconnectController: reconnected after {}ms, {} attempts", outageMs, attempt);
+            if (onRestored) {
+                onRestored(outageMs, attempt);
+            }
+        } else {
+            LOG_ERROR_FMT("ReconnectController: giving up after {}ms, {} attempts", outageMs, attempt);
+            if (onGaveUp) {
+                onGaveUp(outageMs, attempt);
+            }
+        }
+        return;
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <random>
+
+// Backoff parameters for ReconnectController
+struct ReconnectPolicy {
+    int initialDelayMs;     // Delay before the first attempt
+    int maxDelayMs;         // Upper bound for a single delay
+    double multiplier;      // Growth factor per failed attempt
+    int maxAttempts;        // 0 = retry until stopped
+
+    ReconnectPolicy()
+        : initialDelayMs(500), maxDelayMs(30000), multiplier(2.0), maxAttempts(0) {
+    }
+};
+
+// Tracks one connection outage and, when the SDK has given up, retries with
+// jittered exponential backoff until an attempt succeeds.
+//
+// Outage lifecycle:
+//   OnLinkLost(true)   SDK is still retrying on its own, only the outage clock starts
+//   OnLinkLost(false)  SDK gave up, start our own attempt loop
+//   OnLinkRestored()   SDK reconnected by itself (ignored while our loop runs,
+//                      the attempt result decides instead)
+// Exactly one of the restored / gave-up callbacks fires per outage.
+class ReconnectController {
+public:
+    // Runs on the controller thread; return true once the channel is fully rejoined
+    typedef std::function<bool(int attempt)> AttemptFunc;
+    typedef std::function<void(long long outageMs, int attempts)> RestoredFunc;
+    typedef std::function<void(long long outageMs, int attempts)> GaveUpFunc;
+
+    ReconnectController();
+    ~ReconnectController();
+
+    void SetPolicy(const ReconnectPolicy& policy);
+    void SetCallbacks(AttemptFunc attempt, RestoredFunc onRestored, GaveUpFunc onGaveUp);
+
+    void OnLinkLost(bool sdkRetrying);
+    void OnLinkRestored();
+
+    bool IsInOutage() const;
+
+    // Cancel any outage in progress and join the attempt thread.
+    // Must not be called from inside the callbacks.
+    void Stop();
+
+    // Delay before attempt number `attempt` (0 based): a random value in
+    // [cap / 2, cap] where cap = min(maxDelayMs, initialDelayMs * multiplier^attempt)
+    static int ComputeDelayMs(const ReconnectPolicy& policy, int attempt, std::mt19937& rng);
+
+private:
+    ReconnectController(const ReconnectController&) = delete;
+    ReconnectController& operator=(const ReconnectController&) = delete;
+
+    void AttemptLoop();
+    long long OutageMs() const;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::thread m_thread;
+
+    ReconnectPolicy m_policy;
+    AttemptFunc m_attempt;
+    RestoredFunc m_onRestored;
+    GaveUpFunc m_onGaveUp;
+
+    bool m_inOutage;
+    bool m_loopRunning;
+    bool m_stopping;
+    std::chrono::steady_clock::time_point m_outageStart;
+    std::mt19937 m_rng;
+};
@@ -0,0 +1,108 @@
+#include "pch.h"
+#include "RteAsyncOperation.h"
+#define LOG_CATEGORY LogCategory::Rte
+#include "Logger.h"
+#include <vector>
+
+RteCancellationToken::RteCancellationToken() {
+}
+
+RteCancellationToken::RteCancellationToken(std::shared_ptr<State> state)
+    : m_state(state) {
+}
+
+bool RteCancellationToken::IsCancelled() const {
+    if (!m_state) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->cancelled;
+}
+
+int RteCancellationToken::Register(std::function<void()> listener) const {
+    if (!m_state) {
+        return 0;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        if (!m_state->cancelled) {
+            int id = m_state->nextId++;
+            m_state->listeners[id] = listener;
+            return id;
+        }
+    }
+
+    // Already cancelled, run outside the lock
+    listener();
+    return 0;
+}
+
+void RteCancellationToken::Unregister(int id) const {
+    if (!m_state || id == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    m_state->listeners.erase(id);
+}
+
+RteCancellationSource::RteCancellationSource()
+    : m_state(std::make_shared<RteCancellationToken::State>()) {
+}
+
+RteCancellationToken RteCancellationSource::GetToken() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return RteCancellationToken(m_state);
+}
+
+void RteCancellationSource::Cancel() {
+    std::shared_ptr<RteCancellationToken::State> state;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        state = m_state;
+    }
+
+    std::vector<std::function<void()>> listeners;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->cancelled) {
+            return;
+        }
+        state->cancelled = true;
+        for (auto& pair : state->listeners) {
+            listeners.push_back(pair.second);
+        }
+        state->listeners.clear();
+    }
+
+    LOG_INFO_FMT("RteCancellationSource: cancelling {} pending operations", listeners.size());
+    for (auto& listener : listeners) {
+        listener();
+    }
+}
+
+bool RteCancellationSource::IsCancelled() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<std::mutex> stateLock(m_state->mutex);
+    return m_state->cancelled;
+}
+
+void RteCancellationSource::Reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_state = std::make_shared<RteCancellationToken::State>();
+}
+
+const char* GetRteOpStatusString(RteOpStatus status) {
+    switch (status) {
+        case RteOpStatus::Pending:   return "pending";
+        case RteOpStatus::Succeeded: return "succeeded";
+        case RteOpStatus::Failed:    return "failed";
+        case RteOpStatus::TimedOut:  return "timed out";
+        case RteOpStatus::Cancelled: return "cancelled";
+        default:                     return "unknown";
+    }
+}
+
+void LogRteLateCompletion(const std::string& name, RteOpStatus finalStatus) {
+    LOG_WARN_FMT("Dropping late callback for {}, operation already {}", name, GetRteOpStatusString(finalStatus));
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <functional>
+
+// Shared cancellation flag. Copies refer to the same state; cancelling wakes every
+// operation created with the token. A default constructed token is never cancelled.
+class RteCancellationToken {
+public:
+    RteCancellationToken();
+
+    bool IsCancelled() const;
+
+    // Run `listener` once when the token is cancelled (immediately if it already is).
+    // Returns an id for Unregister, or 0 if the listener already ran or the token cannot be cancelled.
+    int Register(std::function<void()> listener) const;
+    void Unregister(int id) const;
+
+private:
+    friend class RteCancellationSource;
+
+    struct State {
+        std::mutex mutex;
+        bool cancelled;
+        int nextId;
+        std::map<int, std::function<void()>> listeners;
+
+        State() : cancelled(false), nextId(1) {}
+    };
+
+    explicit RteCancellationToken(std::shared_ptr<State> state);
+
+    std::shared_ptr<State> m_state;
+};
+
+// Owner side of a cancellation token
+class RteCancellationSource {
+public:
+    RteCancellationSource();
+
+    RteCancellationToken GetToken() const;
+    void Cancel();
+    bool IsCancelled() const;
+
+    // Start a fresh token; operations holding the old one stay cancelled
+    void Reset();
+
+private:
+    mutable std::mutex m_mutex;
+    std::shared_ptr<RteCancellationToken::State> m_state;
+};
+
+enum class RteOpStatus {
+    Pending,
+    Succeeded,
+    Failed,
+    TimedOut,
+    Cancelled
+};
+
+const char* GetRteOpStatusString(RteOpStatus status);
+
+// Logs a callback that arrived after its operation already finished
+void LogRteLateCompletion(const std::string& name, RteOpStatus finalStatus);
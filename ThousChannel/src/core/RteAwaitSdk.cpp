@@ -0,0 +1,64 @@
+#include "pch.h"
+#include "RteAwaitSdk.h"
+
+RteCallbackAwaiter<bool> RteAwaitInitMediaEngine(rte::Rte* engine, int timeoutMs,
+                                                 const RteCancellationToken& token) {
+    return RteCallbackAwaiter<bool>("init_media_engine", timeoutMs, token, [engine](RteCompletion<bool> done) {
+        engine->InitMediaEngine(RteErrorCallback(done, true), nullptr);
+    });
+}
+
+RteCallbackAwaiter<bool> RteAwaitConnect(rte::LocalUser* user, int timeoutMs,
+                                         const RteCancellationToken& token) {
+    return RteCallbackAwaiter<bool>("connect_local_user", timeoutMs, token, [user](RteCompletion<bool> done) {
+        user->Connect(RteErrorCallback(done, true));
+    });
+}
+
+RteCallbackAwaiter<bool> RteAwaitDisconnect(rte::LocalUser* user, int timeoutMs,
+                                            const RteCancellationToken& token) {
+    return RteCallbackAwaiter<bool>("disconnect_local_user", timeoutMs, token, [user](RteCompletion<bool> done) {
+        user->Disconnect(RteErrorCallback(done, true));
+    });
+}
+
+RteCallbackAwaiter<bool> RteAwaitStartTrack(rte::MicAudioTrack* track, int timeoutMs,
+                                            const RteCancellationToken& token) {
+    return RteCallbackAwaiter<bool>("start_mic_track", timeoutMs, token, [track](RteCompletion<bool> done) {
+        track->Start(RteErrorCallback(done, true));
+    });
+}
+
+RteCallbackAwaiter<bool> RteAwaitStartTrack(rte::CameraVideoTrack* track, int timeoutMs,
+                                            const RteCancellationToken& token) {
+    return RteCallbackAwaiter<bool>("start_camera_track", timeoutMs, token, [track](RteCompletion<bool> done) {
+        track->Start(RteErrorCallback(done, true));
+    });
+}
+
+RteCallbackAwaiter<bool> RteAwaitPublish(rte::Channel* channel, rte::LocalStream* stream, int timeoutMs,
+                                         const RteCancellationToken& token) {
+    return RteCallbackAwaiter<bool>("publish_stream", timeoutMs, token, [channel, stream](RteCompletion<bool> done) {
+        channel->PublishStream(stream, RteErrorCallback(done, true));
+    });
+}
+
+RteCallbackAwaiter<std::shared_ptr<rte::Track>> RteAwaitSubscribe(rte::Channel* channel, const std::string& streamId,
+                                                                   rte::TrackMediaType mediaType, int timeoutMs,
+                                                                   const RteCancellationToken& token) {
+    typedef std::shared_ptr<rte::Track> TrackPtr;
+    return RteCallbackAwaiter<TrackPtr>("subscribe:" + streamId, timeoutMs, token,
+        [channel, streamId, mediaType](RteCompletion<TrackPtr> done) {
+            rte::SubscribeOptions options;
+            options.SetTrackMediaType(mediaType);
+            channel->SubscribeTrack(streamId, &options, [done](rte::Track* track, rte::Error* err) {
+                // The SDK hands over a heap allocated wrapper; take ownership either way
+                TrackPtr owned(track);
+                if (err && err->Code() == kRteOk) {
+                    done.Resolve(owned);
+                } else {
+                    done.Fail(err ? err->Code() : -1);
+                }
+            });
+        });
+}
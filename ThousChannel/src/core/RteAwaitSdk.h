@@ -0,0 +1,42 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "rte_cpp.h"
+#include "RteCoroutine.h"
+
+// Awaitable adaptors for the rte:: calls RteManager uses. Kept apart from
+// RteCoroutine.h so the coroutine layer itself does not depend on the SDK.
+
+// Callback for SDK calls that only report an rte::Error
+template<typename T>
+std::function<void(rte::Error*)> RteErrorCallback(RteCompletion<T> done, T successValue) {
+    return [done, successValue](rte::Error* err) {
+        if (err && err->Code() == kRteOk) {
+            done.Resolve(successValue);
+        } else {
+            done.Fail(err ? err->Code() : -1);
+        }
+    };
+}
+
+RteCallbackAwaiter<bool> RteAwaitInitMediaEngine(rte::Rte* engine, int timeoutMs,
+                                                 const RteCancellationToken& token);
+RteCallbackAwaiter<bool> RteAwaitConnect(rte::LocalUser* user, int timeoutMs,
+                                         const RteCancellationToken& token);
+RteCallbackAwaiter<bool> RteAwaitDisconnect(rte::LocalUser* user, int timeoutMs,
+                                            const RteCancellationToken& token);
+RteCallbackAwaiter<bool> RteAwaitStartTrack(rte::MicAudioTrack* track, int timeoutMs,
+                                            const RteCancellationToken& token);
+RteCallbackAwaiter<bool> RteAwaitStartTrack(rte::CameraVideoTrack* track, int timeoutMs,
+                                            const RteCancellationToken& token);
+RteCallbackAwaiter<bool> RteAwaitPublish(rte::Channel* channel, rte::LocalStream* stream, int timeoutMs,
+                                         const RteCancellationToken& token);
+
+// Subscribed track, owned by the caller. A track delivered after a timeout or
+// cancel is released by the awaiter.
+RteCallbackAwaiter<std::shared_ptr<rte::Track>> RteAwaitSubscribe(rte::Channel* channel, const std::string& streamId,
+                                                                   rte::TrackMediaType mediaType, int timeoutMs,
+                                                                   const RteCancellationToken& token);
@@ -0,0 +1,8 @@
+#include "pch.h"
+#include "RteCoroutine.h"
+#define LOG_CATEGORY LogCategory::Rte
+#include "Logger.h"
+
+void LogRteTaskException(const char* what) {
+    LOG_ERROR_FMT("RteTask failed: {}", what);
+}
@@ -0,0 +1,469 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <future>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <functional>
+#include <utility>
+#include <type_traits>
+
+#include "RteEventLoop.h"
+#include "RteAsyncOperation.h"
+
+// Coroutine layer over the callback based rte:: API. The SDK call adaptors
+// (RteAwaitConnect etc.) live in RteAwaitSdk.h; this header does not need the SDK.
+//
+//   RteTask<bool> RteManager::JoinChannelAsync(std::string channelId, std::string token) {
+//       RteAwaitResult<bool> connected = co_await RteAwaitConnect(m_localUser.get(), 5000, token);
+//       ...
+//   }
+//
+// A task is lazy: it starts when awaited by another task, or when handed to
+// RteSpawn / RteSyncWait, which start it on an RteEventLoop. While suspended
+// on an SDK callback no thread is blocked; the coroutine resumes on the loop
+// it was running on. Coroutine parameters are copied into the frame, so pass
+// strings by value, never by reference.
+
+// Reports an exception escaping a spawned task, or a misuse of RteSyncWait
+void LogRteTaskException(const char* what);
+
+template<typename T>
+struct RteAwaitResult {
+    RteOpStatus status;
+    T value;
+    int errorCode;
+
+    RteAwaitResult() : status(RteOpStatus::Pending), value(), errorCode(0) {}
+    bool Succeeded() const { return status == RteOpStatus::Succeeded; }
+};
+
+template<typename T>
+class RteTask;
+
+namespace rte_coro_detail {
+
+class PromiseBase {
+public:
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            std::coroutine_handle<> continuation = handle.promise().m_continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() { m_error = std::current_exception(); }
+
+    void SetContinuation(std::coroutine_handle<> continuation) { m_continuation = continuation; }
+    void RethrowIfFailed() const {
+        if (m_error) {
+            std::rethrow_exception(m_error);
+        }
+    }
+
+private:
+    std::coroutine_handle<> m_continuation;
+    std::exception_ptr m_error;
+};
+
+template<typename T>
+class Promise : public PromiseBase {
+public:
+    RteTask<T> get_return_object();
+    void return_value(T value) { m_value = std::move(value); }
+    T TakeValue() {
+        RethrowIfFailed();
+        return std::move(*m_value);
+    }
+
+private:
+    std::optional<T> m_value;
+};
+
+template<>
+class Promise<void> : public PromiseBase {
+public:
+    RteTask<void> get_return_object();
+    void return_void() {}
+    void TakeValue() { RethrowIfFailed(); }
+};
+
+// Fire-and-forget coroutine, frees itself when it finishes
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() { return DetachedTask(); }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+} // namespace rte_coro_detail
+
+// Lazily started coroutine producing a T. Move only; awaiting it runs it to
+// completion and resumes the awaiting coroutine (symmetric transfer, no extra hop).
+template<typename T>
+class RteTask {
+public:
+    typedef rte_coro_detail::Promise<T> promise_type;
+    typedef std::coroutine_handle<promise_type> Handle;
+
+    RteTask() {}
+    explicit RteTask(Handle handle) : m_handle(handle) {}
+    RteTask(RteTask&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+    RteTask& operator=(RteTask&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+    ~RteTask() { Reset(); }
+
+    bool IsValid() const { return static_cast<bool>(m_handle); }
+
+    bool await_ready() const noexcept { return !m_handle || m_handle.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        m_handle.promise().SetContinuation(awaiting);
+        return m_handle;
+    }
+    T await_resume() { return m_handle.promise().TakeValue(); }
+
+private:
+    RteTask(const RteTask&) = delete;
+    RteTask& operator=(const RteTask&) = delete;
+
+    void Reset() {
+        if (m_handle) {
+            m_handle.destroy();
+            m_handle = nullptr;
+        }
+    }
+
+    Handle m_handle;
+};
+
+namespace rte_coro_detail {
+
+template<typename T>
+RteTask<T> Promise<T>::get_return_object() {
+    return RteTask<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline RteTask<void> Promise<void>::get_return_object() {
+    return RteTask<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+template<typename T, typename Callback>
+DetachedTask RunDetached(RteTask<T> task, Callback onDone) {
+    try {
+        if constexpr (std::is_void<T>::value) {
+            co_await task;
+            onDone();
+        } else {
+            onDone(co_await task);
+        }
+    } catch (const std::exception& e) {
+        LogRteTaskException(e.what());
+    } catch (...) {
+        LogRteTaskException("unknown exception");
+    }
+}
+
+template<typename T>
+DetachedTask RunToPromise(RteTask<T> task, std::shared_ptr<std::promise<T>> result) {
+    try {
+        if constexpr (std::is_void<T>::value) {
+            co_await task;
+            result->set_value();
+        } else {
+            result->set_value(co_await task);
+        }
+    } catch (...) {
+        result->set_exception(std::current_exception());
+    }
+}
+
+} // namespace rte_coro_detail
+
+// Start `task` on `loop` without waiting for it. `onDone` runs on the loop with the
+// result (no argument for RteTask<void>). Returns false if the loop is stopped.
+template<typename T, typename Callback>
+bool RteSpawn(RteEventLoop& loop, RteTask<T> task, Callback onDone) {
+    auto holder = std::make_shared<RteTask<T>>(std::move(task));
+    return loop.Post([holder, onDone]() {
+        rte_coro_detail::RunDetached(std::move(*holder), onDone);
+    }, "task_spawn");
+}
+
+template<typename T>
+bool RteSpawn(RteEventLoop& loop, RteTask<T> task) {
+    if constexpr (std::is_void<T>::value) {
+        return RteSpawn(loop, std::move(task), []() {});
+    } else {
+        return RteSpawn(loop, std::move(task), [](T) {});
+    }
+}
+
+// Run `task` on `loop` and block the calling thread until it finishes.
+// For callers outside the coroutine world (UI commands, JoinOrchestrator steps).
+// Calling it on the loop thread would deadlock; that is reported and a default value returned.
+template<typename T>
+T RteSyncWait(RteEventLoop& loop, RteTask<T> task) {
+    if (loop.IsCurrentThread()) {
+        LogRteTaskException("RteSyncWait called on its own loop thread");
+        if constexpr (!std::is_void<T>::value) {
+            return T();
+        } else {
+            return;
+        }
+    }
+
+    auto result = std::make_shared<std::promise<T>>();
+    std::future<T> future = result->get_future();
+    auto holder = std::make_shared<RteTask<T>>(std::move(task));
+    bool posted = loop.Post([holder, result]() {
+        rte_coro_detail::RunToPromise(std::move(*holder), result);
+    }, "task_sync_wait");
+    if (!posted) {
+        LogRteTaskException("RteSyncWait on a stopped loop");
+        if constexpr (!std::is_void<T>::value) {
+            return T();
+        } else {
+            return;
+        }
+    }
+    return future.get();
+}
+
+// Completion handle passed to the SDK call wrapped by RteCallbackAwaiter.
+// Copies share one state; the first Resolve / Fail wins, later ones are dropped.
+template<typename T>
+class RteCompletion;
+
+// Awaitable for one callback based SDK call, with a deadline and a cancellation
+// token. co_await yields an RteAwaitResult<T>. Deadlines are driven by the loop
+// the awaiting coroutine runs on.
+template<typename T>
+class RteCallbackAwaiter {
+public:
+    typedef std::function<void(RteCompletion<T>)> Starter;
+
+    RteCallbackAwaiter(const std::string& name, int timeoutMs, const RteCancellationToken& token, Starter starter)
+        : m_state(std::make_shared<State>()), m_starter(std::move(starter)) {
+        m_state->name = name;
+        m_state->timeoutMs = timeoutMs;
+        m_state->token = token;
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+        std::shared_ptr<State> state = m_state;
+        RteEventLoop* loop = RteEventLoop::Current();
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->handle = handle;
+            state->loop = loop;
+            state->suspending = true;
+        }
+
+        std::weak_ptr<State> weakState = state;
+        int listenerId = state->token.Register([weakState]() {
+            if (auto locked = weakState.lock()) {
+                Complete(locked, RteOpStatus::Cancelled, T(), 0);
+            }
+        });
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->listenerId = state->done ? 0 : listenerId;
+        }
+
+        if (loop && state->timeoutMs > 0) {
+            loop->PostDelayed(state->timeoutMs, [weakState]() {
+                if (auto locked = weakState.lock()) {
+                    Complete(locked, RteOpStatus::TimedOut, T(), 0);
+                }
+            }, "op_deadline");
+        }
+
+        if (!IsDone(state) && m_starter) {
+            m_starter(RteCompletion<T>(state));
+        }
+
+        // Finished synchronously (pre-cancelled token, SDK error reported inline):
+        // do not suspend at all
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->suspending = false;
+        return !state->done;
+    }
+
+    RteAwaitResult<T> await_resume() {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        return m_state->result;
+    }
+
+private:
+    friend class RteCompletion<T>;
+
+    struct State {
+        std::mutex mutex;
+        std::string name;
+        int timeoutMs;
+        RteCancellationToken token;
+        int listenerId;
+        std::coroutine_handle<> handle;
+        RteEventLoop* loop;
+        bool suspending;
+        bool done;
+        RteAwaitResult<T> result;
+
+        State() : timeoutMs(0), listenerId(0), loop(nullptr), suspending(false), done(false) {}
+    };
+
+    static bool IsDone(const std::shared_ptr<State>& state) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->done;
+    }
+
+    static bool Complete(const std::shared_ptr<State>& state, RteOpStatus status, T value, int errorCode) {
+        std::coroutine_handle<> handle;
+        RteEventLoop* loop = nullptr;
+        int listenerId = 0;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->done) {
+                if (status == RteOpStatus::Succeeded || status == RteOpStatus::Failed) {
+                    LogRteLateCompletion(state->name, state->result.status);
+                }
+                return false;
+            }
+            state->done = true;
+            state->result.status = status;
+            state->result.value = std::move(value);
+            state->result.errorCode = errorCode;
+            listenerId = state->listenerId;
+            state->listenerId = 0;
+            if (!state->suspending) {
+                handle = state->handle;
+                loop = state->loop;
+            }
+        }
+
+        state->token.Unregister(listenerId);
+
+        // Completed inside await_suspend: it returns false and the coroutine continues there
+        if (!handle) {
+            return true;
+        }
+
+        // SDK callbacks arrive on SDK threads; hop back to the coroutine's loop
+        if (!loop || !loop->Post([handle]() { handle.resume(); }, "op_resume")) {
+            handle.resume();
+        }
+        return true;
+    }
+
+    std::shared_ptr<State> m_state;
+    Starter m_starter;
+};
+
+template<typename T>
+class RteCompletion {
+public:
+    typedef typename RteCallbackAwaiter<T>::State State;
+
+    explicit RteCompletion(std::shared_ptr<State> state) : m_state(std::move(state)) {}
+
+    bool Resolve(T value) const {
+        return RteCallbackAwaiter<T>::Complete(m_state, RteOpStatus::Succeeded, std::move(value), 0);
+    }
+    bool Fail(int errorCode) const {
+        return RteCallbackAwaiter<T>::Complete(m_state, RteOpStatus::Failed, T(), errorCode);
+    }
+
+private:
+    std::shared_ptr<State> m_state;
+};
+
+// Wrap an awaiter in a task so it can be combined with RteWhenAll
+template<typename T>
+RteTask<RteAwaitResult<T>> RteAsTask(RteCallbackAwaiter<T> awaiter) {
+    co_return co_await awaiter;
+}
+
+// Run all tasks concurrently on the current loop and resume once every one has
+// finished. Results keep the order of `tasks`. The first exception is rethrown
+// after all tasks are done.
+template<typename T>
+class RteWhenAllAwaiter {
+public:
+    explicit RteWhenAllAwaiter(std::vector<RteTask<T>> tasks)
+        : m_tasks(std::move(tasks)), m_state(std::make_shared<State>()) {
+        m_state->results.resize(m_tasks.size());
+    }
+
+    bool await_ready() const noexcept { return m_tasks.empty(); }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+        m_state->parent = handle;
+        // One extra count held by await_suspend so a task finishing synchronously
+        // cannot resume the parent before every task has been started
+        m_state->remaining.store(m_tasks.size() + 1);
+        for (size_t i = 0; i < m_tasks.size(); ++i) {
+            Run(std::move(m_tasks[i]), m_state, i);
+        }
+        return m_state->remaining.fetch_sub(1) != 1;
+    }
+
+    std::vector<T> await_resume() {
+        if (m_state->error) {
+            std::rethrow_exception(m_state->error);
+        }
+        return std::move(m_state->results);
+    }
+
+private:
+    struct State {
+        std::vector<T> results;
+        std::atomic<size_t> remaining;
+        std::coroutine_handle<> parent;
+        std::mutex errorMutex;
+        std::exception_ptr error;
+
+        State() : remaining(0) {}
+    };
+
+    static rte_coro_detail::DetachedTask Run(RteTask<T> task, std::shared_ptr<State> state, size_t index) {
+        try {
+            state->results[index] = co_await task;
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(state->errorMutex);
+            if (!state->error) {
+                state->error = std::current_exception();
+            }
+        }
+        if (state->remaining.fetch_sub(1) == 1) {
+            state->parent.resume();
+        }
+    }
+
+    std::vector<RteTask<T>> m_tasks;
+    std::shared_ptr<State> m_state;
+};
+
+template<typename T>
+RteWhenAllAwaiter<T> RteWhenAll(std::vector<RteTask<T>> tasks) {
+    return RteWhenAllAwaiter<T>(std::move(tasks));
+}
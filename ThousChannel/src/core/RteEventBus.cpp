@@ -0,0 +1,336 @@
+#include "pch.h"
+#include "RteEventBus.h"
+#define LOG_CATEGORY LogCategory::Rte
+#include "Logger.h"
+#include <algorithm>
+
+// Buses whose Publish is on this thread's stack, innermost last
+static thread_local std::vector<const RteEventBus*> t_publishing;
+
+const char* GetRteEventTypeString(RteEventType type) {
+    switch (type) {
+        case RteEventType::ConnectionStateChanged:  return "connection_state_changed";
+        case RteEventType::ConnectionRestored:      return "connection_restored";
+        case RteEventType::UserJoined:              return "user_joined";
+        case RteEventType::UserLeft:                return "user_left";
+        case RteEventType::LocalAudioStateChanged:  return "local_audio_state_changed";
+        case RteEventType::LocalVideoStateChanged:  return "local_video_state_changed";
+        case RteEventType::RemoteAudioStateChanged: return "remote_audio_state_changed";
+        case RteEventType::RemoteVideoStateChanged: return "remote_video_state_changed";
+        case RteEventType::Error:                   return "error";
+        case RteEventType::UserListChanged:         return "user_list_changed";
+        case RteEventType::UserSnapshot:            return "user_snapshot";
+        default:                                    return "unknown";
+    }
+}
+
+RteEvent RteEvent::ConnectionStateChanged(int state) {
+    RteEvent event;
+    event.type = RteEventType::ConnectionStateChanged;
+    event.state = state;
+    return event;
+}
+
+RteEvent RteEvent::ConnectionRestored(long long outageMs, int attempts) {
+    RteEvent event;
+    event.type = RteEventType::ConnectionRestored;
+    event.outageMs = outageMs;
+    event.attempts = attempts;
+    return event;
+}
+
+RteEvent RteEvent::UserJoined(UserHandle user) {
+    RteEvent event;
+    event.type = RteEventType::UserJoined;
+    event.user = user;
+    return event;
+}
+
+RteEvent RteEvent::UserLeft(UserHandle user) {
+    RteEvent event;
+    event.type = RteEventType::UserLeft;
+    event.user = user;
+    return event;
+}
+
+RteEvent RteEvent::LocalAudioStateChanged(int state) {
+    RteEvent event;
+    event.type = RteEventType::LocalAudioStateChanged;
+    event.state = state;
+    return event;
+}
+
+RteEvent RteEvent::LocalVideoStateChanged(int state, int reason) {
+    RteEvent event;
+    event.type = RteEventType::LocalVideoStateChanged;
+    event.state = state;
+    event.reason = reason;
+    return event;
+}
+
+RteEvent RteEvent::RemoteAudioStateChanged(UserHandle user, int state) {
+    RteEvent event;
+    event.type = RteEventType::RemoteAudioStateChanged;
+    event.user = user;
+    event.state = state;
+    return event;
+}
+
+RteEvent RteEvent::RemoteVideoStateChanged(UserHandle user, int state) {
+    RteEvent event;
+    event.type = RteEventType::RemoteVideoStateChanged;
+    event.user = user;
+    event.state = state;
+    return event;
+}
+
+RteEvent RteEvent::Error(int error) {
+    RteEvent event;
+    event.type = RteEventType::Error;
+    event.state = error;
+    return event;
+}
+
+RteEvent RteEvent::UserListChanged() {
+    RteEvent event;
+    event.type = RteEventType::UserListChanged;
+    return event;
+}
+
+RteEvent RteEvent::UserSnapshot(std::shared_ptr<const std::vector<UserHandle>> roster) {
+    RteEvent event;
+    event.type = RteEventType::UserSnapshot;
+    event.state = roster ? static_cast<int>(roster->size()) : 0;
+    event.roster = roster;
+    return event;
+}
+
+RteEventBus::RteEventBus()
+    : m_subscribers(new SubscriberList()), m_epoch(0), m_nextSeq(1), m_nextId(1), m_hasDeferred(false) {
+    m_readers[0].store(0);
+    m_readers[1].store(0);
+}
+
+RteEventBus::~RteEventBus() {
+    std::vector<int> ids;
+    {
+        const SubscriberList* list = m_subscribers.load();
+        for (const auto& subscriber : *list) {
+            ids.push_back(subscriber->id);
+        }
+    }
+    for (int id : ids) {
+        Unsubscribe(id);
+    }
+    delete m_subscribers.load();
+}
+
+int RteEventBus::Subscribe(const std::string& name, Callback callback, const RteEventSubscriberOptions& options) {
+    auto subscriber = std::make_shared<Subscriber>();
+    subscriber->name = name;
+    subscriber->callback = callback;
+    subscriber->options = options;
+    if (options.delivery == RteEventDelivery::Queued) {
+        subscriber->queue.reset(new RteBoundedQueue<RteEvent>(options.queueCapacity));
+    }
+
+    std::lock_guard<std::mutex> lock(m_writerMutex);
+    subscriber->id = m_nextId++;
+    if (subscriber->queue) {
+        subscriber->thread = std::thread(&RteEventBus::ConsumerLoop, subscriber);
+    }
+
+    SubscriberList* next = new SubscriberList(*m_subscribers.load());
+    next->push_back(subscriber);
+    Replace(next);
+
+    LOG_INFO_FMT("RteEventBus: subscribed {} (id={}, {})", name, subscriber->id,
+        options.delivery == RteEventDelivery::Queued ? "queued" : "inline");
+    return subscriber->id;
+}
+
+void RteEventBus::Unsubscribe(int id) {
+    // This thread holds a snapshot until its publish returns, so waiting for
+    // publishers here would wait for itself. Stop deliveries now and finish
+    // the removal at the end of the publish.
+    if (IsPublishingOnThisThread()) {
+        for (const auto& subscriber : *m_subscribers.load()) {
+            if (subscriber->id == id) {
+                subscriber->removed.store(true);
+            }
+        }
+        std::lock_guard<std::mutex> lock(m_deferredMutex);
+        m_deferred.push_back(id);
+        m_hasDeferred.store(true);
+        return;
+    }
+
+    std::shared_ptr<Subscriber> removed;
+    {
+        std::lock_guard<std::mutex> lock(m_writerMutex);
+        const SubscriberList* current = m_subscribers.load();
+        SubscriberList* next = new SubscriberList();
+        for (const auto& subscriber : *current) {
+            if (subscriber->id == id) {
+                removed = subscriber;
+            } else {
+                next->push_back(subscriber);
+            }
+        }
+        if (!removed) {
+            delete next;
+            return;
+        }
+        // After Replace no publisher is inside an inline callback or pushing to the queue
+        Replace(next);
+    }
+
+    if (removed->thread.joinable()) {
+        removed->stopping.store(true);
+        removed->signal.fetch_add(1);
+        removed->signal.notify_one();
+        if (removed->thread.get_id() == std::this_thread::get_id()) {
+            // From the subscriber's own queued callback; the loop ends when it returns
+            removed->thread.detach();
+        } else {
+            removed->thread.join();
+        }
+    }
+    LOG_INFO_FMT("RteEventBus: unsubscribed {} (delivered={}, dropped={})",
+        removed->name, removed->delivered.load(), removed->dropped.load());
+}
+
+void RteEventBus::Publish(RteEvent event) {
+    event.seq = m_nextSeq.fetch_add(1);
+    event.publishedAt = std::chrono::steady_clock::now();
+    unsigned int mask = RteEventMask(event.type);
+
+    // Read side: announce this publisher in the current epoch's bucket, then load the snapshot
+    unsigned int bucket = m_epoch.load() & 1;
+    m_readers[bucket].fetch_add(1);
+    const SubscriberList* list = m_subscribers.load();
+    t_publishing.push_back(this);
+
+    for (const auto& subscriber : *list) {
+        if (!(subscriber->options.typeMask & mask) || subscriber->removed.load()) {
+            continue;
+        }
+        if (subscriber->queue) {
+            if (subscriber->queue->TryPush(event)) {
+                subscriber->signal.fetch_add(1);
+                subscriber->signal.notify_one();
+            } else {
+                subscriber->dropped.fetch_add(1);
+            }
+        } else {
+            Deliver(*subscriber, event);
+        }
+    }
+
+    t_publishing.pop_back();
+    m_readers[bucket].fetch_sub(1);
+
+    if (m_hasDeferred.load() && !IsPublishingOnThisThread()) {
+        RunDeferredUnsubscribes();
+    }
+}
+
+bool RteEventBus::IsPublishingOnThisThread() const {
+    return std::find(t_publishing.begin(), t_publishing.end(), this) != t_publishing.end();
+}
+
+void RteEventBus::RunDeferredUnsubscribes() {
+    std::vector<int> ids;
+    {
+        std::lock_guard<std::mutex> lock(m_deferredMutex);
+        ids.swap(m_deferred);
+        m_hasDeferred.store(false);
+    }
+    for (int id : ids) {
+        Unsubscribe(id);
+    }
+}
+
+std::vector<RteEventSubscriberStats> RteEventBus::GetStats() const {
+    std::vector<RteEventSubscriberStats> result;
+
+    unsigned int bucket = m_epoch.load() & 1;
+    m_readers[bucket].fetch_add(1);
+    const SubscriberList* list = m_subscribers.load();
+    for (const auto& subscriber : *list) {
+        RteEventSubscriberStats stats;
+        stats.id = subscriber->id;
+        stats.name = subscriber->name;
+        stats.delivered = subscriber->delivered.load();
+        stats.dropped = subscriber->dropped.load();
+        stats.queued = subscriber->queue ? subscriber->queue->ApproxSize() : 0;
+        stats.lastLagMs = subscriber->lastLagMs.load();
+        stats.maxLagMs = subscriber->maxLagMs.load();
+        result.push_back(stats);
+    }
+    m_readers[bucket].fetch_sub(1);
+
+    return result;
+}
+
+void RteEventBus::LogStats() const {
+    for (const auto& stats : GetStats()) {
+        LOG_INFO_FMT("RteEventBus: {} delivered={} dropped={} queued={}",
+            stats.name, stats.delivered, stats.dropped, stats.queued);
+        LOG_INFO_FMT("RteEventBus: {} lag last={}ms max={}ms", stats.name, stats.lastLagMs, stats.maxLagMs);
+    }
+}
+
+void RteEventBus::Deliver(Subscriber& subscriber, const RteEvent& event) {
+    long long lagMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - event.publishedAt).count();
+    subscriber.lastLagMs.store(lagMs);
+    long long maxLagMs = subscriber.maxLagMs.load();
+    while (lagMs > maxLagMs && !subscriber.maxLagMs.compare_exchange_weak(maxLagMs, lagMs)) {
+    }
+
+    try {
+        subscriber.callback(event);
+    } catch (const std::exception& e) {
+        LOG_ERROR_FMT("RteEventBus: subscriber {} threw on {}: {}",
+            subscriber.name, GetRteEventTypeString(event.type), e.what());
+    }
+    subscriber.delivered.fetch_add(1);
+}
+
+// Holds a reference so a subscriber that unsubscribed from its own callback
+// lives until the loop has returned
+void RteEventBus::ConsumerLoop(std::shared_ptr<Subscriber> subscriber) {
+    while (true) {
+        // Read the signal before draining so a push during the drain is not missed
+        unsigned int observed = subscriber->signal.load();
+        if (subscriber->stopping.load()) {
+            break;
+        }
+
+        RteEvent event;
+        while (!subscriber->stopping.load() && !subscriber->removed.load() && subscriber->queue->TryPop(event)) {
+            Deliver(*subscriber, event);
+        }
+
+        subscriber->signal.wait(observed);
+    }
+}
+
+void RteEventBus::Replace(const SubscriberList* next) {
+    const SubscriberList* previous = m_subscribers.exchange(next);
+    Synchronize();
+    delete previous;
+}
+
+// Wait until every publisher that could have loaded the previous snapshot has
+// left. Flipping twice covers a publisher that read the epoch just before the
+// first flip and registered in the bucket that was drained first.
+void RteEventBus::Synchronize() {
+    for (int pass = 0; pass < 2; ++pass) {
+        unsigned int previous = m_epoch.fetch_add(1);
+        while (m_readers[previous & 1].load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <functional>
+
+#include "RteBoundedQueue.h"
+#include "UserIdInterner.h"
+
+enum class RteEventType {
+    ConnectionStateChanged,
+    ConnectionRestored,
+    UserJoined,
+    UserLeft,
+    LocalAudioStateChanged,
+    LocalVideoStateChanged,
+    RemoteAudioStateChanged,
+    RemoteVideoStateChanged,
+    Error,
+    UserListChanged,
+    UserSnapshot
+};
+
+const char* GetRteEventTypeString(RteEventType type);
+
+// One RteManager event, the union of the IRteManagerEventHandler callbacks.
+// Fields not used by a type are left at zero / kInvalidUserHandle. Events carry
+// no strings and UserSnapshot shares its roster, so copying one into a
+// subscriber queue does not allocate.
+struct RteEvent {
+    RteEventType type;
+    UserHandle user;
+    int state;              // Link, audio or video state; error code for Error; roster size for UserSnapshot
+    int reason;
+    long long outageMs;     // ConnectionRestored
+    int attempts;           // ConnectionRestored
+    std::shared_ptr<const std::vector<UserHandle>> roster;  // UserSnapshot: remote users when published
+    unsigned long long seq; // Assigned by RteEventBus::Publish
+    std::chrono::steady_clock::time_point publishedAt;
+
+    RteEvent() : type(RteEventType::UserListChanged), user(kInvalidUserHandle), state(0), reason(0), outageMs(0), attempts(0), seq(0) {}
+
+    static RteEvent ConnectionStateChanged(int state);
+    static RteEvent ConnectionRestored(long long outageMs, int attempts);
+    static RteEvent UserJoined(UserHandle user);
+    static RteEvent UserLeft(UserHandle user);
+    static RteEvent LocalAudioStateChanged(int state);
+    static RteEvent LocalVideoStateChanged(int state, int reason);
+    static RteEvent RemoteAudioStateChanged(UserHandle user, int state);
+    static RteEvent RemoteVideoStateChanged(UserHandle user, int state);
+    static RteEvent Error(int error);
+    static RteEvent UserListChanged();
+    static RteEvent UserSnapshot(std::shared_ptr<const std::vector<UserHandle>> roster);
+};
+
+inline unsigned int RteEventMask(RteEventType type) {
+    return 1u << static_cast<unsigned int>(type);
+}
+
+const unsigned int kRteEventMaskAll = 0xFFFFFFFFu;
+
+enum class RteEventDelivery {
+    Inline,     // Called on the publishing thread; the callback must be short and non-blocking
+    Queued      // Copied into a bounded queue drained by the subscriber's own thread
+};
+
+struct RteEventSubscriberOptions {
+    unsigned int typeMask;
+    RteEventDelivery delivery;
+    size_t queueCapacity;   // Queued only; events are dropped (and counted) when full
+
+    RteEventSubscriberOptions()
+        : typeMask(kRteEventMaskAll), delivery(RteEventDelivery::Queued), queueCapacity(1024) {
+    }
+};
+
+struct RteEventSubscriberStats {
+    int id;
+    std::string name;
+    unsigned long long delivered;
+    unsigned long long dropped;
+    size_t queued;          // Events waiting in the queue right now
+    long long lastLagMs;    // Publish to callback start, last delivered event
+    long long maxLagMs;
+};
+
+// Multi-subscriber bus for RteManager events.
+//
+// Publish takes no lock: the subscriber list is an immutable snapshot swapped
+// with copy-on-write and reclaimed with a two-bucket epoch scheme (writers wait
+// until no publisher can still see the old snapshot). Subscribe / Unsubscribe
+// serialize on a writer mutex and may wait for in-flight publishes, so they are
+// meant for setup and teardown, not the hot path. An Unsubscribe from inside a
+// callback cannot wait for the publish it runs in, so it is deferred instead.
+class RteEventBus {
+public:
+    typedef std::function<void(const RteEvent&)> Callback;
+
+    RteEventBus();
+    ~RteEventBus();
+
+    // Returns a subscription id (> 0). Must not be called from an inline callback.
+    int Subscribe(const std::string& name, Callback callback,
+                  const RteEventSubscriberOptions& options = RteEventSubscriberOptions());
+
+    // Once this returns the callback is not running and will not be called again.
+    // Events still queued for the subscriber are discarded.
+    //
+    // From inside a callback (inline, or the subscriber's own queued one) it
+    // returns without waiting: no further event is delivered, the callback that
+    // made the call finishes normally, and the subscriber is removed when the
+    // publish on this thread returns. An inline callback of the same subscriber
+    // running on another publishing thread at that moment may still complete.
+    void Unsubscribe(int id);
+
+    // Safe from any thread, never blocks on a subscriber
+    void Publish(RteEvent event);
+
+    std::vector<RteEventSubscriberStats> GetStats() const;
+    void LogStats() const;
+
+private:
+    RteEventBus(const RteEventBus&) = delete;
+    RteEventBus& operator=(const RteEventBus&) = delete;
+
+    struct Subscriber {
+        int id;
+        std::string name;
+        Callback callback;
+        RteEventSubscriberOptions options;
+        std::unique_ptr<RteBoundedQueue<RteEvent>> queue;
+        std::thread thread;
+        std::atomic<unsigned int> signal;       // Bumped on push; the consumer waits on it
+        std::atomic<bool> stopping;
+        std::atomic<bool> removed;              // Unsubscribed, removal deferred; skipped by Publish
+        std::atomic<unsigned long long> delivered;
+        std::atomic<unsigned long long> dropped;
+        std::atomic<long long> lastLagMs;
+        std::atomic<long long> maxLagMs;
+
+        Subscriber() : id(0), signal(0), stopping(false), removed(false), delivered(0), dropped(0), lastLagMs(0), maxLagMs(0) {}
+    };
+
+    typedef std::vector<std::shared_ptr<Subscriber>> SubscriberList;
+
+    static void Deliver(Subscriber& subscriber, const RteEvent& event);
+    static void ConsumerLoop(std::shared_ptr<Subscriber> subscriber);
+
+    bool IsPublishingOnThisThread() const;
+    void RunDeferredUnsubscribes();
+
+    // Replace the snapshot and free the old one once no publisher can hold it
+    void Replace(const SubscriberList* next);
+    void Synchronize();
+
+    std::atomic<const SubscriberList*> m_subscribers;
+    std::atomic<unsigned int> m_epoch;
+    mutable std::atomic<int> m_readers[2];
+    std::atomic<unsigned long long> m_nextSeq;
+
+    std::mutex m_writerMutex;
+    int m_nextId;
+
+    std::mutex m_deferredMutex;
+    std::vector<int> m_deferred;                // Unsubscribed from inside a publish
+    std::atomic<bool> m_hasDeferred;
+};
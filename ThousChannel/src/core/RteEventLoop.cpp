@@ -0,0 +1,194 @@
+#include "pch.h"
+#include "RteEventLoop.h"
+#define LOG_CATEGORY LogCategory::Rte
+#include "Logger.h"
+#include "FlightRecorder.h"
+#include <algorithm>
+
+static thread_local RteEventLoop* t_currentLoop = nullptr;
+
+static const int kDefaultSlowTaskThresholdMs = 50;
+
+static long long MicrosBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
+RteEventLoop::RteEventLoop(const std::string& name)
+    : m_name(name), m_nextSeq(0), m_stopping(false), m_stopped(false),
+      m_slowTaskThresholdMs(kDefaultSlowTaskThresholdMs) {
+}
+
+RteEventLoop::~RteEventLoop() {
+    Stop();
+}
+
+void RteEventLoop::Start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_thread.joinable() || m_stopped) {
+        return;
+    }
+    m_thread = std::thread(&RteEventLoop::Run, this);
+    m_threadId = m_thread.get_id();
+    LOG_INFO_FMT("RteEventLoop {} started", m_name);
+}
+
+void RteEventLoop::Stop() {
+    std::thread thread;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopped) {
+            return;
+        }
+        m_stopping = true;
+        m_stopped = true;
+        thread = std::move(m_thread);
+        m_cv.notify_all();
+    }
+
+    if (thread.joinable()) {
+        thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_delayed.empty()) {
+        LOG_INFO_FMT("RteEventLoop {} dropping {} delayed tasks", m_name, m_delayed.size());
+    }
+    m_tasks.clear();
+    m_delayed.clear();
+    m_stats.queueDepth = 0;
+    LOG_INFO_FMT("RteEventLoop {} stopped", m_name);
+}
+
+bool RteEventLoop::IsStopped() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stopped;
+}
+
+bool RteEventLoop::Post(Task task, const char* label) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stopped && !IsCurrentThread()) {
+        return false;
+    }
+    EnqueueLocked(std::move(task), label, std::chrono::steady_clock::now());
+    m_cv.notify_one();
+    return true;
+}
+
+bool RteEventLoop::PostDelayed(int delayMs, Task task, const char* label) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stopped) {
+        return false;
+    }
+    DelayedTask delayed;
+    delayed.due = std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs);
+    delayed.seq = m_nextSeq++;
+    delayed.task = std::move(task);
+    delayed.label = label;
+    m_delayed.push_back(std::move(delayed));
+    std::push_heap(m_delayed.begin(), m_delayed.end(), DelayedTaskLater());
+    m_cv.notify_one();
+    return true;
+}
+
+bool RteEventLoop::IsCurrentThread() const {
+    return std::this_thread::get_id() == m_threadId;
+}
+
+RteEventLoop* RteEventLoop::Current() {
+    return t_currentLoop;
+}
+
+RteEventLoopStats RteEventLoop::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void RteEventLoop::LogStats() const {
+    RteEventLoopStats stats = GetStats();
+    long long avgWaitUs = stats.executed ? stats.totalWaitUs / static_cast<long long>(stats.executed) : 0;
+    long long avgRunUs = stats.executed ? stats.totalRunUs / static_cast<long long>(stats.executed) : 0;
+    LOG_INFO_FMT("RteEventLoop {}: {} tasks, queue depth {} (max {})",
+        m_name, stats.executed, stats.queueDepth, stats.maxQueueDepth);
+    LOG_INFO_FMT("RteEventLoop {}: wait avg {}us max {}us, run avg {}us",
+        m_name, avgWaitUs, stats.maxWaitUs, avgRunUs);
+    LOG_INFO_FMT("RteEventLoop {}: slowest task {} took {}us",
+        m_name, stats.maxRunLabel.empty() ? std::string("-") : stats.maxRunLabel, stats.maxRunUs);
+}
+
+void RteEventLoop::SetSlowTaskThresholdMs(int thresholdMs) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_slowTaskThresholdMs = thresholdMs;
+}
+
+void RteEventLoop::EnqueueLocked(Task task, const char* label, std::chrono::steady_clock::time_point readyAt) {
+    QueuedTask queued;
+    queued.task = std::move(task);
+    queued.label = label;
+    queued.readyAt = readyAt;
+    m_tasks.push_back(std::move(queued));
+    m_stats.queueDepth = m_tasks.size();
+    m_stats.maxQueueDepth = std::max(m_stats.maxQueueDepth, m_stats.queueDepth);
+}
+
+void RteEventLoop::Run() {
+    t_currentLoop = this;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        // Move due delayed tasks to the ready queue
+        auto now = std::chrono::steady_clock::now();
+        while (!m_stopping && !m_delayed.empty() && m_delayed.front().due <= now) {
+            std::pop_heap(m_delayed.begin(), m_delayed.end(), DelayedTaskLater());
+            DelayedTask& due = m_delayed.back();
+            EnqueueLocked(std::move(due.task), due.label, due.due);
+            m_delayed.pop_back();
+        }
+
+        if (!m_tasks.empty()) {
+            QueuedTask queued = std::move(m_tasks.front());
+            m_tasks.pop_front();
+            m_stats.queueDepth = m_tasks.size();
+            int slowTaskThresholdMs = m_slowTaskThresholdMs;
+            lock.unlock();
+
+            auto start = std::chrono::steady_clock::now();
+            long long waitUs = MicrosBetween(queued.readyAt, start);
+            FlightRecorder::Record(FlightEventKind::TaskStart, queued.label, waitUs);
+            try {
+                queued.task();
+            } catch (const std::exception& e) {
+                LOG_ERROR_FMT("RteEventLoop {}: task {} threw: {}", m_name, queued.label ? queued.label : "-", e.what());
+            }
+            auto end = std::chrono::steady_clock::now();
+
+            long long runUs = MicrosBetween(start, end);
+            FlightRecorder::Record(FlightEventKind::TaskEnd, queued.label, runUs);
+            if (slowTaskThresholdMs > 0 && runUs > slowTaskThresholdMs * 1000LL) {
+                LOG_WARN_FMT("RteEventLoop {}: slow task {} ran {}us after waiting {}us",
+                    m_name, queued.label ? queued.label : "-", runUs, waitUs);
+            }
+
+            lock.lock();
+            m_stats.executed++;
+            m_stats.totalWaitUs += waitUs;
+            m_stats.totalRunUs += runUs;
+            m_stats.maxWaitUs = std::max(m_stats.maxWaitUs, waitUs);
+            if (runUs > m_stats.maxRunUs) {
+                m_stats.maxRunUs = runUs;
+                m_stats.maxRunLabel = queued.label ? queued.label : "";
+            }
+            continue;
+        }
+
+        // Queue drained; on stop, tasks posted by the last tasks have run too
+        if (m_stopping) {
+            break;
+        }
+
+        if (m_delayed.empty()) {
+            m_cv.wait(lock);
+        } else {
+            m_cv.wait_until(lock, m_delayed.front().due);
+        }
+    }
+    t_currentLoop = nullptr;
+}
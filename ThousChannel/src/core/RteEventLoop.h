@@ -0,0 +1,107 @@
+#pragma once
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+// Counters for one RteEventLoop. Wait is the time from a task becoming
+// runnable (posted, or due for delayed tasks) until it starts running.
+struct RteEventLoopStats {
+    unsigned long long executed;
+    size_t queueDepth;          // Runnable tasks waiting right now
+    size_t maxQueueDepth;
+    long long totalWaitUs;
+    long long maxWaitUs;
+    long long totalRunUs;
+    long long maxRunUs;
+    std::string maxRunLabel;    // Label of the slowest task so far
+
+    RteEventLoopStats()
+        : executed(0), queueDepth(0), maxQueueDepth(0),
+          totalWaitUs(0), maxWaitUs(0), totalRunUs(0), maxRunUs(0) {
+    }
+};
+
+// Single-threaded executor. Tasks run in post order on one worker thread;
+// delayed tasks run once their due time passes. Coroutines in RteCoroutine.h
+// resume on the loop they were started on. Used as a strand: state owned by
+// the loop is only touched by its tasks, so it needs no lock.
+class RteEventLoop {
+public:
+    typedef std::function<void()> Task;
+
+    explicit RteEventLoop(const std::string& name);
+    ~RteEventLoop();
+
+    // Start the worker thread. Post before Start queues tasks until it runs.
+    void Start();
+
+    // Run the tasks already queued, drop pending delayed tasks and join the worker.
+    // Posting after Stop fails. Must not be called from the loop thread.
+    void Stop();
+    bool IsStopped() const;
+
+    // Return false if the loop has been stopped; the task is not run in that case.
+    // `label` names the task in stats and slow task warnings (must be a literal).
+    bool Post(Task task, const char* label = nullptr);
+    bool PostDelayed(int delayMs, Task task, const char* label = nullptr);
+
+    bool IsCurrentThread() const;
+
+    // Loop running on the calling thread, or nullptr outside any loop
+    static RteEventLoop* Current();
+
+    const std::string& GetName() const { return m_name; }
+
+    RteEventLoopStats GetStats() const;
+    void LogStats() const;
+
+    // Tasks running longer than this are logged with their label (0 disables)
+    void SetSlowTaskThresholdMs(int thresholdMs);
+
+private:
+    RteEventLoop(const RteEventLoop&) = delete;
+    RteEventLoop& operator=(const RteEventLoop&) = delete;
+
+    struct QueuedTask {
+        Task task;
+        const char* label;
+        std::chrono::steady_clock::time_point readyAt;
+    };
+
+    struct DelayedTask {
+        std::chrono::steady_clock::time_point due;
+        unsigned long long seq;     // Keeps post order for equal due times
+        Task task;
+        const char* label;
+    };
+
+    struct DelayedTaskLater {
+        bool operator()(const DelayedTask& a, const DelayedTask& b) const {
+            return a.due != b.due ? a.due > b.due : a.seq > b.seq;
+        }
+    };
+
+    void Run();
+    void EnqueueLocked(Task task, const char* label, std::chrono::steady_clock::time_point readyAt);
+
+    std::string m_name;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::thread m_thread;
+    std::thread::id m_threadId;
+
+    std::deque<QueuedTask> m_tasks;
+    std::vector<DelayedTask> m_delayed;     // Min-heap on due time
+    unsigned long long m_nextSeq;
+    bool m_stopping;
+    bool m_stopped;
+
+    RteEventLoopStats m_stats;
+    int m_slowTaskThresholdMs;
+};
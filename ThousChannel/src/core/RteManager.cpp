@@ -1,45 +1,28 @@
 #include "pch.h"
 #include "RteManager.h"
+#include "RteAwaitSdk.h"
+#define LOG_CATEGORY LogCategory::Rte
 #include "Logger.h"
+#include "FlightRecorder.h"
 #include <iterator>
 #include <algorithm>
 #include <set>
 #include <atomic>
-#include <future>
 #include <chrono>
+#include <thread>
 
-// AsyncResult class for handling asynchronous operations
-template<typename T>
-class AsyncResult {
-public:
-    AsyncResult() : valid_(false) {}
-    
-    void SetResult(const T& value) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        value_ = value;
-        valid_ = true;
-        cv_.notify_all();
-    }
-    
-    struct Result {
-        bool valid;
-        T value;
-    };
-    
-    Result Wait(int timeoutMs) {
-        std::unique_lock<std::mutex> lock(mutex_);
-        if (cv_.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return valid_; })) {
-            return {true, value_};
-        }
-        return {false, T{}};
-    }
-    
-private:
-    T value_;
-    bool valid_;
-    std::mutex mutex_;
-    std::condition_variable cv_;
-};
+// Deadlines for SDK calls that complete through a callback
+static const int kRteOpTimeoutMs = 5000;
+static const int kRteDisconnectTimeoutMs = 3000;
+
+// Mic restart delay after re-enabling capture
+static const int kMicStartDelayMs = 1000;
+
+// Subscription commands outstanding at once; also the batch run per strand turn
+static const int kMaxSubscriptionsInFlight = 8;
+
+// Join batches this large are announced as a roster snapshot, not per user
+static const size_t kUserSnapshotMinBatch = 32;
 
 // RTE Event Observer for channel events
 class RteManagerEventObserver : public rte::ChannelObserver {
@@ -52,56 +35,107 @@ public:
     // Override the correct virtual functions from ChannelObserver
     void OnRemoteUsersJoined(const std::vector<rte::RemoteUser>& new_users, const std::vector<rte::RemoteUserInfo>& new_users_info) override {
         LOG_INFO("OnRemoteUsersJoined");
+        FlightRecorder::Record(FlightEventKind::SdkCallback, "remote_users_joined", static_cast<int64_t>(new_users.size()));
+        // Ids are interned here, everything past the SDK boundary uses the handle
+        std::vector<UserHandle> users;
         for (size_t i = 0; i < new_users.size(); ++i) {
             std::string userId = new_users_info[i].UserId();
-            LOG_INFO_FMT("OnUserJoined: userId={}", userId);
-            
-            m_rteManager->OnRemoteUserJoined(userId);
-            
-            if (m_rteManager->m_eventHandler) {
-                m_rteManager->m_eventHandler->OnUserJoined(userId);
-                m_rteManager->m_eventHandler->OnUserListChanged();
-            }
+            users.push_back(UserIdInterner::instance().Intern(userId));
+            LOG_INFO_LIMITED_FMT("OnUserJoined: userId={}, handle={}", LogUser(users.back()), users.back());
         }
+
+        RteManager* manager = m_rteManager;
+        manager->PostToStrand("remote_users_joined", [manager, users]() {
+            manager->OnRemoteUsersJoined(users, false);
+        });
+    }
+
+    // Everyone present when the channel was joined, in one callback; the
+    // per-user joins that may follow for the same users are then no-ops
+    void OnChannelUserPresenceSnapshotReceived(const std::vector<rte::PresenceState>& states) override {
+        LOG_INFO_FMT("OnChannelUserPresenceSnapshotReceived: {} users", states.size());
+        FlightRecorder::Record(FlightEventKind::SdkCallback, "user_presence_snapshot", static_cast<int64_t>(states.size()));
+        std::vector<UserHandle> users;
+        users.reserve(states.size());
+        for (const rte::PresenceState& entry : states) {
+            // GetName is not const; read a copy
+            rte::PresenceState state(entry);
+            users.push_back(UserIdInterner::instance().Intern(state.GetName()));
+        }
+
+        RteManager* manager = m_rteManager;
+        manager->PostToStrand("user_presence_snapshot", [manager, users]() {
+            manager->OnRemoteUsersJoined(users, true);
+        });
     }
 
     void OnRemoteUsersLeft(const std::vector<rte::RemoteUser>& removed_users, const std::vector<rte::RemoteUserInfo>& removed_users_info) override {
         LOG_INFO("OnRemoteUsersLeft");
+        FlightRecorder::Record(FlightEventKind::SdkCallback, "remote_users_left", static_cast<int64_t>(removed_users.size()));
+        std::vector<UserHandle> users;
         for (size_t i = 0; i < removed_users.size(); ++i) {
             std::string userId = removed_users_info[i].UserId();
-            LOG_INFO_FMT("OnUserLeft: userId={}", userId);
-            
-            m_rteManager->OnRemoteUserLeft(userId);
-            
-            if (m_rteManager->m_eventHandler) {
-                m_rteManager->m_eventHandler->OnUserLeft(userId);
-                m_rteManager->m_eventHandler->OnUserListChanged();
-            }
+            users.push_back(UserIdInterner::instance().Intern(userId));
+            LOG_INFO_LIMITED_FMT("OnUserLeft: userId={}, handle={}", LogUser(users.back()), users.back());
         }
+
+        RteManager* manager = m_rteManager;
+        manager->PostToStrand("remote_users_left", [manager, users]() {
+            for (UserHandle user : users) {
+                manager->OnRemoteUserLeft(user);
+            }
+        });
     }
 
     void OnRemoteStreamsAdded(const std::vector<rte::RemoteStream>& new_streams, const std::vector<rte::RemoteStreamInfo>& new_streams_info) override {
         LOG_INFO("OnRemoteStreamsAdded");
-        for (size_t i = 0; i < new_streams.size(); ++i) {
-            // TODO: Fix HasAudio() const issue - temporarily commented out
-            // if (m_rteManager->m_eventHandler && new_streams_info[i].HasAudio()) {
-            //     // Note: We need to get the user ID from the stream info or context
-            //     // For now, we'll use a placeholder approach
-            //     m_rteManager->m_eventHandler->OnRemoteAudioStateChanged("", 2); // REMOTE_AUDIO_STATE_DECODING
-            // }
+        FlightRecorder::Record(FlightEventKind::SdkCallback, "remote_streams_added", static_cast<int64_t>(new_streams_info.size()));
+        std::vector<RteRemoteStreamRecord> streams;
+        for (size_t i = 0; i < new_streams_info.size(); ++i) {
+            // The info getters are not const; read a copy
+            rte::RemoteStreamInfo info(new_streams_info[i]);
+            RteRemoteStreamRecord record;
+            record.streamId = info.GetStreamId();
+            record.user = PublisherOf(info);
+            record.hasAudio = info.GetHasAudio();
+            record.hasVideo = info.GetHasVideo();
+            record.audioSubscribed = false;
+            record.videoSubscribed = false;
+            streams.push_back(record);
         }
+
+        RteManager* manager = m_rteManager;
+        manager->PostToStrand("remote_streams_added", [manager, streams]() {
+            manager->OnRemoteStreamsAdded(streams);
+        });
     }
 
     void OnRemoteStreamsRemoved(const std::vector<rte::RemoteStream>& removed_streams, const std::vector<rte::RemoteStreamInfo>& removed_streams_info) override {
         LOG_INFO("OnRemoteStreamsRemoved");
-        for (size_t i = 0; i < removed_streams.size(); ++i) {
-            // TODO: Fix HasAudio() const issue - temporarily commented out
-            // if (m_rteManager->m_eventHandler && removed_streams_info[i].HasAudio()) {
-            //     // Note: We need to get the user ID from the stream info or context
-            //     // For now, we'll use a placeholder approach
-            //     m_rteManager->m_eventHandler->OnRemoteAudioStateChanged("", 0); // REMOTE_AUDIO_STATE_STOPPED
-            // }
+        FlightRecorder::Record(FlightEventKind::SdkCallback, "remote_streams_removed", static_cast<int64_t>(removed_streams_info.size()));
+        std::vector<std::string> streamIds;
+        for (size_t i = 0; i < removed_streams_info.size(); ++i) {
+            rte::RemoteStreamInfo info(removed_streams_info[i]);
+            streamIds.push_back(info.GetStreamId());
+        }
+
+        RteManager* manager = m_rteManager;
+        manager->PostToStrand("remote_streams_removed", [manager, streamIds]() {
+            manager->OnRemoteStreamsRemoved(streamIds);
+        });
+    }
+
+    // Interned id of the user publishing the stream, kInvalidUserHandle if unknown
+    static UserHandle PublisherOf(rte::RemoteStreamInfo& info) {
+        RteRemoteStreamInfo* raw = info.get_underlying_impl();
+        if (!raw) {
+            return kInvalidUserHandle;
+        }
+        rte::UserInfo userInfo;
+        if (!RteUserGetInfo(&raw->stream_info.user, userInfo.get_underlying_impl(), nullptr)) {
+            return kInvalidUserHandle;
         }
+        return UserIdInterner::instance().Intern(userInfo.UserId());
     }
 
     // Connection state handling - these might need to be handled differently
@@ -109,8 +143,37 @@ public:
     // We might need to use other callbacks or handle this through different mechanisms
 };
 
-RteManager::RteManager() : m_eventHandler(nullptr) {
+// Local user observer, feeds link state changes into the reconnect controller
+class RteManagerLocalUserObserver : public rte::LocalUserObserver {
+private:
+    RteManager* m_rteManager;
+
+public:
+    RteManagerLocalUserObserver(RteManager* rteManager) : m_rteManager(rteManager) {}
+
+    void OnLinkStateEvent(rte::LocalUserLinkState old_state, rte::LocalUserLinkState new_state,
+                          rte::LocalUserLinkStateChangedReason reason, const rte::Error& err) override {
+        FlightRecorder::Record(FlightEventKind::SdkCallback, "link_state_changed",
+            static_cast<int64_t>(new_state), static_cast<int64_t>(reason));
+        RteManager* manager = m_rteManager;
+        manager->PostToStrand("link_state_changed", [manager, old_state, new_state, reason]() {
+            manager->OnLinkStateChanged(old_state, new_state, reason);
+        });
+    }
+};
+
+RteManager::RteManager()
+    : m_handlerSubscription(0), m_audioTrackStarted(false), m_videoTrackStarted(false),
+      m_remoteVideoPaused(false), m_subscriptions(kMaxSubscriptionsInFlight), m_subscriptionPumpPosted(false),
+      m_inChannel(false),
+      m_loop("rte_manager") {
     LOG_INFO("RteManager created.");
+    m_loop.Start();
+
+    m_reconnectController.SetCallbacks(
+        [this](int attempt) { return ReconnectAttempt(attempt); },
+        [this](long long outageMs, int attempts) { OnReconnected(outageMs, attempts); },
+        [this](long long outageMs, int attempts) { OnReconnectGaveUp(outageMs, attempts); });
     
     // Test new std::string interface
     LOG_INFO("Testing new std::string interface");
@@ -120,14 +183,76 @@ RteManager::RteManager() : m_eventHandler(nullptr) {
 RteManager::~RteManager() {
     LOG_INFO("RteManager destroyed.");
     Destroy();
+
+    // Wake coroutines still waiting on SDK callbacks so their frames are released
+    m_cancelSource.Cancel();
+    m_loop.Stop();
 }
 
+// Forward one bus event to the matching IRteManagerEventHandler callback
+static void DispatchToHandler(IRteManagerEventHandler* handler, const RteEvent& event) {
+    switch (event.type) {
+        case RteEventType::ConnectionStateChanged:  handler->OnConnectionStateChanged(event.state); break;
+        case RteEventType::ConnectionRestored:      handler->OnConnectionRestored(event.outageMs, event.attempts); break;
+        case RteEventType::UserJoined:              handler->OnUserJoined(event.user); break;
+        case RteEventType::UserLeft:                handler->OnUserLeft(event.user); break;
+        case RteEventType::LocalAudioStateChanged:  handler->OnLocalAudioStateChanged(event.state); break;
+        case RteEventType::LocalVideoStateChanged:  handler->OnLocalVideoStateChanged(event.state, event.reason); break;
+        case RteEventType::RemoteAudioStateChanged: handler->OnRemoteAudioStateChanged(event.user, event.state); break;
+        case RteEventType::RemoteVideoStateChanged: handler->OnRemoteVideoStateChanged(event.user, event.state); break;
+        case RteEventType::Error:                   handler->OnError(event.state); break;
+        case RteEventType::UserListChanged:         handler->OnUserListChanged(); break;
+        case RteEventType::UserSnapshot:            handler->OnUserSnapshot(event.roster); break;
+        default: break;
+    }
+}
+
+// The handler is one more bus subscriber. Once this returns with nullptr no
+// event reaches the old handler (RteEventBus::Unsubscribe guarantees it).
 void RteManager::SetEventHandler(IRteManagerEventHandler* handler) {
+    if (!IsOnStrand()) {
+        RunOnStrand("set_event_handler", [this, handler]() { SetEventHandler(handler); });
+        return;
+    }
     LOG_INFO("SetEventHandler called.");
-    m_eventHandler = handler;
+
+    if (m_handlerSubscription != 0) {
+        m_eventBus.Unsubscribe(m_handlerSubscription);
+        m_handlerSubscription = 0;
+    }
+    if (handler) {
+        // Inline: the handler only posts window messages, so it never stalls the publisher
+        RteEventSubscriberOptions options;
+        options.delivery = RteEventDelivery::Inline;
+        m_handlerSubscription = m_eventBus.Subscribe("event_handler",
+            [handler](const RteEvent& event) { DispatchToHandler(handler, event); }, options);
+    }
+}
+
+bool RteManager::IsOnStrand() const {
+    // Once the loop is stopped (destruction) the calling thread is the only owner left
+    return m_loop.IsCurrentThread() || m_loop.IsStopped();
+}
+
+bool RteManager::PostToStrand(const char* label, std::function<void()> task) {
+    if (!m_loop.Post(std::move(task), label)) {
+        LOG_WARN_FMT("RteManager: strand stopped, dropping {}", label);
+        return false;
+    }
+    return true;
+}
+
+// Never called on the strand: a reconnect attempt thread may be waiting on it
+void RteManager::StopReconnect() {
+    m_inChannel.store(false);
+    m_reconnectController.Stop();
 }
 
 bool RteManager::Initialize(const RteManagerConfig& config) {
+    return RteSyncWait(m_loop, InitializeAsync(config));
+}
+
+RteTask<bool> RteManager::InitializeAsync(RteManagerConfig config) {
     LOG_INFO_FMT("Initialize: appId={}, userId={}", config.appId, config.userId);
     m_appId = config.appId;
     m_userId = config.userId;
@@ -142,31 +267,18 @@ bool RteManager::Initialize(const RteManagerConfig& config) {
     rteConfig.SetAppId(m_appId.c_str(), &err);
     if (err.Code() != kRteOk) {
         LOG_ERROR_FMT("Initialize failed: SetAppId error={}", err.Code());
-        return false;
+        co_return false;
     }
 
     if (!m_rte->SetConfigs(&rteConfig, &err)) {
         LOG_ERROR_FMT("Initialize failed: SetConfigs error={}", err.Code());
-        return false;
+        co_return false;
     }
 
-    // Initialize media engine
-    bool initSuccess = false;
-    m_rte->InitMediaEngine([&initSuccess, this](rte::Error* err) {
-        if (err && err->Code() == kRteOk) {
-            initSuccess = true;
-            LOG_INFO("Media engine initialized successfully");
-        } else {
-            LOG_ERROR_FMT("Media engine initialization failed: error={}", err ? err->Code() : -1);
-        }
-    }, nullptr);
-
-    // Wait for initialization (simple blocking approach)
-    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-    
-    if (!initSuccess) {
-        LOG_ERROR("Initialize failed: Media engine initialization timeout or error");
-        return false;
+    // Initialize media engine, waiting for the callback since it is on the join critical path
+    if (!co_await InitMediaEngineAsync()) {
+        LOG_ERROR("Initialize failed: media engine initialization timeout or error");
+        co_return false;
     }
 
     // Create local user
@@ -178,7 +290,14 @@ bool RteManager::Initialize(const RteManagerConfig& config) {
     m_localUser->SetConfigs(&localUserConfig, &err);
     if (err.Code() != kRteOk) {
         LOG_ERROR_FMT("Initialize failed: LocalUser SetConfigs error={}", err.Code());
-        return false;
+        co_return false;
+    }
+
+    m_localUserObserver = std::make_shared<RteManagerLocalUserObserver>(this);
+    m_localUser->RegisterObserver(m_localUserObserver.get(), &err);
+    if (err.Code() != kRteOk) {
+        // Not fatal, the channel works but connection loss is not detected
+        LOG_WARN_FMT("Initialize: LocalUser RegisterObserver error={}", err.Code());
     }
 
     // Create media tracks
@@ -191,7 +310,7 @@ bool RteManager::Initialize(const RteManagerConfig& config) {
         m_micAudioTrack->SetConfigs(&micConfig, &err);
         if (err.Code() != kRteOk) {
             LOG_ERROR_FMT("Initialize failed: MicAudioTrack SetConfigs error={}", err.Code());
-            return false;
+            co_return false;
         }
     } // micConfig goes out of scope here and is properly destroyed
 
@@ -201,22 +320,38 @@ bool RteManager::Initialize(const RteManagerConfig& config) {
         m_cameraVideoTrack->SetConfigs(&cameraConfig, &err);
         if (err.Code() != kRteOk) {
             LOG_ERROR_FMT("Initialize failed: CameraVideoTrack SetConfigs error={}", err.Code());
-            return false;
+            co_return false;
         }
     } // cameraConfig goes out of scope here and is properly destroyed
 
     LOG_INFO("Initialize successful.");
-    return true;
+    co_return true;
 }
 
 void RteManager::Destroy() {
     LOG_INFO("Destroy called.");
-    
-    // Leave channel if connected
-    if (m_channel) {
-        LeaveChannel();
+
+    // A reconnect attempt may be between channels (m_channel empty), stop it first
+    StopReconnect();
+
+    RunOnStrand("destroy", [this]() {
+        // Leave channel if connected
+        if (m_channel) {
+            LeaveChannelOnStrand();
+        }
+        StopLocalTracks();
+        ReleaseEngineOnStrand();
+    });
+    m_loop.LogStats();
+    m_eventBus.LogStats();
+}
+
+void RteManager::StopLocalTracks() {
+    if (!IsOnStrand()) {
+        RunOnStrand("stop_local_tracks", [this]() { StopLocalTracks(); });
+        return;
     }
-    
+
     // Stop and release media tracks
     if (m_micAudioTrack) {
         m_micAudioTrack->Stop([](rte::Error* err) {
@@ -239,13 +374,28 @@ void RteManager::Destroy() {
         });
         m_cameraVideoTrack.reset();
     }
-    
+    m_audioTrackStarted = false;
+    m_videoTrackStarted = false;
+}
+
+void RteManager::ReleaseEngine() {
+    // Normally stopped by LeaveChannel already, but that step may have been skipped
+    StopReconnect();
+    RunOnStrand("release_engine", [this]() { ReleaseEngineOnStrand(); });
+}
+
+void RteManager::ReleaseEngineOnStrand() {
     // Release local stream and user
     if (m_localStream) {
         m_localStream.reset();
     }
     
     if (m_localUser) {
+        if (m_localUserObserver) {
+            rte::Error err;
+            m_localUser->UnregisterObserver(m_localUserObserver.get(), &err);
+            m_localUserObserver.reset();
+        }
         m_localUser.reset();
     }
     
@@ -257,162 +407,286 @@ void RteManager::Destroy() {
     }
 }
 
+RteTask<bool> RteManager::InitMediaEngineAsync() {
+    RteAwaitResult<bool> result = co_await RteAwaitInitMediaEngine(m_rte.get(), kRteOpTimeoutMs, m_cancelSource.GetToken());
+    if (!result.Succeeded()) {
+        LOG_ERROR_FMT("Media engine initialization {}: error={}", GetRteOpStatusString(result.status), result.errorCode);
+        co_return false;
+    }
+    LOG_INFO("Media engine initialized successfully");
+    co_return true;
+}
+
 bool RteManager::JoinChannel(const std::string& channelId, const std::string& token) {
+    return RteSyncWait(m_loop, JoinChannelAsync(channelId, token));
+}
+
+RteTask<bool> RteManager::JoinChannelAsync(std::string channelId, std::string token) {
     LOG_INFO_FMT("JoinChannel: channelId={}", channelId);
-    m_channelId = channelId;
-    
+
+    if (!co_await ConnectLocalUserAsync(token) || !EnterChannel(channelId)) {
+        co_return false;
+    }
+
+    // Both tracks start concurrently. Failures are not fatal, the stream is
+    // published with whatever started
+    std::vector<RteTask<bool>> trackStarts;
+    trackStarts.push_back(StartMicTrackAsync());
+    trackStarts.push_back(StartCameraTrackAsync());
+    std::vector<bool> started = co_await RteWhenAll(std::move(trackStarts));
+    if (!started[0]) {
+        LOG_WARN("MicAudioTrack failed to start, continuing anyway");
+    }
+    if (!started[1]) {
+        LOG_WARN("CameraVideoTrack failed to start, continuing anyway");
+    }
+
+    if (!co_await PublishLocalStreamAsync()) {
+        co_return false;
+    }
+
+    LOG_INFO("JoinChannel successful");
+    co_return true;
+}
+
+bool RteManager::ConnectLocalUser(const std::string& token) {
+    return RteSyncWait(m_loop, ConnectLocalUserAsync(token));
+}
+
+RteTask<bool> RteManager::ConnectLocalUserAsync(std::string token) {
     if (!m_rte || !m_localUser) {
-        LOG_ERROR("JoinChannel failed: RTE or LocalUser not initialized");
-        return false;
+        LOG_ERROR("ConnectLocalUser failed: RTE or LocalUser not initialized");
+        co_return false;
     }
-    
+
     rte::Error err;
-    
+
     // Update user token if provided
     if (!token.empty()) {
+        m_token = token;
         {
             rte::LocalUserConfig localUserConfig;
             m_localUser->GetConfigs(&localUserConfig, &err);
             localUserConfig.SetUserToken(token.c_str());
             m_localUser->SetConfigs(&localUserConfig, &err);
             if (err.Code() != kRteOk) {
-                LOG_ERROR_FMT("JoinChannel failed: SetUserToken error={}", err.Code());
-                return false;
+                LOG_ERROR_FMT("ConnectLocalUser failed: SetUserToken error={}", err.Code());
+                co_return false;
             }
         } // localUserConfig goes out of scope here
     }
-    
+
     // Connect local user
-    std::atomic<bool> connectSuccess(false);
-    m_localUser->Connect([&connectSuccess](rte::Error* err) {
-        if (err && err->Code() == kRteOk) {
-            connectSuccess = true;
-            LOG_INFO("Local user connected successfully");
-        } else {
-            LOG_ERROR_FMT("Local user connection failed: error={}", err ? err->Code() : -1);
-        }
-    });
-    
-    // Wait for connection with longer timeout
-    std::this_thread::sleep_for(std::chrono::milliseconds(5000));
-    
-    if (!connectSuccess.load()) {
-        LOG_ERROR("JoinChannel failed: Local user connection timeout");
+    RteAwaitResult<bool> result = co_await RteAwaitConnect(m_localUser.get(), kRteOpTimeoutMs, m_cancelSource.GetToken());
+    if (!result.Succeeded()) {
+        LOG_ERROR_FMT("ConnectLocalUser failed: connect {}, error={}", GetRteOpStatusString(result.status), result.errorCode);
+        co_return false;
+    }
+    LOG_INFO("Local user connected successfully");
+    co_return true;
+}
+
+bool RteManager::EnterChannel(const std::string& channelId) {
+    if (!IsOnStrand()) {
+        return RunOnStrand("enter_channel", [this, channelId]() { return EnterChannel(channelId); });
+    }
+
+    LOG_INFO_FMT("EnterChannel: channelId={}", channelId);
+    m_channelId = channelId;
+
+    if (!m_rte || !m_localUser) {
+        LOG_ERROR("EnterChannel failed: RTE or LocalUser not initialized");
         return false;
     }
-    
+
+    rte::Error err;
+
     // Create and configure channel
     m_channel = std::make_shared<rte::Channel>(m_rte.get());
     m_channelObserver = std::make_shared<RteManagerEventObserver>(this);
-    
+
     {
         rte::ChannelConfig channelConfig;
         channelConfig.SetChannelId(channelId.c_str());
-        
+        // The roster of a large channel arrives as one presence snapshot
+        channelConfig.SetAutoSubscribeUserPresence(true);
+
         if (!m_channel->SetConfigs(&channelConfig, &err)) {
-            LOG_ERROR_FMT("JoinChannel failed: Channel SetConfigs error={}", err.Code());
+            LOG_ERROR_FMT("EnterChannel failed: Channel SetConfigs error={}", err.Code());
             return false;
         }
     } // channelConfig goes out of scope here
-    
+
     m_channel->RegisterObserver(m_channelObserver.get(), &err);
     if (err.Code() != kRteOk) {
-        LOG_ERROR("JoinChannel failed: RegisterObserver error={}", err.Code());
+        LOG_ERROR_FMT("EnterChannel failed: RegisterObserver error={}", err.Code());
         return false;
     }
-    
+
     // Join channel
+    m_joinStartedAt = std::chrono::steady_clock::now();
     bool joinSuccess = m_channel->Join(m_localUser.get(), &err);
     if (!joinSuccess || err.Code() != kRteOk) {
-        LOG_ERROR_FMT("JoinChannel failed: Join error={}", err.Code());
+        LOG_ERROR_FMT("EnterChannel failed: Join error={}", err.Code());
         return false;
     }
-    
+
     LOG_INFO("Channel joined successfully");
-    
-    // Start audio and video tracks before adding to stream - following UT pattern
-    std::atomic<bool> audioTrackStarted(false);
-    std::atomic<bool> videoTrackStarted(false);
-    
-    // Start mic audio track first
-    {
-        std::shared_ptr<AsyncResult<bool>> mic_audio_track_start_result = std::make_shared<AsyncResult<bool>>();
-        m_micAudioTrack->Start([&audioTrackStarted, mic_audio_track_start_result](rte::Error* err) {
-            if (err && err->Code() == kRteOk) {
-                audioTrackStarted.store(true);
-                mic_audio_track_start_result->SetResult(true);
-                LOG_INFO("MicAudioTrack started successfully");
-            } else {
-                mic_audio_track_start_result->SetResult(false);
-                LOG_ERROR_FMT("MicAudioTrack start failed: error={}", err ? err->Code() : -1);
-            }
-        });
+    return true;
+}
 
-        auto result = mic_audio_track_start_result->Wait(5000); // 5 second timeout
-        if (!result.valid || !result.value) {
-            LOG_WARN("MicAudioTrack failed to start, continuing anyway");
-        }
+bool RteManager::StartMicTrack() {
+    return RteSyncWait(m_loop, StartMicTrackAsync());
+}
+
+RteTask<bool> RteManager::StartMicTrackAsync() {
+    if (!m_micAudioTrack) {
+        LOG_ERROR("StartMicTrack failed: MicAudioTrack not created");
+        co_return false;
     }
-    
-    // Start camera video track
-    {
-        std::shared_ptr<AsyncResult<bool>> camera_video_track_start_result = std::make_shared<AsyncResult<bool>>();
-        m_cameraVideoTrack->Start([&videoTrackStarted, camera_video_track_start_result](rte::Error* err) {
-            if (err && err->Code() == kRteOk) {
-                videoTrackStarted.store(true);
-                camera_video_track_start_result->SetResult(true);
-                LOG_INFO("CameraVideoTrack started successfully");
-            } else {
-                camera_video_track_start_result->SetResult(false);
-                LOG_ERROR_FMT("CameraVideoTrack start failed: error={}", err ? err->Code() : -1);
-            }
-        });
 
-        auto result = camera_video_track_start_result->Wait(5000); // 5 second timeout
-        if (!result.valid || !result.value) {
-            LOG_WARN("CameraVideoTrack failed to start, continuing anyway");
-        }
+    RteAwaitResult<bool> result = co_await RteAwaitStartTrack(m_micAudioTrack.get(), kRteOpTimeoutMs, m_cancelSource.GetToken());
+    if (result.Succeeded()) {
+        LOG_INFO("MicAudioTrack started successfully");
+    } else {
+        LOG_ERROR_FMT("MicAudioTrack start {}: error={}", GetRteOpStatusString(result.status), result.errorCode);
     }
-    
+    m_audioTrackStarted = result.Succeeded();
+    if (m_audioTrackStarted) {
+        m_eventBus.Publish(RteEvent::LocalAudioStateChanged(1)); // LOCAL_AUDIO_STREAM_STATE_RECORDING
+    }
+    co_return m_audioTrackStarted;
+}
+
+bool RteManager::StartCameraTrack() {
+    return RteSyncWait(m_loop, StartCameraTrackAsync());
+}
+
+RteTask<bool> RteManager::StartCameraTrackAsync() {
+    if (!m_cameraVideoTrack) {
+        LOG_ERROR("StartCameraTrack failed: CameraVideoTrack not created");
+        co_return false;
+    }
+
+    RteAwaitResult<bool> result = co_await RteAwaitStartTrack(m_cameraVideoTrack.get(), kRteOpTimeoutMs, m_cancelSource.GetToken());
+    if (result.Succeeded()) {
+        LOG_INFO("CameraVideoTrack started successfully");
+    } else {
+        LOG_ERROR_FMT("CameraVideoTrack start {}: error={}", GetRteOpStatusString(result.status), result.errorCode);
+    }
+    m_videoTrackStarted = result.Succeeded();
+    co_return m_videoTrackStarted;
+}
+
+bool RteManager::PublishLocalStream() {
+    return RteSyncWait(m_loop, PublishLocalStreamAsync());
+}
+
+RteTask<bool> RteManager::PublishLocalStreamAsync() {
+    if (!m_rte || !m_channel) {
+        LOG_ERROR("PublishLocalStream failed: channel not joined");
+        co_return false;
+    }
+
+    rte::Error err;
+
     // Create and publish local stream
     m_localStream = std::make_shared<rte::LocalRealTimeStream>(m_rte.get());
-    
+
     // Add tracks to stream - only add audio if it started successfully
-    if (audioTrackStarted.load()) {
+    if (m_audioTrackStarted) {
         m_localStream->AddAudioTrack(m_micAudioTrack.get(), &err);
         if (err.Code() != kRteOk) {
-            LOG_ERROR_FMT("JoinChannel warning: AddAudioTrack error={}", err.Code());
+            LOG_ERROR_FMT("PublishLocalStream warning: AddAudioTrack error={}", err.Code());
         } else {
             LOG_INFO("Audio track added to stream successfully");
         }
     } else {
-        LOG_WARN("Skipping audio track addition due to initialization failure");
+        LOG_WARN("Skipping audio track addition, mic track not started");
     }
-    
+
     // Always try to add video track
     m_localStream->AddVideoTrack(m_cameraVideoTrack.get(), &err);
-            if (err.Code() != kRteOk) {
-            LOG_ERROR_FMT("JoinChannel warning: AddVideoTrack error={}", err.Code());
-        } else {
-            LOG_INFO("Video track added to stream successfully");
-        }
-    
+    if (err.Code() != kRteOk) {
+        LOG_ERROR_FMT("PublishLocalStream warning: AddVideoTrack error={}", err.Code());
+    } else {
+        LOG_INFO("Video track added to stream successfully");
+    }
+
     // Publish stream to channel
-    m_channel->PublishStream(m_localStream.get(), [this](rte::Error* err) {
-        if (err && err->Code() == kRteOk) {
-            LOG_INFO("Local stream published successfully");
+    RteAwaitResult<bool> result = co_await RteAwaitPublish(m_channel.get(), m_localStream.get(), kRteOpTimeoutMs, m_cancelSource.GetToken());
+    if (!result.Succeeded()) {
+        LOG_ERROR_FMT("Publish stream {}: error={}", GetRteOpStatusString(result.status), result.errorCode);
+        co_return false;
+    }
+    LOG_INFO("Local stream published successfully");
+
+    m_inChannel.store(true);
+    co_return true;
+}
+
+int RteManager::SubscribeTracks(const std::vector<std::string>& streamIds, rte::TrackMediaType mediaType) {
+    return RteSyncWait(m_loop, SubscribeTracksAsync(streamIds, mediaType));
+}
+
+RteTask<int> RteManager::SubscribeTracksAsync(std::vector<std::string> streamIds, rte::TrackMediaType mediaType) {
+    if (!m_channel) {
+        LOG_ERROR("SubscribeTracks failed: channel not joined");
+        co_return 0;
+    }
+
+    // All subscriptions are in flight together instead of one round trip after another
+    std::vector<RteTask<RteAwaitResult<std::shared_ptr<rte::Track>>>> subscribes;
+    for (const auto& streamId : streamIds) {
+        subscribes.push_back(RteAsTask(RteAwaitSubscribe(m_channel.get(), streamId, mediaType,
+                                                         kRteOpTimeoutMs, m_cancelSource.GetToken())));
+    }
+    auto results = co_await RteWhenAll(std::move(subscribes));
+
+    int subscribed = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (results[i].Succeeded()) {
+            m_subscribedTracks[streamIds[i]] = results[i].value;
+            if (mediaType == rte::TrackMediaType::kRteTrackMediaTypeAudio) {
+                m_streamCatalog.SetAudioSubscribed(streamIds[i], true);
+            } else if (mediaType == rte::TrackMediaType::kRteTrackMediaTypeVideo) {
+                m_streamCatalog.SetVideoSubscribed(streamIds[i], true);
+            }
+            ++subscribed;
         } else {
-            LOG_ERROR_FMT("Publish stream failed: error={}", err ? err->Code() : -1);
+            LOG_WARN_FMT("SubscribeTrack {} {}: error={}", streamIds[i],
+                GetRteOpStatusString(results[i].status), results[i].errorCode);
         }
+    }
+    LOG_INFO_FMT("SubscribeTracks: {}/{} subscribed", subscribed, streamIds.size());
+    co_return subscribed;
+}
+
+std::vector<RteRemoteStreamRecord> RteManager::GetRemoteStreams(UserHandle user) {
+    return RunOnStrand("get_remote_streams", [this, user]() {
+        std::vector<RteRemoteStreamRecord> records;
+        m_streamCatalog.GetUserStreams(user, records);
+        return records;
     });
-    
-    LOG_INFO("JoinChannel successful");
-    return true;
+}
+
+size_t RteManager::GetRemoteStreamCount() {
+    return RunOnStrand("get_remote_stream_count", [this]() { return m_streamCatalog.Size(); });
+}
+
+std::vector<UserHandle> RteManager::GetRemoteUsers() {
+    return RunOnStrand("get_remote_users", [this]() { return m_remoteUsers; });
 }
 
 void RteManager::LeaveChannel() {
+    // A reconnect attempt must not race with the leave
+    StopReconnect();
+    RunOnStrand("leave_channel", [this]() { LeaveChannelOnStrand(); });
+}
+
+void RteManager::LeaveChannelOnStrand() {
     LOG_INFO_FMT("LeaveChannel: channelId={}", m_channelId);
-    
+
     if (m_channel) {
         rte::Error err;
         
@@ -453,15 +727,20 @@ void RteManager::LeaveChannel() {
     }
     
     // Clear remote user data
-    {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        m_remoteUsers.clear();
-        m_remoteUserCanvases.clear();
-        m_viewToUserMap.clear();
-    }
+    m_remoteUsers.clear();
+    m_isRemoteUser.clear();
+    m_remoteUserCanvases.clear();
+    ResetSubscriptions();
+    m_subscribedTracks.clear();
+    m_streamCatalog.Clear();
 }
 
 void RteManager::RenewToken(const std::string& token) {
+    if (!IsOnStrand()) {
+        PostToStrand("renew_token", [this, token]() { RenewToken(token); });
+        return;
+    }
+
     LOG_INFO("RenewToken called.");
     if (m_localUser) {
         rte::Error err;
@@ -471,25 +750,34 @@ void RteManager::RenewToken(const std::string& token) {
         m_localUser->SetConfigs(&localUserConfig, &err);
         if (err.Code() != kRteOk) {
             LOG_ERROR_FMT("RenewToken failed: error={}", err.Code());
+        } else {
+            m_token = token;
         }
     }
 }
 
 void RteManager::SetLocalAudioCaptureEnabled(bool enabled) {
+    if (!IsOnStrand()) {
+        PostToStrand("set_local_audio_capture", [this, enabled]() { SetLocalAudioCaptureEnabled(enabled); });
+        return;
+    }
+
     LOG_INFO_FMT("SetLocalAudioCaptureEnabled: enabled={}", enabled);
     if (m_micAudioTrack) {
         if (enabled) {
-            // Add delay to ensure RTE is fully initialized
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-            
-            // Start audio track with simple retry mechanism
-            m_micAudioTrack->Start([](rte::Error* err) {
-                            if (err && err->Code() != kRteOk) {
-                LOG_ERROR_FMT("MicAudioTrack Start failed: error={}", err->Code());
-            } else {
-                LOG_INFO("MicAudioTrack started successfully");
-            }
-            });
+            // Delay to ensure RTE is fully initialized, without blocking the strand
+            m_loop.PostDelayed(kMicStartDelayMs, [this]() {
+                if (!m_micAudioTrack) {
+                    return;
+                }
+                m_micAudioTrack->Start([](rte::Error* err) {
+                    if (err && err->Code() != kRteOk) {
+                        LOG_ERROR_FMT("MicAudioTrack Start failed: error={}", err->Code());
+                    } else {
+                        LOG_INFO("MicAudioTrack started successfully");
+                    }
+                });
+            }, "mic_start_delayed");
         } else {
             m_micAudioTrack->Stop([](rte::Error* err) {
                             if (err && err->Code() != kRteOk) {
@@ -499,14 +787,17 @@ void RteManager::SetLocalAudioCaptureEnabled(bool enabled) {
             }
             });
         }
-        if (m_eventHandler) {
-            int state = enabled ? 1 : 0; // Corresponds to LOCAL_AUDIO_STREAM_STATE_RECORDING and LOCAL_AUDIO_STREAM_STATE_STOPPED
-            m_eventHandler->OnLocalAudioStateChanged(state);
-        }
+        int state = enabled ? 1 : 0; // Corresponds to LOCAL_AUDIO_STREAM_STATE_RECORDING and LOCAL_AUDIO_STREAM_STATE_STOPPED
+        m_eventBus.Publish(RteEvent::LocalAudioStateChanged(state));
     }
 }
 
 void RteManager::SetLocalVideoCaptureEnabled(bool enabled) {
+    if (!IsOnStrand()) {
+        PostToStrand("set_local_video_capture", [this, enabled]() { SetLocalVideoCaptureEnabled(enabled); });
+        return;
+    }
+
     LOG_INFO_FMT("SetLocalVideoCaptureEnabled: enabled={}", enabled);
     if (m_cameraVideoTrack) {
         if (enabled) {
@@ -529,49 +820,42 @@ void RteManager::SetLocalVideoCaptureEnabled(bool enabled) {
     }
 }
 
-void RteManager::SetViewUserBindings(const std::map<void*, std::string>& viewToUserMap) {
-    LOG_INFO("SetViewUserBindings called.");
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
-    // Clear existing canvases for views that are no longer bound
-    for (const auto& pair : m_viewToUserMap) {
-        void* view = pair.first;
-        const std::string& userId = pair.second;
-        if (viewToUserMap.find(view) == viewToUserMap.end() || viewToUserMap.at(view) != userId) {
-            LOG_INFO_FMT("Unbinding view for user: {}", userId);
-            if (m_remoteUserCanvases.count(userId)) {
-                m_remoteUserCanvases.erase(userId);
-            }
-        }
+void RteManager::SetViewUserBindings(const std::vector<RteViewBinding>& bindings) {
+    if (!IsOnStrand()) {
+        PostToStrand("set_view_user_bindings", [this, bindings]() { SetViewUserBindings(bindings); });
+        return;
     }
-    
-    // Create new canvases for new view bindings
-    for (const auto& pair : viewToUserMap) {
-        void* view = pair.first;
-        const std::string& userId = pair.second;
-        if (m_viewToUserMap.find(view) == m_viewToUserMap.end() || m_viewToUserMap.at(view) != userId) {
-            LOG_INFO_FMT("Binding view for user: {}", userId);
-            if (m_rte) {
-                auto canvas = std::make_shared<rte::Canvas>(m_rte.get());
-                rte::Error err;
-                rte::View rteView = reinterpret_cast<rte::View>(view);
-                rte::ViewConfig viewConfig;
-                canvas->AddView(&rteView, &viewConfig, &err);
-                if (err.Code() == kRteOk) {
-                    m_remoteUserCanvases[userId] = canvas;
-                } else {
-                    LOG_ERROR_FMT("Failed to create canvas for user {}: error={}", userId, err.Code());
-                }
-            }
+
+    std::vector<RteSubscriptionTarget> targets;
+    targets.reserve(bindings.size());
+    for (const RteViewBinding& binding : bindings) {
+        RteSubscriptionTarget target;
+        target.user = binding.user;
+        target.view = binding.view;
+        target.visible = binding.visible;
+        targets.push_back(target);
+    }
+
+    std::vector<uint64_t> cancel;
+    m_subscriptions.SetDesired(targets, cancel);
+    for (uint64_t ticket : cancel) {
+        auto it = m_subscriptionCancels.find(ticket);
+        if (it != m_subscriptionCancels.end()) {
+            it->second->Cancel();
         }
     }
-    
-    m_viewToUserMap = viewToUserMap;
+    LOG_INFO_FMT("SetViewUserBindings: {} bindings, {} in-flight subscribes cancelled", bindings.size(), cancel.size());
+
+    // Applied on a later turn, after bindings queued behind these have replaced them
+    PostSubscriptionPump();
 }
 
-int RteManager::SetupRemoteVideo(const std::string& userId, void* view) {
-    LOG_INFO_FMT("SetupRemoteVideo for user: {}", userId);
-    std::lock_guard<std::mutex> lock(m_mutex);
+int RteManager::SetupRemoteVideo(UserHandle user, void* view) {
+    if (!IsOnStrand()) {
+        return RunOnStrand("setup_remote_video", [this, user, view]() { return SetupRemoteVideo(user, view); });
+    }
+
+    LOG_INFO_LIMITED_FMT("SetupRemoteVideo for user: {}", LogUser(user));
     
     if (!m_rte) {
         LOG_ERROR("SetupRemoteVideo failed: RTE not initialized");
@@ -580,51 +864,486 @@ int RteManager::SetupRemoteVideo(const std::string& userId, void* view) {
     
     if (!view) {
         // Remove canvas for user
-        if (m_remoteUserCanvases.count(userId)) {
-            m_remoteUserCanvases.erase(userId);
-            LOG_INFO_FMT("Removed canvas for user: {}", userId);
+        if (SetRemoteUserCanvas(user, nullptr, false)) {
+            LOG_INFO_LIMITED_FMT("Removed canvas for user: {}", LogUser(user));
         }
         return 0;
     }
     
     // Create canvas for user
+    if (SetRemoteUserCanvas(user, view, true)) {
+        LOG_INFO_LIMITED_FMT("Created canvas for user: {}", LogUser(user));
+        return 0;
+    }
+    
+    LOG_ERROR_FMT("SetupRemoteVideo failed for user: {}", LogUser(user));
+    return -1;
+}
+
+void RteManager::SetRemoteVideoPaused(bool paused) {
+    if (!IsOnStrand()) {
+        PostToStrand("set_remote_video_paused", [this, paused]() { SetRemoteVideoPaused(paused); });
+        return;
+    }
+    if (paused == m_remoteVideoPaused) {
+        return;
+    }
+
+    m_remoteVideoPaused = paused;
+    int canvases = 0;
+    for (UserHandle user = 0; user < m_remoteUserCanvases.size(); ++user) {
+        RemoteCanvas& entry = m_remoteUserCanvases[user];
+        if (!entry.view) {
+            continue;
+        }
+        if (paused) {
+            entry.canvas.reset();
+        } else {
+            entry.canvas = CreateRemoteCanvas(user, entry.view, entry.fit);
+            if (!entry.canvas) {
+                entry = RemoteCanvas();
+                continue;
+            }
+        }
+        ++canvases;
+    }
+    LOG_INFO_FMT("Remote video {}: {} canvases", paused ? "paused" : "resumed", canvases);
+}
+
+// Canvases are indexed by handle. A null view removes the user's canvas and
+// returns true if there was one; otherwise returns false if the canvas could
+// not be created. While paused only the view is recorded.
+bool RteManager::SetRemoteUserCanvas(UserHandle user, void* view, bool fit) {
+    if (user == kInvalidUserHandle) {
+        return false;
+    }
+    if (user >= m_remoteUserCanvases.size()) {
+        if (!view) {
+            return false;
+        }
+        m_remoteUserCanvases.resize(user + 1);
+    }
+
+    RemoteCanvas& entry = m_remoteUserCanvases[user];
+    if (!view) {
+        bool hadCanvas = (entry.view != nullptr);
+        entry = RemoteCanvas();
+        return hadCanvas;
+    }
+
+    entry.view = view;
+    entry.fit = fit;
+    entry.canvas.reset();
+    if (m_remoteVideoPaused) {
+        return true;
+    }
+    entry.canvas = CreateRemoteCanvas(user, view, fit);
+    if (!entry.canvas) {
+        entry = RemoteCanvas();
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<rte::Canvas> RteManager::CreateRemoteCanvas(UserHandle user, void* view, bool fit) {
+    if (!m_rte) {
+        return nullptr;
+    }
+
     auto canvas = std::make_shared<rte::Canvas>(m_rte.get());
     rte::Error err;
     rte::View rteView = reinterpret_cast<rte::View>(view);
     rte::ViewConfig viewConfig;
     canvas->AddView(&rteView, &viewConfig, &err);
-    
-    if (err.Code() == kRteOk) {
+    bool created = (err.Code() == kRteOk);
+    if (created && fit) {
         rte::CanvasConfig canvasConfig;
         canvasConfig.SetRenderMode(rte::VideoRenderMode::kRteVideoRenderModeFit);
-        if (canvas->SetConfigs(&canvasConfig, &err)) {
-            m_remoteUserCanvases[userId] = canvas;
-            LOG_INFO_FMT("Created canvas for user: {}", userId);
-            return 0;
-        }
+        created = canvas->SetConfigs(&canvasConfig, &err);
     }
-    
-    LOG_ERROR_FMT("SetupRemoteVideo failed for user: {}, error={}", userId, err.Code());
-    return -1;
+    if (!created) {
+        LOG_ERROR_FMT("Failed to create canvas for user {}: error={}", LogUser(user), err.Code());
+        return nullptr;
+    }
+    return canvas;
+}
+
+void RteManager::PostSubscriptionPump() {
+    if (!m_subscriptionPumpPosted) {
+        m_subscriptionPumpPosted = PostToStrand("pump_subscriptions", [this]() {
+            m_subscriptionPumpPosted = false;
+            PumpSubscriptions();
+        });
+    }
+}
+
+// One batch per strand turn, so bindings posted meanwhile can still replace the rest
+void RteManager::PumpSubscriptions() {
+    if (!m_rte) {
+        return;
+    }
+
+    std::vector<RteSubscriptionCommand> commands;
+    m_subscriptions.TakeReady(commands);
+    if (commands.empty()) {
+        return;
+    }
+    for (const RteSubscriptionCommand& command : commands) {
+        RunSubscriptionCommand(command);
+    }
+
+    RteSubscriptionQueueStats stats = m_subscriptions.GetStats();
+    LOG_INFO_FMT("Subscriptions: ran {}, {} in flight, {} pending, {} superseded so far",
+        commands.size(), stats.inFlight, stats.pending, stats.superseded);
+    PostSubscriptionPump();
 }
 
-void RteManager::OnRemoteUserJoined(const std::string& userId) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_remoteUsers.push_back(userId);
-    LOG_INFO_FMT("Remote user joined: {}", userId);
+// Subscribe = canvas on the view plus the user's video track if the channel
+// announced one; only the track subscribe is asynchronous. Unsubscribe releases both.
+void RteManager::RunSubscriptionCommand(const RteSubscriptionCommand& command) {
+    if (command.op == RteSubscriptionOp::Unsubscribe) {
+        ReleaseUserVideo(command.user);
+        m_subscriptions.Complete(command.ticket, true);
+        return;
+    }
+
+    // A refresh of a bound user keeps its canvas
+    bool bound = command.user < m_remoteUserCanvases.size() && m_remoteUserCanvases[command.user].view == command.view;
+    if (!bound && !SetRemoteUserCanvas(command.user, command.view, false)) {
+        m_subscriptions.Complete(command.ticket, false);
+        return;
+    }
+
+    const RteRemoteStreamRecord* stream = m_streamCatalog.FindUserVideoStream(command.user);
+    if (!m_channel || !stream || stream->videoSubscribed) {
+        m_subscriptions.Complete(command.ticket, true);
+        return;
+    }
+
+    // Cancelled when the binding is superseded, and with every other pending
+    // operation by a leave or CancelPendingOperations
+    auto source = std::make_shared<RteCancellationSource>();
+    RteCancellationToken parent = m_cancelSource.GetToken();
+    int listener = parent.Register([source]() { source->Cancel(); });
+    m_subscriptionCancels[command.ticket] = source;
+    RteSpawn(m_loop, SubscribeUserVideoAsync(stream->streamId, source->GetToken()),
+        [this, command, parent, listener](bool succeeded) {
+            parent.Unregister(listener);
+            OnSubscriptionDone(command, succeeded);
+        });
+}
+
+void RteManager::OnSubscriptionDone(const RteSubscriptionCommand& command, bool succeeded) {
+    // Gone if the subscriptions were reset by a leave or reconnect meanwhile
+    if (m_subscriptionCancels.erase(command.ticket) == 0) {
+        return;
+    }
+    if (!m_subscriptions.Complete(command.ticket, succeeded) || !succeeded) {
+        ReleaseUserVideo(command.user);
+    }
+    PostSubscriptionPump();
 }
 
-void RteManager::OnRemoteUserLeft(const std::string& userId) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    auto it = std::find(m_remoteUsers.begin(), m_remoteUsers.end(), userId);
-    if (it != m_remoteUsers.end()) {
-        m_remoteUsers.erase(it);
+// Returns false only if cancelled. A track that fails to subscribe leaves the
+// canvas in place; the next announcement of the stream retries it.
+RteTask<bool> RteManager::SubscribeUserVideoAsync(std::string streamId, RteCancellationToken token) {
+    if (!m_channel) {
+        co_return false;
+    }
+
+    RteAwaitResult<std::shared_ptr<rte::Track>> result = co_await RteAwaitSubscribe(m_channel.get(), streamId,
+        rte::TrackMediaType::kRteTrackMediaTypeVideo, kRteOpTimeoutMs, token);
+    if (result.status == RteOpStatus::Cancelled) {
+        co_return false;
+    }
+    if (!result.Succeeded()) {
+        LOG_WARN_LIMITED_FMT("Subscribe video {} {}: error={}", streamId, GetRteOpStatusString(result.status), result.errorCode);
+        co_return true;
+    }
+
+    m_subscribedTracks[streamId] = result.value;
+    m_streamCatalog.SetVideoSubscribed(streamId, true);
+    co_return true;
+}
+
+void RteManager::ReleaseUserVideo(UserHandle user) {
+    SetRemoteUserCanvas(user, nullptr, false);
+
+    const RteRemoteStreamRecord* stream = m_streamCatalog.FindUserVideoStream(user);
+    if (!stream || !stream->videoSubscribed) {
+        return;
+    }
+    std::string streamId = stream->streamId;
+    m_streamCatalog.SetVideoSubscribed(streamId, false);
+    m_subscribedTracks.erase(streamId);
+    if (m_channel) {
+        m_channel->UnsubscribeTrack(streamId, nullptr, [streamId](rte::Error* err) {
+            if (err && err->Code() != kRteOk) {
+                LOG_WARN_LIMITED_FMT("Unsubscribe video {} failed: error={}", streamId, err->Code());
+            }
+        });
+    }
+}
+
+// Canvases and tracks went with the channel: drop the queue and wake its in-flight subscribes
+void RteManager::ResetSubscriptions() {
+    for (auto& item : m_subscriptionCancels) {
+        item.second->Cancel();
+    }
+    m_subscriptionCancels.clear();
+    m_subscriptions.Clear();
+}
+
+RteSubscriptionQueueStats RteManager::GetSubscriptionStats() {
+    return RunOnStrand("get_subscription_stats", [this]() { return m_subscriptions.GetStats(); });
+}
+
+// Users from a join callback or the presence snapshot. Known users are
+// skipped; a large batch is announced as one UserSnapshot so the UI inserts
+// the roster in bulk instead of handling a UserJoined per user.
+void RteManager::OnRemoteUsersJoined(const std::vector<UserHandle>& users, bool snapshot) {
+    UserHandle localUser = UserIdInterner::instance().Find(m_userId);
+    std::vector<UserHandle> added;
+    for (UserHandle user : users) {
+        if (user == kInvalidUserHandle || user == localUser) {
+            continue;
+        }
+        if (user >= m_isRemoteUser.size()) {
+            m_isRemoteUser.resize(user + 1, false);
+        }
+        if (m_isRemoteUser[user]) {
+            continue;
+        }
+        m_isRemoteUser[user] = true;
+        m_remoteUsers.push_back(user);
+        added.push_back(user);
+    }
+
+    if (snapshot) {
+        long long elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - m_joinStartedAt).count();
+        LOG_INFO_FMT("User presence snapshot: {} users, {} new, {}ms after join", users.size(), added.size(), elapsedMs);
+    }
+    if (added.empty()) {
+        return;
+    }
+
+    if (snapshot || added.size() >= kUserSnapshotMinBatch) {
+        m_eventBus.Publish(RteEvent::UserSnapshot(std::make_shared<const std::vector<UserHandle>>(m_remoteUsers)));
+    } else {
+        for (UserHandle user : added) {
+            LOG_INFO_LIMITED_FMT("Remote user joined: {}", LogUser(user));
+            m_eventBus.Publish(RteEvent::UserJoined(user));
+        }
+    }
+    m_eventBus.Publish(RteEvent::UserListChanged());
+}
+
+void RteManager::OnRemoteUserLeft(UserHandle user) {
+    if (user < m_isRemoteUser.size() && m_isRemoteUser[user]) {
+        m_isRemoteUser[user] = false;
+        m_remoteUsers.erase(std::find(m_remoteUsers.begin(), m_remoteUsers.end(), user));
     }
     
-    // Clean up canvas for this user
-    if (m_remoteUserCanvases.count(userId)) {
-        m_remoteUserCanvases.erase(userId);
+    // Clean up canvas, pending subscription and streams for this user
+    SetRemoteUserCanvas(user, nullptr, false);
+    uint64_t ticket = m_subscriptions.RemoveUser(user);
+    auto pending = m_subscriptionCancels.find(ticket);
+    if (pending != m_subscriptionCancels.end()) {
+        pending->second->Cancel();
     }
+    m_streamCatalog.RemoveUser(user);
     
-    LOG_INFO_FMT("Remote user left: {}", userId);
-}
\ No newline at end of file
+    LOG_INFO_LIMITED_FMT("Remote user left: {}", LogUser(user));
+
+    m_eventBus.Publish(RteEvent::UserLeft(user));
+    m_eventBus.Publish(RteEvent::UserListChanged());
+}
+
+// Stream media flags also drive the remote audio / video state events
+// (2 = decoding, 0 = stopped)
+void RteManager::OnRemoteStreamsAdded(const std::vector<RteRemoteStreamRecord>& streams) {
+    for (const RteRemoteStreamRecord& stream : streams) {
+        m_streamCatalog.Update(stream.streamId, stream.user, stream.hasAudio, stream.hasVideo);
+        LOG_INFO_LIMITED_FMT("Remote stream added: {} of {}, audio={}, video={}",
+            stream.streamId, LogUser(stream.user), stream.hasAudio, stream.hasVideo);
+
+        if (stream.user == kInvalidUserHandle) {
+            continue;
+        }
+        if (stream.hasAudio) {
+            m_eventBus.Publish(RteEvent::RemoteAudioStateChanged(stream.user, 2));
+        }
+        if (stream.hasVideo) {
+            // A bound user only has a canvas so far; its track is subscribed by the queue
+            m_subscriptions.Refresh(stream.user);
+            m_eventBus.Publish(RteEvent::RemoteVideoStateChanged(stream.user, 2));
+        }
+    }
+    PostSubscriptionPump();
+}
+
+void RteManager::OnRemoteStreamsRemoved(const std::vector<std::string>& streamIds) {
+    for (const std::string& streamId : streamIds) {
+        const RteRemoteStreamRecord* found = m_streamCatalog.Find(streamId);
+        if (!found) {
+            continue;
+        }
+        RteRemoteStreamRecord stream = *found;
+        m_streamCatalog.Remove(streamId);
+        m_subscribedTracks.erase(streamId);
+        LOG_INFO_LIMITED_FMT("Remote stream removed: {} of {}", streamId, LogUser(stream.user));
+
+        if (stream.user == kInvalidUserHandle) {
+            continue;
+        }
+        // Another stream of the user may still carry the media
+        std::vector<RteRemoteStreamRecord> remaining;
+        m_streamCatalog.GetUserStreams(stream.user, remaining);
+        bool audioLeft = std::any_of(remaining.begin(), remaining.end(),
+            [](const RteRemoteStreamRecord& record) { return record.hasAudio; });
+        if (stream.hasAudio && !audioLeft) {
+            m_eventBus.Publish(RteEvent::RemoteAudioStateChanged(stream.user, 0));
+        }
+        if (stream.hasVideo && !m_streamCatalog.FindUserVideoStream(stream.user)) {
+            m_eventBus.Publish(RteEvent::RemoteVideoStateChanged(stream.user, 0));
+        }
+    }
+}
+
+void RteManager::SetReconnectPolicy(const ReconnectPolicy& policy) {
+    m_reconnectController.SetPolicy(policy);
+}
+
+void RteManager::CancelPendingOperations() {
+    LOG_INFO("CancelPendingOperations");
+    m_cancelSource.Cancel();
+}
+
+void RteManager::OnLinkStateChanged(rte::LocalUserLinkState oldState, rte::LocalUserLinkState newState,
+                                    rte::LocalUserLinkStateChangedReason reason) {
+    LOG_INFO_FMT("OnLinkStateChanged: {} -> {}, reason={}", oldState, newState, reason);
+
+    m_eventBus.Publish(RteEvent::ConnectionStateChanged(newState));
+
+    // Only a joined channel is worth restoring; connect/join failures are reported by the join steps
+    if (!m_inChannel.load()) {
+        return;
+    }
+
+    switch (newState) {
+        case kRteLocalUserLinkStateConnected:
+            m_reconnectController.OnLinkRestored();
+            break;
+
+        case kRteLocalUserLinkStateSuspended:
+            // The SDK keeps retrying on its own while suspended
+            m_reconnectController.OnLinkLost(true);
+            break;
+
+        case kRteLocalUserLinkStateDisconnected:
+        case kRteLocalUserLinkStateFailed:
+            switch (reason) {
+                case kRteLocalUserLinkStateChangedReasonDisconnect:
+                case kRteLocalUserLinkStateChangedReasonLeave:
+                    // Requested by us (leave or a reconnect attempt resetting the link)
+                    break;
+
+                case kRteLocalUserLinkStateChangedReasonConnectNotAuthorized:
+                case kRteLocalUserLinkStateChangedReasonInvalidToken:
+                case kRteLocalUserLinkStateChangedReasonTokenExpired:
+                case kRteLocalUserLinkStateChangedReasonSameUidLogin:
+                case kRteLocalUserLinkStateChangedReasonKickedOutByServer:
+                    // Retrying with the same credentials cannot succeed
+                    LOG_ERROR_FMT("Connection lost for a non retryable reason: {}", reason);
+                    m_inChannel.store(false);
+                    m_eventBus.Publish(RteEvent::Error(kRteManagerErrorReconnectFailed));
+                    break;
+
+                default:
+                    m_reconnectController.OnLinkLost(false);
+                    break;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+// Runs on the reconnect controller thread; the attempt itself runs on the strand
+bool RteManager::ReconnectAttempt(int attempt) {
+    return RteSyncWait(m_loop, ReconnectAttemptAsync(attempt));
+}
+
+RteTask<bool> RteManager::ReconnectAttemptAsync(int attempt) {
+    LOG_INFO_FMT("ReconnectAttempt: attempt={}, channelId={}", attempt + 1, m_channelId);
+
+    ResetChannel();
+
+    // Drop the stale link before connecting again
+    if (m_localUser) {
+        // Any result other than a cancel means the old link is gone
+        RteAwaitResult<bool> result = co_await RteAwaitDisconnect(m_localUser.get(), kRteDisconnectTimeoutMs,
+                                                                  m_cancelSource.GetToken());
+        if (result.status == RteOpStatus::Cancelled) {
+            co_return false;
+        }
+    }
+
+    if (!co_await ConnectLocalUserAsync(m_token) || !EnterChannel(m_channelId)) {
+        co_return false;
+    }
+    co_return co_await PublishLocalStreamAsync();
+}
+
+// Drops the channel and every canvas without disconnecting the local user
+void RteManager::ResetChannel() {
+    if (m_channel) {
+        rte::Error err;
+        if (m_localStream) {
+            m_channel->UnpublishStream(m_localStream.get(), [](rte::Error* err) {});
+            m_localStream.reset();
+        }
+        m_channel->Leave(&err);
+        if (m_channelObserver) {
+            m_channel->UnregisterObserver(m_channelObserver.get(), &err);
+            m_channelObserver.reset();
+        }
+        m_channel.reset();
+    }
+
+    m_remoteUsers.clear();
+    m_isRemoteUser.clear();
+    m_remoteUserCanvases.clear();
+    ResetSubscriptions();
+    m_subscribedTracks.clear();
+    m_streamCatalog.Clear();
+}
+
+void RteManager::OnReconnected(long long outageMs, int attempts) {
+    if (!IsOnStrand()) {
+        PostToStrand("reconnected", [this, outageMs, attempts]() { OnReconnected(outageMs, attempts); });
+        return;
+    }
+
+    LOG_INFO_FMT("Connection restored: outage={}ms, attempts={}", outageMs, attempts);
+
+    // Canvases do not survive a reconnect; forget the old bindings so the
+    // next SetViewUserBindings recreates every canvas in one pass
+    m_remoteUserCanvases.clear();
+    ResetSubscriptions();
+
+    m_eventBus.Publish(RteEvent::ConnectionRestored(outageMs, attempts));
+}
+
+void RteManager::OnReconnectGaveUp(long long outageMs, int attempts) {
+    if (!IsOnStrand()) {
+        PostToStrand("reconnect_gave_up", [this, outageMs, attempts]() { OnReconnectGaveUp(outageMs, attempts); });
+        return;
+    }
+
+    LOG_ERROR_FMT("Reconnect gave up: outage={}ms, attempts={}", outageMs, attempts);
+    m_inChannel.store(false);
+    m_eventBus.Publish(RteEvent::Error(kRteManagerErrorReconnectFailed));
+}
@@ -4,11 +4,29 @@
 #include <vector>
 #include <map>
 #include <memory>
-#include <mutex>
+#include <atomic>
+#include <future>
+#include <functional>
+#include <chrono>
 
 #include "rte_cpp.h"
 
 #include "IRteManagerEventHandler.h"
+#include "ReconnectController.h"
+#include "RteAsyncOperation.h"
+#include "RteEventLoop.h"
+#include "RteCoroutine.h"
+#include "RteEventBus.h"
+#include "RteStreamCatalog.h"
+#include "RteSubscriptionQueue.h"
+#include "UserIdInterner.h"
+
+// A video window bound to the remote user rendered in it
+struct RteViewBinding {
+    void* view;
+    UserHandle user;
+    bool visible;       // False for overscan cells, which are subscribed after the visible ones
+};
 
 // Configuration for RteManager
 struct RteManagerConfig {
@@ -16,6 +34,14 @@ struct RteManagerConfig {
     std::string userId;
 };
 
+// Wraps the RTE engine, the local user, the channel and the local tracks.
+//
+// Threading: all state is owned by one strand (m_loop). SDK observer callbacks
+// and calls from other threads are posted to it as messages, so no lock is
+// needed and no SDK call runs under one. Commands without a result return as
+// soon as they are queued; the others (Initialize, join phases, LeaveChannel,
+// SetEventHandler, SetupRemoteVideo) block the caller until the strand has run them.
+// Events are published on the strand thread to m_eventBus.
 class RteManager {
 public:
     RteManager();
@@ -25,21 +51,116 @@ public:
     bool Initialize(const RteManagerConfig& config);
     void Destroy();
 
+    // Teardown phases. Destroy runs LeaveChannel, StopLocalTracks and ReleaseEngine
+    // in order; the channel page queues them on RteTeardownWorker instead.
+    void StopLocalTracks();
+    void ReleaseEngine();
+
     bool JoinChannel(const std::string& channelId, const std::string& token);
     void LeaveChannel();
+
+    // Join phases. JoinChannel runs them in order; JoinOrchestrator runs the
+    // independent ones (mic, camera) in parallel with the connect/join chain.
+    bool ConnectLocalUser(const std::string& token);
+    bool EnterChannel(const std::string& channelId);
+    bool StartMicTrack();
+    bool StartCameraTrack();
+    bool PublishLocalStream();
+
+    // Coroutine versions of the phases above. They run on the manager's event loop
+    // and hold no thread while waiting for SDK callbacks; the blocking versions
+    // wait for them with RteSyncWait and must not be called on that loop.
+    RteTask<bool> JoinChannelAsync(std::string channelId, std::string token);
+    RteTask<bool> ConnectLocalUserAsync(std::string token);
+    RteTask<bool> StartMicTrackAsync();
+    RteTask<bool> StartCameraTrackAsync();
+    RteTask<bool> PublishLocalStreamAsync();
+
+    // Subscribe to remote tracks with every request in flight at once.
+    // Returns the number of tracks subscribed.
+    int SubscribeTracks(const std::vector<std::string>& streamIds, rte::TrackMediaType mediaType);
+    RteTask<int> SubscribeTracksAsync(std::vector<std::string> streamIds, rte::TrackMediaType mediaType);
+
+    // Remote streams as last reported by the channel, from the stream catalog;
+    // no SDK call is made. Waits for the strand.
+    std::vector<RteRemoteStreamRecord> GetRemoteStreams(UserHandle user);
+    size_t GetRemoteStreamCount();
+
+    // Remote users in the channel, in arrival order. Waits for the strand.
+    std::vector<UserHandle> GetRemoteUsers();
+
+    RteEventLoop& GetEventLoop() { return m_loop; }
+    RteEventLoopStats GetStrandStats() const { return m_loop.GetStats(); }
+
+    // Every event is published here; SetEventHandler is a convenience subscriber.
+    // Other observers (stats panels, recorders) subscribe directly.
+    RteEventBus& GetEventBus() { return m_eventBus; }
     void RenewToken(const std::string& token);
 
     void SetLocalAudioCaptureEnabled(bool enabled);
     void SetLocalVideoCaptureEnabled(bool enabled);
 
-    void SetViewUserBindings(const std::map<void*, std::string>& viewToUserMap);
-    int SetupRemoteVideo(const std::string& userId, void* view);
+    // Replace the view bindings. They are the desired state of the subscription
+    // queue: only views whose user changed get a new canvas (and video track),
+    // a few at a time, and bindings replaced before they were applied cost nothing.
+    void SetViewUserBindings(const std::vector<RteViewBinding>& bindings);
+    int SetupRemoteVideo(UserHandle user, void* view);
+
+    // Release every remote canvas while the video area cannot be seen, so
+    // nothing is decoded or rendered; audio keeps playing. Bindings made while
+    // paused are recorded, and resuming recreates all canvases in one pass.
+    void SetRemoteVideoPaused(bool paused);
+
+    // Counters of the subscription queue. Waits for the strand.
+    RteSubscriptionQueueStats GetSubscriptionStats();
+
+    void SetReconnectPolicy(const ReconnectPolicy& policy);
+
+    // Wake every pending SDK wait (join phases, reconnect attempts) with a Cancelled
+    // status. Callbacks arriving afterwards are dropped. Safe to call from any thread.
+    void CancelPendingOperations();
+    // Cancelled by CancelPendingOperations, for waits of the join outside the
+    // manager such as the token request
+    RteCancellationToken GetCancellationToken() const { return m_cancelSource.GetToken(); }
 
 private:
     friend class RteManagerEventObserver;
-
-    void OnRemoteUserJoined(const std::string& userId);
-    void OnRemoteUserLeft(const std::string& userId);
+    friend class RteManagerLocalUserObserver;
+
+    void OnRemoteUsersJoined(const std::vector<UserHandle>& users, bool snapshot);
+    void OnRemoteUserLeft(UserHandle user);
+    void OnRemoteStreamsAdded(const std::vector<RteRemoteStreamRecord>& streams);
+    void OnRemoteStreamsRemoved(const std::vector<std::string>& streamIds);
+    bool SetRemoteUserCanvas(UserHandle user, void* view, bool fit);
+    std::shared_ptr<rte::Canvas> CreateRemoteCanvas(UserHandle user, void* view, bool fit);
+    void PostSubscriptionPump();
+    void PumpSubscriptions();
+    void RunSubscriptionCommand(const RteSubscriptionCommand& command);
+    void OnSubscriptionDone(const RteSubscriptionCommand& command, bool succeeded);
+    RteTask<bool> SubscribeUserVideoAsync(std::string streamId, RteCancellationToken token);
+    void ReleaseUserVideo(UserHandle user);
+    void ResetSubscriptions();
+    void OnLinkStateChanged(rte::LocalUserLinkState oldState, rte::LocalUserLinkState newState,
+                            rte::LocalUserLinkStateChangedReason reason);
+
+    // Strand helpers
+    bool IsOnStrand() const;
+    bool PostToStrand(const char* label, std::function<void()> task);
+    template<typename Func>
+    auto RunOnStrand(const char* label, Func func) -> decltype(func());
+
+    RteTask<bool> InitializeAsync(RteManagerConfig config);
+    RteTask<bool> InitMediaEngineAsync();
+    void LeaveChannelOnStrand();
+    void ReleaseEngineOnStrand();
+    void StopReconnect();
+
+    // Reconnect support
+    bool ReconnectAttempt(int attempt);
+    RteTask<bool> ReconnectAttemptAsync(int attempt);
+    void ResetChannel();
+    void OnReconnected(long long outageMs, int attempts);
+    void OnReconnectGaveUp(long long outageMs, int attempts);
 
 private:
     std::shared_ptr<rte::Rte> m_rte;
@@ -49,17 +170,61 @@ private:
     std::shared_ptr<rte::MicAudioTrack> m_micAudioTrack;
     std::shared_ptr<rte::CameraVideoTrack> m_cameraVideoTrack;
     std::shared_ptr<rte::ChannelObserver> m_channelObserver;
+    std::shared_ptr<rte::LocalUserObserver> m_localUserObserver;
 
 
-    IRteManagerEventHandler* m_eventHandler;
+    int m_handlerSubscription;          // Bus subscription of the SetEventHandler handler
 
     std::string m_appId;
     std::string m_userId;
     std::string m_channelId;
+    std::string m_token;                // Last token, reused by reconnect attempts
+
+    bool m_audioTrackStarted;
+    bool m_videoTrackStarted;
+    bool m_remoteVideoPaused;
+
+    // The view is kept without a canvas while remote video is paused
+    struct RemoteCanvas {
+        void* view;
+        bool fit;                               // Fit render mode instead of the SDK default
+        std::shared_ptr<rte::Canvas> canvas;
+
+        RemoteCanvas() : view(nullptr), fit(false) {}
+    };
+
+    RteSubscriptionQueue m_subscriptions;                               // Desired view bindings -> SDK commands
+    std::map<uint64_t, std::shared_ptr<RteCancellationSource>> m_subscriptionCancels;   // By in-flight ticket
+    bool m_subscriptionPumpPosted;
+    std::vector<RemoteCanvas> m_remoteUserCanvases;                     // Indexed by UserHandle
+    std::vector<UserHandle> m_remoteUsers;
+    std::vector<bool> m_isRemoteUser;                                   // Indexed by UserHandle
+    std::chrono::steady_clock::time_point m_joinStartedAt;              // For the time to the presence snapshot
+    std::map<std::string, std::shared_ptr<rte::Track>> m_subscribedTracks;    // By stream id
+    RteStreamCatalog m_streamCatalog;
+
+    // Members above are owned by the strand; the ones below are used across threads
+    std::atomic<bool> m_inChannel;      // Fully joined and published, link loss triggers reconnect.
+                                        // Cleared off the strand before a leave so queued link events are ignored
+    ReconnectController m_reconnectController;
+    RteCancellationSource m_cancelSource;
+    RteEventBus m_eventBus;
+    RteEventLoop m_loop;                // The strand; also resumes coroutine phases after SDK callbacks
+};
 
-    // Thread-safe members
-    std::mutex m_mutex;
-    std::map<void*, std::string> m_viewToUserMap;
-    std::map<std::string, std::shared_ptr<rte::Canvas>> m_remoteUserCanvases;
-    std::vector<std::string> m_remoteUsers;
-};
\ No newline at end of file
+// Run `func` on the strand and wait for its result. Runs inline when already on it.
+template<typename Func>
+auto RteManager::RunOnStrand(const char* label, Func func) -> decltype(func()) {
+    typedef decltype(func()) Result;
+    if (IsOnStrand()) {
+        return func();
+    }
+
+    auto task = std::make_shared<std::packaged_task<Result()>>(func);
+    std::future<Result> result = task->get_future();
+    if (!m_loop.Post([task]() { (*task)(); }, label)) {
+        // Stopped between the check and the post; nothing else runs on it any more
+        return func();
+    }
+    return result.get();
+}
\ No newline at end of file
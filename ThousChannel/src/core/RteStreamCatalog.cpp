@@ -0,0 +1,143 @@
+#include "pch.h"
+#include "RteStreamCatalog.h"
+#include <algorithm>
+
+bool RteStreamCatalog::Update(const std::string& streamId, UserHandle user, bool hasAudio, bool hasVideo) {
+    auto it = m_byStreamId.find(streamId);
+    if (it != m_byStreamId.end()) {
+        size_t index = it->second;
+        RteRemoteStreamRecord& record = m_records[index];
+        if (record.user != user) {
+            UnlinkUser(index);
+            record.user = user;
+            LinkUser(index);
+        }
+        record.hasAudio = hasAudio;
+        record.hasVideo = hasVideo;
+        record.audioSubscribed = record.audioSubscribed && hasAudio;
+        record.videoSubscribed = record.videoSubscribed && hasVideo;
+        return false;
+    }
+
+    RteRemoteStreamRecord record;
+    record.streamId = streamId;
+    record.user = user;
+    record.hasAudio = hasAudio;
+    record.hasVideo = hasVideo;
+    record.audioSubscribed = false;
+    record.videoSubscribed = false;
+    m_records.push_back(record);
+    m_byStreamId[streamId] = m_records.size() - 1;
+    LinkUser(m_records.size() - 1);
+    return true;
+}
+
+bool RteStreamCatalog::Remove(const std::string& streamId) {
+    auto it = m_byStreamId.find(streamId);
+    if (it == m_byStreamId.end()) {
+        return false;
+    }
+
+    size_t index = it->second;
+    size_t last = m_records.size() - 1;
+    UnlinkUser(index);
+    m_byStreamId.erase(it);
+
+    if (index != last) {
+        // The last record takes the freed slot; repoint its index entries
+        UnlinkUser(last);
+        m_records[index] = std::move(m_records[last]);
+        m_byStreamId[m_records[index].streamId] = index;
+        LinkUser(index);
+    }
+    m_records.pop_back();
+    return true;
+}
+
+int RteStreamCatalog::RemoveUser(UserHandle user) {
+    if (user == kInvalidUserHandle || user >= m_byUser.size()) {
+        return 0;
+    }
+
+    int removed = 0;
+    while (!m_byUser[user].empty()) {
+        std::string streamId = m_records[m_byUser[user].back()].streamId;
+        Remove(streamId);
+        ++removed;
+    }
+    return removed;
+}
+
+void RteStreamCatalog::Clear() {
+    m_records.clear();
+    m_byStreamId.clear();
+    m_byUser.clear();
+}
+
+bool RteStreamCatalog::SetAudioSubscribed(const std::string& streamId, bool subscribed) {
+    auto it = m_byStreamId.find(streamId);
+    if (it == m_byStreamId.end() || (subscribed && !m_records[it->second].hasAudio)) {
+        return false;
+    }
+    m_records[it->second].audioSubscribed = subscribed;
+    return true;
+}
+
+bool RteStreamCatalog::SetVideoSubscribed(const std::string& streamId, bool subscribed) {
+    auto it = m_byStreamId.find(streamId);
+    if (it == m_byStreamId.end() || (subscribed && !m_records[it->second].hasVideo)) {
+        return false;
+    }
+    m_records[it->second].videoSubscribed = subscribed;
+    return true;
+}
+
+const RteRemoteStreamRecord* RteStreamCatalog::Find(const std::string& streamId) const {
+    auto it = m_byStreamId.find(streamId);
+    return it != m_byStreamId.end() ? &m_records[it->second] : nullptr;
+}
+
+void RteStreamCatalog::GetUserStreams(UserHandle user, std::vector<RteRemoteStreamRecord>& records) const {
+    if (user == kInvalidUserHandle || user >= m_byUser.size()) {
+        return;
+    }
+    for (size_t index : m_byUser[user]) {
+        records.push_back(m_records[index]);
+    }
+}
+
+const RteRemoteStreamRecord* RteStreamCatalog::FindUserVideoStream(UserHandle user) const {
+    if (user == kInvalidUserHandle || user >= m_byUser.size()) {
+        return nullptr;
+    }
+    for (size_t index : m_byUser[user]) {
+        if (m_records[index].hasVideo) {
+            return &m_records[index];
+        }
+    }
+    return nullptr;
+}
+
+void RteStreamCatalog::LinkUser(size_t index) {
+    UserHandle user = m_records[index].user;
+    if (user == kInvalidUserHandle) {
+        return;
+    }
+    if (user >= m_byUser.size()) {
+        m_byUser.resize(user + 1);
+    }
+    m_byUser[user].push_back(index);
+}
+
+void RteStreamCatalog::UnlinkUser(size_t index) {
+    UserHandle user = m_records[index].user;
+    if (user == kInvalidUserHandle || user >= m_byUser.size()) {
+        return;
+    }
+    std::vector<size_t>& indices = m_byUser[user];
+    auto it = std::find(indices.begin(), indices.end(), index);
+    if (it != indices.end()) {
+        *it = indices.back();
+        indices.pop_back();
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "UserIdInterner.h"
+
+// What RteManager knows about one remote stream
+struct RteRemoteStreamRecord {
+    std::string streamId;
+    UserHandle user;            // Publisher; kInvalidUserHandle if the SDK did not say
+    bool hasAudio;
+    bool hasVideo;
+    bool audioSubscribed;
+    bool videoSubscribed;
+};
+
+// Remote streams by stream id and by publishing user, maintained from the
+// channel's stream added / removed callbacks. Every update and lookup is O(1)
+// on average (a user publishes a handful of streams at most), and queries
+// never call into the SDK. Owned by the RteManager strand, not thread-safe.
+class RteStreamCatalog {
+public:
+    // Add a stream or refresh its media flags. The subscription state of a
+    // known stream is kept unless it lost that media. Returns true if new.
+    bool Update(const std::string& streamId, UserHandle user, bool hasAudio, bool hasVideo);
+    // Returns false for an unknown stream
+    bool Remove(const std::string& streamId);
+    // Drop every stream of `user`; returns how many
+    int RemoveUser(UserHandle user);
+    void Clear();
+
+    // Returns false for an unknown stream or a media type it does not carry
+    bool SetAudioSubscribed(const std::string& streamId, bool subscribed);
+    bool SetVideoSubscribed(const std::string& streamId, bool subscribed);
+
+    // Null for an unknown stream; invalidated by the next update
+    const RteRemoteStreamRecord* Find(const std::string& streamId) const;
+
+    // Streams of `user`, appended to `records`
+    void GetUserStreams(UserHandle user, std::vector<RteRemoteStreamRecord>& records) const;
+    // First stream of `user` carrying video, or null
+    const RteRemoteStreamRecord* FindUserVideoStream(UserHandle user) const;
+
+    size_t Size() const { return m_records.size(); }
+    const std::vector<RteRemoteStreamRecord>& GetRecords() const { return m_records; }
+
+private:
+    void LinkUser(size_t index);
+    void UnlinkUser(size_t index);
+
+    std::vector<RteRemoteStreamRecord> m_records;           // Dense; removal moves the last record into the hole
+    std::unordered_map<std::string, size_t> m_byStreamId;   // Stream id -> record index
+    std::vector<std::vector<size_t>> m_byUser;              // UserHandle -> record indices
+};
@@ -0,0 +1,282 @@
+#include "pch.h"
+#include "RteSubscriptionQueue.h"
+#include <algorithm>
+#include <unordered_set>
+
+RteSubscriptionQueue::RteSubscriptionQueue(int maxInFlight)
+    : m_maxInFlight((std::max)(maxInFlight, 1)), m_inFlight(0), m_nextTicket(1), m_stats() {
+}
+
+bool RteSubscriptionQueue::IsPending(const Entry& entry) {
+    if (entry.ticket != 0 || entry.removed) {
+        return false;
+    }
+    if (entry.desired && entry.desired == entry.failed) {
+        return false;
+    }
+    return entry.desired != entry.actual || (entry.stale && entry.desired != nullptr);
+}
+
+void RteSubscriptionQueue::SetDesired(const std::vector<RteSubscriptionTarget>& targets, std::vector<uint64_t>& cancel) {
+    std::unordered_map<UserHandle, size_t> wanted;
+    std::unordered_set<void*> views;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        const RteSubscriptionTarget& target = targets[i];
+        if (target.user == kInvalidUserHandle || !target.view || wanted.count(target.user) || views.count(target.view)) {
+            continue;
+        }
+        wanted[target.user] = i;
+        views.insert(target.view);
+    }
+
+    std::vector<UserHandle> idle;
+    for (auto& item : m_entries) {
+        Entry& entry = item.second;
+        auto it = wanted.find(item.first);
+        void* desired = (it != wanted.end()) ? targets[it->second].view : nullptr;
+        if (IsPending(entry) && desired != entry.desired) {
+            ++m_stats.superseded;
+        }
+        // A removed user's command is cancelled already
+        if (entry.ticket != 0 && entry.op == RteSubscriptionOp::Subscribe && entry.opView != desired &&
+            !entry.cancelRequested) {
+            entry.cancelRequested = true;
+            cancel.push_back(entry.ticket);
+            ++m_stats.cancelled;
+        }
+
+        if (desired != entry.desired) {
+            entry.failed = nullptr;
+        }
+        entry.desired = desired;
+        if (it != wanted.end()) {
+            entry.visible = targets[it->second].visible;
+            entry.order = static_cast<int>(it->second);
+            wanted.erase(it);
+        } else if (entry.ticket == 0 && entry.actual == nullptr) {
+            idle.push_back(item.first);
+        }
+    }
+
+    for (const auto& item : wanted) {
+        Entry& entry = m_entries[item.first];
+        entry.desired = targets[item.second].view;
+        entry.visible = targets[item.second].visible;
+        entry.order = static_cast<int>(item.second);
+    }
+    for (UserHandle user : idle) {
+        m_entries.erase(user);
+    }
+}
+
+void RteSubscriptionQueue::Refresh(UserHandle user) {
+    auto it = m_entries.find(user);
+    if (it != m_entries.end() && !it->second.removed) {
+        it->second.stale = (it->second.actual != nullptr);
+        it->second.failed = nullptr;
+    }
+}
+
+uint64_t RteSubscriptionQueue::RemoveUser(UserHandle user) {
+    auto it = m_entries.find(user);
+    if (it == m_entries.end()) {
+        return 0;
+    }
+
+    Entry& entry = it->second;
+    if (entry.actual) {
+        ReleaseView(entry.actual, user);
+    }
+    if (entry.ticket == 0) {
+        m_entries.erase(it);
+        return 0;
+    }
+
+    // Kept until the completion comes back so the in-flight count stays right
+    if (entry.op == RteSubscriptionOp::Subscribe) {
+        ReleaseView(entry.opView, user);
+        if (!entry.cancelRequested) {
+            ++m_stats.cancelled;
+        }
+    }
+    entry.removed = true;
+    entry.desired = nullptr;
+    entry.actual = nullptr;
+    entry.cancelRequested = true;
+    return entry.ticket;
+}
+
+void RteSubscriptionQueue::Clear() {
+    m_entries.clear();
+    m_viewOwners.clear();
+    m_tickets.clear();
+    m_inFlight = 0;
+}
+
+void RteSubscriptionQueue::TakeReady(std::vector<RteSubscriptionCommand>& commands) {
+    if (m_inFlight >= m_maxInFlight) {
+        return;
+    }
+
+    // Visible subscribes, overscan subscribes, then unsubscribes; grid order within each
+    struct Candidate {
+        int rank;
+        int order;
+        UserHandle user;
+    };
+    std::vector<Candidate> candidates;
+    for (const auto& item : m_entries) {
+        const Entry& entry = item.second;
+        if (!IsPending(entry)) {
+            continue;
+        }
+        Candidate candidate;
+        candidate.user = item.first;
+        if (entry.desired) {
+            candidate.rank = entry.visible ? 0 : 1;
+            candidate.order = entry.order;
+        } else {
+            candidate.rank = 2;
+            candidate.order = static_cast<int>(item.first);
+        }
+        candidates.push_back(candidate);
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.rank != b.rank ? a.rank < b.rank : a.order < b.order;
+    });
+
+    for (const Candidate& candidate : candidates) {
+        if (m_inFlight >= m_maxInFlight) {
+            break;
+        }
+        Entry& entry = m_entries[candidate.user];
+        // Already issued above to free its view
+        if (!IsPending(entry)) {
+            continue;
+        }
+        if (!entry.desired) {
+            Issue(candidate.user, entry, RteSubscriptionOp::Unsubscribe, nullptr, commands);
+            continue;
+        }
+
+        auto owner = m_viewOwners.find(entry.desired);
+        if (owner != m_viewOwners.end() && owner->second != candidate.user) {
+            // Two canvases must not render into one view: move the holder out
+            // first, to its own new view if that one is free, and come back later
+            UserHandle holderUser = owner->second;
+            Entry& holder = m_entries[holderUser];
+            if (holder.ticket == 0) {
+                if (holder.desired && m_viewOwners.find(holder.desired) == m_viewOwners.end()) {
+                    Issue(holderUser, holder, RteSubscriptionOp::Subscribe, holder.desired, commands);
+                } else {
+                    Issue(holderUser, holder, RteSubscriptionOp::Unsubscribe, nullptr, commands);
+                }
+            }
+            continue;
+        }
+        Issue(candidate.user, entry, RteSubscriptionOp::Subscribe, entry.desired, commands);
+    }
+}
+
+void RteSubscriptionQueue::Issue(UserHandle user, Entry& entry, RteSubscriptionOp op, void* view,
+                                 std::vector<RteSubscriptionCommand>& commands) {
+    RteSubscriptionCommand command;
+    command.op = op;
+    command.user = user;
+    command.view = view;
+    command.ticket = m_nextTicket++;
+
+    entry.ticket = command.ticket;
+    entry.op = op;
+    entry.opView = view;
+    entry.stale = false;
+    entry.cancelRequested = false;
+    if (op == RteSubscriptionOp::Subscribe) {
+        m_viewOwners[view] = user;
+    }
+    m_tickets[command.ticket] = user;
+    ++m_inFlight;
+    ++m_stats.issued;
+    commands.push_back(command);
+}
+
+bool RteSubscriptionQueue::Complete(uint64_t ticket, bool succeeded) {
+    auto it = m_tickets.find(ticket);
+    if (it == m_tickets.end()) {
+        return false;
+    }
+    UserHandle user = it->second;
+    m_tickets.erase(it);
+    --m_inFlight;
+
+    Entry& entry = m_entries[user];
+    entry.ticket = 0;
+    bool stands = !entry.removed;
+    // A user that came back meanwhile starts over from no view
+    entry.removed = false;
+    if (entry.op == RteSubscriptionOp::Subscribe && succeeded && stands) {
+        if (entry.actual && entry.actual != entry.opView) {
+            ReleaseView(entry.actual, user);
+        }
+        entry.actual = entry.opView;
+        entry.failed = nullptr;
+    } else {
+        // Replacing the view released the old one even if the new one failed
+        if (entry.op == RteSubscriptionOp::Subscribe) {
+            ReleaseView(entry.opView, user);
+            if (!succeeded && !entry.cancelRequested) {
+                entry.failed = entry.opView;
+                ++m_stats.failed;
+            }
+        }
+        if (entry.actual) {
+            ReleaseView(entry.actual, user);
+        }
+        entry.actual = nullptr;
+    }
+    Prune(user);
+    return stands;
+}
+
+void RteSubscriptionQueue::ReleaseView(void* view, UserHandle user) {
+    auto it = m_viewOwners.find(view);
+    if (it != m_viewOwners.end() && it->second == user) {
+        m_viewOwners.erase(it);
+    }
+}
+
+void RteSubscriptionQueue::Prune(UserHandle user) {
+    auto it = m_entries.find(user);
+    if (it != m_entries.end() && it->second.ticket == 0 && !it->second.desired && !it->second.actual) {
+        m_entries.erase(it);
+    }
+}
+
+bool RteSubscriptionQueue::IsIdle() const {
+    if (m_inFlight > 0) {
+        return false;
+    }
+    for (const auto& item : m_entries) {
+        if (IsPending(item.second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void* RteSubscriptionQueue::GetView(UserHandle user) const {
+    auto it = m_entries.find(user);
+    return it != m_entries.end() ? it->second.actual : nullptr;
+}
+
+RteSubscriptionQueueStats RteSubscriptionQueue::GetStats() const {
+    RteSubscriptionQueueStats stats = m_stats;
+    stats.inFlight = m_inFlight;
+    stats.pending = 0;
+    for (const auto& item : m_entries) {
+        if (IsPending(item.second)) {
+            ++stats.pending;
+        }
+    }
+    return stats;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+#include "UserIdInterner.h"
+
+// A remote user the grid wants rendered into `view`
+struct RteSubscriptionTarget {
+    UserHandle user;
+    void* view;
+    bool visible;               // False for overscan tiles kept live for scrolling
+};
+
+enum class RteSubscriptionOp {
+    Subscribe,                  // Render `user` into `view` (replaces any other view of the user)
+    Unsubscribe                 // Release whatever `user` renders into
+};
+
+struct RteSubscriptionCommand {
+    RteSubscriptionOp op;
+    UserHandle user;
+    void* view;                 // Subscribe only
+    uint64_t ticket;            // Passed back to Complete
+};
+
+struct RteSubscriptionQueueStats {
+    uint64_t issued;            // Commands handed out by TakeReady
+    uint64_t superseded;        // Pending changes dropped before they were issued
+    uint64_t cancelled;         // In-flight subscribes whose target went away
+    uint64_t failed;            // Subscribes completed as failed
+    int inFlight;
+    int pending;                // Users whose subscription differs from the desired one, not in flight
+};
+
+// Subscription scheduler between the video grid and the SDK. The grid only
+// states what it wants to see; the queue keeps that end state and hands out
+// the commands still needed to reach it, at most maxInFlight at a time.
+// A change that has not been issued yet is replaced by the next SetDesired,
+// and an in-flight subscribe that is no longer wanted is reported for
+// cancellation, so a burst of page flips costs the SDK work of the last page
+// only. Visible subscribes go first, then overscan ones, then teardown; a
+// view still held by another user is released just before it is reused.
+// Owned by the RteManager strand, not thread-safe.
+class RteSubscriptionQueue {
+public:
+    explicit RteSubscriptionQueue(int maxInFlight);
+
+    // Replace the desired state; users not listed are to be unsubscribed. A
+    // view listed twice keeps its first user. Tickets of in-flight subscribes
+    // that no longer match are appended to `cancel`.
+    void SetDesired(const std::vector<RteSubscriptionTarget>& targets, std::vector<uint64_t>& cancel);
+
+    // Subscribe the user into its view again once nothing is in flight for it,
+    // e.g. after its video stream showed up. Also retries a view that failed.
+    void Refresh(UserHandle user);
+
+    // The user left: forget it. Returns its in-flight ticket, 0 if none.
+    uint64_t RemoveUser(UserHandle user);
+
+    // Forget everything; completions of commands still in flight are unknown tickets
+    void Clear();
+
+    // Append the next commands, keeping at most maxInFlight outstanding
+    void TakeReady(std::vector<RteSubscriptionCommand>& commands);
+
+    // A failed subscribe leaves the user with no view, and that view is not
+    // tried again until the desired one changes or Refresh. Returns false if the
+    // ticket is unknown or its user was removed meanwhile, in which case the
+    // caller undoes whatever the command set up.
+    bool Complete(uint64_t ticket, bool succeeded);
+
+    bool IsIdle() const;
+    // View `user` renders into as far as completed commands go, or null
+    void* GetView(UserHandle user) const;
+    RteSubscriptionQueueStats GetStats() const;
+
+private:
+    struct Entry {
+        void* desired;
+        bool visible;
+        int order;              // Position in the last SetDesired, orders subscribes
+        void* actual;
+        bool stale;             // Subscribe again into `actual`
+        void* failed;           // Last view whose subscribe failed
+        bool removed;           // Left while a command was in flight
+        uint64_t ticket;        // In-flight command, 0 if none
+        RteSubscriptionOp op;
+        void* opView;
+        bool cancelRequested;
+
+        Entry()
+            : desired(nullptr), visible(false), order(0), actual(nullptr), stale(false), failed(nullptr), removed(false),
+              ticket(0), op(RteSubscriptionOp::Unsubscribe), opView(nullptr), cancelRequested(false) {
+        }
+    };
+
+    static bool IsPending(const Entry& entry);
+    void Issue(UserHandle user, Entry& entry, RteSubscriptionOp op, void* view,
+               std::vector<RteSubscriptionCommand>& commands);
+    void ReleaseView(void* view, UserHandle user);
+    void Prune(UserHandle user);
+
+    int m_maxInFlight;
+    int m_inFlight;
+    uint64_t m_nextTicket;
+    std::unordered_map<UserHandle, Entry> m_entries;
+    std::unordered_map<void*, UserHandle> m_viewOwners;     // View -> user rendering or being subscribed into it
+    std::unordered_map<uint64_t, UserHandle> m_tickets;     // In-flight ticket -> user
+    RteSubscriptionQueueStats m_stats;
+};
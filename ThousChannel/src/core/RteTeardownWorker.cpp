@@ -0,0 +1,147 @@
+#include "pch.h"
+#include "RteTeardownWorker.h"
+#define LOG_CATEGORY LogCategory::Rte
+#include "Logger.h"
+
+RteTeardownJob::RteTeardownJob(const std::string& name, int deadlineMs)
+    : m_name(name), m_deadlineMs(deadlineMs) {
+}
+
+void RteTeardownJob::AddStep(const std::string& name, StepFunc func, bool mandatory) {
+    Step step;
+    step.name = name;
+    step.func = func;
+    step.mandatory = mandatory;
+    m_steps.push_back(step);
+}
+
+void RteTeardownJob::SetCompletionCallback(CompletionCallback callback) {
+    m_onComplete = callback;
+}
+
+RteTeardownWorker& RteTeardownWorker::Instance() {
+    static RteTeardownWorker worker;
+    return worker;
+}
+
+RteTeardownWorker::RteTeardownWorker()
+    : m_jobRunning(false), m_stopping(false) {
+}
+
+RteTeardownWorker::~RteTeardownWorker() {
+    Shutdown(0);
+}
+
+void RteTeardownWorker::Submit(const RteTeardownJob& job) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_stopping) {
+        lock.unlock();
+        LOG_WARN_FMT("RteTeardownWorker: shutting down, running job {} inline", job.m_name);
+        RunJob(job);
+        return;
+    }
+
+    // The worker thread is started lazily on the first teardown
+    if (!m_thread.joinable()) {
+        m_thread = std::thread(&RteTeardownWorker::WorkerLoop, this);
+    }
+
+    LOG_INFO_FMT("RteTeardownWorker: queued job {} ({} steps)", job.m_name, job.m_steps.size());
+    m_jobs.push_back(job);
+    m_jobCv.notify_one();
+}
+
+bool RteTeardownWorker::WaitIdle(int timeoutMs) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_idleCv.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+        [this]() { return m_jobs.empty() && !m_jobRunning; });
+}
+
+bool RteTeardownWorker::IsIdle() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_jobs.empty() && !m_jobRunning;
+}
+
+void RteTeardownWorker::Shutdown(int timeoutMs) {
+    bool idle = WaitIdle(timeoutMs);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_jobCv.notify_all();
+    }
+
+    if (!m_thread.joinable()) {
+        return;
+    }
+
+    if (idle) {
+        m_thread.join();
+    } else {
+        // Joining would hang the caller on a stuck SDK call
+        LOG_ERROR_FMT("RteTeardownWorker: teardown still running after {}ms, abandoning it", timeoutMs);
+        m_thread.detach();
+    }
+}
+
+void RteTeardownWorker::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_jobCv.wait(lock, [this]() { return !m_jobs.empty() || m_stopping; });
+        if (m_jobs.empty()) {
+            break;
+        }
+
+        RteTeardownJob job = m_jobs.front();
+        m_jobs.pop_front();
+        m_jobRunning = true;
+
+        lock.unlock();
+        RunJob(job);
+        lock.lock();
+
+        m_jobRunning = false;
+        if (m_jobs.empty()) {
+            m_idleCv.notify_all();
+        }
+    }
+}
+
+void RteTeardownWorker::RunJob(const RteTeardownJob& job) {
+    auto startTime = std::chrono::steady_clock::now();
+    auto elapsedMs = [startTime]() {
+        return static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime).count());
+    };
+
+    RteTeardownResult result;
+    result.name = job.m_name;
+    result.deadlineMissed = false;
+
+    for (const auto& step : job.m_steps) {
+        if (!step.mandatory && elapsedMs() > job.m_deadlineMs) {
+            LOG_WARN_FMT("RteTeardownWorker: {} past its {}ms deadline, skipping step {}",
+                job.m_name, job.m_deadlineMs, step.name);
+            result.deadlineMissed = true;
+            result.skippedSteps.push_back(step.name);
+            continue;
+        }
+
+        long long stepStart = elapsedMs();
+        try {
+            if (step.func) {
+                step.func();
+            }
+        } catch (const std::exception& e) {
+            LOG_ERROR_FMT("RteTeardownWorker: step {} threw: {}", step.name, e.what());
+        }
+        LOG_INFO_FMT("RteTeardownWorker: {} step {} took {}ms", job.m_name, step.name, elapsedMs() - stepStart);
+    }
+
+    result.elapsedMs = elapsedMs();
+    LOG_INFO_FMT("RteTeardownWorker: job {} finished in {}ms", job.m_name, result.elapsedMs);
+
+    if (job.m_onComplete) {
+        job.m_onComplete(result);
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+// Outcome of one teardown job, passed to its completion callback
+struct RteTeardownResult {
+    std::string name;
+    long long elapsedMs;
+    bool deadlineMissed;                    // At least one optional step was skipped because of the deadline
+    std::vector<std::string> skippedSteps;
+};
+
+// A named sequence of teardown steps, run strictly in order on the teardown worker.
+// Optional steps are skipped once the job deadline has passed; mandatory steps
+// (joining threads, destroying the engine, freeing memory) always run.
+class RteTeardownJob {
+public:
+    typedef std::function<void()> StepFunc;
+    typedef std::function<void(const RteTeardownResult&)> CompletionCallback;
+
+    RteTeardownJob(const std::string& name, int deadlineMs);
+
+    void AddStep(const std::string& name, StepFunc func, bool mandatory = false);
+    void SetCompletionCallback(CompletionCallback callback);
+
+private:
+    friend class RteTeardownWorker;
+
+    struct Step {
+        std::string name;
+        StepFunc func;
+        bool mandatory;
+    };
+
+    std::string m_name;
+    int m_deadlineMs;
+    std::vector<Step> m_steps;
+    CompletionCallback m_onComplete;
+};
+
+// Process wide worker that drains RTE resources off the UI thread.
+// Jobs run one at a time in submission order, so a new engine can be created
+// safely once WaitIdle() returns true.
+class RteTeardownWorker {
+public:
+    static RteTeardownWorker& Instance();
+
+    // Queue a job and return immediately
+    void Submit(const RteTeardownJob& job);
+
+    // Block until every queued job has finished. Returns false on timeout.
+    bool WaitIdle(int timeoutMs);
+
+    bool IsIdle() const;
+
+    // Drain outstanding jobs for up to timeoutMs and stop the worker thread.
+    // Called on application exit; a job still stuck after the timeout is abandoned.
+    void Shutdown(int timeoutMs);
+
+private:
+    RteTeardownWorker();
+    ~RteTeardownWorker();
+    RteTeardownWorker(const RteTeardownWorker&) = delete;
+    RteTeardownWorker& operator=(const RteTeardownWorker&) = delete;
+
+    void WorkerLoop();
+    void RunJob(const RteTeardownJob& job);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_jobCv;
+    std::condition_variable m_idleCv;
+    std::deque<RteTeardownJob> m_jobs;
+    bool m_jobRunning;
+    bool m_stopping;
+    std::thread m_thread;
+};
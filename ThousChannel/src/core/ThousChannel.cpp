@@ -8,11 +8,15 @@
 #include "ThousChannel.h"
 #include "MainFrm.h"
 #include "Logger.h"
+#include "FlightRecorder.h"
+#include "LogStore.h"
 
 #include "ChildFrm.h"
 #include "ThousChannelDoc.h"
 #include "ThousChannelView.h"
 #include "HomePageDlg.h"
+#include "RteTeardownWorker.h"
+#include "HttpClient.h"
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -56,6 +60,20 @@ CThousChannelApp::CThousChannelApp() noexcept
 	// 将所有重要的初始化放置在 InitInstance 中
 }
 
+// UI thread stall that triggers a flight recorder dump
+static const int kUiWatchdogTimeoutMs = 5000;
+
+// Megabytes from an environment variable, or `fallback` bytes when it is unset
+static uint64_t GetEnvironmentMegabytes(const char* name, uint64_t fallback)
+{
+	char value[32] = {};
+	if (GetEnvironmentVariableA(name, value, sizeof(value)) == 0)
+	{
+		return fallback;
+	}
+	return strtoull(value, nullptr, 10) * 1024 * 1024;
+}
+
 // 唯一的 CThousChannelApp 对象
 
 CThousChannelApp theApp;
@@ -69,6 +87,39 @@ BOOL CThousChannelApp::InitInstance()
 	auto& logger = Logger::instance();
 	logger.setLogLevel(LogLevel::Debug);  // 开发时使用Debug级别
 	logger.setLogFile("logs/ThousChannel.log");
+	// Log segment size and how much of the newest logs is kept, e.g.
+	// THOUSCHANNEL_LOG_SEGMENT_MB=16 THOUSCHANNEL_LOG_KEEP_MB=256; a segment
+	// size of 0 appends every session to the one log file
+	logger.setLogRotation(GetEnvironmentMegabytes("THOUSCHANNEL_LOG_SEGMENT_MB", 16 * 1024 * 1024),
+		GetEnvironmentMegabytes("THOUSCHANNEL_LOG_KEEP_MB", 256 * 1024 * 1024));
+	// LZ4 compressed log files for long verbose sessions; read with decode_log.py or lz4 -d
+	if (GetEnvironmentVariableA("THOUSCHANNEL_LOG_COMPRESS", nullptr, 0) > 0)
+	{
+		logger.setLogCompression(true);
+	}
+	// The output pane's log view; collects from the first line on, tagged by the
+	// LogUser arguments of the call sites, and fed from a thread of the logger
+	logger.setLogStore(&LogStore::Instance());
+	// Per-category levels, e.g. THOUSCHANNEL_LOG_LEVELS=rte=debug,layout=warn
+	char levels[256] = {};
+	if (GetEnvironmentVariableA("THOUSCHANNEL_LOG_LEVELS", levels, sizeof(levels)) > 0 &&
+		!logger.setCategoryLevels(levels))
+	{
+		LOG_WARN_FMT("Ignored part of THOUSCHANNEL_LOG_LEVELS: {}", levels);
+	}
+	// Compact binary records instead of text lines; decode with decode_log.py
+	if (GetEnvironmentVariableA("THOUSCHANNEL_BINARY_LOG", nullptr, 0) > 0 &&
+		!logger.setBinaryLogFile("logs/ThousChannel.tclog"))
+	{
+		LOG_WARN("Could not open the binary log, logging as text");
+	}
+
+	// Last events of every thread go to logs/flight_*.txt on a crash, a fatal
+	// log line, or when the channel page's UI thread stops for 5 seconds
+	FlightRecorder& recorder = FlightRecorder::Instance();
+	recorder.SetDumpDirectory("logs");
+	recorder.InstallCrashHandlers();
+	recorder.StartWatchdog(kUiWatchdogTimeoutMs);
 
 	LOG_INFO("ThousChannel application starting...");
 
@@ -203,11 +254,20 @@ BOOL CThousChannelApp::InitInstance()
 int CThousChannelApp::ExitInstance()
 {
 	LOG_INFO("Application exit started");
+
+	// Let a channel teardown that is still draining finish before the process exits
+	RteTeardownWorker::Instance().Shutdown(5000);
+	HttpClient::ShutdownInstance(2000);
+	FlightRecorder::Instance().StopWatchdog();
 	
 	//TODO: 处理可能已添加的附加资源
 	AfxOleTerm(FALSE);
 
 	LOG_INFO("Application exit completed");
+	Logger::instance().flushSuppressed();
+	Logger::instance().flush();
+	// Drains the pane's queue while the store still exists
+	Logger::instance().setLogStore(nullptr);
 	return CWinAppEx::ExitInstance();
 }
 
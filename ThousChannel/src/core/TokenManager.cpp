@@ -1,22 +1,27 @@
 ﻿#include "pch.h"
 #include "TokenManager.h"
+#define LOG_CATEGORY LogCategory::Token
 #include "Logger.h"
-#include <winhttp.h>
-#include <vector>
 #include <string>
-#include <thread>
 #include <chrono>
 #include <sstream>
 #include <iomanip>
 
-#pragma comment(lib, "winhttp.lib")
-
 // ============================================================================
 // CTokenManager 实现
 // ============================================================================
 
+const std::string CTokenManager::DEFAULT_TOKEN_SERVER_URL = "https://service.agora.io/toolbox-global/v1/token/generate";
+
 CTokenManager::CTokenManager()
-    : m_timeoutMs(30000)  // 默认30秒超时
+    : CTokenManager(HttpClient::Instance())
+{
+}
+
+CTokenManager::CTokenManager(HttpClient& http)
+    : m_serverUrl(DEFAULT_TOKEN_SERVER_URL)
+    , m_timeoutMs(30000)  // 默认30秒超时
+    , m_http(http)
 {
     LOG_INFO("Token Manager created");
 }
@@ -26,6 +31,11 @@ CTokenManager::~CTokenManager()
     LOG_INFO("Token Manager destroyed");
 }
 
+void CTokenManager::SetServerUrl(const std::string& serverUrl)
+{
+    m_serverUrl = serverUrl;
+}
+
 void CTokenManager::SetTimeout(DWORD timeoutMs)
 {
     m_timeoutMs = timeoutMs;
@@ -37,8 +47,23 @@ void CTokenManager::GenerateTokenAsync(const TokenGenerateParams& params, TokenC
         return;
     }
 
-    std::thread requestThread(AsyncRequestThread, this, params, callback);
-    requestThread.detach();
+    std::string jsonData = BuildRequestJson(params);
+    if (jsonData.empty()) {
+        callback("", false, "构建请求数据失败");
+        return;
+    }
+
+    // 回调只用到静态函数，管理器可以先于请求销毁
+    bool queued = m_http.PostAsync(m_serverUrl, "application/json", jsonData, static_cast<int>(m_timeoutMs),
+        [callback](bool success, const HttpResponse& response, const std::string& httpError) {
+            std::string token, errorMsg;
+            bool ok = ParseHttpResult(success, response, httpError, token, errorMsg);
+            // 在主线程中调用回调（需要通过消息机制）
+            callback(token, ok, errorMsg);
+        });
+    if (!queued) {
+        callback("", false, "Token请求队列已满");
+    }
 }
 
 bool CTokenManager::GenerateTokenSync(const TokenGenerateParams& params, std::string& token, std::string& errorMsg)
@@ -50,15 +75,14 @@ bool CTokenManager::GenerateTokenSync(const TokenGenerateParams& params, std::st
         return false;
     }
 
-    // 执行HTTP请求
-    std::string response;
-    if (!ExecuteHttpRequest("https://service.agora.io/toolbox-global/v1/token/generate", 
-                           jsonData, response, errorMsg)) {
-        return false;
-    }
+    // 执行HTTP请求，复用已建立的连接
+    HttpResponse response;
+    std::string httpError;
+    bool success = m_http.Post(m_serverUrl, "application/json", jsonData, static_cast<int>(m_timeoutMs),
+                               response, httpError);
 
     // 解析响应
-    return ParseResponseJson(response, token, errorMsg);
+    return ParseHttpResult(success, response, httpError, token, errorMsg);
 }
 
 std::string CTokenManager::BuildRequestJson(const TokenGenerateParams& params)
@@ -82,7 +106,7 @@ std::string CTokenManager::BuildRequestJson(const TokenGenerateParams& params)
         return json.str();
     }
     catch (const std::exception& e) {
-        LOG_ERROR("Failed to build JSON: {}", e.what());
+        LOG_ERROR_FMT("Failed to build JSON: {}", e.what());
         return "";
     }
 }
@@ -156,145 +180,18 @@ bool CTokenManager::ParseResponseJson(const std::string& jsonResponse, std::stri
     }
 }
 
-bool CTokenManager::ExecuteHttpRequest(const std::string& url, const std::string& postData, 
-                                      std::string& response, std::string& errorMsg)
+bool CTokenManager::ParseHttpResult(bool success, const HttpResponse& response, const std::string& httpError,
+                                    std::string& token, std::string& errorMsg)
 {
-    HINTERNET hSession = nullptr;
-    HINTERNET hConnect = nullptr;
-    HINTERNET hRequest = nullptr;
-    bool success = false;
-
-    try {
-        // 解析URL - 使用宽字符串进行WinHTTP调用
-        URL_COMPONENTS urlComp = { 0 };
-        urlComp.dwStructSize = sizeof(urlComp);
-        urlComp.dwSchemeLength = -1;
-        urlComp.dwHostNameLength = -1;
-        urlComp.dwUrlPathLength = -1;
-        urlComp.dwExtraInfoLength = -1;
-
-        // 转换std::string到宽字符串
-        std::wstring urlWide(url.begin(), url.end());
-        if (!WinHttpCrackUrl(urlWide.c_str(), urlWide.length(), 0, &urlComp)) {
-            errorMsg = "解析URL失败";
-            return false;
-        }
-
-        std::wstring hostNameWide(urlComp.lpszHostName, urlComp.dwHostNameLength);
-        std::wstring urlPathWide(urlComp.lpszUrlPath, urlComp.dwUrlPathLength);
-
-        // 创建会话
-        hSession = WinHttpOpen(L"ThousChannel/1.0",
-                              WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
-                              WINHTTP_NO_PROXY_NAME,
-                              WINHTTP_NO_PROXY_BYPASS,
-                              0);
-        if (!hSession) {
-            errorMsg = "创建HTTP会话失败";
-            return false;
-        }
-
-        // 设置超时
-        WinHttpSetTimeouts(hSession, m_timeoutMs, m_timeoutMs, m_timeoutMs, m_timeoutMs);
-
-        // 连接服务器
-        hConnect = WinHttpConnect(hSession, hostNameWide.c_str(), 
-                                 urlComp.nScheme == INTERNET_SCHEME_HTTPS ? INTERNET_DEFAULT_HTTPS_PORT : INTERNET_DEFAULT_HTTP_PORT,
-                                 0);
-        if (!hConnect) {
-            errorMsg = "连接服务器失败";
-            return false;
-        }
-
-        // 创建请求
-        DWORD flags = urlComp.nScheme == INTERNET_SCHEME_HTTPS ? WINHTTP_FLAG_SECURE : 0;
-        hRequest = WinHttpOpenRequest(hConnect, L"POST", urlPathWide.c_str(), nullptr,
-                                     WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES, flags);
-        if (!hRequest) {
-            errorMsg = "创建HTTP请求失败";
-            return false;
-        }
-
-        // 设置请求头
-        std::wstring headers = L"Content-Type: application/json\r\n";
-        WinHttpAddRequestHeaders(hRequest, headers.c_str(), headers.length(), WINHTTP_ADDREQ_FLAG_ADD);
-
-        // 发送请求 - 直接使用std::string
-        if (!WinHttpSendRequest(hRequest, WINHTTP_NO_ADDITIONAL_HEADERS, 0,
-                               (LPVOID)postData.c_str(), (DWORD)postData.length(),
-                               (DWORD)postData.length(), 0)) {
-            errorMsg = "发送HTTP请求失败";
-            return false;
-        }
-
-        // 接收响应
-        if (!WinHttpReceiveResponse(hRequest, nullptr)) {
-            errorMsg = "接收HTTP响应失败";
-            return false;
-        }
-
-        // 检查状态码
-        DWORD statusCode = 0;
-        DWORD statusCodeSize = sizeof(statusCode);
-        WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
-                           WINHTTP_HEADER_NAME_BY_INDEX, &statusCode, &statusCodeSize, WINHTTP_NO_HEADER_INDEX);
-
-        if (statusCode != 200) {
-            errorMsg = "HTTP请求失败，状态码: " + std::to_string(statusCode);
-            return false;
-        }
-
-        // 读取响应数据
-        DWORD availableBytes = 0;
-        std::string responseData;
-        
-        do {
-            availableBytes = 0;
-            if (!WinHttpQueryDataAvailable(hRequest, &availableBytes)) {
-                errorMsg = "查询可用数据失败";
-                return false;
-            }
-
-            if (availableBytes > 0) {
-                std::vector<char> buffer(availableBytes + 1);
-                DWORD bytesRead = 0;
-                
-                if (WinHttpReadData(hRequest, buffer.data(), availableBytes, &bytesRead)) {
-                    buffer[bytesRead] = '\0';
-                    responseData.append(buffer.data(), bytesRead);
-                } else {
-                    errorMsg = "读取响应数据失败";
-                    return false;
-                }
-            }
-        } while (availableBytes > 0);
-
-        response = responseData;
-        success = true;
-    }
-    catch (const std::exception& e) {
-        errorMsg = "HTTP请求异常: " + std::string(e.what());
+    if (!success) {
+        errorMsg = httpError;
+        return false;
     }
-
-    // 清理资源
-    if (hRequest) WinHttpCloseHandle(hRequest);
-    if (hConnect) WinHttpCloseHandle(hConnect);
-    if (hSession) WinHttpCloseHandle(hSession);
-
-    return success;
-}
-
-void CTokenManager::AsyncRequestThread(CTokenManager* pManager, TokenGenerateParams params, TokenCallback callback)
-{
-    if (!pManager || !callback) {
-        return;
+    if (response.statusCode != 200) {
+        errorMsg = "HTTP请求失败，状态码: " + std::to_string(response.statusCode);
+        return false;
     }
-
-    std::string token, errorMsg;
-    bool success = pManager->GenerateTokenSync(params, token, errorMsg);
-    
-    // 在主线程中调用回调（需要通过消息机制）
-    callback(token, success, errorMsg);
+    return ParseResponseJson(response.body, token, errorMsg);
 }
 
 std::string CTokenManager::UrlEncode(const std::string& text)
@@ -2,9 +2,9 @@
 
 #include <functional>
 #include <memory>
-#include <winhttp.h>
 #include <string>
-#include <thread>
+
+#include "HttpClient.h"
 
 // Token retrieval callback function type
 typedef std::function<void(const std::string& token, bool success, const std::string& errorMsg)> TokenCallback;
@@ -29,6 +29,8 @@ struct TokenGenerateParams {
 /**
  * Token Manager
  * Responsible for obtaining RTC Token from Agora server
+ * Requests go through a shared HttpClient, so every manager reuses the same
+ * keep-alive connections and worker threads
  */
 class CTokenManager
 {
@@ -36,9 +38,12 @@ private:
     static const std::string DEFAULT_TOKEN_SERVER_URL;
     std::string m_serverUrl;
     DWORD m_timeoutMs;
+    HttpClient& m_http;
 
 public:
     CTokenManager();
+    // Uses `http` instead of HttpClient::Instance(), e.g. to point it at a stand-in server
+    explicit CTokenManager(HttpClient& http);
     virtual ~CTokenManager();
 
     // Set Token server URL
@@ -47,7 +52,8 @@ public:
     // Set request timeout
     void SetTimeout(DWORD timeoutMs);
 
-    // Asynchronously generate Token
+    // Asynchronously generate Token. The callback runs on an HttpClient worker
+    // thread, or at once with an error if the request queue is full.
     void GenerateTokenAsync(const TokenGenerateParams& params, TokenCallback callback);
 
     // Synchronously generate Token (blocking call)
@@ -55,21 +61,18 @@ public:
 
 private:
     // Build request JSON
-    std::string BuildRequestJson(const TokenGenerateParams& params);
+    static std::string BuildRequestJson(const TokenGenerateParams& params);
 
     // Parse response JSON
-    bool ParseResponseJson(const std::string& jsonResponse, std::string& token, std::string& errorMsg);
-
-    // Execute HTTP POST request
-    bool ExecuteHttpRequest(const std::string& url, const std::string& postData, 
-                           std::string& response, std::string& errorMsg);
+    static bool ParseResponseJson(const std::string& jsonResponse, std::string& token, std::string& errorMsg);
 
-    // Asynchronous request thread function
-    static void AsyncRequestThread(CTokenManager* pManager, TokenGenerateParams params, TokenCallback callback);
+    // Turn an HTTP result into a token; the response must be 200
+    static bool ParseHttpResult(bool success, const HttpResponse& response, const std::string& httpError,
+                                std::string& token, std::string& errorMsg);
 
     // URL encode
     std::string UrlEncode(const std::string& text);
 
     // Get current timestamp (milliseconds)
-    std::string GetCurrentTimestamp();
+    static std::string GetCurrentTimestamp();
 };
@@ -0,0 +1,74 @@
+#include "pch.h"
+#include "UserIdInterner.h"
+#include "Logger.h"
+
+static const std::string kEmptyUserId;
+
+UserIdInterner::UserIdInterner() : m_count(0) {
+    for (size_t i = 0; i < kMaxChunks; ++i) {
+        m_chunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+UserIdInterner::~UserIdInterner() {
+    for (size_t i = 0; i < kMaxChunks; ++i) {
+        delete[] m_chunks[i].load(std::memory_order_relaxed);
+    }
+}
+
+UserHandle UserIdInterner::Intern(const std::string& userId) {
+    if (userId.empty()) {
+        return kInvalidUserHandle;
+    }
+
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto it = m_lookup.find(userId);
+        if (it != m_lookup.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    auto it = m_lookup.find(userId);
+    if (it != m_lookup.end()) {
+        return it->second;
+    }
+
+    uint32_t index = m_count.load(std::memory_order_relaxed);
+    size_t chunkIndex = index >> kChunkBits;
+    if (chunkIndex >= kMaxChunks) {
+        LOG_ERROR_FMT("UserIdInterner full, cannot intern user {}", userId);
+        return kInvalidUserHandle;
+    }
+
+    std::string* chunk = m_chunks[chunkIndex].load(std::memory_order_relaxed);
+    if (!chunk) {
+        chunk = new std::string[kChunkSize];
+        m_chunks[chunkIndex].store(chunk, std::memory_order_release);
+    }
+
+    std::string& slot = chunk[index & (kChunkSize - 1)];
+    slot = userId;
+    UserHandle handle = index + 1;
+    m_lookup.emplace(std::string_view(slot), handle);
+
+    // Readers check the count before touching the slot
+    m_count.store(index + 1, std::memory_order_release);
+    return handle;
+}
+
+UserHandle UserIdInterner::Find(const std::string& userId) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    auto it = m_lookup.find(userId);
+    return it != m_lookup.end() ? it->second : kInvalidUserHandle;
+}
+
+const std::string& UserIdInterner::GetString(UserHandle handle) const {
+    if (handle == kInvalidUserHandle || handle > m_count.load(std::memory_order_acquire)) {
+        return kEmptyUserId;
+    }
+    uint32_t index = handle - 1;
+    const std::string* chunk = m_chunks[index >> kChunkBits].load(std::memory_order_acquire);
+    return chunk[index & (kChunkSize - 1)];
+}
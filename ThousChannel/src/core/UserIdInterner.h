@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <shared_mutex>
+#include <atomic>
+#include <cstdint>
+
+// Dense 32-bit handle for a user id string. Handles start at 1 and are never
+// reused, so they can index plain arrays; 0 means "no user".
+typedef uint32_t UserHandle;
+const UserHandle kInvalidUserHandle = 0;
+
+// Process-wide user id table. Ids are interned once where they enter the app
+// (SDK callbacks, join parameters); everything inside compares and stores the
+// handle and only turns it back into a string for display and logs.
+//
+// Entries are never removed: a channel session sees a bounded set of ids and
+// keeping them makes a handle valid for the life of the process.
+class UserIdInterner {
+public:
+    static UserIdInterner& instance() {
+        static UserIdInterner interner;
+        return interner;
+    }
+
+    // Return the handle for `userId`, assigning the next one on first use.
+    // An empty id returns kInvalidUserHandle.
+    UserHandle Intern(const std::string& userId);
+
+    // Handle of an id seen before, or kInvalidUserHandle
+    UserHandle Find(const std::string& userId) const;
+
+    // Lock-free. Returns an empty string for kInvalidUserHandle and unknown handles.
+    const std::string& GetString(UserHandle handle) const;
+
+    size_t Size() const { return m_count.load(std::memory_order_acquire); }
+
+private:
+    UserIdInterner();
+    ~UserIdInterner();
+    UserIdInterner(const UserIdInterner&) = delete;
+    UserIdInterner& operator=(const UserIdInterner&) = delete;
+
+    // Strings live in fixed-size chunks that never move, so readers can index
+    // them without a lock and the lookup map can key on views into them
+    static const size_t kChunkBits = 10;
+    static const size_t kChunkSize = size_t(1) << kChunkBits;
+    static const size_t kMaxChunks = 4096;      // 4M ids
+
+    std::atomic<std::string*> m_chunks[kMaxChunks];
+    std::atomic<uint32_t> m_count;              // Published handles, 1..m_count are readable
+
+    mutable std::shared_mutex m_mutex;          // Guards m_lookup and writers
+    std::unordered_map<std::string_view, UserHandle> m_lookup;
+};
+
+// Display / log form of a handle
+inline const std::string& UserIdString(UserHandle handle) {
+    return UserIdInterner::instance().GetString(handle);
+}
@@ -6,6 +6,9 @@
 
 #pragma once
 
+// tests/CMakeLists.txt builds the MFC-free sources on their own with THOUSCHANNEL_NO_MFC
+#ifndef THOUSCHANNEL_NO_MFC
+
 #include "targetver.h"
 
 // MFC 头文件
@@ -32,3 +35,4 @@
 // Agora RTE SDK 头文件
 // 注意：RTC相关头文件已移除，现在使用RTE SDK
 
+#endif // THOUSCHANNEL_NO_MFC
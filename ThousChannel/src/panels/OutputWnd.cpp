@@ -5,6 +5,7 @@
 #include "OutputWnd.h"
 #include "Resource.h"
 #include "MainFrm.h"
+#include <ctime>
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -12,6 +13,25 @@
 static char THIS_FILE[] = __FILE__;
 #endif
 
+// Control ids of the filter bar and the log list
+static const UINT kLogListId = 2;
+static const UINT kLevelComboId = 5;
+static const UINT kCategoryComboId = 6;
+static const UINT kUserEditId = 7;
+static const UINT kTextEditId = 8;
+
+// Never assigned; an unknown user id filters every line out
+static const UserHandle kUnknownUserHandle = 0xFFFFFFFF;
+
+enum LogColumn
+{
+	kColumnTime,
+	kColumnLevel,
+	kColumnCategory,
+	kColumnThread,
+	kColumnMessage
+};
+
 /////////////////////////////////////////////////////////////////////////////
 // COutputBar
 
@@ -25,7 +45,13 @@ COutputWnd::~COutputWnd()
 
 BEGIN_MESSAGE_MAP(COutputWnd, CDockablePane)
 	ON_WM_CREATE()
+	ON_WM_DESTROY()
 	ON_WM_SIZE()
+	ON_CBN_SELCHANGE(kLevelComboId, &COutputWnd::OnFilterChanged)
+	ON_CBN_SELCHANGE(kCategoryComboId, &COutputWnd::OnFilterChanged)
+	ON_EN_CHANGE(kUserEditId, &COutputWnd::OnFilterChanged)
+	ON_EN_CHANGE(kTextEditId, &COutputWnd::OnFilterChanged)
+	ON_MESSAGE(WM_USER_LOG_STORE_CHANGED, &COutputWnd::OnLogStoreChanged)
 END_MESSAGE_MAP()
 
 int COutputWnd::OnCreate(LPCREATESTRUCT lpCreateStruct)
@@ -43,12 +69,8 @@ int COutputWnd::OnCreate(LPCREATESTRUCT lpCreateStruct)
 		return -1;      // 未能创建
 	}
 
-	// 创建输出窗格: 
-	const DWORD dwStyle = LBS_NOINTEGRALHEIGHT | WS_CHILD | WS_VISIBLE | WS_HSCROLL | WS_VSCROLL;
-
-	if (!m_wndOutputBuild.Create(dwStyle, rectDummy, &m_wndTabs, 2) ||
-		!m_wndOutputDebug.Create(dwStyle, rectDummy, &m_wndTabs, 3) ||
-		!m_wndOutputFind.Create(dwStyle, rectDummy, &m_wndTabs, 4))
+	// 创建日志列表和筛选栏: 
+	if (!m_wndOutputLog.CreateList(&m_wndTabs, kLogListId) || !CreateFilterBar())
 	{
 		TRACE0("未能创建输出窗口\n");
 		return -1;      // 未能创建
@@ -60,83 +82,139 @@ int COutputWnd::OnCreate(LPCREATESTRUCT lpCreateStruct)
 	BOOL bNameValid;
 
 	// 将列表窗口附加到选项卡: 
-	bNameValid = strTabName.LoadString(IDS_BUILD_TAB);
-	ASSERT(bNameValid);
-	m_wndTabs.AddTab(&m_wndOutputBuild, strTabName, (UINT)0);
-	bNameValid = strTabName.LoadString(IDS_DEBUG_TAB);
+	bNameValid = strTabName.LoadString(IDS_LOG_TAB);
 	ASSERT(bNameValid);
-	m_wndTabs.AddTab(&m_wndOutputDebug, strTabName, (UINT)1);
-	bNameValid = strTabName.LoadString(IDS_FIND_TAB);
-	ASSERT(bNameValid);
-	m_wndTabs.AddTab(&m_wndOutputFind, strTabName, (UINT)2);
+	m_wndTabs.AddTab(&m_wndOutputLog, strTabName, (UINT)0);
 
-	// 使用一些虚拟文本填写输出选项卡(无需复杂数据)
-	FillBuildWindow();
-	FillDebugWindow();
-	FillFindWindow();
+	// The logging thread posts one message per batch of new lines
+	HWND hWnd = GetSafeHwnd();
+	LogStore::Instance().SetChangeHandler([hWnd]() { ::PostMessage(hWnd, WM_USER_LOG_STORE_CHANGED, 0, 0); });
+	m_wndOutputLog.Refresh();
 
 	return 0;
 }
 
-void COutputWnd::OnSize(UINT nType, int cx, int cy)
+void COutputWnd::OnDestroy()
 {
-	CDockablePane::OnSize(nType, cx, cy);
-
-	// 选项卡控件应覆盖整个工作区: 
-	m_wndTabs.SetWindowPos (nullptr, -1, -1, cx, cy, SWP_NOMOVE | SWP_NOACTIVATE | SWP_NOZORDER);
+	LogStore::Instance().SetChangeHandler(nullptr);
+	CDockablePane::OnDestroy();
 }
 
-void COutputWnd::AdjustHorzScroll(CListBox& wndListBox)
+BOOL COutputWnd::CreateFilterBar()
 {
-	CClientDC dc(this);
-	CFont* pOldFont = dc.SelectObject(&afxGlobalData.fontRegular);
-
-	int cxExtentMax = 0;
+	CRect rectDummy;
+	rectDummy.SetRectEmpty();
 
-	for (int i = 0; i < wndListBox.GetCount(); i ++)
+	const DWORD dwComboStyle = CBS_DROPDOWNLIST | WS_CHILD | WS_VISIBLE | WS_VSCROLL | WS_TABSTOP;
+	const DWORD dwEditStyle = ES_AUTOHSCROLL | WS_CHILD | WS_VISIBLE | WS_BORDER | WS_TABSTOP;
+	if (!m_comboLevel.Create(dwComboStyle, CRect(0, 0, 0, 200), this, kLevelComboId) ||
+		!m_comboCategory.Create(dwComboStyle, CRect(0, 0, 0, 200), this, kCategoryComboId) ||
+		!m_editUser.Create(dwEditStyle, rectDummy, this, kUserEditId) ||
+		!m_editText.Create(dwEditStyle, rectDummy, this, kTextEditId))
 	{
-		CString strItem;
-		wndListBox.GetText(i, strItem);
+		return FALSE;
+	}
 
-		cxExtentMax = max(cxExtentMax, (int)dc.GetTextExtent(strItem).cx);
+	m_comboLevel.AddString(_T("全部级别"));
+	m_comboLevel.AddString(_T("Debug 及以上"));
+	m_comboLevel.AddString(_T("Info 及以上"));
+	m_comboLevel.AddString(_T("Warn 及以上"));
+	m_comboLevel.AddString(_T("Error 及以上"));
+	m_comboLevel.AddString(_T("Fatal"));
+	m_comboLevel.SetCurSel(0);
+
+	m_comboCategory.AddString(_T("全部分类"));
+	for (int i = 0; i < static_cast<int>(LogCategory::Count); ++i)
+	{
+		m_comboCategory.AddString(CString(Logger::getCategoryName(static_cast<LogCategory>(i))));
 	}
+	m_comboCategory.SetCurSel(0);
 
-	wndListBox.SetHorizontalExtent(cxExtentMax);
-	dc.SelectObject(pOldFont);
+	m_editUser.SetCueBanner(L"用户 ID");
+	m_editText.SetCueBanner(L"包含文本");
+	return TRUE;
 }
 
-void COutputWnd::FillBuildWindow()
+void COutputWnd::OnFilterChanged()
 {
-	m_wndOutputBuild.AddString(_T("生成输出正显示在此处。"));
-	m_wndOutputBuild.AddString(_T("输出正显示在列表视图的行中"));
-	m_wndOutputBuild.AddString(_T("但您可以根据需要更改其显示方式..."));
+	ApplyFilter();
+}
+
+void COutputWnd::ApplyFilter()
+{
+	LogFilter filter;
+	int nLevel = m_comboLevel.GetCurSel();
+	filter.minLevel = static_cast<LogLevel>(nLevel > 0 ? nLevel : 0);
+	int nCategory = m_comboCategory.GetCurSel();
+	if (nCategory > 0)
+	{
+		filter.categoryMask = 1u << (nCategory - 1);
+	}
+
+	CString strUser;
+	m_editUser.GetWindowText(strUser);
+	strUser.Trim();
+	if (!strUser.IsEmpty())
+	{
+		UserHandle user = UserIdInterner::instance().Find(std::string(CW2A(strUser, CP_UTF8)));
+		filter.user = (user != kInvalidUserHandle) ? user : kUnknownUserHandle;
+	}
+
+	CString strText;
+	m_editText.GetWindowText(strText);
+	filter.text = std::string(CW2A(strText, CP_UTF8));
+
+	m_wndOutputLog.SetFilter(filter);
 }
 
-void COutputWnd::FillDebugWindow()
+LRESULT COutputWnd::OnLogStoreChanged(WPARAM /*wParam*/, LPARAM /*lParam*/)
 {
-	m_wndOutputDebug.AddString(_T("调试输出正显示在此处。"));
-	m_wndOutputDebug.AddString(_T("输出正显示在列表视图的行中"));
-	m_wndOutputDebug.AddString(_T("但您可以根据需要更改其显示方式..."));
+	// Acknowledge first: lines arriving during the refresh post again
+	LogStore::Instance().AcknowledgeChange();
+	m_wndOutputLog.Refresh();
+	return 0;
 }
 
-void COutputWnd::FillFindWindow()
+void COutputWnd::OnSize(UINT nType, int cx, int cy)
 {
-	m_wndOutputFind.AddString(_T("查找输出正显示在此处。"));
-	m_wndOutputFind.AddString(_T("输出正显示在列表视图的行中"));
-	m_wndOutputFind.AddString(_T("但您可以根据需要更改其显示方式..."));
+	CDockablePane::OnSize(nType, cx, cy);
+
+	if (m_comboLevel.GetSafeHwnd() == nullptr)
+	{
+		return;
+	}
+
+	// 筛选栏在上，选项卡控件覆盖其余工作区: 
+	CRect rectCombo;
+	m_comboLevel.GetWindowRect(rectCombo);
+	int cyBar = rectCombo.Height() + 4;
+	int cxField = max(cx / 5, 60);
+	int x = 2;
+	m_comboLevel.SetWindowPos(nullptr, x, 2, cxField, 200, SWP_NOACTIVATE | SWP_NOZORDER);
+	x += cxField + 4;
+	m_comboCategory.SetWindowPos(nullptr, x, 2, cxField, 200, SWP_NOACTIVATE | SWP_NOZORDER);
+	x += cxField + 4;
+	m_editUser.SetWindowPos(nullptr, x, 2, cxField, cyBar - 4, SWP_NOACTIVATE | SWP_NOZORDER);
+	x += cxField + 4;
+	m_editText.SetWindowPos(nullptr, x, 2, max(cx - x - 2, 60), cyBar - 4, SWP_NOACTIVATE | SWP_NOZORDER);
+
+	m_wndTabs.SetWindowPos(nullptr, 0, cyBar, cx, max(cy - cyBar, 0), SWP_NOACTIVATE | SWP_NOZORDER);
 }
 
 void COutputWnd::UpdateFonts()
 {
-	m_wndOutputBuild.SetFont(&afxGlobalData.fontRegular);
-	m_wndOutputDebug.SetFont(&afxGlobalData.fontRegular);
-	m_wndOutputFind.SetFont(&afxGlobalData.fontRegular);
+	m_wndOutputLog.SetFont(&afxGlobalData.fontRegular);
+	m_comboLevel.SetFont(&afxGlobalData.fontRegular);
+	m_comboCategory.SetFont(&afxGlobalData.fontRegular);
+	m_editUser.SetFont(&afxGlobalData.fontRegular);
+	m_editText.SetFont(&afxGlobalData.fontRegular);
 }
 
 /////////////////////////////////////////////////////////////////////////////
 // COutputList1
 
 COutputList::COutputList() noexcept
+	: m_nextSeq(0), m_cachedSeq(0), m_hasCachedRecord(false)
 {
 }
 
@@ -144,16 +222,140 @@ COutputList::~COutputList()
 {
 }
 
-BEGIN_MESSAGE_MAP(COutputList, CListBox)
+BEGIN_MESSAGE_MAP(COutputList, CListCtrl)
 	ON_WM_CONTEXTMENU()
+	ON_NOTIFY_REFLECT(LVN_GETDISPINFO, &COutputList::OnGetDispInfo)
 	ON_COMMAND(ID_EDIT_COPY, OnEditCopy)
 	ON_COMMAND(ID_EDIT_CLEAR, OnEditClear)
 	ON_COMMAND(ID_VIEW_OUTPUTWND, OnViewOutput)
 	ON_WM_WINDOWPOSCHANGING()
 END_MESSAGE_MAP()
+
+BOOL COutputList::CreateList(CWnd* pParent, UINT nID)
+{
+	// LVS_OWNERDATA: the list only knows the row count, text is asked for when drawn
+	const DWORD dwStyle = LVS_REPORT | LVS_OWNERDATA | LVS_SHOWSELALWAYS | WS_CHILD | WS_VISIBLE | WS_HSCROLL | WS_VSCROLL;
+	CRect rectDummy;
+	rectDummy.SetRectEmpty();
+	if (!Create(dwStyle, rectDummy, pParent, nID))
+	{
+		return FALSE;
+	}
+	SetExtendedStyle(LVS_EX_FULLROWSELECT | LVS_EX_DOUBLEBUFFER);
+
+	InsertColumn(kColumnTime, _T("时间"), LVCFMT_LEFT, 90);
+	InsertColumn(kColumnLevel, _T("级别"), LVCFMT_LEFT, 50);
+	InsertColumn(kColumnCategory, _T("分类"), LVCFMT_LEFT, 60);
+	InsertColumn(kColumnThread, _T("线程"), LVCFMT_RIGHT, 60);
+	InsertColumn(kColumnMessage, _T("内容"), LVCFMT_LEFT, 800);
+	return TRUE;
+}
+
+void COutputList::SetFilter(const LogFilter& filter)
+{
+	m_filter = filter;
+	m_rows.clear();
+	m_nextSeq = 0;
+	m_hasCachedRecord = false;
+	SetItemCountEx(0);
+	Refresh();
+}
+
+void COutputList::Refresh()
+{
+	LogStore& store = LogStore::Instance();
+	std::vector<uint64_t> newRows;
+	m_nextSeq = store.Query(m_filter, m_nextSeq, newRows);
+
+	// Rows the store has evicted leave from the front
+	uint64_t firstSeq = store.GetFirstSeq();
+	size_t dropped = 0;
+	while (!m_rows.empty() && m_rows.front() < firstSeq)
+	{
+		m_rows.pop_front();
+		++dropped;
+	}
+	if (newRows.empty() && dropped == 0)
+	{
+		return;
+	}
+
+	int nCount = GetItemCount();
+	BOOL bFollowTail = (nCount == 0) || (GetTopIndex() + GetCountPerPage() >= nCount);
+	m_rows.insert(m_rows.end(), newRows.begin(), newRows.end());
+	SetItemCountEx(static_cast<int>(m_rows.size()), LVSICF_NOINVALIDATEALL | LVSICF_NOSCROLL);
+	if (dropped > 0)
+	{
+		Invalidate(FALSE);
+	}
+	if (bFollowTail && !m_rows.empty())
+	{
+		EnsureVisible(static_cast<int>(m_rows.size()) - 1, FALSE);
+	}
+}
+
+const LogStoreRecord* COutputList::GetRecord(int nItem)
+{
+	if (nItem < 0 || nItem >= static_cast<int>(m_rows.size()))
+	{
+		return nullptr;
+	}
+	uint64_t seq = m_rows[nItem];
+	if (!m_hasCachedRecord || m_cachedSeq != seq)
+	{
+		m_hasCachedRecord = LogStore::Instance().GetRecord(seq, m_cachedRecord);
+		m_cachedSeq = seq;
+	}
+	return m_hasCachedRecord ? &m_cachedRecord : nullptr;
+}
+
+CString COutputList::FormatColumn(const LogStoreRecord& record, int nColumn) const
+{
+	static const TCHAR* const kLevelNames[] = { _T("TRACE"), _T("DEBUG"), _T("INFO"), _T("WARN"), _T("ERROR"), _T("FATAL") };
+	CString strText;
+	switch (nColumn)
+	{
+	case kColumnTime:
+	{
+		time_t seconds = static_cast<time_t>(record.timeUs / 1000000);
+		struct tm local = {};
+		localtime_s(&local, &seconds);
+		strText.Format(_T("%02d:%02d:%02d.%03d"), local.tm_hour, local.tm_min, local.tm_sec,
+			static_cast<int>(record.timeUs % 1000000 / 1000));
+		break;
+	}
+	case kColumnLevel:
+		strText = kLevelNames[static_cast<int>(record.level)];
+		break;
+	case kColumnCategory:
+		strText = CString(Logger::getCategoryName(record.category));
+		break;
+	case kColumnThread:
+		strText.Format(_T("%u"), record.threadId);
+		break;
+	case kColumnMessage:
+		strText = CString(CA2W(record.text.c_str(), CP_UTF8));
+		break;
+	}
+	return strText;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // COutputList 消息处理程序
 
+void COutputList::OnGetDispInfo(NMHDR* pNMHDR, LRESULT* pResult)
+{
+	NMLVDISPINFO* pDispInfo = reinterpret_cast<NMLVDISPINFO*>(pNMHDR);
+	LVITEM& item = pDispInfo->item;
+	if (item.mask & LVIF_TEXT)
+	{
+		const LogStoreRecord* pRecord = GetRecord(item.iItem);
+		CString strText = pRecord ? FormatColumn(*pRecord, item.iSubItem) : CString();
+		_tcsncpy_s(item.pszText, item.cchTextMax, strText, _TRUNCATE);
+	}
+	*pResult = 0;
+}
+
 void COutputList::OnContextMenu(CWnd* /*pWnd*/, CPoint point)
 {
 	CMenu menu;
@@ -177,12 +379,47 @@ void COutputList::OnContextMenu(CWnd* /*pWnd*/, CPoint point)
 
 void COutputList::OnEditCopy()
 {
-	MessageBox(_T("复制输出"));
+	// Selected rows, columns separated by tabs
+	CString strCopy;
+	POSITION pos = GetFirstSelectedItemPosition();
+	while (pos != nullptr)
+	{
+		const LogStoreRecord* pRecord = GetRecord(GetNextSelectedItem(pos));
+		if (pRecord == nullptr)
+		{
+			continue;
+		}
+		for (int nColumn = kColumnTime; nColumn <= kColumnMessage; ++nColumn)
+		{
+			strCopy += FormatColumn(*pRecord, nColumn);
+			strCopy += (nColumn == kColumnMessage) ? _T("\r\n") : _T("\t");
+		}
+	}
+	if (strCopy.IsEmpty() || !OpenClipboard())
+	{
+		return;
+	}
+
+	EmptyClipboard();
+	size_t cbText = (strCopy.GetLength() + 1) * sizeof(TCHAR);
+	HGLOBAL hText = GlobalAlloc(GMEM_MOVEABLE, cbText);
+	if (hText != nullptr)
+	{
+		memcpy(GlobalLock(hText), (LPCTSTR)strCopy, cbText);
+		GlobalUnlock(hText);
+		if (SetClipboardData(CF_UNICODETEXT, hText) == nullptr)
+		{
+			GlobalFree(hText);
+		}
+	}
+	CloseClipboard();
 }
 
 void COutputList::OnEditClear()
 {
-	MessageBox(_T("清除输出"));
+	// Clears the store itself, which frees its memory
+	LogStore::Instance().Clear();
+	SetFilter(m_filter);
 }
 
 void COutputList::OnViewOutput()
@@ -198,4 +435,3 @@ void COutputList::OnViewOutput()
 
 	}
 }
-
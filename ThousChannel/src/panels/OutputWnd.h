@@ -1,21 +1,48 @@
 ﻿
 #pragma once
 
+#include <deque>
+#include "LogStore.h"
+
+// Posted by the log store's change handler, see COutputWnd::OnCreate
+#define WM_USER_LOG_STORE_CHANGED   (WM_USER + 301)
+
 /////////////////////////////////////////////////////////////////////////////
 // COutputList 窗口
 
-class COutputList : public CListBox
+// Virtual list over LogStore: only the sequence numbers of the lines that pass
+// the filter are kept, and a row's text is read from the store when the list
+// draws it
+class COutputList : public CListCtrl
 {
 // 构造
 public:
 	COutputList() noexcept;
 
+	BOOL CreateList(CWnd* pParent, UINT nID);
+	void SetFilter(const LogFilter& filter);
+	// Appends the lines that arrived since the last call
+	void Refresh();
+
 // 实现
 public:
 	virtual ~COutputList();
 
 protected:
+	LogFilter m_filter;
+	std::deque<uint64_t> m_rows;		// Sequence numbers in the store
+	uint64_t m_nextSeq;
+
+	// The list asks once per column; the row is read once
+	uint64_t m_cachedSeq;
+	LogStoreRecord m_cachedRecord;
+	bool m_hasCachedRecord;
+
+	const LogStoreRecord* GetRecord(int nItem);
+	CString FormatColumn(const LogStoreRecord& record, int nColumn) const;
+
 	afx_msg void OnContextMenu(CWnd* pWnd, CPoint point);
+	afx_msg void OnGetDispInfo(NMHDR* pNMHDR, LRESULT* pResult);
 	afx_msg void OnEditCopy();
 	afx_msg void OnEditClear();
 	afx_msg void OnViewOutput();
@@ -35,16 +62,17 @@ public:
 protected:
 	CMFCTabCtrl	m_wndTabs;
 
-	COutputList m_wndOutputBuild;
-	COutputList m_wndOutputDebug;
-	COutputList m_wndOutputFind;
+	COutputList m_wndOutputLog;
 
-protected:
-	void FillBuildWindow();
-	void FillDebugWindow();
-	void FillFindWindow();
+	// Filter bar above the tabs
+	CComboBox m_comboLevel;
+	CComboBox m_comboCategory;
+	CEdit m_editUser;
+	CEdit m_editText;
 
-	void AdjustHorzScroll(CListBox& wndListBox);
+protected:
+	BOOL CreateFilterBar();
+	void ApplyFilter();
 
 // 实现
 public:
@@ -52,7 +80,10 @@ public:
 
 protected:
 	afx_msg int OnCreate(LPCREATESTRUCT lpCreateStruct);
+	afx_msg void OnDestroy();
 	afx_msg void OnSize(UINT nType, int cx, int cy);
+	afx_msg void OnFilterChanged();
+	afx_msg LRESULT OnLogStoreChanged(WPARAM wParam, LPARAM lParam);
 
 	DECLARE_MESSAGE_MAP()
 };
@@ -1,17 +1,27 @@
 ﻿#include "pch.h"
 #include "ThousChannel.h"
 #include "ChannelPageDlg.h"
+#define LOG_CATEGORY LogCategory::Ui
 #include "Logger.h"
+#include "FlightRecorder.h"
 #include "RteManager.h"
+#include "JoinOrchestrator.h"
+#include "RteTeardownWorker.h"
 #include "afxdialogex.h"
+#include <dwmapi.h>
 #include <algorithm>
+#include <iterator>
 #include <string>
 #include <vector>
+#include <chrono>
+#include <condition_variable>
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
 #endif
 
+#pragma comment(lib, "dwmapi.lib")
+
 IMPLEMENT_DYNAMIC(CChannelPageDlg, CDialogEx)
 
 BEGIN_MESSAGE_MAP(CChannelPageDlg, CDialogEx)
@@ -20,6 +30,9 @@ BEGIN_MESSAGE_MAP(CChannelPageDlg, CDialogEx)
     ON_BN_CLICKED(IDC_BTN_PREV_PAGE, &CChannelPageDlg::OnBnClickedPrevPage)
     ON_BN_CLICKED(IDC_BTN_NEXT_PAGE, &CChannelPageDlg::OnBnClickedNextPage)
     ON_WM_SIZE()
+    ON_WM_VSCROLL()
+    ON_WM_MOUSEWHEEL()
+    ON_WM_TIMER()
     ON_MESSAGE(WM_USER_RTE_JOIN_CHANNEL_SUCCESS, &CChannelPageDlg::OnRteJoinChannelSuccess)
     ON_MESSAGE(WM_USER_RTE_USER_JOINED, &CChannelPageDlg::OnRteUserJoined)
     ON_MESSAGE(WM_USER_RTE_USER_LEFT, &CChannelPageDlg::OnRteUserLeft)
@@ -29,8 +42,151 @@ BEGIN_MESSAGE_MAP(CChannelPageDlg, CDialogEx)
     ON_MESSAGE(WM_USER_RTE_USER_LIST_CHANGED, &CChannelPageDlg::OnRteUserListChanged)
     ON_MESSAGE(WM_USER_RTE_REMOTE_AUDIO_STATE_CHANGED, &CChannelPageDlg::OnRteRemoteAudioStateChanged)
     ON_MESSAGE(WM_USER_RTE_LOCAL_AUDIO_STATE_CHANGED, &CChannelPageDlg::OnRteLocalAudioStateChanged)
+    ON_MESSAGE(WM_USER_RTE_JOIN_FAILED, &CChannelPageDlg::OnRteJoinFailed)
+    ON_MESSAGE(WM_USER_RTE_CONNECTION_STATE_CHANGED, &CChannelPageDlg::OnRteConnectionStateChanged)
+    ON_MESSAGE(WM_USER_RTE_CONNECTION_RESTORED, &CChannelPageDlg::OnRteConnectionRestored)
+    ON_MESSAGE(WM_USER_RTE_USER_SNAPSHOT, &CChannelPageDlg::OnRteUserSnapshot)
 END_MESSAGE_MAP()
 
+// Layouts offered in the grid mode combo, in combo order
+struct LayoutPreset {
+    const TCHAR* name;
+    LayoutMode mode;
+    int columns;
+    int rows;
+    int pinnedTile;     // -1 for none
+    bool overview;      // Thumbnail mosaic of every user instead of the wall
+};
+
+static const LayoutPreset kLayoutPresets[] = {
+    { _T("2x2"),                LayoutMode::Grid,             2, 2, -1, false },
+    { _T("3x3"),                LayoutMode::Grid,             3, 3, -1, false },
+    { _T("4x4"),                LayoutMode::Grid,             4, 4, -1, false },
+    { _T("5x5"),                LayoutMode::Grid,             5, 5, -1, false },
+    { _T("7x7"),                LayoutMode::Grid,             7, 7, -1, false },
+    { _T("4x3"),                LayoutMode::Grid,             4, 3, -1, false },
+    { _T("4x4, first pinned"),  LayoutMode::Grid,             4, 4,  0, false },
+    { _T("Auto"),               LayoutMode::Auto,             0, 0, -1, false },
+    { _T("Speaker + filmstrip"), LayoutMode::SpeakerFilmstrip, 6, 1, -1, false },
+    { _T("Overview mosaic"),    LayoutMode::Auto,             0, 0, -1, true  },
+};
+
+static const int kLayoutPresetCount = sizeof(kLayoutPresets) / sizeof(kLayoutPresets[0]);
+static const int kAutoLayoutMaxTiles = 25;  // Auto sizes to the user count up to this many tiles
+
+// Scrolling wall
+static const int kWallOverscanBands = 1;            // Bands kept live above and below the viewport
+static const int kWallSettleMs = 150;               // Idle time after which streams attach
+static const double kWallLiveViewportsPerSecond = 2.0;  // Slower scrolling keeps streams attached
+static const UINT kWallSettlePollMs = 50;
+
+// Overview mosaic: at most kThumbnailSlots streams are subscribed at any time
+static const int kThumbnailSlots = 4;
+static const int kThumbnailStartsPerSecond = 8;
+static const UINT kThumbnailTickMs = 100;
+
+// Remote video pauses at once on minimize, after kOcclusionPauseDelayMs of
+// being covered, and resumes as soon as any part shows again
+static const UINT kVisibilityPollMs = 1000;
+static const int64_t kOcclusionPauseDelayMs = 2000;
+
+// Achieved render rates are measured one cell at a time by sampling a patch
+// of its pixels on screen faster than any target rate
+static const UINT kRenderProbeSampleMs = 15;
+static const int64_t kRenderProbeWindowMs = 2000;
+static const int kRenderProbePatch = 8;
+
+// Checksum of a small patch at the centre of `hwnd` as shown on screen
+static bool SampleWindowPatch(HWND hwnd, uint32_t& checksum)
+{
+    CRect rect;
+    if (!::GetWindowRect(hwnd, &rect) || rect.Width() < kRenderProbePatch || rect.Height() < kRenderProbePatch)
+    {
+        return false;
+    }
+
+    BITMAPINFO info = {};
+    info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    info.bmiHeader.biWidth = kRenderProbePatch;
+    info.bmiHeader.biHeight = -kRenderProbePatch;
+    info.bmiHeader.biPlanes = 1;
+    info.bmiHeader.biBitCount = 32;
+    info.bmiHeader.biCompression = BI_RGB;
+
+    void* bits = nullptr;
+    HDC screenDC = ::GetDC(NULL);
+    HDC memDC = ::CreateCompatibleDC(screenDC);
+    HBITMAP patch = ::CreateDIBSection(screenDC, &info, DIB_RGB_COLORS, &bits, NULL, 0);
+    bool sampled = false;
+    if (patch)
+    {
+        HGDIOBJ oldBitmap = ::SelectObject(memDC, patch);
+        CPoint center = rect.CenterPoint();
+        sampled = ::BitBlt(memDC, 0, 0, kRenderProbePatch, kRenderProbePatch, screenDC,
+            center.x - kRenderProbePatch / 2, center.y - kRenderProbePatch / 2, SRCCOPY) != FALSE;
+        ::GdiFlush();
+        if (sampled)
+        {
+            // FNV-1a
+            const uint32_t* pixels = static_cast<const uint32_t*>(bits);
+            checksum = 2166136261u;
+            for (int i = 0; i < kRenderProbePatch * kRenderProbePatch; i++)
+            {
+                checksum = (checksum ^ (pixels[i] & 0x00FFFFFF)) * 16777619u;
+            }
+        }
+        ::SelectObject(memDC, oldBitmap);
+        ::DeleteObject(patch);
+    }
+    ::DeleteDC(memDC);
+    ::ReleaseDC(NULL, screenDC);
+    return sampled;
+}
+
+// True when other top-level windows above `hwnd` cover all of its on-screen
+// part. Hidden, minimized, cloaked (other virtual desktop) and layered windows
+// do not cover anything.
+static bool IsWindowOccluded(HWND hwnd)
+{
+    CRect windowRect;
+    CRect screenRect(::GetSystemMetrics(SM_XVIRTUALSCREEN), ::GetSystemMetrics(SM_YVIRTUALSCREEN),
+        ::GetSystemMetrics(SM_XVIRTUALSCREEN) + ::GetSystemMetrics(SM_CXVIRTUALSCREEN),
+        ::GetSystemMetrics(SM_YVIRTUALSCREEN) + ::GetSystemMetrics(SM_CYVIRTUALSCREEN));
+    if (!::GetWindowRect(hwnd, &windowRect) || !windowRect.IntersectRect(&windowRect, &screenRect))
+    {
+        return true;    // Entirely off screen
+    }
+
+    CRgn visible;
+    visible.CreateRectRgnIndirect(&windowRect);
+    for (HWND above = ::GetWindow(hwnd, GW_HWNDPREV); above; above = ::GetWindow(above, GW_HWNDPREV))
+    {
+        if (!::IsWindowVisible(above) || ::IsIconic(above) ||
+            (::GetWindowLong(above, GWL_EXSTYLE) & (WS_EX_LAYERED | WS_EX_TRANSPARENT)))
+        {
+            continue;
+        }
+        BOOL cloaked = FALSE;
+        if (SUCCEEDED(::DwmGetWindowAttribute(above, DWMWA_CLOAKED, &cloaked, sizeof(cloaked))) && cloaked)
+        {
+            continue;
+        }
+
+        CRect aboveRect;
+        if (!::GetWindowRect(above, &aboveRect) || !aboveRect.IntersectRect(&aboveRect, &windowRect))
+        {
+            continue;
+        }
+        CRgn cover;
+        cover.CreateRectRgnIndirect(&aboveRect);
+        if (visible.CombineRgn(&visible, &cover, RGN_DIFF) == NULLREGION)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 //===========================================================================
 // CChannelPageDlg Constructor & Destructor
 //===========================================================================
@@ -38,10 +194,17 @@ END_MESSAGE_MAP()
 CChannelPageDlg::CChannelPageDlg(CWnd* pParent /*=nullptr*/)
     : CDialogEx(IDD_CHANNEL_PAGE_DLG, pParent)
 {
-    m_pageState.currentGridMode = 2;
-    m_pageState.currentPage = 1;
+    m_pageState.currentLayout = 0;
     m_pageState.usersPerPage = 4;
     m_rteManager = nullptr;
+    m_wallUpdatePending = false;
+    m_overviewActive = false;
+    m_videoPaused = false;
+    m_occludedSinceMs = -1;
+    m_renderProbeRunning = false;
+    m_probeCell = -1;
+    m_probeStartMs = 0;
+    m_rosterLoaded = false;
     m_isChannelJoined = false;
 }
 
@@ -53,37 +216,37 @@ CChannelPageDlg::CChannelPageDlg(const ChannelJoinParams& joinParams, CWnd* pPar
     m_pageState.audioMode = joinParams.audioPullMode;
     m_pageState.isLocalVideoEnabled = joinParams.enableCamera;
     m_pageState.isLocalAudioEnabled = joinParams.enableMic;
-    m_pageState.currentGridMode = 2;
-    m_pageState.currentPage = 1;
+    m_pageState.currentLayout = 0;
     m_pageState.usersPerPage = 4;
     m_rteManager = nullptr;
+    m_wallUpdatePending = false;
+    m_overviewActive = false;
+    m_videoPaused = false;
+    m_occludedSinceMs = -1;
+    m_renderProbeRunning = false;
+    m_probeCell = -1;
+    m_probeStartMs = 0;
+    m_rosterLoaded = false;
     m_isChannelJoined = false;
 
     // Create placeholder users for grid display
     int maxUsers = 32; // Assuming a max of 32 users for grid display
+    m_pageState.users.Reserve(maxUsers);
     for (int i = 1; i < maxUsers; i++) {
-        ChannelUser* placeholderUser = new ChannelUser();
-        placeholderUser->userId = "-1";
-        placeholderUser->isLocal = false;
-        placeholderUser->isConnected = false;
-        placeholderUser->isRobot = false;
-        m_pageState.userList.Add(placeholderUser);
+        m_pageState.users.Add(kInvalidUserHandle, UserFlag(kUserVideoSubscribed) | UserFlag(kUserAudioSubscribed));
     }
 }
 
 CChannelPageDlg::~CChannelPageDlg()
 {
     LOG_INFO("Channel page dialog destroyed");
-    
-    LeaveRteChannel();
+
+    // Nothing beats the watchdog once the page is gone
+    FlightRecorder::Instance().Disarm();
+
+    // Hands the join thread and the engine to the teardown worker, does not block
     ReleaseRteEngine();
     DestroyVideoWindows();
-    
-    // Clean up user list
-    for (int i = 0; i < m_pageState.userList.GetSize(); i++) {
-        delete m_pageState.userList[i];
-    }
-    m_pageState.userList.RemoveAll();
 }
 
 
@@ -113,37 +276,36 @@ BOOL CChannelPageDlg::OnInitDialog()
     InitializeControls();
     
     // SetupVideoContainer(); // This function was removed during refactoring.
-    CreateVideoWindows();
     UpdateGridLayout();
 
-    if (!InitializeRteEngine()) {
-        LOG_ERROR("Failed to initialize RTE engine");
-        AfxMessageBox(_T("Failed to initialize RTE engine."));
-        EndDialog(IDCANCEL);
-        return FALSE;
-    }
-    
     // Create local user data
-    ChannelUser* localUser = new ChannelUser();
-    localUser->isLocal = true;
-    localUser->isConnected = true;
-    localUser->userId = m_pageState.currentUserId;
-    m_pageState.userList.InsertAt(0, localUser);
-    
-    if (!JoinRteChannel()) {
-        LOG_ERROR("Failed to join RTE channel");
-        return FALSE;
-    }
-    
-    // Enable local audio/video after successful channel join
-    if (m_rteManager) {
-        m_rteManager->SetLocalAudioCaptureEnabled(m_joinParams.enableMic);
-        m_rteManager->SetLocalVideoCaptureEnabled(m_joinParams.enableCamera);
+    ChannelUserFlags localFlags = UserFlag(kUserLocal) | UserFlag(kUserConnected) |
+        UserFlag(kUserVideoSubscribed) | UserFlag(kUserAudioSubscribed);
+    if (m_pageState.isLocalVideoEnabled) {
+        localFlags |= UserFlag(kUserVideoOn);
     }
+    m_pageState.users.InsertAt(0, UserIdInterner::instance().Intern(m_pageState.currentUserId), localFlags);
+
+    SetTimer(kVisibilityTimerId, kVisibilityPollMs, NULL);
+
+    // Token, engine init, connect, join and device open run on a worker thread,
+    // the result comes back as WM_USER_RTE_JOIN_CHANNEL_SUCCESS or WM_USER_RTE_JOIN_FAILED
+    StartJoinSequence();
 
     return TRUE;
 }
 
+// RTE notifications and commands go to the flight recorder; input, paint and
+// timer traffic would push everything else out of the UI thread's ring
+LRESULT CChannelPageDlg::WindowProc(UINT message, WPARAM wParam, LPARAM lParam)
+{
+    if (message >= WM_USER || message == WM_COMMAND || message == WM_CLOSE)
+    {
+        FlightRecorder::Record(FlightEventKind::UiMessage, "ChannelPageDlg", message, static_cast<int64_t>(wParam));
+    }
+    return CDialogEx::WindowProc(message, wParam, lParam);
+}
+
 void CChannelPageDlg::OnOK()
 {
     // Override to prevent closing with Enter key
@@ -164,6 +326,7 @@ void CChannelPageDlg::OnSize(UINT nType, int cx, int cy)
 {
     CDialogEx::OnSize(nType, cx, cy);
     UpdateGridLayout();
+    UpdateVideoPause();     // Minimize and restore take effect at once
 }
 
 void CChannelPageDlg::OnBnClickedExitChannel()
@@ -177,34 +340,87 @@ void CChannelPageDlg::OnBnClickedExitChannel()
 void CChannelPageDlg::OnCbnSelchangeGridMode()
 {
     int sel = static_cast<int>(m_comboGridMode.GetCurSel());
-    int newGridMode = 2 + sel;
-    if (sel == 4) newGridMode = 7;
-    
-    SetGridMode(newGridMode);
+    if (sel != CB_ERR) {
+        SetLayoutPreset(sel);
+    }
 }
 
 void CChannelPageDlg::OnBnClickedPrevPage()
 {
-    if (m_pageState.currentPage > 1)
+    ScrollWall(m_wall.GetOffset() - m_wall.GetViewportHeight());
+}
+
+void CChannelPageDlg::OnBnClickedNextPage()
+{
+    ScrollWall(m_wall.GetOffset() + m_wall.GetViewportHeight());
+}
+
+void CChannelPageDlg::OnVScroll(UINT nSBCode, UINT nPos, CScrollBar* pScrollBar)
+{
+    if (pScrollBar != &m_scrollVideoWall)
     {
-        m_pageState.currentPage--;
-        UpdateVideoLayout();
-        UpdatePageDisplay();
-        UpdateSubscribedUsers();
-        UpdateViewUserBindings();
+        CDialogEx::OnVScroll(nSBCode, nPos, pScrollBar);
+        return;
+    }
+
+    int offset = m_wall.GetOffset();
+    int lineStep = (std::max)(m_wall.GetBandHeight() / 4, 1);
+    switch (nSBCode)
+    {
+    case SB_LINEUP:     offset -= lineStep; break;
+    case SB_LINEDOWN:   offset += lineStep; break;
+    case SB_PAGEUP:     offset -= m_wall.GetViewportHeight(); break;
+    case SB_PAGEDOWN:   offset += m_wall.GetViewportHeight(); break;
+    case SB_TOP:        offset = 0; break;
+    case SB_BOTTOM:     offset = m_wall.GetMaxOffset(); break;
+    case SB_THUMBTRACK:
+    case SB_THUMBPOSITION:
+    {
+        // nPos is 16-bit, the track position is not
+        SCROLLINFO info = { sizeof(SCROLLINFO) };
+        info.fMask = SIF_TRACKPOS;
+        if (m_scrollVideoWall.GetScrollInfo(&info, SIF_TRACKPOS)) {
+            offset = info.nTrackPos;
+        }
+        break;
+    }
+    default:
+        return;
     }
+    ScrollWall(offset);
 }
 
-void CChannelPageDlg::OnBnClickedNextPage()
+BOOL CChannelPageDlg::OnMouseWheel(UINT nFlags, short zDelta, CPoint pt)
 {
-    if (m_pageState.currentPage < GetMaxPages())
+    // Half a band per notch
+    ScrollWall(m_wall.GetOffset() - zDelta * m_wall.GetBandHeight() / (2 * WHEEL_DELTA));
+    return TRUE;
+}
+
+void CChannelPageDlg::OnTimer(UINT_PTR nIDEvent)
+{
+    if (nIDEvent == kWallSettleTimerId)
     {
-        m_pageState.currentPage++;
-        UpdateVideoLayout();
-        UpdatePageDisplay();
-        UpdateSubscribedUsers();
-        UpdateViewUserBindings();
+        UpdateWallSubscriptions();
+        return;
     }
+    if (nIDEvent == kThumbnailTimerId)
+    {
+        RefreshThumbnails();
+        return;
+    }
+    if (nIDEvent == kVisibilityTimerId)
+    {
+        FlightRecorder::Instance().Heartbeat();
+        UpdateVideoPause();
+        return;
+    }
+    if (nIDEvent == kRenderProbeTimerId)
+    {
+        SampleRenderProbe();
+        return;
+    }
+    CDialogEx::OnTimer(nIDEvent);
 }
 
 
@@ -216,21 +432,25 @@ void CChannelPageDlg::OnBnClickedNextPage()
 void CChannelPageDlg::OnConnectionStateChanged(int state)
 {
     // Post message to UI thread
-    PostMessage(WM_USER_RTE_JOIN_CHANNEL_SUCCESS, 0, 0);
+    PostMessage(WM_USER_RTE_CONNECTION_STATE_CHANGED, (WPARAM)state, 0);
 }
 
-void CChannelPageDlg::OnUserJoined(const std::string& userId)
+void CChannelPageDlg::OnConnectionRestored(long long outageMs, int attempts)
 {
-    // Convert std::string to CString and post it
-    CString* uidStr = new CString(userId.c_str());
-    PostMessage(WM_USER_RTE_USER_JOINED, (WPARAM)uidStr, 0);
+    // Post message to UI thread
+    PostMessage(WM_USER_RTE_CONNECTION_RESTORED, (WPARAM)outageMs, (LPARAM)attempts);
 }
 
-void CChannelPageDlg::OnUserLeft(const std::string& userId)
+void CChannelPageDlg::OnUserJoined(UserHandle user)
 {
-    // Convert std::string to CString and post it
-    CString* uidStr = new CString(userId.c_str());
-    PostMessage(WM_USER_RTE_USER_LEFT, (WPARAM)uidStr, 0);
+    // Post message to UI thread
+    PostMessage(WM_USER_RTE_USER_JOINED, (WPARAM)user, 0);
+}
+
+void CChannelPageDlg::OnUserLeft(UserHandle user)
+{
+    // Post message to UI thread
+    PostMessage(WM_USER_RTE_USER_LEFT, (WPARAM)user, 0);
 }
 
 void CChannelPageDlg::OnLocalAudioStateChanged(int state)
@@ -245,18 +465,16 @@ void CChannelPageDlg::OnLocalVideoStateChanged(int state, int reason)
     PostMessage(WM_USER_RTE_LOCAL_VIDEO_STATE_CHANGED, MAKEWPARAM(state, reason), 0);
 }
 
-void CChannelPageDlg::OnRemoteAudioStateChanged(const std::string& userId, int state)
+void CChannelPageDlg::OnRemoteAudioStateChanged(UserHandle user, int state)
 {
-    // Convert std::string to CString and post it
-    CString* uidStr = new CString(userId.c_str());
-    PostMessage(WM_USER_RTE_REMOTE_AUDIO_STATE_CHANGED, (WPARAM)uidStr, state);
+    // Post message to UI thread
+    PostMessage(WM_USER_RTE_REMOTE_AUDIO_STATE_CHANGED, (WPARAM)user, state);
 }
 
-void CChannelPageDlg::OnRemoteVideoStateChanged(const std::string& userId, int state)
+void CChannelPageDlg::OnRemoteVideoStateChanged(UserHandle user, int state)
 {
-    // Convert std::string to CString and post it
-    CString* uidStr = new CString(userId.c_str());
-    PostMessage(WM_USER_RTE_REMOTE_VIDEO_STATE_CHANGED, (WPARAM)uidStr, state);
+    // Post message to UI thread
+    PostMessage(WM_USER_RTE_REMOTE_VIDEO_STATE_CHANGED, (WPARAM)user, state);
 }
 
 void CChannelPageDlg::OnError(int error)
@@ -271,19 +489,39 @@ void CChannelPageDlg::OnUserListChanged()
     PostMessage(WM_USER_RTE_USER_LIST_CHANGED, 0, 0);
 }
 
+void CChannelPageDlg::OnUserSnapshot(std::shared_ptr<const std::vector<UserHandle>> roster)
+{
+    // Post message to UI thread. Every roster holds all remote users, so a newer
+    // one replaces one the UI thread has not merged yet.
+    {
+        std::lock_guard<std::mutex> lock(m_snapshotMutex);
+        m_pendingSnapshot = roster;
+    }
+    PostMessage(WM_USER_RTE_USER_SNAPSHOT, 0, 0);
+}
+
 LRESULT CChannelPageDlg::OnRteJoinChannelSuccess(WPARAM wParam, LPARAM lParam)
 {
+    // The join thread has finished, expose the manager to the UI thread
+    if (m_joinThread.joinable()) {
+        m_joinThread.join();
+    }
+    m_rteManager = m_joinContext ? m_joinContext->manager : nullptr;
+    m_isChannelJoined = (m_rteManager != nullptr);
+    if (m_rteManager && m_videoPaused) {
+        m_rteManager->SetRemoteVideoPaused(true);
+    }
+
     // Use the real user ID passed from the previous page
     std::string realUserId = m_pageState.currentUserId;
     CString localUserId(realUserId.c_str());
 
     LOG_INFO_FMT("Join channel success - Using user ID: {}", realUserId);
 
-    if (m_pageState.userList.GetSize() > 0) {
-        ChannelUser* localUser = m_pageState.userList[0];
-        if (localUser->isLocal) {
+    if (m_pageState.users.GetSize() > 0) {
+        if (m_pageState.users.Test(0, kUserLocal)) {
             // Update the local user with the real user ID from RTE
-            localUser->userId = realUserId;
+            m_pageState.users.SetUser(0, UserIdInterner::instance().Intern(realUserId));
             LOG_INFO_FMT("Updated local user ID to: {}", realUserId);
 
             UpdateVideoLayout();
@@ -297,78 +535,66 @@ LRESULT CChannelPageDlg::OnRteJoinChannelSuccess(WPARAM wParam, LPARAM lParam)
         }
     }
 
+    // Users that arrived while joining were added without a manager, bind them now
+    UpdateSubscribedUsers();
+    UpdateViewUserBindings();
+
     return 0;
 }
 
 LRESULT CChannelPageDlg::OnRteUserJoined(WPARAM wParam, LPARAM lParam)
 {
-    CString* uidPtr = (CString*)wParam;
-    CString uid = *uidPtr;
-    delete uidPtr;
+    UserHandle user = (UserHandle)wParam;
+    const std::string& userId = UserIdString(user);
 
-    LOG_INFO_FMT("User joined: {}", uid);
+    LOG_INFO_LIMITED_FMT("User joined: {}", LogUser(user));
+    m_thumbnailScheduler.MarkActive(user, static_cast<int64_t>(::GetTickCount64()));
 
     // 1. 用户类型判断
-    bool isRobot = (_ttoi(uid) >= 1000);
-    std::string userId = std::string(CT2A(uid));
+    bool isRobot = (atoi(userId.c_str()) >= 1000);
 
     // 2. 用户存在性检查
-    int userIndex = FindUserIndex(uid);
-    ChannelUser* targetUser = nullptr;
+    int userIndex = FindUserIndex(user);
+    ChannelUserTable& users = m_pageState.users;
 
     if (isRobot) {
         // 机器人用户处理
         if (userIndex != -1) {
             // 已存在 -> 不做任何事
-            LOG_INFO_FMT("Robot user {} already exists, skipping", uid);
+            LOG_INFO_LIMITED_FMT("Robot user {} already exists, skipping", LogUser(user));
             return 0;
         }
         
         // 创建新的机器人用户
-        targetUser = new ChannelUser();
-        targetUser->userId = userId;
-        targetUser->isConnected = true;
-        targetUser->isLocal = false;
-        targetUser->isRobot = true;
-        targetUser->isVideoSubscribed = true;
-        targetUser->isAudioSubscribed = true;
-        
-        m_pageState.userList.Add(targetUser);
-        LOG_INFO_FMT("Created new robot user: {}", userId);
+        userIndex = users.Add(user, kNewRemoteUserFlags | UserFlag(kUserRobot));
+        LOG_INFO_LIMITED_FMT("Created new robot user: {}", LogUser(user));
         
     } else {
         // 真人用户处理
         if (userIndex != -1) {
             // 更新现有占位符用户
-            targetUser = m_pageState.userList[userIndex];
-            if (targetUser && !targetUser->isConnected) {
-                targetUser->isConnected = true;
-                targetUser->userId = userId;
-                targetUser->isVideoSubscribed = true;
-                targetUser->isAudioSubscribed = true;
-                LOG_INFO_FMT("Updated existing placeholder user: {}", userId);
+            if (!users.Test(userIndex, kUserConnected)) {
+                users.SetFlags(userIndex, kNewRemoteUserFlags | (users.GetFlags(userIndex) & UserFlag(kUserVisible)));
+                LOG_INFO_LIMITED_FMT("Updated existing placeholder user: {}", LogUser(user));
             }
         } else {
             // 占位符不存在，创建新用户（异常情况）
-            targetUser = new ChannelUser();
-            targetUser->userId = userId;
-            targetUser->isConnected = true;
-            targetUser->isLocal = false;
-            targetUser->isRobot = false;
-            targetUser->isVideoSubscribed = true;
-            targetUser->isAudioSubscribed = true;
-            
-            m_pageState.userList.Add(targetUser);
-            LOG_WARN("Created new real user (should be placeholder): {}", userId);
+            userIndex = users.Add(user, kNewRemoteUserFlags);
+            LOG_WARN_LIMITED_FMT("Created new real user (should be placeholder): {}", LogUser(user));
         }
     }
 
     // 3. 订阅状态更新
-    if (m_rteManager && targetUser && !targetUser->isLocal) {
-        LOG_INFO_FMT("Subscribing to remote video/audio for user: {}", userId);
+    if (m_rteManager && !users.Test(userIndex, kUserLocal)) {
+        LOG_INFO_LIMITED_FMT("Subscribing to remote video/audio for user: {}", LogUser(user));
         // TODO: 实现真正的订阅逻辑
     }
 
+    // While reconnecting, the view is restored in one batch from the snapshot
+    if (m_reconnectSnapshot.valid) {
+        return 0;
+    }
+
     // 4. 更新UI状态
     UpdateVideoLayout();
     UpdatePageDisplay();
@@ -380,51 +606,48 @@ LRESULT CChannelPageDlg::OnRteUserJoined(WPARAM wParam, LPARAM lParam)
 
 LRESULT CChannelPageDlg::OnRteUserLeft(WPARAM wParam, LPARAM lParam)
 {
-    CString* uidPtr = (CString*)wParam;
-    CString uid = *uidPtr;
-    delete uidPtr;
+    UserHandle user = (UserHandle)wParam;
 
-    LOG_INFO_FMT("User left: {}", uid);
+    LOG_INFO_LIMITED_FMT("User left: {}", LogUser(user));
 
     // 1. 用户存在性检查
-    int userIndex = FindUserIndex(uid);
+    int userIndex = FindUserIndex(user);
     if (userIndex == -1) {
-        LOG_WARN("User {} not found in list, ignoring leave event", uid);
+        LOG_WARN_LIMITED_FMT("User {} not found in list, ignoring leave event", LogUser(user));
         return 0;
     }
 
     // 2. 获取用户信息
-    ChannelUser* targetUser = m_pageState.userList[userIndex];
-    if (!targetUser) {
-        LOG_ERROR("User object at index {} is null", userIndex);
-        return 0;
-    }
+    ChannelUserTable& users = m_pageState.users;
+    bool isRobot = users.Test(userIndex, kUserRobot);
+    bool isLocal = users.Test(userIndex, kUserLocal);
 
     // 3. 用户类型判断和处理
-    bool isRobot = targetUser->isRobot;
-    std::string userId = targetUser->GetUserId();
-
     if (isRobot) {
         // 机器人用户 -> 从列表中移除
-        LOG_INFO_FMT("Removing robot user: {}", userId);
-        delete targetUser;
-        m_pageState.userList.RemoveAt(userIndex);
+        LOG_INFO_LIMITED_FMT("Removing robot user: {}", LogUser(user));
+        users.RemoveAt(userIndex);
         
     } else {
         // 真人用户 -> 设置为离线状态
-        LOG_INFO_FMT("Setting real user offline: {}", userId);
-        targetUser->isConnected = false;
-        targetUser->isVideoSubscribed = false;
-        targetUser->isAudioSubscribed = false;
-        targetUser->userId = userId + " (Offline)";
+        LOG_INFO_LIMITED_FMT("Setting real user offline: {}", LogUser(user));
+        users.Set(userIndex, kUserConnected, false);
+        users.Set(userIndex, kUserVideoSubscribed, false);
+        users.Set(userIndex, kUserAudioSubscribed, false);
+        users.Set(userIndex, kUserVideoOn, false);
+        // Keeps its handle so a rejoin finds the same row; shown as offline by GetDisplayName
     }
 
     // 4. 订阅状态更新
-    if (m_rteManager && !targetUser->isLocal) {
-        LOG_INFO_FMT("Unsubscribing from remote video/audio for user: {}", userId);
+    if (m_rteManager && !isLocal) {
+        LOG_INFO_LIMITED_FMT("Unsubscribing from remote video/audio for user: {}", LogUser(user));
         // TODO: 实现真正的取消订阅逻辑
     }
 
+    if (m_reconnectSnapshot.valid) {
+        return 0;
+    }
+
     // 5. 更新UI状态
     UpdateVideoLayout();
     UpdatePageDisplay();
@@ -436,13 +659,18 @@ LRESULT CChannelPageDlg::OnRteUserLeft(WPARAM wParam, LPARAM lParam)
 
 LRESULT CChannelPageDlg::OnRteRemoteVideoStateChanged(WPARAM wParam, LPARAM lParam)
 {
-    CString* uidPtr = (CString*)wParam;
-    CString uid = *uidPtr;
-    delete uidPtr;
+    UserHandle user = (UserHandle)wParam;
 
     int state = LOWORD(lParam);
     int reason = HIWORD(lParam);
-    LOG_INFO_FMT("Remote video state changed for user {}, state={}, reason={}", uid, state, reason);
+    LOG_INFO_LIMITED_FMT("Remote video state changed for user {}, state={}, reason={}", LogUser(user), state, reason);
+
+    // REMOTE_VIDEO_STATE_STARTING (1) and REMOTE_VIDEO_STATE_DECODING (2) count as video on
+    int userIndex = FindUserIndex(user);
+    if (userIndex != -1) {
+        m_pageState.users.Set(userIndex, kUserVideoOn, state == 1 || state == 2);
+    }
+    m_thumbnailScheduler.MarkActive(user, static_cast<int64_t>(::GetTickCount64()));
 
     // You might want to update the UI for this user
     // For example, show an icon if their video is disabled
@@ -456,6 +684,11 @@ LRESULT CChannelPageDlg::OnRteLocalVideoStateChanged(WPARAM wParam, LPARAM lPara
     int reason = HIWORD(wParam);
     LOG_INFO_FMT("Local video state changed, state={}, reason={}", state, reason);
 
+    // LOCAL_VIDEO_STREAM_STATE_CAPTURING (1) and LOCAL_VIDEO_STREAM_STATE_ENCODING (2)
+    if (m_pageState.users.GetSize() > 0 && m_pageState.users.Test(0, kUserLocal)) {
+        m_pageState.users.Set(0, kUserVideoOn, state == 1 || state == 2);
+    }
+
     // You can update the local user's UI based on the state
     // e.g., show a "camera off" icon
     return 0;
@@ -463,12 +696,11 @@ LRESULT CChannelPageDlg::OnRteLocalVideoStateChanged(WPARAM wParam, LPARAM lPara
 
 LRESULT CChannelPageDlg::OnRteRemoteAudioStateChanged(WPARAM wParam, LPARAM lParam)
 {
-    CString* uidPtr = (CString*)wParam;
-    CString uid = *uidPtr;
-    delete uidPtr;
+    UserHandle user = (UserHandle)wParam;
 
     int state = (int)lParam;
-    LOG_INFO_FMT("Remote audio state changed for user {}, state={}", uid, state);
+    LOG_INFO_LIMITED_FMT("Remote audio state changed for user {}, state={}", LogUser(user), state);
+    m_thumbnailScheduler.MarkActive(user, static_cast<int64_t>(::GetTickCount64()));
 
     return 0;
 }
@@ -485,7 +717,7 @@ LRESULT CChannelPageDlg::OnRteError(WPARAM wParam, LPARAM lParam)
 {
     // Placeholder implementation
     int error_code = (int)wParam;
-    LOG_ERROR("RTE Engine Error: {}", error_code);
+    LOG_ERROR_FMT("RTE Engine Error: {}", error_code);
     
     // Display an error message to the user
     CString errorMsg;
@@ -495,11 +727,112 @@ LRESULT CChannelPageDlg::OnRteError(WPARAM wParam, LPARAM lParam)
     return 0;
 }
 
+LRESULT CChannelPageDlg::OnRteJoinFailed(WPARAM wParam, LPARAM lParam)
+{
+    if (m_joinThread.joinable()) {
+        m_joinThread.join();
+    }
+
+    std::string failedStep = m_joinContext ? m_joinContext->failedStep : std::string();
+    LOG_ERROR_FMT("Join channel failed at step: {}", failedStep);
+
+    CString errorMsg;
+    errorMsg.Format(_T("Failed to join channel (step: %s). Please check the logs."), CString(failedStep.c_str()));
+    AfxMessageBox(errorMsg, MB_ICONERROR);
+    EndDialog(IDCANCEL);
+
+    return 0;
+}
+
+LRESULT CChannelPageDlg::OnRteConnectionStateChanged(WPARAM wParam, LPARAM lParam)
+{
+    int state = (int)wParam;
+    LOG_INFO_FMT("Connection state changed: {}", state);
+
+    if (!m_isChannelJoined || m_reconnectSnapshot.valid) {
+        return 0;
+    }
+
+    if (state == kRteLocalUserLinkStateDisconnected ||
+        state == kRteLocalUserLinkStateSuspended ||
+        state == kRteLocalUserLinkStateFailed) {
+        TakeReconnectSnapshot();
+
+        CString strChannelInfo;
+        strChannelInfo.Format(_T("Channel: %s (Reconnecting...)"), CString(m_pageState.channelId.c_str()));
+        m_staticChannelId.SetWindowText(strChannelInfo);
+    }
+
+    return 0;
+}
+
+LRESULT CChannelPageDlg::OnRteConnectionRestored(WPARAM wParam, LPARAM lParam)
+{
+    long long outageMs = (long long)wParam;
+    int attempts = (int)lParam;
+
+    auto restoreStart = std::chrono::steady_clock::now();
+    RestoreReconnectSnapshot();
+    long long restoreMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - restoreStart).count();
+
+    LOG_INFO_FMT("Reconnected: outage={}ms, attempts={}, view restored in {}ms", outageMs, attempts, restoreMs);
+
+    CString strChannelInfo;
+    strChannelInfo.Format(_T("Channel: %s (My UID: %s)"),
+        CString(m_pageState.channelId.c_str()), CString(m_pageState.currentUserId.c_str()));
+    m_staticChannelId.SetWindowText(strChannelInfo);
+
+    return 0;
+}
+
+// Many users at once (presence snapshot on join): merge the whole roster in
+// one pass. The UserListChanged posted right after it refreshes the view once.
+// The roster came with the event, so the UI thread never waits on the strand.
+LRESULT CChannelPageDlg::OnRteUserSnapshot(WPARAM wParam, LPARAM lParam)
+{
+    std::shared_ptr<const std::vector<UserHandle>> roster;
+    {
+        std::lock_guard<std::mutex> lock(m_snapshotMutex);
+        roster.swap(m_pendingSnapshot);
+    }
+    // Merged already by the message of a newer snapshot
+    if (!roster) {
+        return 0;
+    }
+
+    auto mergeStart = std::chrono::steady_clock::now();
+    int added = MergeRemoteUsers(*roster);
+    auto mergeEnd = std::chrono::steady_clock::now();
+    LOG_INFO_FMT("User snapshot: {} users, {} added in {}us", roster->size(), added,
+        std::chrono::duration_cast<std::chrono::microseconds>(mergeEnd - mergeStart).count());
+
+    if (!m_rosterLoaded) {
+        m_rosterLoaded = true;
+        LOG_INFO_FMT("Time to roster: {}ms after join start, {} users",
+            std::chrono::duration_cast<std::chrono::milliseconds>(mergeEnd - m_joinStartedAt).count(), roster->size());
+    }
+    return 0;
+}
+
 LRESULT CChannelPageDlg::OnRteUserListChanged(WPARAM wParam, LPARAM lParam)
 {
     // Placeholder implementation
     // This message is sent when the user list changes, e.g., when a user joins or leaves.
     // You might need to re-sort or update the UI based on the new user list.
+    const ChannelUserTable& users = m_pageState.users;
+    LOG_INFO_FMT("User list changed: {} connected, {} with video on, {} rows",
+        users.Count(UserFlag(kUserConnected)),
+        users.Count(UserFlag(kUserConnected) | UserFlag(kUserVideoOn)),
+        users.GetSize());
+
+    if (m_overviewActive) {
+        UpdateOverviewUsers();
+    }
+    if (m_reconnectSnapshot.valid) {
+        return 0;
+    }
+    UpdateGridLayout();     // Auto layout follows the user count
     UpdateVideoLayout();
     UpdatePageDisplay();
     UpdateSubscribedUsers();
@@ -525,12 +858,31 @@ void CChannelPageDlg::InitializeFonts()
 
 void CChannelPageDlg::InitializeControls()
 {
-    m_comboGridMode.AddString(_T("2x2"));
-    m_comboGridMode.AddString(_T("3x3"));
-    m_comboGridMode.AddString(_T("4x4"));
-    m_comboGridMode.AddString(_T("5x5"));
-    m_comboGridMode.AddString(_T("7x7"));
-    m_comboGridMode.SetCurSel(0);
+    for (int i = 0; i < kLayoutPresetCount; i++) {
+        m_comboGridMode.AddString(kLayoutPresets[i].name);
+    }
+    m_comboGridMode.SetCurSel(m_pageState.currentLayout);
+
+    // The wall scrolls inside the container, its scroll bar takes a strip on the right.
+    // Cells are children of the container so partly scrolled-out rows are clipped.
+    CRect containerRect;
+    m_staticVideoContainer.GetWindowRect(&containerRect);
+    ScreenToClient(&containerRect);
+    int scrollBarWidth = ::GetSystemMetrics(SM_CXVSCROLL);
+    containerRect.right -= scrollBarWidth;
+    m_staticVideoContainer.MoveWindow(&containerRect);
+    m_staticVideoContainer.ModifyStyle(0, WS_CLIPCHILDREN);
+    m_scrollVideoWall.Create(SBS_VERT | WS_CHILD | WS_VISIBLE,
+        CRect(containerRect.right, containerRect.top, containerRect.right + scrollBarWidth, containerRect.bottom),
+        this, IDC_SCROLL_VIDEO_WALL);
+    m_overviewMosaic.Create(this,
+        CRect(containerRect.left, containerRect.top, containerRect.right + scrollBarWidth, containerRect.bottom),
+        IDC_OVERVIEW_MOSAIC);
+
+    ThumbnailSchedulerConfig thumbnailConfig;
+    thumbnailConfig.slotCount = kThumbnailSlots;
+    thumbnailConfig.maxStartsPerSecond = kThumbnailStartsPerSecond;
+    m_thumbnailScheduler.SetConfig(thumbnailConfig);
 
     m_btnExitChannel.SetWindowText(_T("Exit Channel"));
     
@@ -546,21 +898,30 @@ void CChannelPageDlg::InitializeControls()
 // RTE Engine Management
 //===========================================================================
 
-BOOL CChannelPageDlg::InitializeRteEngine()
+bool CChannelPageDlg::InitializeRteEngine(ChannelJoinContext& context)
 {
-    m_rteManager = new RteManager();
-    if (!m_rteManager) {
-        return FALSE;
+    if (!context.manager) {
+        return false;
     }
 
-    // Set event handler
-    m_rteManager->SetEventHandler(this);
+    // An engine from the previous channel page may still be draining,
+    // creating a second rte::Rte before it is destroyed is not supported
+    auto waitStart = std::chrono::steady_clock::now();
+    if (!RteTeardownWorker::Instance().WaitIdle(kTeardownWaitMs)) {
+        LOG_ERROR_FMT("Previous engine still tearing down after {}ms", kTeardownWaitMs);
+        return false;
+    }
+    long long waitedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - waitStart).count();
+    if (waitedMs > 0) {
+        LOG_INFO_FMT("Waited {}ms for previous engine teardown", waitedMs);
+    }
 
     // Initialize RTE with config
     RteManagerConfig config;
     // Convert std::string to std::string (no conversion needed for appId)
-    config.appId = m_joinParams.appId;
-    config.userId = m_pageState.currentUserId;
+    config.appId = context.params.appId;
+    config.userId = context.params.userId;
     
     // Debug: Log the converted values using CString to avoid encoding issues
     LOG_INFO_FMT("Converted appId: {}", CString(config.appId.c_str()));
@@ -568,48 +929,202 @@ BOOL CChannelPageDlg::InitializeRteEngine()
     // userToken is not a member of RteManagerConfig
     // Token should be passed separately to JoinChannel method
 
-    if (!m_rteManager->Initialize(config)) {
+    if (!context.manager->Initialize(config)) {
         LOG_ERROR("Failed to initialize RteManager");
-        return FALSE;
+        return false;
     }
 
-    return TRUE;
+    return true;
 }
 
 void CChannelPageDlg::ReleaseRteEngine()
 {
-    if (m_rteManager) {
-        m_rteManager->Destroy();
-        delete m_rteManager;
-        m_rteManager = nullptr;
+    std::shared_ptr<ChannelJoinContext> context = m_joinContext;
+    m_joinContext.reset();
+    m_rteManager = nullptr;
+    m_isChannelJoined = false;
+
+    if (!context || !context->manager) {
+        return;
+    }
+
+    // Stop callbacks into this dialog and drop canvases bound to its windows
+    // before they are destroyed; everything else drains in the background
+    RteManager* manager = context->manager;
+    manager->SetEventHandler(nullptr);
+    manager->SetViewUserBindings(std::vector<RteViewBinding>());
+    std::vector<ThumbnailAction> stops;
+    m_thumbnailScheduler.StopAll(stops);
+    for (const ThumbnailAction& stop : stops) {
+        manager->SetupRemoteVideo(stop.user, nullptr);
     }
+
+    // Abort a join or reconnect still waiting on SDK callbacks so wait_join
+    // below returns promptly instead of running into each phase timeout
+    manager->CancelPendingOperations();
+
+    std::shared_ptr<std::thread> joinThread;
+    if (m_joinThread.joinable()) {
+        joinThread = std::make_shared<std::thread>(std::move(m_joinThread));
+    }
+
+    RteTeardownJob job("channel:" + context->params.channelId, kTeardownDeadlineMs);
+    job.AddStep("wait_join", [joinThread]() {
+        if (joinThread) {
+            joinThread->join();
+        }
+    }, true);
+    job.AddStep("leave_channel", [manager]() {
+        manager->LeaveChannel();
+    });
+    job.AddStep("stop_tracks", [manager]() {
+        manager->StopLocalTracks();
+    });
+    job.AddStep("release_engine", [manager]() {
+        manager->ReleaseEngine();
+    }, true);
+    job.AddStep("delete_manager", [context]() {
+        delete context->manager;
+        context->manager = nullptr;
+    }, true);
+    job.SetCompletionCallback([](const RteTeardownResult& result) {
+        if (result.deadlineMissed) {
+            LOG_WARN_FMT("Channel teardown missed its deadline, took {}ms, {} steps skipped",
+                result.elapsedMs, result.skippedSteps.size());
+        }
+    });
+
+    RteTeardownWorker::Instance().Submit(job);
 }
 
-BOOL CChannelPageDlg::JoinRteChannel()
+void CChannelPageDlg::StartJoinSequence()
 {
-    if (!m_rteManager || m_joinParams.token.empty()) {
-        return FALSE;
+    m_joinStartedAt = std::chrono::steady_clock::now();
+    m_rosterLoaded = false;
+    {
+        std::lock_guard<std::mutex> lock(m_snapshotMutex);
+        m_pendingSnapshot.reset();
     }
+    m_joinContext = std::make_shared<ChannelJoinContext>();
+    m_joinContext->params = m_joinParams;
+    m_joinContext->hwnd = GetSafeHwnd();
+
+    // Created here so the event handler is set before any callback can fire
+    m_joinContext->manager = new RteManager();
+    m_joinContext->manager->SetEventHandler(this);
+
+    // The thread only touches the context, so the dialog can go away while it runs
+    std::shared_ptr<ChannelJoinContext> context = m_joinContext;
+    m_joinThread = std::thread([context]() {
+        RunJoinSequence(context);
+    });
+}
 
-    // Convert std::string to std::string (no conversion needed)
-    std::string channelId = m_joinParams.channelId;
-    std::string token = m_joinParams.token;
-    
-    // Debug: Log the values directly using std::string
-    LOG_INFO_FMT("Converted channelId: {}", channelId);
-    LOG_INFO_FMT("Converted token: {}", token.substr(0, 20));
-    
-    bool result = m_rteManager->JoinChannel(channelId, token);
-    m_isChannelJoined = result;
-    return result;
+void CChannelPageDlg::RunJoinSequence(std::shared_ptr<ChannelJoinContext> context)
+{
+    RteManager* manager = context->manager;
+    std::string channelId = context->params.channelId;
+
+    // token ----------------------.
+    //                             +--> connect --> join --.
+    // engine_init --+-------------'                       +--> publish
+    //               +--> mic (optional) -------------------|
+    //               '--> camera (optional) ----------------'
+    JoinOrchestrator orchestrator;
+    orchestrator.AddStep("token", {}, [context]() {
+        return FetchToken(*context);
+    });
+    orchestrator.AddStep("engine_init", {}, [context]() {
+        return InitializeRteEngine(*context);
+    });
+    orchestrator.AddStep("connect", { "token", "engine_init" }, [context, manager]() {
+        return manager->ConnectLocalUser(context->params.token);
+    });
+    orchestrator.AddStep("join", { "connect" }, [manager, channelId]() {
+        return manager->EnterChannel(channelId);
+    });
+
+    std::vector<std::string> publishDeps = { "join" };
+    if (context->params.enableMic) {
+        orchestrator.AddStep("mic", { "engine_init" }, [manager]() {
+            return manager->StartMicTrack();
+        }, false);
+        publishDeps.push_back("mic");
+    }
+    if (context->params.enableCamera) {
+        orchestrator.AddStep("camera", { "engine_init" }, [manager]() {
+            return manager->StartCameraTrack();
+        }, false);
+        publishDeps.push_back("camera");
+    }
+    orchestrator.AddStep("publish", publishDeps, [manager]() {
+        return manager->PublishLocalStream();
+    });
+
+    if (orchestrator.Run()) {
+        ::PostMessage(context->hwnd, WM_USER_RTE_JOIN_CHANNEL_SUCCESS, 0, 0);
+    } else {
+        context->failedStep = orchestrator.GetFailedStep();
+        ::PostMessage(context->hwnd, WM_USER_RTE_JOIN_FAILED, 0, 0);
+    }
 }
 
-void CChannelPageDlg::LeaveRteChannel()
+bool CChannelPageDlg::FetchToken(ChannelJoinContext& context)
 {
-    if (m_rteManager && m_isChannelJoined) {
-        m_rteManager->LeaveChannel();
-        m_isChannelJoined = false;
+    TokenGenerateParams tokenParams;
+    tokenParams.appId = context.params.appId;
+    tokenParams.appCertificate = context.params.appCertificate;
+    tokenParams.channelName = context.params.channelId;
+    tokenParams.userId = context.params.userId;
+    tokenParams.expire = 24 * 60 * 60;  // 24 hours
+    tokenParams.type = 1;               // RTC Token
+    tokenParams.src = "Windows";
+
+    // Sent by the HTTP client's workers and awaited here, so a leave that
+    // cancels the join wakes this step at once instead of waiting out the request
+    struct TokenResult {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool done = false;
+        bool cancelled = false;
+        bool success = false;
+        std::string token;
+        std::string errorMsg;
+    };
+    auto result = std::make_shared<TokenResult>();
+
+    CTokenManager tokenManager;
+    tokenManager.GenerateTokenAsync(tokenParams, [result](const std::string& token, bool success, const std::string& errorMsg) {
+        std::lock_guard<std::mutex> lock(result->mutex);
+        result->done = true;
+        result->success = success;
+        result->token = token;
+        result->errorMsg = errorMsg;
+        result->cv.notify_all();
+    });
+
+    RteCancellationToken cancel = context.manager->GetCancellationToken();
+    int listener = cancel.Register([result]() {
+        std::lock_guard<std::mutex> lock(result->mutex);
+        result->cancelled = true;
+        result->cv.notify_all();
+    });
+    std::unique_lock<std::mutex> lock(result->mutex);
+    result->cv.wait(lock, [&result]() { return result->done || result->cancelled; });
+    cancel.Unregister(listener);
+
+    if (!result->done) {
+        LOG_INFO("Token request abandoned, join cancelled");
+        return false;
     }
+    if (!result->success || result->token.empty()) {
+        LOG_ERROR_FMT("Token generation failed: {}", result->errorMsg);
+        return false;
+    }
+
+    LOG_INFO_FMT("Token generated: {}", result->token.substr(0, 20));
+    context.params.token = result->token;
+    return true;
 }
 
 
@@ -617,19 +1132,26 @@ void CChannelPageDlg::LeaveRteChannel()
 // Video Window & Layout Management
 //===========================================================================
 
-void CChannelPageDlg::CreateVideoWindows()
+// Grow or shrink the cell pool to `count`, keeping the existing cells
+void CChannelPageDlg::EnsureVideoWindows(int count)
 {
-    DestroyVideoWindows();
+    while (m_videoWindows.GetSize() > count)
+    {
+        INT_PTR last = m_videoWindows.GetSize() - 1;
+        if (m_videoWindows[last] && ::IsWindow(m_videoWindows[last]->GetSafeHwnd()))
+        {
+            m_videoWindows[last]->DestroyWindow();
+        }
+        delete m_videoWindows[last];
+        m_videoWindows.RemoveAt(last);
+    }
 
-    int gridSize = GetGridSize(m_pageState.currentGridMode);
-    int maxWindows = gridSize * gridSize;
-    
-    for (int i = 0; i < maxWindows; i++)
+    for (int i = static_cast<int>(m_videoWindows.GetSize()); i < count; i++)
     {
         CVideoGridCell* pVideoWnd = new CVideoGridCell();
         BOOL bResult = pVideoWnd->Create(NULL, _T(""), 
             WS_CHILD | WS_VISIBLE | WS_BORDER | WS_CLIPCHILDREN,
-            CRect(0,0,0,0), this, static_cast<UINT>(IDC_VIDEO_WINDOW_BASE + i));
+            CRect(0,0,0,0), &m_staticVideoContainer, static_cast<UINT>(IDC_VIDEO_WINDOW_BASE + i));
 
         if (bResult)
         {
@@ -641,8 +1163,12 @@ void CChannelPageDlg::CreateVideoWindows()
         else
         {
             delete pVideoWnd;
+            break;
         }
     }
+
+    m_cellItems.resize(m_videoWindows.GetSize(), -1);
+    m_cellBoundUsers.resize(m_videoWindows.GetSize(), kInvalidUserHandle);
 }
 
 void CChannelPageDlg::DestroyVideoWindows()
@@ -656,112 +1182,613 @@ void CChannelPageDlg::DestroyVideoWindows()
         delete m_videoWindows[i];
     }
     m_videoWindows.RemoveAll();
+    m_cellItems.clear();
+    m_cellBoundUsers.clear();
+    m_layout = Layout();
 }
 
-void CChannelPageDlg::UpdateGridLayout()
+// Recompute the tile rects of one viewport and the wall geometry derived from
+// them. Cells keep their users; only their positions change.
+// Returns true when the tile count, and with it the users per page, changed.
+bool CChannelPageDlg::UpdateGridLayout()
 {
-    if (m_staticVideoContainer.GetSafeHwnd() && m_videoWindows.GetSize() > 0)
+    if (!m_staticVideoContainer.GetSafeHwnd())
     {
-        CRect containerRect;
-        m_staticVideoContainer.GetWindowRect(&containerRect);
-        ScreenToClient(&containerRect);
-        
-        CArray<CRect> windowRects;
-        CalculateGridLayout(m_pageState.currentGridMode, containerRect, windowRects);
-        
-        for (int i = 0; i < m_videoWindows.GetSize(); i++)
-        {
-            if (i < windowRects.GetSize())
-            {
-                m_videoWindows[i]->SetWindowPos(NULL, 
-                    windowRects[i].left, windowRects[i].top,
-                    windowRects[i].Width(), windowRects[i].Height(),
-                    SWP_NOZORDER | SWP_NOACTIVATE);
-                m_videoWindows[i]->ShowWindow(SW_SHOW);
-            }
-            else
-            {
-                m_videoWindows[i]->ShowWindow(SW_HIDE);
+        return false;
+    }
+
+    CRect clientRect;
+    m_staticVideoContainer.GetClientRect(&clientRect);
+    LayoutRect container(0, 0, clientRect.Width(), clientRect.Height());
+
+    Layout layout = LayoutEngine::Compute(GetLayoutSpec(), container);
+    std::vector<LayoutChange> changes = LayoutEngine::Diff(m_layout, layout);
+    int tileCount = static_cast<int>(layout.tiles.size());
+    bool tileCountChanged = (tileCount != static_cast<int>(m_layout.tiles.size()));
+
+    if (!changes.empty())
+    {
+        // Grids scroll by row; stage layouts (large tiles) scroll a whole layout at a time
+        std::vector<LayoutRect> bandTiles;
+        int bandHeight = 0;
+        VirtualWall::BandFromLayout(layout, container, bandTiles, bandHeight);
+        int overscanBands = (bandHeight >= container.Height()) ? 0 : kWallOverscanBands;
+        m_wall.SetGeometry(bandTiles, bandHeight, container.Height(), overscanBands);
+        m_wall.SetSettlePolicy(kWallLiveViewportsPerSecond * container.Height(), kWallSettleMs);
+        EnsureVideoWindows(m_wall.GetCellCapacity());
+
+        LOG_CAT_FMT(LogCategory::Layout, LogLevel::Info, "Layout updated: {} tiles ({}x{}), {} changed",
+            tileCount, layout.columns, layout.rows, changes.size());
+        LOG_CAT_FMT(LogCategory::Layout, LogLevel::Info, "Wall geometry: {} tiles per band, band height {}, {} cells",
+            bandTiles.size(), bandHeight, m_videoWindows.GetSize());
+    }
+
+    m_layout = layout;
+    m_pageState.usersPerPage = (std::max)(tileCount, 1);
+    m_wall.SetItemCount(m_pageState.users.GetSize());
+    if (!changes.empty())
+    {
+        PositionVideoWindows();
+    }
+    UpdateWallScrollBar();
+    return tileCountChanged;
+}
+
+LayoutSpec CChannelPageDlg::GetLayoutSpec() const
+{
+    int presetIndex = (std::max)(0, (std::min)(m_pageState.currentLayout, kLayoutPresetCount - 1));
+    const LayoutPreset& preset = kLayoutPresets[presetIndex];
+
+    switch (preset.mode) {
+        case LayoutMode::Auto:
+            return LayoutSpec::Auto((std::max)(1, (std::min)(m_pageState.users.GetSize(), kAutoLayoutMaxTiles)));
+        case LayoutMode::SpeakerFilmstrip:
+            return LayoutSpec::SpeakerFilmstrip(1 + preset.columns);
+        case LayoutMode::Grid:
+        default: {
+            LayoutSpec spec = LayoutSpec::Grid(preset.columns, preset.rows);
+            if (preset.pinnedTile >= 0) {
+                spec.pinnedTiles.push_back(preset.pinnedTile);
             }
+            return spec;
         }
     }
 }
 
-void CChannelPageDlg::UpdateVideoLayout()
+// Hand cells to the rows in the wall's live range and refresh the cells whose
+// row changed. With resetCells every cell is refreshed (rows were inserted or removed).
+void CChannelPageDlg::UpdateVideoLayout(bool resetCells)
 {
-    int startUserIndex = (m_pageState.currentPage - 1) * m_pageState.usersPerPage;
-    int userCount = (int)m_pageState.userList.GetSize();
-    int windowCount = (int)m_videoWindows.GetSize();
+    ChannelUserTable& users = m_pageState.users;
+    int userCount = users.GetSize();
+    m_wall.SetItemCount(userCount);
+
+    std::vector<int> rebound;
+    m_wall.AssignCells(m_cellItems, rebound, resetCells);
+
+    // Visibility follows the viewport, not the overscan
+    std::vector<int> previouslyVisible;
+    users.Select(UserFlag(kUserVisible), 0, 0, userCount, previouslyVisible);
+    for (int row : previouslyVisible) {
+        users.Set(row, kUserVisible, false);
+    }
+    WallRange visible = m_wall.GetVisibleRange();
+    int currentPage = GetCurrentPage();
+    for (int row = visible.first; row < visible.end; row++) {
+        users.Set(row, kUserVisible, true);
+        users.SetLastVisiblePage(row, currentPage);
+    }
+    // Labels of this page and its neighbours; the rest of the audience stays ids and flags
+    m_rosterCache.Prefetch(users, m_pageState.usersPerPage, currentPage - 1, 1);
 
-    for (int i = 0; i < windowCount; i++)
+    for (int cell : rebound)
     {
-        CVideoGridCell* pVideoWnd = m_videoWindows[i];
+        CVideoGridCell* pVideoWnd = m_videoWindows[cell];
         if (!pVideoWnd) continue;
 
-        int userIndex = startUserIndex + i;
-        if (userIndex < userCount)
+        int userIndex = m_cellItems[cell];
+        if (userIndex >= 0)
         {
-            ChannelUser* userInfo = m_pageState.userList[userIndex];
-            if (pVideoWnd && userInfo) {
-                pVideoWnd->SetUserInfo(CString(userInfo->userId.c_str()), CString(userInfo->userId.c_str()), userInfo->isConnected);
-            }
-            pVideoWnd->SetVideoSubscription(userInfo->isVideoSubscribed);
-            pVideoWnd->SetAudioSubscription(userInfo->isAudioSubscribed);
-            pVideoWnd->ShowWindow(SW_SHOW);
+            const RosterEntry& entry = m_rosterCache.Get(users, userIndex);
+            CString displayName(entry.displayName.c_str());
+            pVideoWnd->SetUserInfo(displayName, displayName, entry.connected);
+            pVideoWnd->SetVideoSubscription(users.Test(userIndex, kUserVideoSubscribed));
+            pVideoWnd->SetAudioSubscription(users.Test(userIndex, kUserAudioSubscribed));
         }
         else
         {
             pVideoWnd->SetUserInfo(_T(""), _T(""), false);
-            pVideoWnd->ShowWindow(SW_HIDE);
         }
     }
+
+    PositionVideoWindows();
+    UpdateWallScrollBar();
 }
 
-void CChannelPageDlg::SetGridMode(int gridMode)
+// Move every live cell to its row's rect at the current offset, hide free cells
+void CChannelPageDlg::PositionVideoWindows()
 {
-    if (gridMode != m_pageState.currentGridMode)
+    int cellCount = static_cast<int>(m_videoWindows.GetSize());
+    HDWP hdwp = ::BeginDeferWindowPos(cellCount);
+    for (int cell = 0; cell < cellCount && hdwp; cell++)
     {
-        m_pageState.currentGridMode = gridMode;
-        m_pageState.currentPage = 1;
-        
-        CreateVideoWindows();
+        HWND hwnd = m_videoWindows[cell]->GetSafeHwnd();
+        int userIndex = m_cellItems[cell];
+        if (userIndex >= 0)
+        {
+            LayoutRect rect = m_wall.GetItemRect(userIndex);
+            hdwp = ::DeferWindowPos(hdwp, hwnd, NULL, rect.left, rect.top, rect.Width(), rect.Height(),
+                SWP_NOZORDER | SWP_NOACTIVATE | SWP_SHOWWINDOW);
+        }
+        else
+        {
+            hdwp = ::DeferWindowPos(hdwp, hwnd, NULL, 0, 0, 0, 0,
+                SWP_NOZORDER | SWP_NOACTIVATE | SWP_NOMOVE | SWP_NOSIZE | SWP_HIDEWINDOW);
+        }
+    }
+    if (hdwp)
+    {
+        ::EndDeferWindowPos(hdwp);
+    }
+}
+
+//===========================================================================
+// Scrolling Wall
+//===========================================================================
+
+void CChannelPageDlg::ScrollWall(int offset)
+{
+    if (m_overviewActive || !m_wall.ScrollTo(offset, static_cast<int64_t>(::GetTickCount64())))
+    {
+        return;
+    }
+    if (m_reconnectSnapshot.valid) {
+        m_reconnectSnapshot.scrollOffset = m_wall.GetOffset();
+    }
+
+    // Only cells whose row scrolled out are rebound
+    UpdateVideoLayout(false);
+    UpdatePageDisplay();
+    UpdateWallSubscriptions();
+}
+
+void CChannelPageDlg::UpdateWallScrollBar()
+{
+    if (!m_scrollVideoWall.GetSafeHwnd())
+    {
+        return;
+    }
+
+    SCROLLINFO info = { sizeof(SCROLLINFO) };
+    info.fMask = SIF_RANGE | SIF_PAGE | SIF_POS | SIF_DISABLENOSCROLL;
+    info.nMin = 0;
+    info.nMax = (std::max)(m_wall.GetContentHeight() - 1, 0);
+    info.nPage = static_cast<UINT>(m_wall.GetViewportHeight());
+    info.nPos = m_wall.GetOffset();
+    m_scrollVideoWall.SetScrollInfo(&info);
+}
+
+// Subscriptions follow the live range once scrolling settles. During a fling
+// recycled cells only lose their old video, the new rows show their name tile.
+void CChannelPageDlg::UpdateWallSubscriptions()
+{
+    if (m_reconnectSnapshot.valid)
+    {
+        return;
+    }
+
+    if (!m_wall.IsSettled(static_cast<int64_t>(::GetTickCount64())))
+    {
+        DetachRecycledViews();
+        if (!m_wallUpdatePending)
+        {
+            m_wallUpdatePending = true;
+            SetTimer(kWallSettleTimerId, kWallSettlePollMs, NULL);
+        }
+        return;
+    }
+
+    if (m_wallUpdatePending)
+    {
+        m_wallUpdatePending = false;
+        KillTimer(kWallSettleTimerId);
+    }
+    if (m_wall.GetLiveRange() != m_boundRange)
+    {
+        UpdateSubscribedUsers();
+        UpdateViewUserBindings();
+    }
+}
+
+// Drop the bindings of cells that now show a different user, keep the rest
+void CChannelPageDlg::DetachRecycledViews()
+{
+    if (!m_rteManager || m_overviewActive) return;
+
+    std::vector<RteViewBinding> bindings;
+    WallRange visible = m_wall.GetVisibleRange();
+    bool detached = false;
+    for (int cell = 0; cell < static_cast<int>(m_cellBoundUsers.size()); cell++)
+    {
+        UserHandle bound = m_cellBoundUsers[cell];
+        if (bound == kInvalidUserHandle) continue;
+
+        int userIndex = m_cellItems[cell];
+        if (userIndex < 0 || m_pageState.users.GetUser(userIndex) != bound)
+        {
+            m_cellBoundUsers[cell] = kInvalidUserHandle;
+            detached = true;
+            continue;
+        }
+
+        RteViewBinding binding;
+        binding.view = m_videoWindows[cell]->GetSafeHwnd();
+        binding.user = bound;
+        binding.visible = visible.Contains(userIndex);
+        bindings.push_back(binding);
+    }
+
+    if (detached)
+    {
+        m_rteManager->SetViewUserBindings(bindings);
+        m_boundRange = WallRange();     // Rebind on settle even if the range comes back
+    }
+}
+
+void CChannelPageDlg::TakeReconnectSnapshot()
+{
+    m_reconnectSnapshot.valid = true;
+    m_reconnectSnapshot.layoutPreset = m_pageState.currentLayout;
+    m_reconnectSnapshot.scrollOffset = m_wall.GetOffset();
+    m_reconnectSnapshot.lostAt = std::chrono::steady_clock::now();
+    m_reconnectSnapshot.subscriptions.clear();
+
+    const ChannelUserTable& users = m_pageState.users;
+    std::vector<int> rows;
+    users.Select(UserFlag(kUserConnected), UserFlag(kUserLocal), 0, users.GetSize(), rows);
+    for (int row : rows) {
+        m_reconnectSnapshot.subscriptions[users.GetUser(row)] =
+            std::make_pair(users.Test(row, kUserVideoSubscribed), users.Test(row, kUserAudioSubscribed));
+    }
+
+    LOG_INFO_FMT("Reconnect snapshot taken: layout={}, offset={}, {} subscriptions",
+        m_reconnectSnapshot.layoutPreset, m_reconnectSnapshot.scrollOffset, m_reconnectSnapshot.subscriptions.size());
+}
+
+void CChannelPageDlg::RestoreReconnectSnapshot()
+{
+    if (m_reconnectSnapshot.valid) {
+        // Subscription flags may have been reset by join/leave events during the outage
+        ChannelUserTable& users = m_pageState.users;
+        for (int row = 0; row < users.GetSize(); row++) {
+            if (users.Test(row, kUserLocal)) continue;
+
+            auto it = m_reconnectSnapshot.subscriptions.find(users.GetUser(row));
+            if (it != m_reconnectSnapshot.subscriptions.end()) {
+                users.Set(row, kUserVideoSubscribed, it->second.first);
+                users.Set(row, kUserAudioSubscribed, it->second.second);
+            }
+        }
+
+        if (m_reconnectSnapshot.layoutPreset != m_pageState.currentLayout) {
+            m_pageState.currentLayout = m_reconnectSnapshot.layoutPreset;
+            m_comboGridMode.SetCurSel(m_pageState.currentLayout);
+        }
         UpdateGridLayout();
-        UpdateVideoLayout();
-        UpdatePageDisplay();
+        m_wall.SetItemCount(m_pageState.users.GetSize());
+        m_wall.ScrollTo(m_reconnectSnapshot.scrollOffset, static_cast<int64_t>(::GetTickCount64()));
+        m_reconnectSnapshot = ReconnectSnapshot();
+    }
+
+    // One pass over the live range instead of one per replayed user event
+    UpdateVideoLayout();
+    UpdatePageDisplay();
+    UpdateSubscribedUsers();
+    UpdateViewUserBindings();
+}
+
+void CChannelPageDlg::SetLayoutPreset(int preset)
+{
+    if (preset == m_pageState.currentLayout || preset < 0 || preset >= kLayoutPresetCount)
+    {
+        return;
+    }
+
+    // Keep the first visible user at the top of the new layout
+    int anchorRow = m_wall.GetVisibleRange().first;
+    m_pageState.currentLayout = preset;
+    if (m_reconnectSnapshot.valid) {
+        m_reconnectSnapshot.layoutPreset = preset;
+    }
+
+    if (kLayoutPresets[preset].overview)
+    {
+        EnterOverview();
+        return;
+    }
+    if (m_overviewActive)
+    {
+        LeaveOverview();
+        m_subscribedUsers.clear();
+    }
+
+    bool tileCountChanged = UpdateGridLayout();
+    if (m_wall.GetItemsPerBand() > 0) {
+        m_wall.ScrollTo(anchorRow / m_wall.GetItemsPerBand() * m_wall.GetBandHeight(),
+            static_cast<int64_t>(::GetTickCount64()));
+    }
+    if (m_reconnectSnapshot.valid) {
+        m_reconnectSnapshot.scrollOffset = m_wall.GetOffset();
+    }
+
+    // Rows that stay live keep their cells; bindings only change with the live range
+    UpdateVideoLayout(false);
+    UpdatePageDisplay();
+    if (!m_reconnectSnapshot.valid && (tileCountChanged || m_wall.GetLiveRange() != m_boundRange))
+    {
         UpdateSubscribedUsers();
         UpdateViewUserBindings();
     }
 }
 
-int CChannelPageDlg::GetGridSize(int gridMode)
+
+//===========================================================================
+// Render Frame Rates
+//===========================================================================
+
+// Stage and pinned tiles render at the focus rate, the other visible tiles at
+// the rate of the grid density, overscan tiles at the minimum
+void CChannelPageDlg::UpdateRenderTargets()
 {
-    return gridMode;
+    int cellCount = static_cast<int>(m_cellBoundUsers.size());
+    m_cellTargetFps.assign(cellCount, 0);
+
+    WallRange visible = m_wall.GetVisibleRange();
+    int itemsPerBand = (std::max)(m_wall.GetItemsPerBand(), 1);
+    std::vector<RenderFpsTile> tiles;
+    std::vector<int> tileCells;
+    for (int cell = 0; cell < cellCount; cell++)
+    {
+        int item = m_cellItems[cell];
+        if (m_cellBoundUsers[cell] == kInvalidUserHandle || item < 0) continue;
+
+        // Every band repeats the tiles of the first one
+        int tile = item % itemsPerBand;
+        RenderFpsTile entry;
+        entry.user = m_cellBoundUsers[cell];
+        entry.visible = visible.Contains(item);
+        entry.focused = tile < static_cast<int>(m_layout.tiles.size()) && m_layout.tiles[tile].large;
+        tiles.push_back(entry);
+        tileCells.push_back(cell);
+    }
+
+    std::vector<int> targets;
+    int total = RenderFpsPolicy::Compute(m_renderFpsConfig, static_cast<int>(m_layout.tiles.size()), tiles, targets);
+    for (size_t i = 0; i < tiles.size(); i++)
+    {
+        m_cellTargetFps[tileCells[i]] = targets[i];
+    }
+    LOG_CAT_FMT(LogCategory::Layout, LogLevel::Info, "Render targets: {} tiles, {} fps in total, budget {} fps",
+        tiles.size(), total, m_renderFpsConfig.budgetFps);
+
+    if (!tiles.empty() && !m_renderProbeRunning)
+    {
+        m_renderProbeRunning = true;
+        m_probeCell = -1;
+        SetTimer(kRenderProbeTimerId, kRenderProbeSampleMs, NULL);
+    }
 }
 
-void CChannelPageDlg::CalculateGridLayout(int gridMode, CRect containerRect, CArray<CRect>& windowRects)
+// Sample one cell for kRenderProbeWindowMs, log its achieved rate against its
+// target, then move on to the next bound cell. Stops when no cell is bound.
+void CChannelPageDlg::SampleRenderProbe()
 {
-    windowRects.RemoveAll();
-    
-    int gridSize = GetGridSize(gridMode);
-    if (gridSize <= 0) return;
+    int64_t now = static_cast<int64_t>(::GetTickCount64());
+    int cellCount = static_cast<int>((std::min)(m_cellTargetFps.size(), static_cast<size_t>(m_videoWindows.GetSize())));
+    bool probing = m_probeCell >= 0 && m_probeCell < cellCount && m_cellTargetFps[m_probeCell] > 0;
+    if (m_videoPaused || m_overviewActive)
+    {
+        m_probeCell = -1;   // Restart the window once video shows again
+        return;
+    }
+
+    if (probing && now - m_probeStartMs < kRenderProbeWindowMs)
+    {
+        uint32_t checksum = 0;
+        if (SampleWindowPatch(m_videoWindows[m_probeCell]->GetSafeHwnd(), checksum))
+        {
+            m_probeCounter.AddSample(checksum, now);
+        }
+        return;
+    }
 
-    int windowWidth = containerRect.Width() / gridSize;
-    int windowHeight = containerRect.Height() / gridSize;
+    if (probing && m_probeCounter.GetSamples() > 0)
+    {
+        LOG_CAT_LIMITED_FMT(LogCategory::Layout, LogLevel::Info, "Render rate of {}: {} fps measured, target {} fps, {} samples",
+            LogUser(m_cellBoundUsers[m_probeCell]),
+            static_cast<int>(m_probeCounter.GetFps(now) + 0.5), m_cellTargetFps[m_probeCell], m_probeCounter.GetSamples());
+    }
 
-    for (int row = 0; row < gridSize; row++)
+    int next = -1;
+    for (int step = 1; step <= cellCount && next < 0; step++)
     {
-        for (int col = 0; col < gridSize; col++)
+        int cell = (m_probeCell + step + cellCount) % cellCount;
+        if (m_cellTargetFps[cell] > 0 && m_videoWindows[cell]->IsWindowVisible())
         {
-            CRect windowRect;
-            windowRect.left = containerRect.left + col * windowWidth;
-            windowRect.top = containerRect.top + row * windowHeight;
-            windowRect.right = windowRect.left + windowWidth - 2; // -2 for border
-            windowRect.bottom = windowRect.top + windowHeight - 2; // -2 for border
-            windowRects.Add(windowRect);
+            next = cell;
         }
     }
+    if (next < 0)
+    {
+        KillTimer(kRenderProbeTimerId);
+        m_renderProbeRunning = false;
+        m_probeCell = -1;
+        return;
+    }
+    m_probeCell = next;
+    m_probeStartMs = now;
+    m_probeCounter.Reset(now);
+}
+
+
+//===========================================================================
+// Visibility
+//===========================================================================
+
+// Bindings and subscriptions stay as they are while paused; only the manager's
+// canvases are released, so resuming is one batch and needs no relayout
+void CChannelPageDlg::UpdateVideoPause()
+{
+    if (!GetSafeHwnd())
+    {
+        return;
+    }
+
+    int64_t now = static_cast<int64_t>(::GetTickCount64());
+    bool minimized = IsIconic() || !IsWindowVisible();
+    bool occluded = !minimized && IsWindowOccluded(GetSafeHwnd());
+    if (!occluded)
+    {
+        m_occludedSinceMs = -1;
+    }
+    else if (m_occludedSinceMs < 0)
+    {
+        m_occludedSinceMs = now;
+    }
+
+    bool pause = minimized || (occluded && now - m_occludedSinceMs >= kOcclusionPauseDelayMs);
+    if (pause == m_videoPaused)
+    {
+        return;
+    }
+    m_videoPaused = pause;
+    LOG_INFO_FMT("Remote video {}: window {}", pause ? "paused" : "resumed",
+        minimized ? "minimized" : (occluded ? "occluded" : "visible"));
+
+    if (m_rteManager)
+    {
+        m_rteManager->SetRemoteVideoPaused(pause);
+    }
+}
+
+
+//===========================================================================
+// Overview Mosaic
+//===========================================================================
+
+// The wall gives up its cells and canvases; the mosaic's capture slots take
+// turns subscribing users (one canvas per user, so the two cannot overlap)
+void CChannelPageDlg::EnterOverview()
+{
+    if (m_overviewActive)
+    {
+        return;
+    }
+
+    if (m_wallUpdatePending)
+    {
+        m_wallUpdatePending = false;
+        KillTimer(kWallSettleTimerId);
+    }
+    if (m_rteManager)
+    {
+        m_rteManager->SetViewUserBindings(std::vector<RteViewBinding>());
+    }
+    std::fill(m_cellBoundUsers.begin(), m_cellBoundUsers.end(), kInvalidUserHandle);
+    m_boundRange = WallRange();
+    m_overviewActive = true;
+
+    m_staticVideoContainer.ShowWindow(SW_HIDE);
+    m_scrollVideoWall.ShowWindow(SW_HIDE);
+    m_btnPrevPage.EnableWindow(FALSE);
+    m_btnNextPage.EnableWindow(FALSE);
+
+    m_overviewMosaic.SetSlotCount(m_thumbnailScheduler.GetConfig().slotCount);
+    UpdateOverviewUsers();
+    m_overviewMosaic.ShowWindow(SW_SHOW);
+    SetTimer(kThumbnailTimerId, kThumbnailTickMs, NULL);
+
+    LOG_INFO_FMT("Overview mosaic entered: {} slots, at most {} subscribes per second",
+        m_thumbnailScheduler.GetConfig().slotCount, m_thumbnailScheduler.GetConfig().maxStartsPerSecond);
+}
+
+void CChannelPageDlg::LeaveOverview()
+{
+    if (!m_overviewActive)
+    {
+        return;
+    }
+
+    KillTimer(kThumbnailTimerId);
+    std::vector<ThumbnailAction> actions;
+    m_thumbnailScheduler.StopAll(actions);
+    RunThumbnailActions(actions);
+    m_overviewActive = false;
+
+    m_overviewMosaic.ShowWindow(SW_HIDE);
+    m_staticVideoContainer.ShowWindow(SW_SHOW);
+    m_scrollVideoWall.ShowWindow(SW_SHOW);
+
+    ThumbnailSchedulerStats stats = m_thumbnailScheduler.GetStats();
+    LOG_INFO_FMT("Overview mosaic left: {} subscribes, {} captures, {} timeouts, mean refresh age {} ms",
+        stats.starts, stats.captures, stats.timeouts, static_cast<int64_t>(stats.meanRefreshAgeMs));
+}
+
+// Connected remote users, in roster order
+void CChannelPageDlg::UpdateOverviewUsers()
+{
+    const ChannelUserTable& users = m_pageState.users;
+    std::vector<int> rows;
+    users.Select(UserFlag(kUserConnected), UserFlag(kUserLocal), 0, users.GetSize(), rows);
+
+    std::vector<UserHandle> handles;
+    handles.reserve(rows.size());
+    for (int row : rows) {
+        handles.push_back(users.GetUser(row));
+    }
+    m_thumbnailScheduler.SetUsers(handles);
+    m_overviewMosaic.SetUsers(handles);
+}
+
+void CChannelPageDlg::RefreshThumbnails()
+{
+    // Slots stay idle until joined, while reconnecting and while paused
+    if (!m_overviewActive || !m_rteManager || m_reconnectSnapshot.valid || m_videoPaused)
+    {
+        return;
+    }
 
-    m_pageState.usersPerPage = gridSize * gridSize;
+    std::vector<ThumbnailAction> actions;
+    m_thumbnailScheduler.Tick(static_cast<int64_t>(::GetTickCount64()), actions);
+    RunThumbnailActions(actions);
+}
+
+void CChannelPageDlg::RunThumbnailActions(const std::vector<ThumbnailAction>& actions)
+{
+    int64_t now = static_cast<int64_t>(::GetTickCount64());
+    for (const ThumbnailAction& action : actions)
+    {
+        switch (action.type)
+        {
+        case ThumbnailActionType::Start:
+            m_overviewMosaic.SetSlotUser(action.slot, action.user);
+            if (m_rteManager) {
+                m_rteManager->SetupRemoteVideo(action.user, m_overviewMosaic.GetSlotView(action.slot));
+            }
+            break;
+        case ThumbnailActionType::Grab:
+            if (m_overviewMosaic.CaptureSlot(action.slot, action.user, now)) {
+                m_thumbnailScheduler.OnFrameCaptured(action.user, now);
+            }
+            break;
+        case ThumbnailActionType::Stop:
+            m_overviewMosaic.SetSlotUser(action.slot, kInvalidUserHandle);
+            if (m_rteManager) {
+                m_rteManager->SetupRemoteVideo(action.user, nullptr);
+            }
+            break;
+        }
+    }
 }
 
 
@@ -769,37 +1796,84 @@ void CChannelPageDlg::CalculateGridLayout(int gridMode, CRect containerRect, CAr
 // User & Page Management
 //===========================================================================
 
-int CChannelPageDlg::FindUserIndex(LPCTSTR uid)
+int CChannelPageDlg::FindUserIndex(UserHandle user)
 {
-    for (int i = 0; i < m_pageState.userList.GetSize(); i++)
+    if (user == kInvalidUserHandle) return -1;
+
+    return m_pageState.users.Find(user);
+}
+
+// Bring every user of `roster` online the way OnRteUserJoined does for one:
+// a real user's placeholder is reconnected, anyone else gets a new row. One
+// pass over the table instead of a Find per user. Returns the users changed.
+int CChannelPageDlg::MergeRemoteUsers(const std::vector<UserHandle>& roster)
+{
+    ChannelUserTable& users = m_pageState.users;
+    std::unordered_map<UserHandle, int> rows;
+    rows.reserve(users.GetSize() + roster.size());
+    for (int row = 0; row < users.GetSize(); row++)
     {
-        if (m_pageState.userList[i]->GetUserId() == std::string(CT2A(uid)))
+        if (users.GetUser(row) != kInvalidUserHandle) rows.emplace(users.GetUser(row), row);
+    }
+    users.Reserve(users.GetSize() + static_cast<int>(roster.size()));
+
+    int64_t now = static_cast<int64_t>(::GetTickCount64());
+    int changed = 0;
+    for (UserHandle user : roster)
+    {
+        m_thumbnailScheduler.MarkActive(user, now);
+        auto it = rows.find(user);
+        if (it == rows.end())
+        {
+            bool isRobot = (atoi(UserIdString(user).c_str()) >= 1000);
+            int row = users.Add(user, kNewRemoteUserFlags | (isRobot ? UserFlag(kUserRobot) : 0));
+            rows.emplace(user, row);
+            changed++;
+        }
+        else if (!users.Test(it->second, kUserConnected))
         {
-            return i;
+            users.SetFlags(it->second, kNewRemoteUserFlags | (users.GetFlags(it->second) & UserFlag(kUserVisible)));
+            changed++;
         }
     }
-    return -1;
+    return changed;
 }
 
 
 
+int CChannelPageDlg::GetCellUserIndex(int cellIndex) const
+{
+    if (cellIndex < 0 || cellIndex >= static_cast<int>(m_cellItems.size())) return -1;
+    return m_cellItems[cellIndex];
+}
+
 void CChannelPageDlg::UpdatePageDisplay()
 {
     int maxPages = GetMaxPages();
     CString strPageInfo;
-    strPageInfo.Format(_T("%d / %d"), m_pageState.currentPage, maxPages);
+    strPageInfo.Format(_T("%d / %d"), GetCurrentPage(), maxPages);
     m_staticCurrentPage.SetWindowText(strPageInfo);
 
-    m_btnPrevPage.EnableWindow(m_pageState.currentPage > 1);
-    m_btnNextPage.EnableWindow(m_pageState.currentPage < maxPages);
+    m_btnPrevPage.EnableWindow(!m_overviewActive && m_wall.GetOffset() > 0);
+    m_btnNextPage.EnableWindow(!m_overviewActive && m_wall.GetOffset() < m_wall.GetMaxOffset());
+}
+
+// Page of the viewport top; a page is one viewport of the wall
+int CChannelPageDlg::GetCurrentPage()
+{
+    int maxPages = GetMaxPages();
+    if (m_wall.GetViewportHeight() <= 0) return 1;
+    if (m_wall.GetOffset() > 0 && m_wall.GetOffset() >= m_wall.GetMaxOffset()) return maxPages;
+
+    return (std::min)(m_wall.GetOffset() / m_wall.GetViewportHeight() + 1, maxPages);
 }
 
 int CChannelPageDlg::GetMaxPages()
 {
     if (m_pageState.usersPerPage <= 0) return 1;
-    if (m_pageState.userList.GetSize() == 0) return 1;
+    if (m_pageState.users.GetSize() == 0) return 1;
     
-    size_t totalUsers = m_pageState.userList.GetSize();
+    size_t totalUsers = m_pageState.users.GetSize();
     size_t usersPerPage = static_cast<size_t>(m_pageState.usersPerPage);
     return static_cast<int>((totalUsers + usersPerPage - 1) / usersPerPage);
 }
@@ -827,16 +1901,19 @@ void CChannelPageDlg::OnVideoCellAudioSubscriptionChangedCallback(CWnd* pParent,
 
 void CChannelPageDlg::OnVideoCellVideoSubscriptionChanged(int cellIndex, BOOL isVideoSubscribed)
 {
-    int userIndex = (m_pageState.currentPage - 1) * m_pageState.usersPerPage + cellIndex;
-    if (userIndex >= 0 && userIndex < m_pageState.userList.GetSize()) {
-        ChannelUser* user = m_pageState.userList[userIndex];
-        if (user && !user->isLocal) {
-            user->isVideoSubscribed = isVideoSubscribed;
+    int userIndex = GetCellUserIndex(cellIndex);
+    ChannelUserTable& users = m_pageState.users;
+    if (userIndex >= 0 && userIndex < users.GetSize()) {
+        if (!users.Test(userIndex, kUserLocal)) {
+            users.Set(userIndex, kUserVideoSubscribed, isVideoSubscribed != FALSE);
+            if (m_reconnectSnapshot.valid) {
+                m_reconnectSnapshot.subscriptions[users.GetUser(userIndex)].first = (isVideoSubscribed != FALSE);
+            }
             if (m_rteManager) {
                 // SubscribeRemoteVideo and UnsubscribeRemoteVideo methods are not implemented in RteManager.
                 // The video subscription logic needs to be updated based on the new RTE SDK API.
                 // For now, we'll just log it.
-                LOG_INFO_FMT("Video subscription for user {} set to {}", user->GetUserId(), isVideoSubscribed);
+                LOG_INFO_LIMITED_FMT("Video subscription for user {} set to {}", LogUser(users.GetUser(userIndex)), isVideoSubscribed);
             }
 
             // 更新UI显示状态
@@ -844,24 +1921,28 @@ void CChannelPageDlg::OnVideoCellVideoSubscriptionChanged(int cellIndex, BOOL is
                 m_videoWindows[cellIndex]->SetVideoSubscription(isVideoSubscribed);
             }
 
-            // 同步订阅用户列表
+            // 同步订阅用户列表和视频窗口绑定
             UpdateSubscribedUsers();
+            UpdateViewUserBindings();
         }
     }
 }
 
 void CChannelPageDlg::OnVideoCellAudioSubscriptionChanged(int cellIndex, BOOL isAudioSubscribed)
 {
-    int userIndex = (m_pageState.currentPage - 1) * m_pageState.usersPerPage + cellIndex;
-    if (userIndex >= 0 && userIndex < m_pageState.userList.GetSize()) {
-        ChannelUser* user = m_pageState.userList[userIndex];
-        if (user && !user->isLocal) {
-            user->isAudioSubscribed = isAudioSubscribed;
+    int userIndex = GetCellUserIndex(cellIndex);
+    ChannelUserTable& users = m_pageState.users;
+    if (userIndex >= 0 && userIndex < users.GetSize()) {
+        if (!users.Test(userIndex, kUserLocal)) {
+            users.Set(userIndex, kUserAudioSubscribed, isAudioSubscribed != FALSE);
+            if (m_reconnectSnapshot.valid) {
+                m_reconnectSnapshot.subscriptions[users.GetUser(userIndex)].second = (isAudioSubscribed != FALSE);
+            }
             if (m_rteManager) {
                 // SubscribeRemoteAudio and UnsubscribeRemoteAudio were removed or renamed.
                 // The logic for audio subscription needs to be updated based on the new RteManager API.
                 // For now, we'll just log it.
-                LOG_INFO_FMT("Audio subscription for user {} set to {}", user->GetUserId(), isAudioSubscribed);
+                LOG_INFO_LIMITED_FMT("Audio subscription for user {} set to {}", LogUser(users.GetUser(userIndex)), isAudioSubscribed);
             }
             
             // 更新UI显示状态
@@ -878,75 +1959,84 @@ void CChannelPageDlg::OnVideoCellAudioSubscriptionChanged(int cellIndex, BOOL is
 
 void CChannelPageDlg::UpdateSubscribedUsers()
 {
-    if (!m_rteManager) return;
+    if (!m_rteManager || m_overviewActive) return;
 
     // 获取当前页面显示的用户列表
-    std::vector<std::string> subscribedUserIds;
-    int startUserIndex = (m_pageState.currentPage - 1) * m_pageState.usersPerPage;
-    int endUserIndex = startUserIndex + m_pageState.usersPerPage;
-
-    LOG_INFO_FMT("Updating subscribed users for page {} (users {} to {})", m_pageState.currentPage, startUserIndex, endUserIndex - 1);
-
-    for (int i = startUserIndex; i < endUserIndex && i < m_pageState.userList.GetSize(); i++) {
-        ChannelUser* user = m_pageState.userList[i];
-        if (user && !user->isLocal && user->isConnected) {
-            // 检查视频订阅状态
-            if (user->isVideoSubscribed) {
-                subscribedUserIds.push_back(user->GetUserId());
-                LOG_INFO_FMT("Adding user {} to video subscription list", user->GetUserId());
-            } else {
-                LOG_INFO_FMT("User {} video subscription is disabled", user->GetUserId());
-            }
-        }
+    std::vector<UserHandle> subscribedUsers;
+    WallRange live = m_wall.GetLiveRange();
+    int startUserIndex = live.first;
+    int endUserIndex = live.end;
+
+    LOG_CAT_FMT(LogCategory::Layout, LogLevel::Info, "Updating subscribed users for page {} (users {} to {})", GetCurrentPage(), startUserIndex, endUserIndex - 1);
+
+    // 可见行及预取行中已连接、已订阅视频的远端用户
+    const ChannelUserTable& users = m_pageState.users;
+    std::vector<int> rows;
+    users.Select(UserFlag(kUserConnected) | UserFlag(kUserVideoSubscribed), UserFlag(kUserLocal),
+        startUserIndex, endUserIndex, rows);
+    for (int row : rows) {
+        subscribedUsers.push_back(users.GetUser(row));
     }
 
-    // 将订阅用户列表传给RTE管理器
-    if (!subscribedUserIds.empty()) {
-        LOG_INFO_FMT("Subscribing to {} users: {}", subscribedUserIds.size(), [&]() -> std::string {                     std::string result;                     for (const auto& id : subscribedUserIds) {                         if (!result.empty()) result += ", ";                         result += id;                     }                     return result;                 }());
-        
-        // 创建视图用户绑定映射
-        std::map<void*, std::string> viewUserMap;
-        for (const auto& userId : subscribedUserIds) {
-            // 使用用户ID的指针作为临时视图键
-            viewUserMap[const_cast<char*>(userId.c_str())] = userId;
-        }
-        m_rteManager->SetViewUserBindings(viewUserMap);
-    } else {
-        LOG_INFO("No users to subscribe to");
-        m_rteManager->SetViewUserBindings(std::map<void*, std::string>());
+    // 和上一次的订阅列表对比，只记录变化的用户
+    std::sort(subscribedUsers.begin(), subscribedUsers.end());
+    std::vector<UserHandle> added;
+    std::vector<UserHandle> removed;
+    std::set_difference(subscribedUsers.begin(), subscribedUsers.end(),
+        m_subscribedUsers.begin(), m_subscribedUsers.end(), std::back_inserter(added));
+    std::set_difference(m_subscribedUsers.begin(), m_subscribedUsers.end(),
+        subscribedUsers.begin(), subscribedUsers.end(), std::back_inserter(removed));
+
+    for (UserHandle user : added) {
+        LOG_INFO_LIMITED_FMT("Adding user {} to video subscription list", LogUser(user));
+    }
+    for (UserHandle user : removed) {
+        LOG_INFO_LIMITED_FMT("Removing user {} from video subscription list", LogUser(user));
     }
+    LOG_CAT_FMT(LogCategory::Layout, LogLevel::Info, "Subscribed to {} users ({} added, {} removed)", subscribedUsers.size(), added.size(), removed.size());
+
+    // 视频窗口的绑定由 UpdateViewUserBindings 按订阅状态下发
+    m_subscribedUsers.swap(subscribedUsers);
 }
 
 void CChannelPageDlg::UpdateViewUserBindings()
 {
-    if (!m_rteManager) return;
+    if (!m_rteManager || m_overviewActive) return;
 
-    std::map<void*, std::string> viewToUserMap;
-    int startUserIndex = (m_pageState.currentPage - 1) * m_pageState.usersPerPage;
+    const ChannelUserTable& users = m_pageState.users;
+    std::vector<RteViewBinding> bindings;
+    WallRange live = m_wall.GetLiveRange();
+    WallRange visible = m_wall.GetVisibleRange();
 
-    LOG_INFO_FMT("Updating view-user bindings for page {} (users {} to {})", m_pageState.currentPage, startUserIndex, startUserIndex + m_videoWindows.GetSize() - 1);
+    LOG_CAT_FMT(LogCategory::Layout, LogLevel::Info, "Updating view-user bindings for page {} (users {} to {})", GetCurrentPage(), live.first, live.end - 1);
 
     for (int i = 0; i < m_videoWindows.GetSize(); i++) {
-        int userIndex = startUserIndex + i;
+        int userIndex = m_cellItems[i];
         HWND videoWindow = m_videoWindows[i]->GetSafeHwnd();
-        
-        if (userIndex < m_pageState.userList.GetSize()) {
-            ChannelUser* user = m_pageState.userList[userIndex];
-            if (user && user->isConnected) {
-                // 绑定已连接的用户到视频窗口
-                viewToUserMap[videoWindow] = user->GetUserId();
-                LOG_INFO_FMT("Binding user {} to video window {} (index {})", user->GetUserId(), (void*)videoWindow, i);
-            } else if (user) {
-                LOG_INFO_FMT("User {} is not connected, skipping binding for window {}", user->GetUserId(), (void*)videoWindow);
-            } else {
-                LOG_INFO_FMT("No user at index {}, skipping binding for window {}", userIndex, (void*)videoWindow);
-            }
+        m_cellBoundUsers[i] = kInvalidUserHandle;
+
+        // Free cells are hidden and hold no user
+        if (userIndex < 0) {
+            continue;
+        }
+        if (users.Test(userIndex, kUserConnected) && users.Test(userIndex, kUserVideoSubscribed)) {
+            // 绑定已连接的用户到视频窗口
+            RteViewBinding binding;
+            binding.view = videoWindow;
+            binding.user = users.GetUser(userIndex);
+            binding.visible = visible.Contains(userIndex);
+            bindings.push_back(binding);
+            m_cellBoundUsers[i] = binding.user;
+            LOG_CAT_LIMITED_FMT(LogCategory::Layout, LogLevel::Info, "Binding user {} to video window {} (index {})", LogUser(binding.user), (void*)videoWindow, i);
         } else {
-            LOG_INFO_FMT("No user at index {} (beyond list size), skipping binding for window {}", userIndex, (void*)videoWindow);
+            LOG_CAT_LIMITED_FMT(LogCategory::Layout, LogLevel::Info, "User {} is not connected or not subscribed, skipping binding for window {}", users.GetDisplayName(userIndex), (void*)videoWindow);
         }
     }
 
-    LOG_INFO_FMT("Setting {} view-user bindings", viewToUserMap.size());
-    m_rteManager->SetViewUserBindings(viewToUserMap);
-}
+    LOG_CAT_FMT(LogCategory::Layout, LogLevel::Info, "Setting {} view-user bindings", bindings.size());
+    m_rteManager->SetViewUserBindings(bindings);
+    m_boundRange = live;
 
+    // The stage tile may now show another user
+    UpdateRenderTargets();
+}
@@ -5,13 +5,28 @@
 #include "resource.h"
 #include "HomePageDlg.h"
 #include "VideoGridCell.h"
+#include "ChannelUserTable.h"
+#include "LayoutEngine.h"
+#include "VirtualWall.h"
+#include "ThumbnailScheduler.h"
+#include "ThumbnailMosaicWnd.h"
+#include "RenderFpsPolicy.h"
+#include "RosterPageCache.h"
 #include "../../core/IRteManagerEventHandler.h"
 #include <string>
+#include <thread>
+#include <mutex>
+#include <memory>
+#include <map>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
 
 // Forward declarations
 class RteManager;
 
-// Custom Windows Messages for RTE events
+// Custom Windows Messages for RTE events.
+// User messages carry the remote user's UserHandle in WPARAM, no heap payload
 #define WM_USER_RTE_JOIN_CHANNEL_SUCCESS        (WM_USER + 201)
 #define WM_USER_RTE_USER_JOINED                 (WM_USER + 202)
 #define WM_USER_RTE_USER_LEFT                   (WM_USER + 203)
@@ -21,41 +36,41 @@ class RteManager;
 #define WM_USER_RTE_USER_LIST_CHANGED           (WM_USER + 207)
 #define WM_USER_RTE_REMOTE_AUDIO_STATE_CHANGED  (WM_USER + 208)
 #define WM_USER_RTE_LOCAL_AUDIO_STATE_CHANGED   (WM_USER + 209)
+#define WM_USER_RTE_JOIN_FAILED                 (WM_USER + 210)
+#define WM_USER_RTE_CONNECTION_STATE_CHANGED    (WM_USER + 211)
+#define WM_USER_RTE_CONNECTION_RESTORED         (WM_USER + 212)
+#define WM_USER_RTE_USER_SNAPSHOT               (WM_USER + 213)
 
-// ChannelUser class definition
-class ChannelUser 
-{
-public:
-    // Constructor
-    ChannelUser() 
-        : userId(""), isLocal(false), isRobot(false), isConnected(false),
-          isVideoSubscribed(true), isAudioSubscribed(true),
-          isCurrentlyVisible(false), lastVisiblePage(0) 
-    {
-    }
-
-    // Getter method
-    std::string GetUserId() const { return userId; }
-
-    // Public members
-    std::string userId;
-    bool isLocal;
-    bool isRobot;
-    bool isConnected;
-    bool isVideoSubscribed;
-    bool isAudioSubscribed;
-    bool isCurrentlyVisible;
-    int lastVisiblePage;
+// Join state shared by the dialog, the join thread and the teardown job,
+// so either side can outlive the other
+struct ChannelJoinContext {
+    ChannelJoinParams params;
+    RteManager* manager;                // Owned here, deleted by the teardown job
+    std::string failedStep;             // Set before WM_USER_RTE_JOIN_FAILED is posted
+    HWND hwnd;
+
+    ChannelJoinContext() : manager(nullptr), hwnd(NULL) {}
+};
+
+// View state captured when the connection drops, re-applied in one batch
+// after reconnect instead of replaying per-user join/leave events
+struct ReconnectSnapshot {
+    bool valid;
+    int layoutPreset;
+    int scrollOffset;
+    std::unordered_map<UserHandle, std::pair<bool, bool>> subscriptions;  // user -> (video, audio)
+    std::chrono::steady_clock::time_point lostAt;
+
+    ReconnectSnapshot() : valid(false), layoutPreset(0), scrollOffset(0) {}
 };
 
 // Page state management
 struct ChannelPageState {
     std::string channelId;              // Current channel ID
     std::string currentUserId;          // Current user ID
-    int currentGridMode;                // Current grid mode (2,3,4,5,7)
-    int currentPage;                    // Current page number
-    int usersPerPage;                   // Users per page
-    CArray<ChannelUser*> userList;      // User list (using pointers to avoid copying)
+    int currentLayout;                  // Index into the layout presets (combo order)
+    int usersPerPage;                   // Users per page (one viewport), the tile count of the applied layout
+    ChannelUserTable users;             // User list, row order is grid order
     std::string audioMode;              // Audio mode
     bool isLocalVideoEnabled;           // Local video status
     bool isLocalAudioEnabled;           // Local audio mode status
@@ -82,6 +97,7 @@ protected:
     virtual BOOL OnInitDialog();
     virtual void OnOK();
     virtual void OnCancel();
+    virtual LRESULT WindowProc(UINT message, WPARAM wParam, LPARAM lParam);
 
     // Message Map Functions
     DECLARE_MESSAGE_MAP()
@@ -90,6 +106,9 @@ protected:
     afx_msg void OnBnClickedPrevPage();
     afx_msg void OnBnClickedNextPage();
     afx_msg void OnSize(UINT nType, int cx, int cy);
+    afx_msg void OnVScroll(UINT nSBCode, UINT nPos, CScrollBar* pScrollBar);
+    afx_msg BOOL OnMouseWheel(UINT nFlags, short zDelta, CPoint pt);
+    afx_msg void OnTimer(UINT_PTR nIDEvent);
     
     // RTE Event Handlers
     afx_msg LRESULT OnRteJoinChannelSuccess(WPARAM wParam, LPARAM lParam);
@@ -101,6 +120,10 @@ protected:
     afx_msg LRESULT OnRteUserListChanged(WPARAM wParam, LPARAM lParam);
     afx_msg LRESULT OnRteRemoteAudioStateChanged(WPARAM wParam, LPARAM lParam);
     afx_msg LRESULT OnRteLocalAudioStateChanged(WPARAM wParam, LPARAM lParam);
+    afx_msg LRESULT OnRteJoinFailed(WPARAM wParam, LPARAM lParam);
+    afx_msg LRESULT OnRteConnectionStateChanged(WPARAM wParam, LPARAM lParam);
+    afx_msg LRESULT OnRteConnectionRestored(WPARAM wParam, LPARAM lParam);
+    afx_msg LRESULT OnRteUserSnapshot(WPARAM wParam, LPARAM lParam);
 
 private:
     // UI Controls
@@ -111,38 +134,96 @@ private:
     CButton m_btnPrevPage;
     CButton m_btnNextPage;
     CStatic m_staticCurrentPage;
-    CArray<CVideoGridCell*> m_videoWindows;
+    CScrollBar m_scrollVideoWall;
+    CArray<CVideoGridCell*> m_videoWindows;     // Cell pool, children of m_staticVideoContainer
     CFont m_titleFont;
     CFont m_normalFont;
 
     // RTE & Data Members
     ChannelJoinParams m_joinParams;
     ChannelPageState m_pageState;
-    RteManager* m_rteManager;
+    RteManager* m_rteManager;           // Set from m_joinContext once the join succeeded
     BOOL m_isChannelJoined;
+    std::shared_ptr<ChannelJoinContext> m_joinContext;
+    std::thread m_joinThread;
+    std::chrono::steady_clock::time_point m_joinStartedAt;     // For the time to the first roster
+    bool m_rosterLoaded;                // The first roster snapshot was merged
+    std::mutex m_snapshotMutex;
+    std::shared_ptr<const std::vector<UserHandle>> m_pendingSnapshot;  // Newest roster not merged yet
+    ReconnectSnapshot m_reconnectSnapshot;
+    Layout m_layout;                    // Tile rects of one viewport
+    VirtualWall m_wall;                 // Scroll position and live range over the user rows
+    RosterPageCache m_rosterCache;      // Cell labels for the pages around the current one
+    std::vector<int> m_cellItems;       // Cell -> user row it shows, -1 for a free cell
+    std::vector<UserHandle> m_cellBoundUsers;   // Cell -> user whose video is bound to it
+    WallRange m_boundRange;             // Live range the subscriptions were last computed for
+    bool m_wallUpdatePending;           // Subscriptions wait for the wall to settle
+    std::vector<UserHandle> m_subscribedUsers;  // Video subscriptions on the current page, sorted
+    CThumbnailMosaicWnd m_overviewMosaic;       // Replaces the wall in the overview preset
+    ThumbnailScheduler m_thumbnailScheduler;    // Which users the mosaic's capture slots refresh
+    bool m_overviewActive;
+    bool m_videoPaused;                 // Remote video released while the window cannot be seen
+    int64_t m_occludedSinceMs;          // -1 while not covered
+    RenderFpsConfig m_renderFpsConfig;
+    std::vector<int> m_cellTargetFps;   // Cell -> target render rate of its bound user, 0 when unbound
+    bool m_renderProbeRunning;
+    int m_probeCell;                    // Cell whose achieved rate is being sampled, -1 for none
+    int64_t m_probeStartMs;
+    FrameChangeCounter m_probeCounter;
+
+    static const int kTeardownDeadlineMs = 5000;    // Optional teardown steps are skipped after this
+    static const int kTeardownWaitMs = 15000;       // How long a new join waits for the previous teardown
+    static const UINT_PTR kWallSettleTimerId = 1;
+    static const UINT_PTR kThumbnailTimerId = 2;
+    static const UINT_PTR kVisibilityTimerId = 3;
+    static const UINT_PTR kRenderProbeTimerId = 4;
 
     // Initialization
     void InitializeControls();
     void InitializeFonts();
 
     // RTE Engine Management
-    BOOL InitializeRteEngine();
     void ReleaseRteEngine();
-    BOOL JoinRteChannel();
-    void LeaveRteChannel();
+    void StartJoinSequence();
+    static void RunJoinSequence(std::shared_ptr<ChannelJoinContext> context);
+    static bool InitializeRteEngine(ChannelJoinContext& context);
+    static bool FetchToken(ChannelJoinContext& context);
 
     // Video Window & Layout Management
-    void CreateVideoWindows();
+    void EnsureVideoWindows(int count);
     void DestroyVideoWindows();
-    void UpdateGridLayout();
-    void UpdateVideoLayout();
-    void SetGridMode(int gridMode);
-    int GetGridSize(int gridMode);
-    void CalculateGridLayout(int gridMode, CRect containerRect, CArray<CRect>& windowRects);
+    bool UpdateGridLayout();
+    void UpdateVideoLayout(bool resetCells = true);
+    void PositionVideoWindows();
+    void SetLayoutPreset(int preset);
+    LayoutSpec GetLayoutSpec() const;
+
+    // Scrolling wall
+    void ScrollWall(int offset);
+    void UpdateWallScrollBar();
+    void UpdateWallSubscriptions();
+    void DetachRecycledViews();
+
+    // Render frame rate targets, and their measurement
+    void UpdateRenderTargets();
+    void SampleRenderProbe();
+
+    // Pause remote video while minimized or covered
+    void UpdateVideoPause();
+
+    // Overview mosaic
+    void EnterOverview();
+    void LeaveOverview();
+    void UpdateOverviewUsers();
+    void RefreshThumbnails();
+    void RunThumbnailActions(const std::vector<ThumbnailAction>& actions);
 
     // User & Page Management
-    int FindUserIndex(LPCTSTR uid);
+    int FindUserIndex(UserHandle user);
+    int MergeRemoteUsers(const std::vector<UserHandle>& roster);
+    int GetCellUserIndex(int cellIndex) const;
     void UpdatePageDisplay();
+    int GetCurrentPage();
     int GetMaxPages();
     
     // Static Callbacks for CVideoGridCell
@@ -155,17 +236,23 @@ private:
 
     // IRteManagerEventHandler implementation
     void OnConnectionStateChanged(int state) override;
-    void OnUserJoined(const std::string& userId) override;
-    void OnUserLeft(const std::string& userId) override;
+    void OnConnectionRestored(long long outageMs, int attempts) override;
+    void OnUserJoined(UserHandle user) override;
+    void OnUserLeft(UserHandle user) override;
     void OnLocalAudioStateChanged(int state) override;
     void OnLocalVideoStateChanged(int state, int reason) override;
-    void OnRemoteAudioStateChanged(const std::string& userId, int state) override;
-    void OnRemoteVideoStateChanged(const std::string& userId, int state) override;
+    void OnRemoteAudioStateChanged(UserHandle user, int state) override;
+    void OnRemoteVideoStateChanged(UserHandle user, int state) override;
     void OnError(int error) override;
     void OnUserListChanged() override;
+    void OnUserSnapshot(std::shared_ptr<const std::vector<UserHandle>> roster) override;
 
     // RTE Integration Helpers
     void UpdateSubscribedUsers();
     void UpdateViewUserBindings();
+
+    // Reconnect support
+    void TakeReconnectSnapshot();
+    void RestoreReconnectSnapshot();
 };
 
@@ -0,0 +1,284 @@
+#include "pch.h"
+#include "ChannelUserTable.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+ChannelUserTable::ChannelUserTable()
+    : m_block(nullptr), m_blockBytes(0), m_size(0), m_capacity(0),
+      m_users(nullptr), m_lastVisiblePage(nullptr), m_orderKeys(nullptr), m_version(0) {
+    for (int flag = 0; flag < kUserFlagCount; ++flag) {
+        m_flags[flag] = nullptr;
+    }
+}
+
+ChannelUserTable::~ChannelUserTable() {
+    delete[] m_block;
+}
+
+void ChannelUserTable::Reserve(int rows) {
+    if (rows > m_capacity) {
+        Grow(rows);
+    }
+}
+
+// One block: the bitset words first (8-byte aligned), then the handle, key and page columns
+void ChannelUserTable::Grow(int minCapacity) {
+    int capacity = (std::max)(m_capacity * 2, kRowAlign);
+    while (capacity < minCapacity) {
+        capacity *= 2;
+    }
+
+    size_t words = static_cast<size_t>(capacity) / 64;
+    size_t flagBytes = words * sizeof(uint64_t) * kUserFlagCount;
+    size_t userBytes = static_cast<size_t>(capacity) * sizeof(UserHandle);
+    size_t keyBytes = static_cast<size_t>(capacity) * sizeof(uint32_t);
+    size_t pageBytes = static_cast<size_t>(capacity) * sizeof(int32_t);
+    size_t blockBytes = flagBytes + userBytes + keyBytes + pageBytes;
+
+    unsigned char* block = new unsigned char[blockBytes];
+    memset(block, 0, blockBytes);
+
+    uint64_t* flags[kUserFlagCount];
+    for (int flag = 0; flag < kUserFlagCount; ++flag) {
+        flags[flag] = reinterpret_cast<uint64_t*>(block) + words * flag;
+    }
+    UserHandle* users = reinterpret_cast<UserHandle*>(block + flagBytes);
+    uint32_t* keys = reinterpret_cast<uint32_t*>(block + flagBytes + userBytes);
+    int32_t* pages = reinterpret_cast<int32_t*>(block + flagBytes + userBytes + keyBytes);
+
+    if (m_block) {
+        size_t usedWords = static_cast<size_t>(m_capacity) / 64;
+        for (int flag = 0; flag < kUserFlagCount; ++flag) {
+            memcpy(flags[flag], m_flags[flag], usedWords * sizeof(uint64_t));
+        }
+        memcpy(users, m_users, m_size * sizeof(UserHandle));
+        memcpy(keys, m_orderKeys, m_size * sizeof(uint32_t));
+        memcpy(pages, m_lastVisiblePage, m_size * sizeof(int32_t));
+        delete[] m_block;
+    }
+
+    m_block = block;
+    m_blockBytes = blockBytes;
+    m_capacity = capacity;
+    for (int flag = 0; flag < kUserFlagCount; ++flag) {
+        m_flags[flag] = flags[flag];
+    }
+    m_users = users;
+    m_orderKeys = keys;
+    m_lastVisiblePage = pages;
+}
+
+int ChannelUserTable::Add(UserHandle user, ChannelUserFlags flags) {
+    return InsertAt(m_size, user, flags);
+}
+
+int ChannelUserTable::InsertAt(int row, UserHandle user, ChannelUserFlags flags) {
+    row = (std::max)(0, (std::min)(row, m_size));
+    if (m_size == m_capacity) {
+        Grow(m_size + 1);
+    }
+    // A key between the neighbours; renumber when there is no room left
+    uint32_t before = (row > 0) ? m_orderKeys[row - 1] : 0;
+    uint64_t after = (row < m_size) ? m_orderKeys[row] : static_cast<uint64_t>(before) + 2 * kKeyGap;
+    if (after - before < 2 || after > UINT32_MAX) {
+        RenumberKeys();
+        before = (row > 0) ? m_orderKeys[row - 1] : 0;
+        after = (row < m_size) ? m_orderKeys[row] : static_cast<uint64_t>(before) + 2 * kKeyGap;
+    }
+    uint32_t key = (row < m_size) ? static_cast<uint32_t>(before + (after - before) / 2) : before + kKeyGap;
+
+    for (int i = m_size; i > row; --i) {
+        CopyRow(i, i - 1);
+    }
+    ++m_size;
+
+    m_users[row] = user;
+    m_orderKeys[row] = key;
+    m_lastVisiblePage[row] = 0;
+    SetFlags(row, flags);
+    IndexUser(row);
+    ++m_version;
+    return row;
+}
+
+void ChannelUserTable::RemoveAt(int row) {
+    if (row < 0 || row >= m_size) {
+        return;
+    }
+    UnindexUser(row);
+    for (int i = row; i < m_size - 1; ++i) {
+        CopyRow(i, i + 1);
+    }
+    --m_size;
+
+    // Clear the vacated last row
+    SetFlags(m_size, 0);
+    ++m_version;
+}
+
+void ChannelUserTable::RemoveAll() {
+    for (int flag = 0; flag < kUserFlagCount; ++flag) {
+        memset(m_flags[flag], 0, static_cast<size_t>(m_capacity) / 64 * sizeof(uint64_t));
+    }
+    m_size = 0;
+    m_keyByUser.clear();
+    ++m_version;
+}
+
+void ChannelUserTable::SetUser(int row, UserHandle user) {
+    UnindexUser(row);
+    m_users[row] = user;
+    IndexUser(row);
+    ++m_version;
+}
+
+void ChannelUserTable::IndexUser(int row) {
+    UserHandle user = m_users[row];
+    if (user == kInvalidUserHandle) {
+        return;
+    }
+    if (user >= m_keyByUser.size()) {
+        m_keyByUser.resize(static_cast<size_t>(user) + 1, 0);
+    }
+    m_keyByUser[user] = m_orderKeys[row];
+}
+
+void ChannelUserTable::UnindexUser(int row) {
+    UserHandle user = m_users[row];
+    if (user != kInvalidUserHandle && user < m_keyByUser.size() && m_keyByUser[user] == m_orderKeys[row]) {
+        m_keyByUser[user] = 0;
+    }
+}
+
+// Spread the keys evenly again; only when an insert found no gap or the keys ran out
+void ChannelUserTable::RenumberKeys() {
+    uint32_t gap = kKeyGap;
+    while (gap > 2 && static_cast<uint64_t>(m_size + 2) * gap > UINT32_MAX) {
+        gap /= 2;
+    }
+    for (int row = 0; row < m_size; ++row) {
+        UnindexUser(row);
+        m_orderKeys[row] = static_cast<uint32_t>(row + 1) * gap;
+        IndexUser(row);
+    }
+}
+
+void ChannelUserTable::CopyRow(int dst, int src) {
+    m_users[dst] = m_users[src];
+    m_orderKeys[dst] = m_orderKeys[src];
+    m_lastVisiblePage[dst] = m_lastVisiblePage[src];
+    SetFlags(dst, GetFlags(src));
+}
+
+void ChannelUserTable::Set(int row, ChannelUserFlag flag, bool value) {
+    uint64_t bit = uint64_t(1) << (row & 63);
+    uint64_t& word = m_flags[flag][row >> 6];
+    word = value ? (word | bit) : (word & ~bit);
+    ++m_version;
+}
+
+ChannelUserFlags ChannelUserTable::GetFlags(int row) const {
+    ChannelUserFlags flags = 0;
+    for (int flag = 0; flag < kUserFlagCount; ++flag) {
+        if (Test(row, static_cast<ChannelUserFlag>(flag))) {
+            flags |= 1u << flag;
+        }
+    }
+    return flags;
+}
+
+void ChannelUserTable::SetFlags(int row, ChannelUserFlags flags) {
+    for (int flag = 0; flag < kUserFlagCount; ++flag) {
+        Set(row, static_cast<ChannelUserFlag>(flag), (flags & (1u << flag)) != 0);
+    }
+}
+
+int ChannelUserTable::Find(UserHandle user) const {
+    if (user == kInvalidUserHandle || user >= m_keyByUser.size() || m_keyByUser[user] == 0) {
+        return -1;
+    }
+    const uint32_t* first = m_orderKeys;
+    const uint32_t* end = first + m_size;
+    const uint32_t* it = std::lower_bound(first, end, m_keyByUser[user]);
+    if (it == end || *it != m_keyByUser[user]) {
+        return -1;
+    }
+    return static_cast<int>(it - first);
+}
+
+uint64_t ChannelUserTable::MatchWord(size_t word, ChannelUserFlags required, ChannelUserFlags excluded) const {
+    uint64_t match = ~uint64_t(0);
+    for (int flag = 0; flag < kUserFlagCount; ++flag) {
+        if (required & (1u << flag)) {
+            match &= m_flags[flag][word];
+        } else if (excluded & (1u << flag)) {
+            match &= ~m_flags[flag][word];
+        }
+    }
+    return match;
+}
+
+int ChannelUserTable::Count(ChannelUserFlags required, ChannelUserFlags excluded) const {
+    return Count(required, excluded, 0, m_size);
+}
+
+int ChannelUserTable::Count(ChannelUserFlags required, ChannelUserFlags excluded, int firstRow, int endRow) const {
+    firstRow = (std::max)(firstRow, 0);
+    endRow = (std::min)(endRow, m_size);
+    if (firstRow >= endRow) {
+        return 0;
+    }
+
+    int count = 0;
+    size_t firstWord = static_cast<size_t>(firstRow) >> 6;
+    size_t lastWord = static_cast<size_t>(endRow - 1) >> 6;
+    for (size_t word = firstWord; word <= lastWord; ++word) {
+        uint64_t match = MatchWord(word, required, excluded);
+        if (word == firstWord) {
+            match &= ~uint64_t(0) << (firstRow & 63);
+        }
+        if (word == lastWord && (endRow & 63) != 0) {
+            match &= ~(~uint64_t(0) << (endRow & 63));
+        }
+        count += std::popcount(match);
+    }
+    return count;
+}
+
+void ChannelUserTable::Select(ChannelUserFlags required, ChannelUserFlags excluded, int firstRow, int endRow,
+                              std::vector<int>& rows) const {
+    rows.clear();
+    firstRow = (std::max)(firstRow, 0);
+    endRow = (std::min)(endRow, m_size);
+    if (firstRow >= endRow) {
+        return;
+    }
+
+    size_t firstWord = static_cast<size_t>(firstRow) >> 6;
+    size_t lastWord = static_cast<size_t>(endRow - 1) >> 6;
+    for (size_t word = firstWord; word <= lastWord; ++word) {
+        uint64_t match = MatchWord(word, required, excluded);
+        if (word == firstWord) {
+            match &= ~uint64_t(0) << (firstRow & 63);
+        }
+        if (word == lastWord && (endRow & 63) != 0) {
+            match &= ~(~uint64_t(0) << (endRow & 63));
+        }
+        while (match) {
+            rows.push_back(static_cast<int>(word * 64 + std::countr_zero(match)));
+            match &= match - 1;
+        }
+    }
+}
+
+std::string ChannelUserTable::GetDisplayName(int row) const {
+    UserHandle user = m_users[row];
+    if (user == kInvalidUserHandle) {
+        return "-1";    // Grid placeholder
+    }
+    if (!Test(row, kUserConnected) && !Test(row, kUserLocal)) {
+        return UserIdString(user) + " (Offline)";
+    }
+    return UserIdString(user);
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "../../core/UserIdInterner.h"
+
+// Per-user boolean state, one bitset column each
+enum ChannelUserFlag {
+    kUserLocal = 0,
+    kUserRobot,
+    kUserConnected,
+    kUserVideoSubscribed,
+    kUserAudioSubscribed,
+    kUserVisible,           // Shown in a grid cell on the current page
+    kUserVideoOn,           // Remote video starting or decoding; local camera enabled
+    kUserFlagCount
+};
+
+typedef unsigned int ChannelUserFlags;  // Bit n is ChannelUserFlag n
+
+inline ChannelUserFlags UserFlag(ChannelUserFlag flag) {
+    return 1u << flag;
+}
+
+// Flags of a newly joined remote user
+const ChannelUserFlags kNewRemoteUserFlags =
+    (1u << kUserConnected) | (1u << kUserVideoSubscribed) | (1u << kUserAudioSubscribed);
+
+// Channel user list stored as columns. Row order is the grid order: row 0 is
+// the local user, then remote users and placeholders (kInvalidUserHandle).
+//
+// Flags are bitsets, so queries such as "connected users with video on" or
+// "video-subscribed users on this page" are word-wise AND + popcount scans.
+// All columns share one arena block that doubles when full; a row costs a few
+// bytes instead of a heap object with a std::string. Display strings are built
+// for the pages on screen only, by RosterPageCache.
+//
+// Every row has an ordering key that increases with the row, and each handle
+// maps to the key of its row, so Find is a binary search instead of a scan.
+// A handle is expected in at most one row.
+class ChannelUserTable {
+public:
+    ChannelUserTable();
+    ~ChannelUserTable();
+
+    int GetSize() const { return m_size; }
+    void Reserve(int rows);
+
+    // Return the row index of the new user
+    int Add(UserHandle user, ChannelUserFlags flags);
+    int InsertAt(int row, UserHandle user, ChannelUserFlags flags);
+    void RemoveAt(int row);
+    void RemoveAll();
+
+    UserHandle GetUser(int row) const { return m_users[row]; }
+    void SetUser(int row, UserHandle user);
+
+    bool Test(int row, ChannelUserFlag flag) const {
+        return (m_flags[flag][row >> 6] >> (row & 63)) & 1u;
+    }
+    void Set(int row, ChannelUserFlag flag, bool value);
+    ChannelUserFlags GetFlags(int row) const;
+    void SetFlags(int row, ChannelUserFlags flags);
+
+    int GetLastVisiblePage(int row) const { return m_lastVisiblePage[row]; }
+    void SetLastVisiblePage(int row, int page) { m_lastVisiblePage[row] = page; }
+
+    // Row of `user`, or -1. O(log n).
+    int Find(UserHandle user) const;
+
+    // Changes on every edit of users or flags, so cached views of rows can tell they are stale
+    uint64_t GetVersion() const { return m_version; }
+
+    // Rows in [firstRow, endRow) with every `required` flag set and every
+    // `excluded` flag clear. Without a range the whole table is scanned.
+    int Count(ChannelUserFlags required, ChannelUserFlags excluded = 0) const;
+    int Count(ChannelUserFlags required, ChannelUserFlags excluded, int firstRow, int endRow) const;
+    void Select(ChannelUserFlags required, ChannelUserFlags excluded, int firstRow, int endRow,
+                std::vector<int>& rows) const;
+
+    // User id for display; placeholders show "-1", offline remote users get a suffix
+    std::string GetDisplayName(int row) const;
+
+    // Bytes held by the arena and the handle index (capacity, not size)
+    size_t GetMemoryUsage() const { return m_blockBytes + m_keyByUser.capacity() * sizeof(uint32_t); }
+
+private:
+    ChannelUserTable(const ChannelUserTable&) = delete;
+    ChannelUserTable& operator=(const ChannelUserTable&) = delete;
+
+    static constexpr int kRowAlign = 64;    // Capacity is a whole number of bitset words
+    static constexpr uint32_t kKeyGap = 1024;   // Between the keys of appended rows
+
+    void Grow(int minCapacity);
+    void CopyRow(int dst, int src);
+    uint64_t MatchWord(size_t word, ChannelUserFlags required, ChannelUserFlags excluded) const;
+    void IndexUser(int row);
+    void UnindexUser(int row);
+    void RenumberKeys();
+
+    unsigned char* m_block;
+    size_t m_blockBytes;
+    int m_size;
+    int m_capacity;
+
+    // Columns, carved out of m_block
+    uint64_t* m_flags[kUserFlagCount];
+    UserHandle* m_users;
+    int32_t* m_lastVisiblePage;
+    uint32_t* m_orderKeys;              // Increasing with the row, never 0
+
+    std::vector<uint32_t> m_keyByUser;  // UserHandle -> order key of its row, 0 if none
+    uint64_t m_version;
+};
@@ -2,6 +2,7 @@
 #include "ThousChannel.h"
 #include "HomePageDlg.h"
 #include "ChannelPageDlg.h"
+#define LOG_CATEGORY LogCategory::Ui
 #include "Logger.h"
 #include <sstream>
 #include <iomanip>
@@ -22,8 +23,6 @@ IMPLEMENT_DYNAMIC(CHomePageDlg, CDialogEx)
 
 CHomePageDlg::CHomePageDlg(CWnd* pParent /*=nullptr*/)
 	: CDialogEx(IDD_JOIN_CHANNEL_DLG, pParent)
-	, m_tokenManager(nullptr)
-	, m_isGeneratingToken(false)
 {
 	// 初始化参数
 	m_joinParams.appId = "";
@@ -37,10 +36,6 @@ CHomePageDlg::CHomePageDlg(CWnd* pParent /*=nullptr*/)
 
 CHomePageDlg::~CHomePageDlg()
 {
-	if (m_tokenManager) {
-		delete m_tokenManager;
-		m_tokenManager = nullptr;
-	}
 }
 
 void CHomePageDlg::DoDataExchange(CDataExchange* pDX)
@@ -73,7 +68,6 @@ BEGIN_MESSAGE_MAP(CHomePageDlg, CDialogEx)
 	ON_CBN_SELCHANGE(IDC_COMBO_APPID, &CHomePageDlg::OnCbnSelchangeAppid)
 	ON_CBN_SELCHANGE(IDC_COMBO_AUDIO_PULL, &CHomePageDlg::OnCbnSelchangeAudioPull)
 	// 证书输入框已移除 - ON_EN_CHANGE(IDC_EDIT_APP_CERTIFICATE, &CHomePageDlg::OnEnChangeAppCertificate)
-	ON_MESSAGE(WM_TOKEN_GENERATED, &CHomePageDlg::OnTokenGenerated)
 END_MESSAGE_MAP()
 
 // CHomePageDlg 消息处理程序
@@ -90,9 +84,6 @@ BOOL CHomePageDlg::OnInitDialog()
 		strTitle.LoadString(IDS_DLG_TITLE);
 		SetWindowText(strTitle);
 
-		// 创建Token管理器
-		m_tokenManager = new CTokenManager();
-
 		// 初始化控件
 		InitializeControls();
 
@@ -195,13 +186,8 @@ bool CHomePageDlg::ValidateInput()
 	return true;
 }
 
-void CHomePageDlg::GenerateToken()
+void CHomePageDlg::CollectJoinParams()
 {
-	if (m_isGeneratingToken) {
-		LOG_WARN("Token generation already in progress");
-		return;
-	}
-
 	// 收集用户输入
 	CString temp;
 	
@@ -235,75 +221,34 @@ void CHomePageDlg::GenerateToken()
 	// 记录日志
 		LOG_INFO_FMT("Join params collected. Channel: {}, UserID: {}, Camera: {}, Mic: {}",
 		m_joinParams.channelId, m_joinParams.userId, m_joinParams.enableCamera, m_joinParams.enableMic);
+}
 
-	// 构建Token生成参数
-	TokenGenerateParams tokenParams;
-	tokenParams.appId = m_joinParams.appId;
-	tokenParams.appCertificate = m_joinParams.appCertificate;
-	tokenParams.channelName = m_joinParams.channelId;
-	tokenParams.userId = m_joinParams.userId;
-	tokenParams.expire = 24 * 60 * 60;  // 24小时过期
-	tokenParams.type = 1;      // RTC Token
-	tokenParams.src = "Windows";
-
-		LOG_INFO_FMT("Generating token for AppID={}, Channel={}, UserID={}",
-		tokenParams.appId, tokenParams.channelName, tokenParams.userId);
-
-	// 更新状态
-	m_isGeneratingToken = true;
-	UpdateTokenStatus("正在生成Token...", false);
+void CHomePageDlg::OpenChannelPage()
+{
+	// Token由频道页面在加入流程中获取，与引擎初始化并行执行
+	m_joinParams.token = "";
 	m_btnJoinChannel.EnableWindow(false);
 
-	// 异步生成Token
-	m_tokenManager->GenerateTokenAsync(tokenParams, [this](const std::string& token, bool success, const std::string& errorMsg) {
-		// 通过消息机制在主线程中处理回调
-		TokenResult* pResult = new TokenResult();
-		pResult->token = token;
-		pResult->success = success;
-		pResult->errorMsg = errorMsg;
-		
-		::PostMessage(this->GetSafeHwnd(), WM_TOKEN_GENERATED, 0, (LPARAM)pResult);
-	});
-}
+	LOG_INFO("Creating channel page dialog");
+	CChannelPageDlg channelPageDlg(m_joinParams, this);
 
-void CHomePageDlg::OnTokenGenerated(const std::string& token, bool success, const std::string& errorMsg)
-{
-	m_isGeneratingToken = false;
+	// 隐藏当前对话框
+	ShowWindow(SW_HIDE);
+
+	// 显示频道页面
+	INT_PTR result = channelPageDlg.DoModal();
 	m_btnJoinChannel.EnableWindow(true);
 
-	if (success && !token.empty()) {
-		m_joinParams.token = token;
-		UpdateTokenStatus("Token生成成功，可以加入频道", false);
-		
-		LOG_INFO_FMT("Token generated successfully: {}", token.substr(0, 20) + "...");
-		
-		// 自动跳转到频道页面
-		LOG_INFO("Creating channel page dialog");
-		CChannelPageDlg channelPageDlg(m_joinParams, this);
-		
-		// 隐藏当前对话框
-		ShowWindow(SW_HIDE);
-		
-		// 显示频道页面
-		INT_PTR result = channelPageDlg.DoModal();
-		
-		// 根据频道页面的返回结果处理
-		if (result == IDOK) {
-			// 用户从频道页面正常退出，关闭整个应用
-			LOG_INFO("User exited from channel page, closing application");
-			EndDialog(IDCANCEL); // 通知主程序退出
-		} else {
-			// 用户从频道页面返回，重新显示加入频道对话框
-			LOG_INFO("User returned from channel page, showing join dialog again");
-			ShowWindow(SW_SHOW);
-			// 清空token，要求重新生成
-			m_joinParams.token = "";
-			UpdateTokenStatus("请重新生成Token", false);
-		}
+	// 根据频道页面的返回结果处理
+	if (result == IDOK) {
+		// 用户从频道页面正常退出，关闭整个应用
+		LOG_INFO("User exited from channel page, closing application");
+		EndDialog(IDCANCEL); // 通知主程序退出
 	} else {
-		UpdateTokenStatus("Token生成失败: " + errorMsg, true);
-		LOG_ERROR_FMT("Token generation failed: {}", errorMsg);
-		AfxMessageBox("Token生成失败: " + CString(errorMsg.c_str()));
+		// 用户从频道页面返回，重新显示加入频道对话框
+		LOG_INFO("User returned from channel page, showing join dialog again");
+		ShowWindow(SW_SHOW);
+		UpdateTokenStatus("请重新加入频道", false);
 	}
 }
 
@@ -343,19 +288,9 @@ void CHomePageDlg::OnBnClickedJoinChannel()
 	if (!ValidateInput())
 		return;
 
-	// 生成Token并加入频道
-	GenerateToken();
-}
-
-LRESULT CHomePageDlg::OnTokenGenerated(WPARAM wParam, LPARAM lParam)
-{
-	TokenResult* pResult = (TokenResult*)lParam;
-	if (pResult) {
-		OnTokenGenerated(pResult->token, pResult->success, pResult->errorMsg);
-		delete pResult;
-	}
-	
-	return 0;
+	// 收集参数并进入频道页面
+	CollectJoinParams();
+	OpenChannelPage();
 }
 
 void CHomePageDlg::OnEnChangeChannelId()
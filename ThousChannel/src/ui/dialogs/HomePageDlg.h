@@ -18,13 +18,6 @@ struct ChannelJoinParams {
 	bool enableMic;              // 是否开启麦克风
 };
 
-// Token结果结构
-struct TokenResult {
-	std::string token;
-	bool success;
-	std::string errorMsg;
-};
-
 // AppID和证书配对结构
 struct AppIdInfo {
 	std::string appId;
@@ -32,9 +25,6 @@ struct AppIdInfo {
 	std::string displayName;  // 显示名称
 };
 
-// 自定义消息
-#define WM_TOKEN_GENERATED (WM_USER + 200)
-
 // 主页对话框类
 class CHomePageDlg : public CDialogEx
 {
@@ -73,8 +63,6 @@ private:
 
 	// 数据成员
 	ChannelJoinParams m_joinParams;
-	CTokenManager* m_tokenManager;
-	bool m_isGeneratingToken;
 	
 	// AppID数据源
 	static const std::vector<AppIdInfo> m_appIdList;
@@ -85,10 +73,10 @@ private:
 	// 输入验证
 	bool ValidateInput();
 
-	// Token生成相关
-	void GenerateToken();
+	// 加入频道相关
+	void CollectJoinParams();
+	void OpenChannelPage();
 	std::string GenerateRandomUserId();
-	void OnTokenGenerated(const std::string& token, bool success, const std::string& errorMsg);
 	void UpdateTokenStatus(const std::string& status, bool isError = false);
 
 	// 消息处理函数
@@ -98,6 +86,5 @@ private:
 	afx_msg void OnCbnSelchangeAppid();
 	afx_msg void OnCbnSelchangeAudioPull();
 	// 证书输入框已移除 - afx_msg void OnEnChangeAppCertificate();
-	afx_msg LRESULT OnTokenGenerated(WPARAM wParam, LPARAM lParam);
 };
 
@@ -0,0 +1,263 @@
+#include "pch.h"
+#include "LayoutEngine.h"
+#include <algorithm>
+
+LayoutSpec LayoutSpec::Grid(int columns, int rows) {
+    LayoutSpec spec;
+    spec.mode = LayoutMode::Grid;
+    spec.columns = columns;
+    spec.rows = rows;
+    spec.tileCount = columns * rows;
+    return spec;
+}
+
+LayoutSpec LayoutSpec::Auto(int tileCount) {
+    LayoutSpec spec;
+    spec.mode = LayoutMode::Auto;
+    spec.tileCount = tileCount;
+    return spec;
+}
+
+LayoutSpec LayoutSpec::SpeakerFilmstrip(int tileCount) {
+    LayoutSpec spec;
+    spec.mode = LayoutMode::SpeakerFilmstrip;
+    spec.tileCount = tileCount;
+    return spec;
+}
+
+// Cell boundaries are computed from the container edges so rounding never accumulates
+LayoutRect LayoutEngine::CellRect(const LayoutRect& container, int columns, int rows, int column, int row,
+                                  int columnSpan, int rowSpan, int gap) {
+    int width = container.Width();
+    int height = container.Height();
+    LayoutRect rect;
+    rect.left = container.left + width * column / columns;
+    rect.top = container.top + height * row / rows;
+    rect.right = container.left + width * (column + columnSpan) / columns - gap;
+    rect.bottom = container.top + height * (row + rowSpan) / rows - gap;
+    rect.right = (std::max)(rect.right, rect.left);
+    rect.bottom = (std::max)(rect.bottom, rect.top);
+    return rect;
+}
+
+void LayoutEngine::ChooseGrid(int count, double aspect, int width, int height, int& columns, int& rows) {
+    columns = 1;
+    rows = 1;
+    if (count <= 1 || width <= 0 || height <= 0) {
+        return;
+    }
+
+    double bestArea = -1.0;
+    for (int c = 1; c <= count; ++c) {
+        int r = (count + c - 1) / c;
+        double cellWidth = static_cast<double>(width) / c;
+        double cellHeight = static_cast<double>(height) / r;
+        double tileWidth = (std::min)(cellWidth, cellHeight * aspect);
+        double area = tileWidth * (tileWidth / aspect);
+        // On a tie prefer fewer empty cells, then more columns in a landscape container
+        bool tie = (area > bestArea - 0.5 && area <= bestArea + 0.5);
+        bool fewerEmpty = (c * r < columns * rows);
+        bool sameEmptyWider = (c * r == columns * rows && width >= height);
+        if (area > bestArea + 0.5 || (tie && (fewerEmpty || sameEmptyWider))) {
+            bestArea = area;
+            columns = c;
+            rows = r;
+        }
+    }
+}
+
+Layout LayoutEngine::Compute(const LayoutSpec& spec, const LayoutRect& container) {
+    switch (spec.mode) {
+        case LayoutMode::Auto: {
+            Layout layout;
+            int count = (std::max)(spec.tileCount, 0);
+            if (count == 0) {
+                return layout;
+            }
+            ChooseGrid(count, spec.tileAspect, container.Width(), container.Height(), layout.columns, layout.rows);
+
+            // A partly filled last row is centred
+            for (int index = 0; index < count; ++index) {
+                int row = index / layout.columns;
+                int column = index % layout.columns;
+                LayoutTile tile;
+                tile.index = index;
+                tile.large = false;
+                tile.rect = CellRect(container, layout.columns, layout.rows, column, row, 1, 1, spec.gap);
+
+                int tilesInRow = (std::min)(layout.columns, count - row * layout.columns);
+                if (tilesInRow < layout.columns) {
+                    int offset = container.Width() * (layout.columns - tilesInRow) / (2 * layout.columns);
+                    tile.rect.left += offset;
+                    tile.rect.right += offset;
+                }
+                layout.tiles.push_back(tile);
+            }
+            return layout;
+        }
+        case LayoutMode::SpeakerFilmstrip:
+            return ComputeSpeakerFilmstrip(spec, container);
+        case LayoutMode::Grid:
+        default:
+            return ComputeGrid(spec, container);
+    }
+}
+
+// Pinned tiles take the first free 2x2 block, the rest fill the free cells in row-major order
+Layout LayoutEngine::ComputeGrid(const LayoutSpec& spec, const LayoutRect& container) {
+    Layout layout;
+    layout.columns = (std::max)(spec.columns, 1);
+    layout.rows = (std::max)(spec.rows, 1);
+    int cellCount = layout.columns * layout.rows;
+
+    std::vector<int> pinned;
+    for (int index : spec.pinnedTiles) {
+        if (index >= 0 && std::find(pinned.begin(), pinned.end(), index) == pinned.end()) {
+            pinned.push_back(index);
+        }
+    }
+
+    struct Placement { int index; int column; int row; };
+    std::vector<Placement> pinnedPlacements;
+    std::vector<bool> occupied;
+
+    // Each placed pin removes three tiles from the page; drop pins that found
+    // no free 2x2 block or whose index no longer exists, and place again until
+    // the set is stable. A dropped pin is filled in as a normal tile.
+    while (true) {
+        pinnedPlacements.clear();
+        occupied.assign(cellCount, false);
+        std::vector<int> unplaced;
+        for (int index : pinned) {
+            bool placed = false;
+            for (int row = 0; row + 1 < layout.rows && !placed; ++row) {
+                for (int column = 0; column + 1 < layout.columns && !placed; ++column) {
+                    int cell = row * layout.columns + column;
+                    if (!occupied[cell] && !occupied[cell + 1] &&
+                        !occupied[cell + layout.columns] && !occupied[cell + layout.columns + 1]) {
+                        occupied[cell] = occupied[cell + 1] = true;
+                        occupied[cell + layout.columns] = occupied[cell + layout.columns + 1] = true;
+                        pinnedPlacements.push_back({ index, column, row });
+                        placed = true;
+                    }
+                }
+            }
+            if (!placed) {
+                unplaced.push_back(index);
+            }
+        }
+
+        int tileCount = cellCount - 3 * static_cast<int>(pinnedPlacements.size());
+        auto dropped = std::remove_if(pinned.begin(), pinned.end(), [tileCount, &unplaced](int index) {
+            return index >= tileCount || std::find(unplaced.begin(), unplaced.end(), index) != unplaced.end();
+        });
+        if (dropped == pinned.end()) {
+            break;
+        }
+        pinned.erase(dropped, pinned.end());
+    }
+
+    for (const Placement& placement : pinnedPlacements) {
+        LayoutTile tile;
+        tile.index = placement.index;
+        tile.large = true;
+        tile.rect = CellRect(container, layout.columns, layout.rows, placement.column, placement.row, 2, 2, spec.gap);
+        layout.tiles.push_back(tile);
+    }
+
+    int nextIndex = 0;
+    for (int cell = 0; cell < cellCount; ++cell) {
+        if (occupied[cell]) {
+            continue;
+        }
+        while (std::find(pinned.begin(), pinned.end(), nextIndex) != pinned.end()) {
+            ++nextIndex;
+        }
+        LayoutTile tile;
+        tile.index = nextIndex++;
+        tile.large = false;
+        tile.rect = CellRect(container, layout.columns, layout.rows, cell % layout.columns, cell / layout.columns, 1, 1, spec.gap);
+        layout.tiles.push_back(tile);
+    }
+
+    std::sort(layout.tiles.begin(), layout.tiles.end(),
+        [](const LayoutTile& a, const LayoutTile& b) { return a.index < b.index; });
+    return layout;
+}
+
+Layout LayoutEngine::ComputeSpeakerFilmstrip(const LayoutSpec& spec, const LayoutRect& container) {
+    Layout layout;
+    int count = (std::max)(spec.tileCount, 0);
+    if (count == 0) {
+        return layout;
+    }
+
+    LayoutTile speaker;
+    speaker.index = 0;
+    speaker.large = true;
+    if (count == 1) {
+        layout.columns = 1;
+        layout.rows = 1;
+        speaker.rect = CellRect(container, 1, 1, 0, 0, 1, 1, spec.gap);
+        layout.tiles.push_back(speaker);
+        return layout;
+    }
+
+    int stripTiles = count - 1;
+    int stripHeight = static_cast<int>(container.Height() * (std::min)((std::max)(spec.filmstripRatio, 0.05), 0.5));
+    LayoutRect stage(container.left, container.top, container.right, container.bottom - stripHeight);
+    LayoutRect strip(container.left, container.bottom - stripHeight, container.right, container.bottom);
+
+    layout.columns = stripTiles;
+    layout.rows = 2;
+    speaker.rect = CellRect(stage, 1, 1, 0, 0, 1, 1, spec.gap);
+    layout.tiles.push_back(speaker);
+
+    for (int i = 0; i < stripTiles; ++i) {
+        LayoutTile tile;
+        tile.index = i + 1;
+        tile.large = false;
+        tile.rect = CellRect(strip, stripTiles, 1, i, 0, 1, 1, spec.gap);
+        layout.tiles.push_back(tile);
+    }
+    return layout;
+}
+
+std::vector<LayoutChange> LayoutEngine::Diff(const Layout& before, const Layout& after) {
+    std::vector<LayoutChange> changes;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < before.tiles.size() || j < after.tiles.size()) {
+        LayoutChange change;
+        if (j == after.tiles.size() || (i < before.tiles.size() && before.tiles[i].index < after.tiles[j].index)) {
+            change.index = before.tiles[i].index;
+            change.type = LayoutChangeType::Removed;
+            change.from = before.tiles[i].rect;
+            changes.push_back(change);
+            ++i;
+            continue;
+        }
+        if (i == before.tiles.size() || after.tiles[j].index < before.tiles[i].index) {
+            change.index = after.tiles[j].index;
+            change.type = LayoutChangeType::Added;
+            change.to = after.tiles[j].rect;
+            changes.push_back(change);
+            ++j;
+            continue;
+        }
+
+        const LayoutRect& from = before.tiles[i].rect;
+        const LayoutRect& to = after.tiles[j].rect;
+        if (from != to) {
+            change.index = after.tiles[j].index;
+            change.type = (from.Width() == to.Width() && from.Height() == to.Height())
+                ? LayoutChangeType::Moved : LayoutChangeType::Resized;
+            change.from = from;
+            change.to = to;
+            changes.push_back(change);
+        }
+        ++i;
+        ++j;
+    }
+    return changes;
+}
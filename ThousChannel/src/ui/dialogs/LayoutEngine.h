@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+
+// Platform-neutral rectangle, right/bottom exclusive like a Win32 RECT
+struct LayoutRect {
+    int left;
+    int top;
+    int right;
+    int bottom;
+
+    LayoutRect() : left(0), top(0), right(0), bottom(0) {}
+    LayoutRect(int l, int t, int r, int b) : left(l), top(t), right(r), bottom(b) {}
+
+    int Width() const { return right - left; }
+    int Height() const { return bottom - top; }
+    bool operator==(const LayoutRect& other) const {
+        return left == other.left && top == other.top && right == other.right && bottom == other.bottom;
+    }
+    bool operator!=(const LayoutRect& other) const { return !(*this == other); }
+};
+
+enum class LayoutMode {
+    Grid,               // Fixed columns x rows
+    Auto,               // Columns / rows chosen for tileCount to maximise tile size at tileAspect
+    SpeakerFilmstrip    // Tile 0 large, the rest in a strip along the bottom
+};
+
+struct LayoutSpec {
+    LayoutMode mode;
+    int columns;                    // Grid
+    int rows;                       // Grid
+    int tileCount;                  // Auto and SpeakerFilmstrip (speaker + strip)
+    double tileAspect;              // Auto, width / height
+    double filmstripRatio;          // SpeakerFilmstrip, strip height / container height
+    int gap;                        // Pixels between tiles
+    std::vector<int> pinnedTiles;   // Grid: tiles that span 2x2 cells, placed first
+
+    LayoutSpec()
+        : mode(LayoutMode::Grid), columns(2), rows(2), tileCount(4),
+          tileAspect(16.0 / 9.0), filmstripRatio(0.2), gap(2) {
+    }
+
+    static LayoutSpec Grid(int columns, int rows);
+    static LayoutSpec Auto(int tileCount);
+    static LayoutSpec SpeakerFilmstrip(int tileCount);
+};
+
+struct LayoutTile {
+    int index;          // Position in page order; user row = first row on the page + index
+    LayoutRect rect;
+    bool large;         // Speaker or pinned tile
+};
+
+struct Layout {
+    std::vector<LayoutTile> tiles;  // Sorted by index
+    int columns;                    // Cell grid the tiles were packed into
+    int rows;
+
+    Layout() : columns(0), rows(0) {}
+};
+
+enum class LayoutChangeType {
+    Added,      // Tile index only in the new layout
+    Removed,    // Tile index only in the old layout
+    Moved,      // Same size, new position
+    Resized     // New size (and possibly position)
+};
+
+struct LayoutChange {
+    int index;
+    LayoutChangeType type;
+    LayoutRect from;    // Empty for Added
+    LayoutRect to;      // Empty for Removed
+};
+
+// Computes tile rects for a container and the difference between two layouts,
+// so the view only moves windows (and the subscription layer only revisits
+// users) whose tile actually changed. Tile pixel sizes are what the stream
+// layer uses to pick high or low streams.
+class LayoutEngine {
+public:
+    static Layout Compute(const LayoutSpec& spec, const LayoutRect& container);
+
+    // Changes from `before` to `after`, ordered by tile index; unchanged tiles are omitted
+    static std::vector<LayoutChange> Diff(const Layout& before, const Layout& after);
+
+    // Columns x rows that give the largest tiles of `aspect` for `count` tiles
+    static void ChooseGrid(int count, double aspect, int width, int height, int& columns, int& rows);
+
+private:
+    static Layout ComputeGrid(const LayoutSpec& spec, const LayoutRect& container);
+    static Layout ComputeSpeakerFilmstrip(const LayoutSpec& spec, const LayoutRect& container);
+    static LayoutRect CellRect(const LayoutRect& container, int columns, int rows, int column, int row,
+                               int columnSpan, int rowSpan, int gap);
+};
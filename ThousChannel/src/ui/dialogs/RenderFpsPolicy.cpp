@@ -0,0 +1,122 @@
+#include "pch.h"
+#include "RenderFpsPolicy.h"
+#include <algorithm>
+
+int RenderFpsPolicy::GridFps(const RenderFpsConfig& config, int tilesPerViewport) {
+    if (tilesPerViewport <= 4) {
+        return config.smallGridFps;
+    }
+    if (tilesPerViewport <= 9) {
+        return config.mediumGridFps;
+    }
+    if (tilesPerViewport <= 25) {
+        return config.largeGridFps;
+    }
+    return config.denseGridFps;
+}
+
+// Scale the targets of the tiles matching `focused` so they sum to at most
+// `available`, keeping each at or above minFps
+static void ScaleDown(const RenderFpsConfig& config, const std::vector<RenderFpsTile>& tiles,
+                      bool focused, int available, std::vector<int>& targets) {
+    int sum = 0;
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        if (tiles[i].visible && tiles[i].focused == focused) {
+            sum += targets[i];
+        }
+    }
+    if (sum <= available || sum <= 0) {
+        return;
+    }
+
+    double scale = static_cast<double>((std::max)(available, 0)) / sum;
+    std::vector<int> wanted(targets);
+    int scaledSum = 0;
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        if (tiles[i].visible && tiles[i].focused == focused) {
+            targets[i] = (std::max)(static_cast<int>(targets[i] * scale), config.minFps);
+            scaledSum += targets[i];
+        }
+    }
+
+    // Rounding down leaves part of the budget unused; hand it out in tile order
+    int left = available - scaledSum;
+    for (size_t i = 0; i < tiles.size() && left > 0; ++i) {
+        if (tiles[i].visible && tiles[i].focused == focused && targets[i] < wanted[i]) {
+            ++targets[i];
+            --left;
+        }
+    }
+}
+
+int RenderFpsPolicy::Compute(const RenderFpsConfig& config, int tilesPerViewport,
+                             const std::vector<RenderFpsTile>& tiles, std::vector<int>& targets) {
+    int gridFps = (std::max)(GridFps(config, tilesPerViewport), config.minFps);
+    int focusFps = (std::max)(config.focusFps, config.minFps);
+
+    targets.assign(tiles.size(), config.minFps);
+    int offscreen = 0;
+    int focusedSum = 0;
+    int total = 0;
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        if (!tiles[i].visible) {
+            offscreen += targets[i];
+        } else if (tiles[i].focused) {
+            targets[i] = focusFps;
+            focusedSum += focusFps;
+        } else {
+            targets[i] = gridFps;
+        }
+        total += targets[i];
+    }
+    if (total <= config.budgetFps) {
+        return total;
+    }
+
+    // Unfocused tiles give way first, then focused ones share what is left
+    int available = config.budgetFps - offscreen;
+    ScaleDown(config, tiles, false, available - focusedSum, targets);
+    int unfocusedSum = 0;
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        if (tiles[i].visible && !tiles[i].focused) {
+            unfocusedSum += targets[i];
+        }
+    }
+    ScaleDown(config, tiles, true, available - unfocusedSum, targets);
+
+    total = 0;
+    for (int target : targets) {
+        total += target;
+    }
+    return total;
+}
+
+FrameChangeCounter::FrameChangeCounter()
+    : m_startMs(-1), m_lastChecksum(0), m_samples(0), m_frames(0) {
+}
+
+void FrameChangeCounter::Reset(int64_t nowMs) {
+    m_startMs = nowMs;
+    m_lastChecksum = 0;
+    m_samples = 0;
+    m_frames = 0;
+}
+
+void FrameChangeCounter::AddSample(uint32_t checksum, int64_t nowMs) {
+    if (m_startMs < 0) {
+        m_startMs = nowMs;
+    }
+    // The first sample is the reference, not a frame
+    if (m_samples > 0 && checksum != m_lastChecksum) {
+        ++m_frames;
+    }
+    m_lastChecksum = checksum;
+    ++m_samples;
+}
+
+double FrameChangeCounter::GetFps(int64_t nowMs) const {
+    if (m_startMs < 0 || nowMs <= m_startMs) {
+        return 0.0;
+    }
+    return m_frames * 1000.0 / static_cast<double>(nowMs - m_startMs);
+}
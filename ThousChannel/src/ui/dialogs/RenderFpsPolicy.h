@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "../../core/UserIdInterner.h"
+
+// Target render rates. Focused tiles (stage, pinned, current speaker) get
+// focusFps, other visible tiles a rate by grid density, tiles only kept live
+// for scrolling get minFps. The sum over all tiles is capped at budgetFps.
+struct RenderFpsConfig {
+    int focusFps;
+    int smallGridFps;       // Up to 4 tiles per viewport
+    int mediumGridFps;      // Up to 9
+    int largeGridFps;       // Up to 25
+    int denseGridFps;       // More than 25
+    int minFps;             // Floor when the budget is short; minFps per tile may exceed the budget
+    int budgetFps;
+
+    RenderFpsConfig()
+        : focusFps(30), smallGridFps(30), mediumGridFps(15), largeGridFps(10), denseGridFps(5),
+          minFps(2), budgetFps(360) {
+    }
+};
+
+struct RenderFpsTile {
+    UserHandle user;
+    bool visible;           // False for overscan tiles
+    bool focused;
+};
+
+class RenderFpsPolicy {
+public:
+    // Rate of an unfocused visible tile in a viewport of `tilesPerViewport` tiles
+    static int GridFps(const RenderFpsConfig& config, int tilesPerViewport);
+
+    // One target per tile. Over budget, unfocused tiles are scaled down
+    // first and focused tiles only if that is not enough. Returns the total.
+    static int Compute(const RenderFpsConfig& config, int tilesPerViewport,
+                       const std::vector<RenderFpsTile>& tiles, std::vector<int>& targets);
+};
+
+// Achieved frame rate of a rendered tile, from samples of its pixels: every
+// sample that differs from the previous one counts as a new frame. Sampling
+// must be faster than the rates measured; static content reads as 0 fps.
+class FrameChangeCounter {
+public:
+    FrameChangeCounter();
+
+    void Reset(int64_t nowMs);
+    void AddSample(uint32_t checksum, int64_t nowMs);
+
+    int GetFrames() const { return m_frames; }
+    int GetSamples() const { return m_samples; }
+    double GetFps(int64_t nowMs) const;
+
+private:
+    int64_t m_startMs;
+    uint32_t m_lastChecksum;
+    int m_samples;
+    int m_frames;
+};
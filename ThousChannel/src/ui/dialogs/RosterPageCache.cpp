@@ -0,0 +1,93 @@
+#include "pch.h"
+#include "RosterPageCache.h"
+#include <algorithm>
+
+RosterPageCache::RosterPageCache(int maxPages)
+    : m_maxPages((std::max)(maxPages, 1)), m_rowsPerPage(0) {
+}
+
+void RosterPageCache::Prefetch(const ChannelUserTable& table, int rowsPerPage, int page, int window) {
+    rowsPerPage = (std::max)(rowsPerPage, 1);
+    if (rowsPerPage != m_rowsPerPage) {
+        Clear();
+        m_rowsPerPage = rowsPerPage;
+    }
+
+    int pageCount = (table.GetSize() + rowsPerPage - 1) / rowsPerPage;
+    int first = (std::max)(page - window, 0);
+    int last = (std::min)(page + window, pageCount - 1);
+    // The current page last, so it is the most recently used
+    for (int index = first; index <= last; ++index) {
+        if (index != page) {
+            Touch(table, index);
+        }
+    }
+    if (page >= 0 && page < pageCount) {
+        Touch(table, page);
+    }
+}
+
+const RosterEntry& RosterPageCache::Get(const ChannelUserTable& table, int row) {
+    if (m_rowsPerPage == 0) {
+        m_rowsPerPage = 1;
+    }
+    Page& page = Touch(table, row / m_rowsPerPage);
+    return page.entries[row % m_rowsPerPage];
+}
+
+void RosterPageCache::Clear() {
+    m_pages.clear();
+    m_byIndex.clear();
+}
+
+RosterPageCache::Page& RosterPageCache::Touch(const ChannelUserTable& table, int index) {
+    auto it = m_byIndex.find(index);
+    if (it != m_byIndex.end()) {
+        m_pages.splice(m_pages.begin(), m_pages, it->second);
+        if (it->second->version != table.GetVersion()) {
+            Build(table, *it->second);
+        }
+        return *it->second;
+    }
+
+    while (static_cast<int>(m_pages.size()) >= m_maxPages) {
+        m_byIndex.erase(m_pages.back().index);
+        m_pages.pop_back();
+    }
+    m_pages.push_front(Page());
+    m_pages.front().index = index;
+    m_byIndex[index] = m_pages.begin();
+    Build(table, m_pages.front());
+    return m_pages.front();
+}
+
+void RosterPageCache::Build(const ChannelUserTable& table, Page& page) const {
+    page.version = table.GetVersion();
+    page.entries.resize(m_rowsPerPage);
+    int first = page.index * m_rowsPerPage;
+    for (int i = 0; i < m_rowsPerPage; ++i) {
+        RosterEntry& entry = page.entries[i];
+        int row = first + i;
+        if (row < table.GetSize()) {
+            entry.user = table.GetUser(row);
+            entry.displayName = table.GetDisplayName(row);
+            entry.connected = table.Test(row, kUserConnected);
+        } else {
+            entry.user = kInvalidUserHandle;
+            entry.displayName.clear();
+            entry.connected = false;
+        }
+    }
+}
+
+size_t RosterPageCache::GetMemoryUsage() const {
+    size_t bytes = m_byIndex.size() * (sizeof(int) + sizeof(void*) * 2);
+    for (const Page& page : m_pages) {
+        bytes += sizeof(Page) + sizeof(void*) * 2;
+        bytes += page.entries.capacity() * sizeof(RosterEntry);
+        for (const RosterEntry& entry : page.entries) {
+            bytes += entry.displayName.capacity() > 15 ? entry.displayName.capacity() + 1 : 0;
+        }
+    }
+    return bytes;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <list>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "ChannelUserTable.h"
+
+// What a grid cell shows for one roster row
+struct RosterEntry {
+    UserHandle user;
+    std::string displayName;
+    bool connected;
+};
+
+// Materialized roster rows for the pages around the current one. The table
+// keeps only handles, ordering keys and flags for the whole audience; the
+// display strings live here for at most maxPages pages, least recently used
+// evicted first, so memory does not grow with the channel. A page built
+// against an older table version is rebuilt on its next Get.
+class RosterPageCache {
+public:
+    explicit RosterPageCache(int maxPages = 5);
+
+    // Build `page` and `window` pages on each side of it. A new page size
+    // drops everything built so far.
+    void Prefetch(const ChannelUserTable& table, int rowsPerPage, int page, int window);
+
+    // Row of the last prefetched page size; builds its page if needed.
+    // Invalidated by the next Prefetch or Get.
+    const RosterEntry& Get(const ChannelUserTable& table, int row);
+
+    void Clear();
+    int GetPageCount() const { return static_cast<int>(m_pages.size()); }
+    size_t GetMemoryUsage() const;
+
+private:
+    struct Page {
+        int index;
+        uint64_t version;
+        std::vector<RosterEntry> entries;
+    };
+
+    Page& Touch(const ChannelUserTable& table, int page);
+    void Build(const ChannelUserTable& table, Page& page) const;
+
+    int m_maxPages;
+    int m_rowsPerPage;
+    std::list<Page> m_pages;                                            // Most recently used first
+    std::unordered_map<int, std::list<Page>::iterator> m_byIndex;       // Page index -> m_pages
+};
@@ -0,0 +1,368 @@
+#include "pch.h"
+#include "ThumbnailMosaicWnd.h"
+#define LOG_CATEGORY LogCategory::Ui
+#include "Logger.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#endif
+
+#ifndef PW_RENDERFULLCONTENT
+#define PW_RENDERFULLCONTENT 0x00000002
+#endif
+
+#define IDC_THUMBNAIL_SLOT_BASE  2001
+
+static const int kSlotStripPadding = 4;
+static const int kBlankLevel = 16;          // Channels at or below this count as black
+
+IMPLEMENT_DYNAMIC(CThumbnailMosaicWnd, CWnd)
+
+BEGIN_MESSAGE_MAP(CThumbnailMosaicWnd, CWnd)
+    ON_WM_CREATE()
+    ON_WM_DESTROY()
+    ON_WM_PAINT()
+    ON_WM_ERASEBKGND()
+    ON_WM_SIZE()
+END_MESSAGE_MAP()
+
+CThumbnailMosaicWnd::CThumbnailMosaicWnd()
+{
+    m_grabBitmap = NULL;
+    m_grabBits = nullptr;
+
+    memset(&m_thumbnailInfo, 0, sizeof(m_thumbnailInfo));
+    m_thumbnailInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    m_thumbnailInfo.bmiHeader.biWidth = kThumbnailWidth;
+    m_thumbnailInfo.bmiHeader.biHeight = -kThumbnailHeight;    // Top-down
+    m_thumbnailInfo.bmiHeader.biPlanes = 1;
+    m_thumbnailInfo.bmiHeader.biBitCount = 32;
+    m_thumbnailInfo.bmiHeader.biCompression = BI_RGB;
+}
+
+CThumbnailMosaicWnd::~CThumbnailMosaicWnd()
+{
+}
+
+BOOL CThumbnailMosaicWnd::Create(CWnd* pParent, const CRect& rect, UINT nID)
+{
+    LPCTSTR className = AfxRegisterWndClass(CS_HREDRAW | CS_VREDRAW, ::LoadCursor(NULL, IDC_ARROW), NULL);
+    return CWnd::Create(className, _T(""), WS_CHILD | WS_CLIPCHILDREN, rect, pParent, nID);
+}
+
+int CThumbnailMosaicWnd::OnCreate(LPCREATESTRUCT lpCreateStruct)
+{
+    if (CWnd::OnCreate(lpCreateStruct) == -1)
+        return -1;
+
+    void* bits = nullptr;
+    m_grabBitmap = ::CreateDIBSection(NULL, &m_thumbnailInfo, DIB_RGB_COLORS, &bits, NULL, 0);
+    m_grabBits = static_cast<uint32_t*>(bits);
+    if (!m_grabBitmap)
+    {
+        LOG_ERROR("Thumbnail mosaic: failed to create the grab bitmap");
+    }
+    return 0;
+}
+
+void CThumbnailMosaicWnd::OnDestroy()
+{
+    SetSlotCount(0);
+    if (m_grabBitmap)
+    {
+        ::DeleteObject(m_grabBitmap);
+        m_grabBitmap = NULL;
+        m_grabBits = nullptr;
+    }
+    CWnd::OnDestroy();
+}
+
+void CThumbnailMosaicWnd::SetUsers(const std::vector<UserHandle>& users)
+{
+    m_users = users;
+    UpdateTiles();
+    if (GetSafeHwnd())
+    {
+        Invalidate(FALSE);
+    }
+}
+
+void CThumbnailMosaicWnd::SetSlotCount(int count)
+{
+    count = (std::max)(count, 0);
+    while (static_cast<int>(m_slotViews.size()) > count)
+    {
+        if (m_slotViews.back()->GetSafeHwnd())
+        {
+            m_slotViews.back()->DestroyWindow();
+        }
+        m_slotViews.pop_back();
+    }
+
+    // Plain black windows; the SDK draws into them
+    LPCTSTR className = AfxRegisterWndClass(0, ::LoadCursor(NULL, IDC_ARROW),
+        static_cast<HBRUSH>(::GetStockObject(BLACK_BRUSH)));
+    while (static_cast<int>(m_slotViews.size()) < count)
+    {
+        std::unique_ptr<CWnd> view(new CWnd());
+        UINT id = static_cast<UINT>(IDC_THUMBNAIL_SLOT_BASE + m_slotViews.size());
+        if (!view->Create(className, _T(""), WS_CHILD | WS_VISIBLE | WS_CLIPSIBLINGS,
+                CRect(0, 0, kThumbnailWidth, kThumbnailHeight), this, id))
+        {
+            LOG_ERROR_FMT("Thumbnail mosaic: failed to create capture slot {}", m_slotViews.size());
+            break;
+        }
+        m_slotViews.push_back(std::move(view));
+    }
+    m_slotUsers.resize(m_slotViews.size(), kInvalidUserHandle);
+
+    PositionSlotViews();
+}
+
+HWND CThumbnailMosaicWnd::GetSlotView(int slot) const
+{
+    if (slot < 0 || slot >= static_cast<int>(m_slotViews.size()))
+    {
+        return NULL;
+    }
+    return m_slotViews[slot]->GetSafeHwnd();
+}
+
+void CThumbnailMosaicWnd::SetSlotUser(int slot, UserHandle user)
+{
+    if (slot < 0 || slot >= static_cast<int>(m_slotUsers.size()))
+    {
+        return;
+    }
+    UserHandle previous = m_slotUsers[slot];
+    m_slotUsers[slot] = user;
+    InvalidateUser(previous);
+    InvalidateUser(user);
+}
+
+bool CThumbnailMosaicWnd::CaptureSlot(int slot, UserHandle user, int64_t nowMs)
+{
+    HWND view = GetSlotView(slot);
+    if (!view || !m_grabBitmap || user == kInvalidUserHandle)
+    {
+        return false;
+    }
+
+    // The slot view is thumbnail sized, so the grab needs no scaling
+    HDC memDC = ::CreateCompatibleDC(NULL);
+    HGDIOBJ oldBitmap = ::SelectObject(memDC, m_grabBitmap);
+    BOOL grabbed = ::PrintWindow(view, memDC, PW_RENDERFULLCONTENT);
+    if (!grabbed)
+    {
+        HDC viewDC = ::GetDC(view);
+        grabbed = ::BitBlt(memDC, 0, 0, kThumbnailWidth, kThumbnailHeight, viewDC, 0, 0, SRCCOPY);
+        ::ReleaseDC(view, viewDC);
+    }
+    ::GdiFlush();
+    ::SelectObject(memDC, oldBitmap);
+    ::DeleteDC(memDC);
+    if (!grabbed)
+    {
+        return false;
+    }
+
+    // A view the renderer has not drawn into yet is still the black background
+    const int pixelCount = kThumbnailWidth * kThumbnailHeight;
+    bool blank = true;
+    for (int i = 0; i < pixelCount && blank; i += 7)
+    {
+        uint32_t pixel = m_grabBits[i];
+        blank = ((pixel & 0xFF) <= kBlankLevel) && (((pixel >> 8) & 0xFF) <= kBlankLevel) &&
+                (((pixel >> 16) & 0xFF) <= kBlankLevel);
+    }
+    if (blank)
+    {
+        return false;
+    }
+
+    if (user >= m_thumbnails.size())
+    {
+        m_thumbnails.resize(user + 1);
+    }
+    if (!m_thumbnails[user])
+    {
+        m_thumbnails[user].reset(new Thumbnail());
+        m_thumbnails[user]->pixels.resize(pixelCount);
+    }
+    memcpy(m_thumbnails[user]->pixels.data(), m_grabBits, pixelCount * sizeof(uint32_t));
+    m_thumbnails[user]->capturedMs = nowMs;
+
+    InvalidateUser(user);
+    return true;
+}
+
+size_t CThumbnailMosaicWnd::GetThumbnailMemory() const
+{
+    size_t bytes = m_thumbnails.capacity() * sizeof(m_thumbnails[0]);
+    for (const auto& thumbnail : m_thumbnails)
+    {
+        if (thumbnail)
+        {
+            bytes += sizeof(Thumbnail) + thumbnail->pixels.capacity() * sizeof(uint32_t);
+        }
+    }
+    return bytes;
+}
+
+CRect CThumbnailMosaicWnd::GetMosaicRect() const
+{
+    CRect rect;
+    GetClientRect(&rect);
+    rect.bottom = (std::max)(rect.top, rect.bottom - (kThumbnailHeight + 2 * kSlotStripPadding));
+    return rect;
+}
+
+void CThumbnailMosaicWnd::UpdateTiles()
+{
+    std::fill(m_userTiles.begin(), m_userTiles.end(), -1);
+    for (int i = 0; i < static_cast<int>(m_users.size()); i++)
+    {
+        UserHandle user = m_users[i];
+        if (user >= m_userTiles.size())
+        {
+            m_userTiles.resize(user + 1, -1);
+        }
+        m_userTiles[user] = i;
+    }
+
+    if (!GetSafeHwnd())
+    {
+        return;
+    }
+    CRect mosaicRect = GetMosaicRect();
+    LayoutSpec spec = LayoutSpec::Auto(static_cast<int>(m_users.size()));
+    spec.gap = 1;
+    m_layout = LayoutEngine::Compute(spec,
+        LayoutRect(mosaicRect.left, mosaicRect.top, mosaicRect.right, mosaicRect.bottom));
+}
+
+void CThumbnailMosaicWnd::PositionSlotViews()
+{
+    if (!GetSafeHwnd())
+    {
+        return;
+    }
+    CRect client;
+    GetClientRect(&client);
+    int top = client.bottom - kThumbnailHeight - kSlotStripPadding;
+    int left = client.right;
+    for (size_t slot = m_slotViews.size(); slot-- > 0;)
+    {
+        left -= kThumbnailWidth + kSlotStripPadding;
+        m_slotViews[slot]->SetWindowPos(NULL, left, top, kThumbnailWidth, kThumbnailHeight,
+            SWP_NOZORDER | SWP_NOACTIVATE);
+    }
+}
+
+int CThumbnailMosaicWnd::GetUserTile(UserHandle user) const
+{
+    if (user == kInvalidUserHandle || user >= m_userTiles.size())
+    {
+        return -1;
+    }
+    int tile = m_userTiles[user];
+    return (tile >= 0 && tile < static_cast<int>(m_layout.tiles.size())) ? tile : -1;
+}
+
+void CThumbnailMosaicWnd::InvalidateUser(UserHandle user)
+{
+    int tile = GetUserTile(user);
+    if (tile < 0 || !GetSafeHwnd())
+    {
+        return;
+    }
+    const LayoutRect& rect = m_layout.tiles[tile].rect;
+    CRect tileRect(rect.left, rect.top, rect.right, rect.bottom);
+    InvalidateRect(&tileRect, FALSE);
+}
+
+void CThumbnailMosaicWnd::OnSize(UINT nType, int cx, int cy)
+{
+    CWnd::OnSize(nType, cx, cy);
+    UpdateTiles();
+    PositionSlotViews();
+    Invalidate(FALSE);
+}
+
+BOOL CThumbnailMosaicWnd::OnEraseBkgnd(CDC* pDC)
+{
+    return TRUE;    // Everything is painted in OnPaint
+}
+
+void CThumbnailMosaicWnd::OnPaint()
+{
+    CPaintDC dc(this);
+    CRect client;
+    GetClientRect(&client);
+
+    // Draw off screen; only tiles inside the update rect are painted
+    CDC memDC;
+    memDC.CreateCompatibleDC(&dc);
+    CBitmap canvas;
+    canvas.CreateCompatibleBitmap(&dc, client.Width(), client.Height());
+    CBitmap* oldBitmap = memDC.SelectObject(&canvas);
+    memDC.SetStretchBltMode(HALFTONE);
+    memDC.SetBkMode(TRANSPARENT);
+    memDC.SetTextColor(RGB(220, 220, 220));
+    CFont* oldFont = memDC.SelectObject(CFont::FromHandle(static_cast<HFONT>(::GetStockObject(DEFAULT_GUI_FONT))));
+
+    CRect updateRect = dc.m_ps.rcPaint;
+    memDC.FillSolidRect(client, RGB(16, 16, 16));
+
+    for (const LayoutTile& tile : m_layout.tiles)
+    {
+        CRect tileRect(tile.rect.left, tile.rect.top, tile.rect.right, tile.rect.bottom);
+        CRect visible;
+        if (tile.index >= static_cast<int>(m_users.size()) || !visible.IntersectRect(&tileRect, &updateRect))
+        {
+            continue;
+        }
+
+        UserHandle user = m_users[tile.index];
+        const Thumbnail* thumbnail = (user < m_thumbnails.size()) ? m_thumbnails[user].get() : nullptr;
+        if (thumbnail)
+        {
+            ::StretchDIBits(memDC.GetSafeHdc(), tileRect.left, tileRect.top, tileRect.Width(), tileRect.Height(),
+                0, 0, kThumbnailWidth, kThumbnailHeight, thumbnail->pixels.data(), &m_thumbnailInfo,
+                DIB_RGB_COLORS, SRCCOPY);
+        }
+        else
+        {
+            memDC.FillSolidRect(tileRect, RGB(48, 48, 48));
+        }
+
+        // Tiles being refreshed are outlined
+        if (std::find(m_slotUsers.begin(), m_slotUsers.end(), user) != m_slotUsers.end())
+        {
+            CBrush outline(RGB(0, 200, 0));
+            memDC.FrameRect(tileRect, &outline);
+        }
+
+        if (tileRect.Height() >= 16)
+        {
+            CString label(UserIdString(user).c_str());
+            CRect labelRect(tileRect.left + 2, tileRect.bottom - 14, tileRect.right - 2, tileRect.bottom);
+            memDC.DrawText(label, labelRect, DT_LEFT | DT_SINGLELINE | DT_END_ELLIPSIS | DT_NOPREFIX);
+        }
+    }
+
+    CRect mosaicRect = GetMosaicRect();
+    CString status;
+    status.Format(_T("Overview: %d users, %d capture slots"),
+        static_cast<int>(m_users.size()), static_cast<int>(m_slotViews.size()));
+    CRect statusRect(client.left + kSlotStripPadding, mosaicRect.bottom, client.right, client.bottom);
+    memDC.DrawText(status, statusRect, DT_LEFT | DT_VCENTER | DT_SINGLELINE | DT_NOPREFIX);
+
+    dc.BitBlt(updateRect.left, updateRect.top, updateRect.Width(), updateRect.Height(),
+        &memDC, updateRect.left, updateRect.top, SRCCOPY);
+
+    memDC.SelectObject(oldFont);
+    memDC.SelectObject(oldBitmap);
+}
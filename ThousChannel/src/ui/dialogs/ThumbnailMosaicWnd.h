@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "LayoutEngine.h"
+#include "../../core/UserIdInterner.h"
+
+// Overview of every user as a still thumbnail, drawn in one window without a
+// child window per tile. A strip at the bottom holds the capture slots: small
+// views a remote stream is rendered into until one frame has been grabbed
+// into the thumbnail store.
+class CThumbnailMosaicWnd : public CWnd
+{
+    DECLARE_DYNAMIC(CThumbnailMosaicWnd)
+
+public:
+    static const int kThumbnailWidth = 128;     // Also the capture slot size
+    static const int kThumbnailHeight = 72;
+
+    CThumbnailMosaicWnd();
+    virtual ~CThumbnailMosaicWnd();
+
+    BOOL Create(CWnd* pParent, const CRect& rect, UINT nID);
+
+    // Users in tile order
+    void SetUsers(const std::vector<UserHandle>& users);
+
+    // Capture slots; a slot's view is what the remote canvas renders into
+    void SetSlotCount(int count);
+    HWND GetSlotView(int slot) const;
+    void SetSlotUser(int slot, UserHandle user);
+
+    // Copy the slot view into the user's thumbnail. Returns false while the
+    // view is still blank (no frame rendered yet).
+    bool CaptureSlot(int slot, UserHandle user, int64_t nowMs);
+
+    size_t GetThumbnailMemory() const;
+
+protected:
+    DECLARE_MESSAGE_MAP()
+
+    afx_msg int OnCreate(LPCREATESTRUCT lpCreateStruct);
+    afx_msg void OnDestroy();
+    afx_msg void OnPaint();
+    afx_msg BOOL OnEraseBkgnd(CDC* pDC);
+    afx_msg void OnSize(UINT nType, int cx, int cy);
+
+private:
+    struct Thumbnail {
+        std::vector<uint32_t> pixels;   // kThumbnailWidth x kThumbnailHeight, top-down BGRA
+        int64_t capturedMs;
+    };
+
+    void UpdateTiles();
+    void PositionSlotViews();
+    CRect GetMosaicRect() const;
+    int GetUserTile(UserHandle user) const;
+    void InvalidateUser(UserHandle user);
+
+    std::vector<UserHandle> m_users;
+    std::vector<int> m_userTiles;                   // UserHandle -> tile index, -1 when not shown
+    Layout m_layout;
+    std::vector<std::unique_ptr<Thumbnail>> m_thumbnails;   // Indexed by UserHandle
+    std::vector<std::unique_ptr<CWnd>> m_slotViews;
+    std::vector<UserHandle> m_slotUsers;
+
+    // Grab target, reused for every capture
+    HBITMAP m_grabBitmap;
+    uint32_t* m_grabBits;
+    BITMAPINFO m_thumbnailInfo;
+};
@@ -0,0 +1,210 @@
+#include "pch.h"
+#include "ThumbnailScheduler.h"
+#include <algorithm>
+
+ThumbnailScheduler::ThumbnailScheduler(const ThumbnailSchedulerConfig& config)
+    : m_startTokens(0.0), m_lastTickMs(-1),
+      m_starts(0), m_captures(0), m_timeouts(0), m_refreshAgeSumMs(0.0), m_refreshAgeCount(0) {
+    SetConfig(config);
+}
+
+void ThumbnailScheduler::SetConfig(const ThumbnailSchedulerConfig& config) {
+    m_config = config;
+    m_config.slotCount = (std::max)(m_config.slotCount, 0);
+    m_config.maxStartsPerSecond = (std::max)(m_config.maxStartsPerSecond, 1);
+    m_config.activeBoost = (std::max)(m_config.activeBoost, 1.0);
+
+    // Slots beyond the new count are stopped by the next Tick
+    if (static_cast<int>(m_slots.size()) < m_config.slotCount) {
+        Slot slot = { kInvalidUserHandle, 0, false };
+        m_slots.resize(m_config.slotCount, slot);
+    }
+}
+
+ThumbnailScheduler::UserRecord& ThumbnailScheduler::Record(UserHandle user) {
+    if (user >= m_records.size()) {
+        UserRecord record = { false, -1, -1, -1, -1 };
+        m_records.resize(user + 1, record);
+    }
+    return m_records[user];
+}
+
+void ThumbnailScheduler::SetUsers(const std::vector<UserHandle>& users) {
+    for (UserHandle user : m_users) {
+        m_records[user].listed = false;
+    }
+    m_users.clear();
+    for (UserHandle user : users) {
+        if (user == kInvalidUserHandle) {
+            continue;
+        }
+        UserRecord& record = Record(user);
+        if (!record.listed) {
+            record.listed = true;
+            m_users.push_back(user);
+        }
+    }
+}
+
+void ThumbnailScheduler::MarkActive(UserHandle user, int64_t nowMs) {
+    if (user != kInvalidUserHandle) {
+        Record(user).lastActiveMs = nowMs;
+    }
+}
+
+void ThumbnailScheduler::OnFrameCaptured(UserHandle user, int64_t nowMs) {
+    if (user == kInvalidUserHandle || user >= m_records.size()) {
+        return;
+    }
+    UserRecord& record = m_records[user];
+    if (record.slot < 0 || m_slots[record.slot].captured) {
+        return;
+    }
+
+    if (record.lastCaptureMs >= 0) {
+        m_refreshAgeSumMs += static_cast<double>(nowMs - record.lastCaptureMs);
+        ++m_refreshAgeCount;
+    }
+    record.lastCaptureMs = nowMs;
+    m_slots[record.slot].captured = true;
+    ++m_captures;
+}
+
+// Time since the last attempt, scaled up for recently active users. Users
+// never attempted come first, in roster order.
+double ThumbnailScheduler::Priority(const UserRecord& record, int64_t nowMs) const {
+    bool active = record.lastActiveMs >= 0 && nowMs - record.lastActiveMs <= m_config.activeWindowMs;
+    double boost = active ? m_config.activeBoost : 1.0;
+    if (record.lastStartMs < 0) {
+        return 1e18 * boost;
+    }
+    // Changed since the last attempt: due now, ahead of users of the same age
+    double age = static_cast<double>(nowMs - record.lastStartMs);
+    if (record.lastActiveMs > record.lastStartMs) {
+        age += m_config.refreshIntervalMs;
+    }
+    return age * boost;
+}
+
+void ThumbnailScheduler::Release(int slot, std::vector<ThumbnailAction>& actions) {
+    Slot& entry = m_slots[slot];
+    ThumbnailAction action = { ThumbnailActionType::Stop, slot, entry.user };
+    actions.push_back(action);
+    if (entry.user < m_records.size()) {
+        m_records[entry.user].slot = -1;
+    }
+    entry.user = kInvalidUserHandle;
+    entry.captured = false;
+}
+
+void ThumbnailScheduler::Tick(int64_t nowMs, std::vector<ThumbnailAction>& actions) {
+    // Release captured, timed-out, removed and surplus slots; ask busy ones for a grab
+    for (int slot = 0; slot < static_cast<int>(m_slots.size()); ++slot) {
+        Slot& entry = m_slots[slot];
+        if (entry.user == kInvalidUserHandle) {
+            continue;
+        }
+        bool timedOut = !entry.captured && nowMs - entry.startedMs >= m_config.captureTimeoutMs;
+        if (entry.captured || timedOut || !m_records[entry.user].listed || slot >= m_config.slotCount) {
+            if (timedOut) {
+                ++m_timeouts;
+            }
+            Release(slot, actions);
+            continue;
+        }
+        if (nowMs - entry.startedMs >= m_config.grabDelayMs) {
+            ThumbnailAction action = { ThumbnailActionType::Grab, slot, entry.user };
+            actions.push_back(action);
+        }
+    }
+    if (m_slots.size() > static_cast<size_t>(m_config.slotCount)) {
+        m_slots.resize(m_config.slotCount);
+    }
+
+    // Token bucket: maxStartsPerSecond, bursts up to one start per slot
+    double perMs = m_config.maxStartsPerSecond / 1000.0;
+    if (m_lastTickMs >= 0) {
+        m_startTokens += static_cast<double>(nowMs - m_lastTickMs) * perMs;
+    } else {
+        m_startTokens = static_cast<double>(m_config.slotCount);
+    }
+    m_startTokens = (std::min)(m_startTokens, static_cast<double>((std::max)(m_config.slotCount, 1)));
+    m_lastTickMs = nowMs;
+
+    std::vector<int> freeSlots;
+    for (int slot = 0; slot < static_cast<int>(m_slots.size()); ++slot) {
+        if (m_slots[slot].user == kInvalidUserHandle) {
+            freeSlots.push_back(slot);
+        }
+    }
+    int starts = (std::min)(static_cast<int>(freeSlots.size()), static_cast<int>(m_startTokens));
+    if (starts <= 0) {
+        return;
+    }
+
+    // Users due for a refresh, stalest first
+    struct Candidate { double priority; int order; UserHandle user; };
+    std::vector<Candidate> candidates;
+    for (int i = 0; i < static_cast<int>(m_users.size()); ++i) {
+        const UserRecord& record = m_records[m_users[i]];
+        if (record.slot >= 0) {
+            continue;
+        }
+        double priority = Priority(record, nowMs);
+        if (priority >= m_config.refreshIntervalMs) {
+            Candidate candidate = { priority, i, m_users[i] };
+            candidates.push_back(candidate);
+        }
+    }
+    starts = (std::min)(starts, static_cast<int>(candidates.size()));
+    auto byPriority = [](const Candidate& a, const Candidate& b) {
+        return a.priority != b.priority ? a.priority > b.priority : a.order < b.order;
+    };
+    std::partial_sort(candidates.begin(), candidates.begin() + starts, candidates.end(), byPriority);
+
+    for (int i = 0; i < starts; ++i) {
+        int slot = freeSlots[i];
+        Slot& entry = m_slots[slot];
+        entry.user = candidates[i].user;
+        entry.startedMs = nowMs;
+        entry.captured = false;
+        m_records[entry.user].slot = slot;
+        m_records[entry.user].lastStartMs = nowMs;
+        m_startTokens -= 1.0;
+        ++m_starts;
+
+        ThumbnailAction action = { ThumbnailActionType::Start, slot, entry.user };
+        actions.push_back(action);
+    }
+}
+
+void ThumbnailScheduler::StopAll(std::vector<ThumbnailAction>& actions) {
+    for (int slot = 0; slot < static_cast<int>(m_slots.size()); ++slot) {
+        if (m_slots[slot].user != kInvalidUserHandle) {
+            Release(slot, actions);
+        }
+    }
+}
+
+int64_t ThumbnailScheduler::GetLastCaptureMs(UserHandle user) const {
+    return user < m_records.size() ? m_records[user].lastCaptureMs : -1;
+}
+
+int ThumbnailScheduler::GetBusySlots() const {
+    int busy = 0;
+    for (const Slot& slot : m_slots) {
+        if (slot.user != kInvalidUserHandle) {
+            ++busy;
+        }
+    }
+    return busy;
+}
+
+ThumbnailSchedulerStats ThumbnailScheduler::GetStats() const {
+    ThumbnailSchedulerStats stats;
+    stats.starts = m_starts;
+    stats.captures = m_captures;
+    stats.timeouts = m_timeouts;
+    stats.meanRefreshAgeMs = m_refreshAgeCount ? m_refreshAgeSumMs / m_refreshAgeCount : 0.0;
+    return stats;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "../../core/UserIdInterner.h"
+
+// Cost bounds of the overview mosaic. At most slotCount streams are decoded at
+// any time and at most maxStartsPerSecond subscriptions are opened per second,
+// whatever the number of users.
+struct ThumbnailSchedulerConfig {
+    int slotCount;              // Concurrent subscriptions
+    int maxStartsPerSecond;     // Subscribe rate
+    int refreshIntervalMs;      // A thumbnail younger than this is not refreshed
+    int grabDelayMs;            // Time from subscribe to the first grab attempt
+    int captureTimeoutMs;       // A slot without a frame after this is released
+    int activeWindowMs;         // Activity this recent favours a user
+    double activeBoost;         // Age multiplier of recently active users
+
+    ThumbnailSchedulerConfig()
+        : slotCount(4), maxStartsPerSecond(8), refreshIntervalMs(5000), grabDelayMs(400),
+          captureTimeoutMs(2500), activeWindowMs(10000), activeBoost(4.0) {
+    }
+};
+
+enum class ThumbnailActionType {
+    Start,      // Subscribe `user` and render it into `slot`
+    Grab,       // Try to grab a frame of `user` from `slot`, report with OnFrameCaptured
+    Stop        // Unsubscribe `user` and free `slot`
+};
+
+struct ThumbnailAction {
+    ThumbnailActionType type;
+    int slot;
+    UserHandle user;
+};
+
+struct ThumbnailSchedulerStats {
+    uint64_t starts;
+    uint64_t captures;
+    uint64_t timeouts;
+    double meanRefreshAgeMs;    // Age of the replaced thumbnail, averaged over captures
+};
+
+// Time-multiplexes a few subscription slots over many users. Every Tick
+// releases finished or timed-out slots and fills free ones with the users
+// whose thumbnail is stalest, where recently active users age faster. The
+// caller performs the actions; nothing here touches the SDK or a window.
+class ThumbnailScheduler {
+public:
+    explicit ThumbnailScheduler(const ThumbnailSchedulerConfig& config = ThumbnailSchedulerConfig());
+
+    void SetConfig(const ThumbnailSchedulerConfig& config);
+    const ThumbnailSchedulerConfig& GetConfig() const { return m_config; }
+
+    // Users that get thumbnails. Users that leave lose their slot on the next Tick;
+    // capture history is kept, so a returning user is not refreshed early.
+    void SetUsers(const std::vector<UserHandle>& users);
+
+    // Speaking, video started or stopped, joined
+    void MarkActive(UserHandle user, int64_t nowMs);
+
+    // A Grab succeeded; the slot is released on the next Tick
+    void OnFrameCaptured(UserHandle user, int64_t nowMs);
+
+    void Tick(int64_t nowMs, std::vector<ThumbnailAction>& actions);
+
+    // Stop every busy slot, for leaving the mosaic
+    void StopAll(std::vector<ThumbnailAction>& actions);
+
+    // -1 before the first capture
+    int64_t GetLastCaptureMs(UserHandle user) const;
+    int GetBusySlots() const;
+    ThumbnailSchedulerStats GetStats() const;
+
+private:
+    struct UserRecord {
+        bool listed;
+        int slot;               // -1 when not being captured
+        int64_t lastStartMs;    // -1 before the first subscribe
+        int64_t lastCaptureMs;  // -1 before the first capture
+        int64_t lastActiveMs;   // -1 when never active
+    };
+
+    struct Slot {
+        UserHandle user;        // kInvalidUserHandle when free
+        int64_t startedMs;
+        bool captured;
+    };
+
+    UserRecord& Record(UserHandle user);
+    double Priority(const UserRecord& record, int64_t nowMs) const;
+    void Release(int slot, std::vector<ThumbnailAction>& actions);
+
+    ThumbnailSchedulerConfig m_config;
+    std::vector<UserHandle> m_users;
+    std::vector<UserRecord> m_records;      // Indexed by UserHandle
+    std::vector<Slot> m_slots;
+
+    double m_startTokens;                   // Rate limit bucket, refilled per ms
+    int64_t m_lastTickMs;                   // -1 before the first Tick
+
+    uint64_t m_starts;
+    uint64_t m_captures;
+    uint64_t m_timeouts;
+    double m_refreshAgeSumMs;
+    uint64_t m_refreshAgeCount;
+};
@@ -0,0 +1,171 @@
+#include "pch.h"
+#include "VirtualWall.h"
+#include <algorithm>
+#include <cmath>
+
+static const int kVelocitySampleGapMs = 100;   // Samples further apart start a new estimate
+
+VirtualWall::VirtualWall()
+    : m_bandHeight(1), m_viewportHeight(0), m_overscanBands(0), m_itemCount(0), m_offset(0),
+      m_maxLiveVelocity(1000.0), m_settleMs(150), m_velocity(0.0), m_lastScrollMs(-1) {
+}
+
+void VirtualWall::SetGeometry(const std::vector<LayoutRect>& bandTiles, int bandHeight, int viewportHeight, int overscanBands) {
+    m_bandTiles = bandTiles;
+    m_bandHeight = (std::max)(bandHeight, 1);
+    m_viewportHeight = (std::max)(viewportHeight, 0);
+    m_overscanBands = (std::max)(overscanBands, 0);
+    m_offset = (std::min)(m_offset, GetMaxOffset());
+}
+
+void VirtualWall::SetItemCount(int count) {
+    m_itemCount = (std::max)(count, 0);
+    m_offset = (std::min)(m_offset, GetMaxOffset());
+}
+
+void VirtualWall::SetSettlePolicy(double maxLiveVelocity, int settleMs) {
+    m_maxLiveVelocity = maxLiveVelocity;
+    m_settleMs = settleMs;
+}
+
+int VirtualWall::GetContentHeight() const {
+    int itemsPerBand = GetItemsPerBand();
+    if (itemsPerBand == 0) {
+        return 0;
+    }
+    int bands = (m_itemCount + itemsPerBand - 1) / itemsPerBand;
+    return bands * m_bandHeight;
+}
+
+int VirtualWall::GetMaxOffset() const {
+    return (std::max)(GetContentHeight() - m_viewportHeight, 0);
+}
+
+bool VirtualWall::ScrollTo(int offset, int64_t nowMs) {
+    offset = (std::max)(0, (std::min)(offset, GetMaxOffset()));
+    if (offset == m_offset) {
+        return false;
+    }
+
+    // Exponentially smoothed; a pause longer than the sample gap restarts the estimate
+    int64_t elapsed = (m_lastScrollMs < 0) ? kVelocitySampleGapMs + 1 : nowMs - m_lastScrollMs;
+    double sample = (offset - m_offset) * 1000.0 / static_cast<double>((std::max)(elapsed, int64_t(1)));
+    if (elapsed > kVelocitySampleGapMs) {
+        m_velocity = (elapsed > m_settleMs) ? 0.0 : sample;
+    } else {
+        m_velocity = 0.6 * sample + 0.4 * m_velocity;
+    }
+
+    m_offset = offset;
+    m_lastScrollMs = nowMs;
+    return true;
+}
+
+bool VirtualWall::ScrollBy(int delta, int64_t nowMs) {
+    return ScrollTo(m_offset + delta, nowMs);
+}
+
+WallRange VirtualWall::GetVisibleRange() const {
+    int itemsPerBand = GetItemsPerBand();
+    if (itemsPerBand == 0 || m_itemCount == 0 || m_viewportHeight == 0) {
+        return WallRange();
+    }
+    int firstBand = m_offset / m_bandHeight;
+    int endBand = (m_offset + m_viewportHeight + m_bandHeight - 1) / m_bandHeight;
+    return WallRange((std::min)(firstBand * itemsPerBand, m_itemCount), (std::min)(endBand * itemsPerBand, m_itemCount));
+}
+
+WallRange VirtualWall::GetLiveRange() const {
+    int itemsPerBand = GetItemsPerBand();
+    if (itemsPerBand == 0 || m_itemCount == 0 || m_viewportHeight == 0) {
+        return WallRange();
+    }
+    int firstBand = (std::max)(m_offset / m_bandHeight - m_overscanBands, 0);
+    int endBand = (m_offset + m_viewportHeight + m_bandHeight - 1) / m_bandHeight + m_overscanBands;
+    return WallRange((std::min)(firstBand * itemsPerBand, m_itemCount), (std::min)(endBand * itemsPerBand, m_itemCount));
+}
+
+int VirtualWall::GetCellCapacity() const {
+    // A viewport cuts at most ceil(viewport / band) + 1 bands
+    int visibleBands = (m_viewportHeight + m_bandHeight - 1) / m_bandHeight + 1;
+    return (visibleBands + 2 * m_overscanBands) * GetItemsPerBand();
+}
+
+LayoutRect VirtualWall::GetItemRect(int item) const {
+    int itemsPerBand = GetItemsPerBand();
+    if (itemsPerBand == 0 || item < 0) {
+        return LayoutRect();
+    }
+    int bandTop = (item / itemsPerBand) * m_bandHeight - m_offset;
+    LayoutRect rect = m_bandTiles[item % itemsPerBand];
+    rect.top += bandTop;
+    rect.bottom += bandTop;
+    return rect;
+}
+
+double VirtualWall::GetVelocity(int64_t nowMs) const {
+    if (m_lastScrollMs < 0 || nowMs - m_lastScrollMs >= m_settleMs) {
+        return 0.0;
+    }
+    return m_velocity;
+}
+
+bool VirtualWall::IsSettled(int64_t nowMs) const {
+    return std::fabs(GetVelocity(nowMs)) <= m_maxLiveVelocity;
+}
+
+void VirtualWall::AssignCells(std::vector<int>& cellItems, std::vector<int>& rebound, bool reset) const {
+    WallRange live = GetLiveRange();
+    std::vector<int> previous = cellItems;
+
+    // Which live items already have a cell; the range is at most the pool size
+    std::vector<char> hasCell(live.Count(), 0);
+    std::vector<int> freeCells;
+    for (int cell = 0; cell < static_cast<int>(cellItems.size()); ++cell) {
+        int item = cellItems[cell];
+        if (!reset && live.Contains(item) && !hasCell[item - live.first]) {
+            hasCell[item - live.first] = 1;
+            continue;
+        }
+        cellItems[cell] = -1;
+        freeCells.push_back(cell);
+    }
+
+    // Hand free cells to the items that entered, lowest cell first
+    std::reverse(freeCells.begin(), freeCells.end());
+    for (int item = live.first; item < live.end && !freeCells.empty(); ++item) {
+        if (hasCell[item - live.first]) {
+            continue;
+        }
+        cellItems[freeCells.back()] = item;
+        freeCells.pop_back();
+    }
+
+    for (int cell = 0; cell < static_cast<int>(cellItems.size()); ++cell) {
+        if (reset || cellItems[cell] != previous[cell]) {
+            rebound.push_back(cell);
+        }
+    }
+}
+
+void VirtualWall::BandFromLayout(const Layout& layout, const LayoutRect& container,
+                                 std::vector<LayoutRect>& bandTiles, int& bandHeight) {
+    bandTiles.clear();
+    bandHeight = (std::max)(container.Height(), 1);
+
+    bool stage = std::any_of(layout.tiles.begin(), layout.tiles.end(),
+        [](const LayoutTile& tile) { return tile.large; });
+    int tilesPerBand = stage ? static_cast<int>(layout.tiles.size())
+                             : (std::min)(layout.columns, static_cast<int>(layout.tiles.size()));
+    if (!stage && layout.rows > 1) {
+        bandHeight = (std::max)(container.Height() / layout.rows, 1);
+    }
+
+    // Tiles are sorted by index, so the first band is the first tilesPerBand tiles
+    for (int i = 0; i < tilesPerBand; ++i) {
+        LayoutRect rect = layout.tiles[i].rect;
+        rect.top -= container.top;
+        rect.bottom -= container.top;
+        bandTiles.push_back(rect);
+    }
+}
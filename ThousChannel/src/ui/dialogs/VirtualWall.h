@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "LayoutEngine.h"
+
+// Half-open range of item (user row) indices
+struct WallRange {
+    int first;
+    int end;
+
+    WallRange() : first(0), end(0) {}
+    WallRange(int f, int e) : first(f), end(e) {}
+
+    int Count() const { return end > first ? end - first : 0; }
+    bool Contains(int item) const { return item >= first && item < end; }
+    bool operator==(const WallRange& other) const { return first == other.first && end == other.end; }
+    bool operator!=(const WallRange& other) const { return !(*this == other); }
+};
+
+// Continuous-scroll wall over a long item list. Items are laid out in bands:
+// every band holds the same tiles (a grid row, or a whole stage layout) and
+// has a fixed height, so the visible range follows from the scroll offset in
+// O(1). Only the live range (visible bands plus overscan) gets cells; cells
+// that scroll out are handed to the items scrolling in.
+//
+// The wall also tracks scroll velocity. While it is not settled (a fast
+// fling, or a jump that has just happened) callers keep cells on their
+// placeholder and attach live streams once IsSettled returns true.
+class VirtualWall {
+public:
+    VirtualWall();
+
+    // `bandTiles` are the tile rects of one band relative to the band top
+    void SetGeometry(const std::vector<LayoutRect>& bandTiles, int bandHeight, int viewportHeight, int overscanBands);
+    void SetItemCount(int count);
+
+    // Streams attach while scrolling slower than `maxLiveVelocity` (pixels per
+    // second) or once no scroll happened for `settleMs`
+    void SetSettlePolicy(double maxLiveVelocity, int settleMs);
+
+    int GetItemCount() const { return m_itemCount; }
+    int GetItemsPerBand() const { return static_cast<int>(m_bandTiles.size()); }
+    int GetBandHeight() const { return m_bandHeight; }
+    int GetViewportHeight() const { return m_viewportHeight; }
+    int GetContentHeight() const;
+    int GetMaxOffset() const;
+    int GetOffset() const { return m_offset; }
+
+    // Clamp and apply the offset; `nowMs` feeds the velocity estimate.
+    // Return true when the offset changed.
+    bool ScrollTo(int offset, int64_t nowMs);
+    bool ScrollBy(int delta, int64_t nowMs);
+
+    // Items of the bands that intersect the viewport
+    WallRange GetVisibleRange() const;
+    // Visible items plus `overscanBands` on each side: the items that hold cells
+    WallRange GetLiveRange() const;
+    // Upper bound of GetLiveRange().Count() for any offset, the cell pool size
+    int GetCellCapacity() const;
+
+    // Item rect relative to the viewport top at the current offset
+    LayoutRect GetItemRect(int item) const;
+
+    // Pixels per second, 0 once the wall has been idle for the settle delay
+    double GetVelocity(int64_t nowMs) const;
+    bool IsSettled(int64_t nowMs) const;
+
+    // Recycle cells for the current live range. `cellItems[cell]` is the item
+    // shown by the cell or -1; cells whose item left the live range are reused
+    // for items that entered it. Cells whose item changed are appended to
+    // `rebound`. With `reset` every cell is released first (item order changed).
+    void AssignCells(std::vector<int>& cellItems, std::vector<int>& rebound, bool reset) const;
+
+    // One band of `layout`: the whole layout when it has large tiles, else its first row
+    static void BandFromLayout(const Layout& layout, const LayoutRect& container,
+                               std::vector<LayoutRect>& bandTiles, int& bandHeight);
+
+private:
+    std::vector<LayoutRect> m_bandTiles;
+    int m_bandHeight;
+    int m_viewportHeight;
+    int m_overscanBands;
+    int m_itemCount;
+    int m_offset;
+
+    double m_maxLiveVelocity;
+    int m_settleMs;
+    double m_velocity;          // Smoothed, pixels per second
+    int64_t m_lastScrollMs;     // -1 before the first scroll
+};
@@ -0,0 +1,166 @@
+#include "TestHarness.h"
+#include "ChannelUserTable.h"
+
+#include <vector>
+
+namespace {
+
+// Every row must be found at its own index
+bool FindMatchesRows(const ChannelUserTable& table) {
+    for (int row = 0; row < table.GetSize(); ++row) {
+        UserHandle user = table.GetUser(row);
+        if (user != kInvalidUserHandle && table.Find(user) != row) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int BruteCount(const ChannelUserTable& table, ChannelUserFlags required, ChannelUserFlags excluded,
+               int firstRow, int endRow, std::vector<int>* rows = nullptr) {
+    int count = 0;
+    for (int row = firstRow; row < endRow; ++row) {
+        ChannelUserFlags flags = table.GetFlags(row);
+        if ((flags & required) == required && (flags & excluded) == 0) {
+            ++count;
+            if (rows) {
+                rows->push_back(row);
+            }
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+TEST_CASE(ChannelUserTable, AddSetsFlagsAndGrows) {
+    ChannelUserTable table;
+    for (int i = 0; i < 200; ++i) {
+        ChannelUserFlags flags = (i % 2) ? kNewRemoteUserFlags : UserFlag(kUserRobot);
+        CHECK_EQ(table.Add(static_cast<UserHandle>(i + 1), flags), i);
+    }
+    CHECK_EQ(table.GetSize(), 200);
+    CHECK_EQ(table.GetFlags(0), UserFlag(kUserRobot));
+    CHECK_EQ(table.GetFlags(199), kNewRemoteUserFlags);
+    CHECK(table.Test(199, kUserConnected));
+    CHECK(!table.Test(198, kUserConnected));
+    CHECK(FindMatchesRows(table));
+}
+
+TEST_CASE(ChannelUserTable, InsertAndRemoveKeepFindConsistent) {
+    ChannelUserTable table;
+    for (int i = 0; i < 100; ++i) {
+        table.Add(static_cast<UserHandle>(i + 1), kNewRemoteUserFlags);
+    }
+    table.InsertAt(0, 1000, UserFlag(kUserLocal));
+    table.InsertAt(50, 1001, 0);
+    CHECK_EQ(table.Find(1000), 0);
+    CHECK_EQ(table.Find(1001), 50);
+    CHECK_EQ(table.Find(1), 1);
+    CHECK(table.Test(0, kUserLocal));
+    CHECK(!table.Test(1, kUserLocal));
+
+    table.RemoveAt(0);
+    CHECK_EQ(table.Find(1000), -1);
+    CHECK_EQ(table.Find(1), 0);
+    CHECK_EQ(table.Find(1001), 49);
+    CHECK_EQ(table.GetSize(), 101);
+    CHECK(FindMatchesRows(table));
+
+    table.RemoveAll();
+    CHECK_EQ(table.GetSize(), 0);
+    CHECK_EQ(table.Find(1), -1);
+    CHECK_EQ(table.Count(0), 0);
+}
+
+TEST_CASE(ChannelUserTable, RepeatedInsertAtOneSpotRenumbersKeys) {
+    // Inserting at the same place halves the key gap each time; after about
+    // ten inserts the table has to renumber, and Find must still hold
+    ChannelUserTable table;
+    table.Add(1, 0);
+    table.Add(2, 0);
+    for (int i = 0; i < 500; ++i) {
+        table.InsertAt(1, static_cast<UserHandle>(100 + i), 0);
+    }
+    CHECK_EQ(table.GetSize(), 502);
+    CHECK_EQ(table.Find(1), 0);
+    CHECK_EQ(table.Find(2), 501);
+    CHECK_EQ(table.Find(599), 1);
+    CHECK_EQ(table.Find(100), 500);
+    CHECK(FindMatchesRows(table));
+}
+
+TEST_CASE(ChannelUserTable, PlaceholdersAreNotIndexed) {
+    ChannelUserTable table;
+    table.Add(5, kNewRemoteUserFlags);
+    table.Add(kInvalidUserHandle, 0);
+    CHECK_EQ(table.Find(kInvalidUserHandle), -1);
+    table.SetUser(1, 6);
+    CHECK_EQ(table.Find(6), 1);
+    table.SetUser(0, kInvalidUserHandle);
+    CHECK_EQ(table.Find(5), -1);
+    CHECK_EQ(table.GetDisplayName(0), std::string("-1"));
+}
+
+TEST_CASE(ChannelUserTable, CountAndSelectMatchBruteForce) {
+    ChannelUserTable table;
+    for (int i = 0; i < 333; ++i) {
+        ChannelUserFlags flags = 0;
+        if (i % 2 == 0) flags |= UserFlag(kUserConnected);
+        if (i % 3 == 0) flags |= UserFlag(kUserVideoOn);
+        if (i % 5 == 0) flags |= UserFlag(kUserVisible);
+        table.Add(static_cast<UserHandle>(i + 1), flags);
+    }
+
+    const ChannelUserFlags required = UserFlag(kUserConnected) | UserFlag(kUserVideoOn);
+    const ChannelUserFlags excluded = UserFlag(kUserVisible);
+    CHECK_EQ(table.Count(required), BruteCount(table, required, 0, 0, table.GetSize()));
+    CHECK_EQ(table.Count(required, excluded), BruteCount(table, required, excluded, 0, table.GetSize()));
+
+    // Ranges inside one word, across word boundaries and past the end
+    const int ranges[][2] = { { 0, 64 }, { 3, 17 }, { 60, 70 }, { 63, 129 }, { 100, 333 }, { 320, 400 }, { 50, 50 } };
+    for (const auto& range : ranges) {
+        int endRow = range[1] < table.GetSize() ? range[1] : table.GetSize();
+        std::vector<int> expected;
+        int expectedCount = BruteCount(table, required, excluded, range[0], endRow, &expected);
+        CHECK_EQ(table.Count(required, excluded, range[0], range[1]), expectedCount);
+
+        std::vector<int> rows;
+        table.Select(required, excluded, range[0], range[1], rows);
+        CHECK(rows == expected);
+    }
+}
+
+TEST_CASE(ChannelUserTable, RemoveClearsTheVacatedRow) {
+    ChannelUserTable table;
+    table.Add(1, UserFlag(kUserConnected));
+    table.Add(2, UserFlag(kUserConnected));
+    table.RemoveAt(0);
+    CHECK_EQ(table.Count(UserFlag(kUserConnected)), 1);
+    CHECK_EQ(table.Count(UserFlag(kUserConnected), 0, 0, 64), 1);
+    table.Add(3, 0);
+    CHECK(!table.Test(1, kUserConnected));
+}
+
+TEST_CASE(ChannelUserTable, VersionChangesOnEdits) {
+    ChannelUserTable table;
+    uint64_t version = table.GetVersion();
+    table.Add(1, 0);
+    CHECK(table.GetVersion() != version);
+    version = table.GetVersion();
+    table.Set(0, kUserVisible, true);
+    CHECK(table.GetVersion() != version);
+}
+
+TEST_CASE(ChannelUserTable, LastVisiblePageHoldsLargePages) {
+    // 2M users in 25-tile pages reach page 80000
+    ChannelUserTable table;
+    table.Add(1, 0);
+    table.Add(2, 0);
+    table.SetLastVisiblePage(0, 80000);
+    table.SetLastVisiblePage(1, 65536);
+    table.InsertAt(0, 3, 0);
+    CHECK_EQ(table.GetLastVisiblePage(0), 0);
+    CHECK_EQ(table.GetLastVisiblePage(1), 80000);
+    CHECK_EQ(table.GetLastVisiblePage(2), 65536);
+}
@@ -0,0 +1,174 @@
+#include "TestHarness.h"
+#include "FlightRecorder.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The recorder is process-wide: each case records under its own event name
+// and only looks at those lines of the dump.
+
+namespace {
+
+std::string TestDirectory(const char* name) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "thouschannel_tests" / name;
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+    std::filesystem::create_directories(directory, error);
+    return directory.string();
+}
+
+std::vector<std::string> DumpFiles(const std::string& directory) {
+    std::vector<std::string> paths;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        paths.push_back(entry.path().string());
+    }
+    return paths;
+}
+
+// `a` of every event named `name`, in dump order
+std::vector<long long> DumpedValues(const std::string& path, const std::string& name) {
+    std::vector<long long> values;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        // "-  0.000500  <thread>  <kind>  <name> <a> <b>"; the age has spaces in it
+        size_t at = line.find(" " + name + " ");
+        if (at == std::string::npos) {
+            continue;
+        }
+        std::istringstream fields(line.substr(at + name.size() + 2));
+        long long a = 0;
+        if (fields >> a) {
+            values.push_back(a);
+        }
+    }
+    return values;
+}
+
+// Dump into a fresh directory and return the file
+std::string DumpTo(const char* directoryName, const char* reason) {
+    std::string directory = TestDirectory(directoryName);
+    FlightRecorder::Instance().SetDumpDirectory(directory);
+    CHECK(FlightRecorder::Instance().Dump(reason));
+    std::vector<std::string> files = DumpFiles(directory);
+    CHECK_EQ(files.size(), 1u);
+    return files.empty() ? std::string() : files.front();
+}
+
+} // namespace
+
+TEST_CASE(FlightRecorder, FullRingDropsTheOldestSlot) {
+    const int recorded = FlightRecorder::kEventsPerThread + 10;
+    std::thread recorder([recorded]() {
+        for (int i = 0; i < recorded; ++i) {
+            FlightRecorder::Record(FlightEventKind::SdkCallback, "ring_wrap", i);
+        }
+    });
+    recorder.join();
+
+    std::vector<long long> values = DumpedValues(DumpTo("flight_wrap", "wrap"), "ring_wrap");
+
+    // The slot a writer could be overwriting is left out, so one less than a ring
+    CHECK_EQ(values.size(), static_cast<size_t>(FlightRecorder::kEventsPerThread - 1));
+    if (!values.empty()) {
+        CHECK_EQ(values.front(), static_cast<long long>(recorded - FlightRecorder::kEventsPerThread + 1));
+        CHECK_EQ(values.back(), static_cast<long long>(recorded - 1));
+    }
+    for (size_t i = 1; i < values.size(); ++i) {
+        CHECK_EQ(values[i], values[i - 1] + 1);
+    }
+}
+
+TEST_CASE(FlightRecorder, ExitedThreadsRingIsReused) {
+    // More threads than rings, one after another: each must find a ring
+    const int threadCount = FlightRecorder::kMaxThreads * 2;
+    for (int i = 0; i < threadCount; ++i) {
+        std::thread recorder([i]() {
+            FlightRecorder::Record(FlightEventKind::SdkCallback, "ring_reuse", i);
+        });
+        recorder.join();
+    }
+
+    std::vector<long long> values = DumpedValues(DumpTo("flight_reuse", "reuse"), "ring_reuse");
+    CHECK(!values.empty());
+    if (!values.empty()) {
+        CHECK_EQ(values.back(), static_cast<long long>(threadCount - 1));
+    }
+}
+
+TEST_CASE(FlightRecorder, DumpMergesThreadsByTime) {
+    // Two threads take turns, so their events interleave in time
+    const int turns = 200;
+    std::mutex mutex;
+    std::condition_variable cv;
+    int turn = 0;
+    auto player = [&](int parity) {
+        for (int i = parity; i < turns; i += 2) {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&]() { return turn == i; });
+            // Keep consecutive events in distinct microseconds
+            std::this_thread::sleep_for(std::chrono::microseconds(20));
+            FlightRecorder::Record(FlightEventKind::TaskStart, "merge_order", i);
+            ++turn;
+            cv.notify_all();
+        }
+    };
+    std::thread even(player, 0);
+    std::thread odd(player, 1);
+    even.join();
+    odd.join();
+
+    std::vector<long long> values = DumpedValues(DumpTo("flight_merge", "merge"), "merge_order");
+    std::vector<long long> expected;
+    for (int i = 0; i < turns; ++i) {
+        expected.push_back(i);
+    }
+    CHECK(values == expected);
+}
+
+TEST_CASE(FlightRecorder, WatchdogDumpsOncePerStall) {
+    std::string directory = TestDirectory("flight_watchdog");
+    FlightRecorder& recorder = FlightRecorder::Instance();
+    recorder.SetDumpDirectory(directory);
+
+    // Not armed until the first heartbeat
+    // Generous next to the 10ms beats below, so a slow scheduler does not look like a stall
+    recorder.StartWatchdog(100);
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    CHECK_EQ(DumpFiles(directory).size(), 0u);
+
+    // A long stall dumps once, not once per check
+    recorder.Heartbeat();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    CHECK_EQ(DumpFiles(directory).size(), 1u);
+
+    // A beat in between makes the next stall dump again
+    recorder.Heartbeat();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    CHECK_EQ(DumpFiles(directory).size(), 2u);
+
+    // Beating steadily never dumps, and a disarmed watchdog stays quiet
+    for (int i = 0; i < 30; ++i) {
+        recorder.Heartbeat();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    recorder.Disarm();
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    recorder.StopWatchdog();
+    CHECK_EQ(DumpFiles(directory).size(), 2u);
+
+    for (const std::string& path : DumpFiles(directory)) {
+        CHECK(path.find("_watchdog.txt") != std::string::npos);
+        std::ifstream file(path);
+        std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        CHECK(text.find("heartbeat missed") != std::string::npos);
+    }
+}
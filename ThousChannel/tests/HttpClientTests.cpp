@@ -0,0 +1,308 @@
+#include "TestHarness.h"
+#include "HttpClient.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Answers every request with its body
+class EchoTransport : public IHttpTransport {
+public:
+    std::atomic<int> calls{ 0 };
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool blocked = false;
+
+    bool Post(const std::string& url, const std::string&, const std::string& body, int, HttpResponse& response,
+              std::string& errorMsg) override {
+        ++calls;
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this]() { return !blocked; });
+        if (url == "fail") {
+            errorMsg = "failed";
+            return false;
+        }
+        response.statusCode = 200;
+        response.body = body;
+        return true;
+    }
+
+    void SetBlocked(bool value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        blocked = value;
+        cv.notify_all();
+    }
+};
+
+bool WaitFor(const std::atomic<int>& value, int expected) {
+    for (int i = 0; i < 2000 && value.load() < expected; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return value.load() == expected;
+}
+
+} // namespace
+
+TEST_CASE(HttpClient, AsyncRequestsRunOnWorkers) {
+    EchoTransport* transport = new EchoTransport();
+    HttpClient client{ std::unique_ptr<IHttpTransport>(transport) };
+    std::atomic<int> succeeded(0);
+    std::atomic<int> failed(0);
+    std::thread::id caller = std::this_thread::get_id();
+    for (int i = 0; i < 10; ++i) {
+        CHECK(client.PostAsync(i == 3 ? "fail" : "echo", "text/plain", std::to_string(i), 1000,
+            [&, i](bool success, const HttpResponse& response, const std::string& errorMsg) {
+                CHECK(std::this_thread::get_id() != caller);
+                if (success) {
+                    CHECK_EQ(response.body, std::to_string(i));
+                    ++succeeded;
+                } else {
+                    CHECK_EQ(errorMsg, std::string("failed"));
+                    ++failed;
+                }
+            }));
+    }
+    CHECK(WaitFor(succeeded, 9));
+    CHECK(WaitFor(failed, 1));
+    client.Shutdown(1000);
+    CHECK(!client.PostAsync("echo", "text/plain", "late", 1000, [](bool, const HttpResponse&, const std::string&) {}));
+}
+
+TEST_CASE(HttpClient, FullQueueRefuses) {
+    EchoTransport* transport = new EchoTransport();
+    transport->SetBlocked(true);
+    HttpClient client(std::unique_ptr<IHttpTransport>(transport), 1, 2);
+    std::atomic<int> done(0);
+    auto callback = [&done](bool, const HttpResponse&, const std::string&) { ++done; };
+
+    // The worker takes the first; two more fill the queue
+    CHECK(client.PostAsync("echo", "text/plain", "1", 1000, callback));
+    CHECK(WaitFor(transport->calls, 1));
+    CHECK(client.PostAsync("echo", "text/plain", "2", 1000, callback));
+    CHECK(client.PostAsync("echo", "text/plain", "3", 1000, callback));
+    CHECK(!client.PostAsync("echo", "text/plain", "4", 1000, callback));
+
+    transport->SetBlocked(false);
+    CHECK(WaitFor(done, 3));
+    client.Shutdown(1000);
+}
+
+#ifndef _WIN32
+
+namespace {
+
+// A server on 127.0.0.1 that hands each accepted connection to `serve`, one
+// at a time, on its own thread
+class LoopbackServer {
+public:
+    typedef std::function<void(int fd, int connection)> ServeFunction;
+
+    explicit LoopbackServer(ServeFunction serve) : m_serve(serve), m_connections(0), m_port(0) {
+        m_listen = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        bind(m_listen, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        listen(m_listen, 8);
+        socklen_t length = sizeof(address);
+        getsockname(m_listen, reinterpret_cast<sockaddr*>(&address), &length);
+        m_port = ntohs(address.sin_port);
+        m_thread = std::thread([this]() { Run(); });
+    }
+
+    ~LoopbackServer() {
+        shutdown(m_listen, SHUT_RDWR);
+        m_thread.join();
+        close(m_listen);
+    }
+
+    std::string Url() const { return "http://127.0.0.1:" + std::to_string(m_port) + "/token"; }
+    int GetConnections() const { return m_connections.load(); }
+
+private:
+    void Run() {
+        while (true) {
+            int fd = accept(m_listen, nullptr, nullptr);
+            if (fd < 0) {
+                return;
+            }
+            m_serve(fd, m_connections++);
+            close(fd);
+        }
+    }
+
+    ServeFunction m_serve;
+    std::atomic<int> m_connections;
+    int m_listen;
+    int m_port;
+    std::thread m_thread;
+};
+
+// One request with a Content-Length body into `body`; false once the client closes
+bool ReadRequest(int fd, std::string& body) {
+    std::string buffer;
+    char chunk[4096];
+    size_t headerEnd;
+    while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            return false;
+        }
+        buffer.append(chunk, static_cast<size_t>(n));
+    }
+    size_t lengthPos = buffer.find("Content-Length: ");
+    size_t length = lengthPos == std::string::npos ? 0 : strtoul(buffer.c_str() + lengthPos + 16, nullptr, 10);
+    while (buffer.size() < headerEnd + 4 + length) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            return false;
+        }
+        buffer.append(chunk, static_cast<size_t>(n));
+    }
+    body = buffer.substr(headerEnd + 4, length);
+    return true;
+}
+
+void Send(int fd, const std::string& text) {
+    send(fd, text.data(), text.size(), MSG_NOSIGNAL);
+}
+
+std::string Reply(const std::string& body) {
+    return "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+bool PostOnce(IHttpTransport& transport, const std::string& url, const std::string& body, int timeoutMs,
+              HttpResponse& response, std::string& errorMsg) {
+    response = HttpResponse();
+    errorMsg.clear();
+    return transport.Post(url, "text/plain", body, timeoutMs, response, errorMsg);
+}
+
+} // namespace
+
+TEST_CASE(HttpClient, KeepAliveReusesTheConnection) {
+    std::atomic<int> requests(0);
+    LoopbackServer server([&requests](int fd, int) {
+        std::string body;
+        while (ReadRequest(fd, body)) {
+            ++requests;
+            Send(fd, Reply("re:" + body));
+        }
+    });
+    std::unique_ptr<IHttpTransport> transport = CreateHttpTransport();
+    HttpResponse response;
+    std::string errorMsg;
+    for (int i = 0; i < 5; ++i) {
+        CHECK(PostOnce(*transport, server.Url(), std::to_string(i), 1000, response, errorMsg));
+        CHECK_EQ(response.statusCode, 200);
+        CHECK_EQ(response.body, "re:" + std::to_string(i));
+    }
+    CHECK_EQ(requests.load(), 5);
+    CHECK_EQ(server.GetConnections(), 1);
+}
+
+TEST_CASE(HttpClient, ChunkedBodyIsJoined) {
+    LoopbackServer server([](int fd, int) {
+        std::string body;
+        while (ReadRequest(fd, body)) {
+            // Chunks split across writes, with an extension and a trailer
+            Send(fd, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhel");
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            Send(fd, "lo\r\n1;ext=1\r\n \r\nA\r\n0123456789\r\n");
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            Send(fd, "0\r\n\r\n");
+        }
+    });
+    std::unique_ptr<IHttpTransport> transport = CreateHttpTransport();
+    HttpResponse response;
+    std::string errorMsg;
+    CHECK(PostOnce(*transport, server.Url(), "x", 1000, response, errorMsg));
+    CHECK_EQ(response.body, std::string("hello 0123456789"));
+    // The connection is still usable after the last chunk
+    CHECK(PostOnce(*transport, server.Url(), "y", 1000, response, errorMsg));
+    CHECK_EQ(response.body, std::string("hello 0123456789"));
+    CHECK_EQ(server.GetConnections(), 1);
+}
+
+TEST_CASE(HttpClient, BodyToCloseAndStatus) {
+    LoopbackServer server([](int fd, int) {
+        std::string body;
+        if (ReadRequest(fd, body)) {
+            Send(fd, "HTTP/1.1 503 Service Unavailable\r\nConnection: close\r\n\r\nbusy, " + body);
+        }
+    });
+    std::unique_ptr<IHttpTransport> transport = CreateHttpTransport();
+    HttpResponse response;
+    std::string errorMsg;
+    CHECK(PostOnce(*transport, server.Url(), "a", 1000, response, errorMsg));
+    CHECK_EQ(response.statusCode, 503);
+    CHECK_EQ(response.body, std::string("busy, a"));
+    CHECK(PostOnce(*transport, server.Url(), "b", 1000, response, errorMsg));
+    CHECK_EQ(response.body, std::string("busy, b"));
+    CHECK_EQ(server.GetConnections(), 2);
+}
+
+TEST_CASE(HttpClient, ClosedPooledConnectionIsRetried) {
+    // The first connection answers once and then closes without a word, as a
+    // server dropping an idle keep-alive connection does
+    std::atomic<int> requests(0);
+    LoopbackServer server([&requests](int fd, int connection) {
+        std::string body;
+        while (ReadRequest(fd, body)) {
+            ++requests;
+            Send(fd, Reply(body));
+            if (connection == 0) {
+                return;
+            }
+        }
+    });
+    std::unique_ptr<IHttpTransport> transport = CreateHttpTransport();
+    HttpResponse response;
+    std::string errorMsg;
+    CHECK(PostOnce(*transport, server.Url(), "first", 1000, response, errorMsg));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(PostOnce(*transport, server.Url(), "second", 1000, response, errorMsg));
+    CHECK_EQ(response.body, std::string("second"));
+    CHECK_EQ(requests.load(), 2);
+    CHECK_EQ(server.GetConnections(), 2);
+}
+
+TEST_CASE(HttpClient, TimeoutIsNotResent) {
+    // The second request on the pooled connection gets no answer; sending it
+    // again could run a non-idempotent POST twice
+    std::atomic<int> requests(0);
+    LoopbackServer server([&requests](int fd, int) {
+        std::string body;
+        while (ReadRequest(fd, body)) {
+            if (++requests == 1) {
+                Send(fd, Reply(body));
+            }
+        }
+    });
+    std::unique_ptr<IHttpTransport> transport = CreateHttpTransport();
+    HttpResponse response;
+    std::string errorMsg;
+    CHECK(PostOnce(*transport, server.Url(), "first", 1000, response, errorMsg));
+    CHECK(!PostOnce(*transport, server.Url(), "second", 200, response, errorMsg));
+    CHECK(!errorMsg.empty());
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK_EQ(requests.load(), 2);
+    CHECK_EQ(server.GetConnections(), 1);
+}
+
+#endif
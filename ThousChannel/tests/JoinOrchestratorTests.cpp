@@ -0,0 +1,140 @@
+#include "TestHarness.h"
+#include "JoinOrchestrator.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+JoinStepRecord Record(const JoinOrchestrator& orchestrator, const std::string& name) {
+    for (const JoinStepRecord& record : orchestrator.GetTimeline()) {
+        if (record.name == name) {
+            return record;
+        }
+    }
+    return JoinStepRecord{ "", JoinStepStatus::Pending, -1, -1 };
+}
+
+} // namespace
+
+TEST_CASE(JoinOrchestrator, IndependentStepsOverlap) {
+    // Both wait for each other, so they only finish if they run at once
+    std::atomic<int> started(0);
+    auto rendezvous = [&started]() {
+        ++started;
+        for (int i = 0; i < 2000 && started.load() < 2; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return started.load() == 2;
+    };
+    JoinOrchestrator orchestrator;
+    orchestrator.AddStep("token", {}, rendezvous);
+    orchestrator.AddStep("engine_init", {}, rendezvous);
+    orchestrator.AddStep("connect", { "token", "engine_init" }, []() {
+        // Ends in a later millisecond, so it is the end of the critical path
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return true;
+    });
+
+    CHECK(orchestrator.Run());
+    CHECK(orchestrator.GetFailedStep().empty());
+    CHECK(Record(orchestrator, "connect").status == JoinStepStatus::Succeeded);
+    CHECK(Record(orchestrator, "connect").startMs >= Record(orchestrator, "token").endMs);
+    std::vector<std::string> path = orchestrator.GetCriticalPath();
+    CHECK_EQ(path.size(), 2u);
+    CHECK_EQ(path.back(), std::string("connect"));
+}
+
+TEST_CASE(JoinOrchestrator, RequiredFailureSkipsDependents) {
+    std::atomic<int> ran(0);
+    JoinOrchestrator orchestrator;
+    orchestrator.AddStep("token", {}, []() { return false; });
+    orchestrator.AddStep("engine_init", {}, [&ran]() { ++ran; return true; });
+    orchestrator.AddStep("connect", { "token", "engine_init" }, [&ran]() { ++ran; return true; });
+    orchestrator.AddStep("join", { "connect" }, [&ran]() { ++ran; return true; });
+
+    CHECK(!orchestrator.Run());
+    CHECK_EQ(orchestrator.GetFailedStep(), std::string("token"));
+    CHECK_EQ(ran.load(), 1);
+    CHECK(Record(orchestrator, "token").status == JoinStepStatus::Failed);
+    CHECK(Record(orchestrator, "connect").status == JoinStepStatus::Skipped);
+    CHECK(Record(orchestrator, "join").status == JoinStepStatus::Skipped);
+    CHECK_EQ(Record(orchestrator, "join").startMs, -1);
+}
+
+TEST_CASE(JoinOrchestrator, OptionalFailureLetsDependentsRun) {
+    bool published = false;
+    JoinOrchestrator orchestrator;
+    orchestrator.AddStep("camera", {}, []() { return false; }, false);
+    orchestrator.AddStep("mic", {}, []() -> bool { throw std::runtime_error("no device"); }, false);
+    orchestrator.AddStep("publish", { "camera", "mic" }, [&published]() { published = true; return true; });
+
+    CHECK(orchestrator.Run());
+    CHECK(published);
+    CHECK(Record(orchestrator, "camera").status == JoinStepStatus::Failed);
+    CHECK(Record(orchestrator, "mic").status == JoinStepStatus::Failed);
+    CHECK(orchestrator.GetFailedStep().empty());
+}
+
+TEST_CASE(JoinOrchestrator, UnknownDependencyFailsTheGraph) {
+    bool ran = false;
+    JoinOrchestrator orchestrator;
+    orchestrator.AddStep("join", { "connect" }, [&ran]() { ran = true; return true; });
+    CHECK(!orchestrator.Run());
+    CHECK(!ran);
+    CHECK_EQ(orchestrator.GetFailedStep(), std::string("<graph>"));
+}
+
+TEST_CASE(JoinOrchestrator, CycleIsSkipped) {
+    bool ranA = false;
+    JoinOrchestrator orchestrator;
+    orchestrator.AddStep("first", {}, []() { return true; });
+    orchestrator.AddStep("a", { "first", "b" }, [&ranA]() { ranA = true; return true; });
+    orchestrator.AddStep("b", { "a" }, []() { return true; });
+
+    CHECK(!orchestrator.Run());
+    CHECK(!ranA);
+    CHECK(Record(orchestrator, "first").status == JoinStepStatus::Succeeded);
+    CHECK(Record(orchestrator, "a").status == JoinStepStatus::Skipped);
+    CHECK(Record(orchestrator, "b").status == JoinStepStatus::Skipped);
+    CHECK_EQ(orchestrator.GetFailedStep(), std::string("a"));
+}
+
+TEST_CASE(JoinOrchestrator, RunAgainStartsOver) {
+    std::atomic<bool> engineDone(false);
+    std::atomic<int> connects(0);
+    std::atomic<int> early(0);
+    bool tokenOk = true;
+    JoinOrchestrator orchestrator;
+    orchestrator.AddStep("token", {}, [&tokenOk]() { return tokenOk; });
+    orchestrator.AddStep("engine_init", {}, [&engineDone]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        engineDone = true;
+        return true;
+    });
+    orchestrator.AddStep("connect", { "token", "engine_init" }, [&]() {
+        ++connects;
+        if (!engineDone.load()) {
+            ++early;
+        }
+        return true;
+    });
+
+    for (int run = 0; run < 3; ++run) {
+        engineDone = false;
+        CHECK(orchestrator.Run());
+    }
+    CHECK_EQ(connects.load(), 3);
+    CHECK_EQ(early.load(), 0);
+
+    // A step skipped this time shows no timing from the run before
+    tokenOk = false;
+    CHECK(!orchestrator.Run());
+    CHECK(Record(orchestrator, "connect").status == JoinStepStatus::Skipped);
+    CHECK_EQ(Record(orchestrator, "connect").startMs, -1);
+    CHECK_EQ(connects.load(), 3);
+}
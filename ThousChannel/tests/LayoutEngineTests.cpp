@@ -0,0 +1,128 @@
+#include "TestHarness.h"
+#include "LayoutEngine.h"
+
+namespace {
+
+// Tiles are sorted and numbered 0..n-1 without gaps
+bool IndicesAreDense(const Layout& layout) {
+    for (size_t i = 0; i < layout.tiles.size(); ++i) {
+        if (layout.tiles[i].index != static_cast<int>(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int LargeTiles(const Layout& layout) {
+    int count = 0;
+    for (const LayoutTile& tile : layout.tiles) {
+        count += tile.large ? 1 : 0;
+    }
+    return count;
+}
+
+} // namespace
+
+TEST_CASE(LayoutEngine, GridSplitsTheContainerWithGaps) {
+    LayoutSpec spec = LayoutSpec::Grid(2, 2);
+    spec.gap = 4;
+    Layout layout = LayoutEngine::Compute(spec, LayoutRect(0, 0, 200, 100));
+    CHECK_EQ(layout.tiles.size(), 4u);
+    CHECK(IndicesAreDense(layout));
+    CHECK(layout.tiles[0].rect == LayoutRect(0, 0, 96, 46));
+    CHECK(layout.tiles[3].rect == LayoutRect(100, 50, 196, 96));
+}
+
+TEST_CASE(LayoutEngine, PinnedTileSpansTwoByTwo) {
+    LayoutSpec spec = LayoutSpec::Grid(3, 3);
+    spec.gap = 0;
+    spec.pinnedTiles = { 4 };
+    Layout layout = LayoutEngine::Compute(spec, LayoutRect(0, 0, 300, 300));
+    CHECK_EQ(layout.tiles.size(), 6u);
+    CHECK(IndicesAreDense(layout));
+    CHECK(layout.tiles[4].large);
+    CHECK(layout.tiles[4].rect == LayoutRect(0, 0, 200, 200));
+    CHECK_EQ(LargeTiles(layout), 1);
+}
+
+TEST_CASE(LayoutEngine, PinThatDoesNotFitBecomesANormalTile) {
+    // The second 2x2 block cannot fit in a 3x3 grid next to the first
+    LayoutSpec spec = LayoutSpec::Grid(3, 3);
+    spec.pinnedTiles = { 0, 1 };
+    Layout layout = LayoutEngine::Compute(spec, LayoutRect(0, 0, 300, 300));
+    CHECK_EQ(layout.tiles.size(), 6u);
+    CHECK(IndicesAreDense(layout));
+    CHECK(layout.tiles[0].large);
+    CHECK(!layout.tiles[1].large);
+
+    // A single-row grid has no 2x2 block at all
+    spec = LayoutSpec::Grid(4, 1);
+    spec.pinnedTiles = { 0 };
+    layout = LayoutEngine::Compute(spec, LayoutRect(0, 0, 400, 100));
+    CHECK_EQ(layout.tiles.size(), 4u);
+    CHECK(IndicesAreDense(layout));
+    CHECK_EQ(LargeTiles(layout), 0);
+}
+
+TEST_CASE(LayoutEngine, PinPastTheLastTileIsDropped) {
+    // Pinning tile 3 of a 2x2 grid leaves a single tile, so the pin is dropped
+    LayoutSpec spec = LayoutSpec::Grid(2, 2);
+    spec.pinnedTiles = { 3 };
+    Layout layout = LayoutEngine::Compute(spec, LayoutRect(0, 0, 400, 400));
+    CHECK_EQ(layout.tiles.size(), 4u);
+    CHECK(IndicesAreDense(layout));
+    CHECK_EQ(LargeTiles(layout), 0);
+
+    // Tile 5 takes the only 2x2 block; the other pins are filled in around it
+    spec = LayoutSpec::Grid(3, 3);
+    spec.pinnedTiles = { 5, 1, 0 };
+    layout = LayoutEngine::Compute(spec, LayoutRect(0, 0, 300, 300));
+    CHECK_EQ(layout.tiles.size(), 6u);
+    CHECK(IndicesAreDense(layout));
+    CHECK(layout.tiles[5].large);
+    CHECK_EQ(LargeTiles(layout), 1);
+}
+
+TEST_CASE(LayoutEngine, ChooseGridPrefersLargestTiles) {
+    int columns = 0;
+    int rows = 0;
+    LayoutEngine::ChooseGrid(4, 16.0 / 9.0, 1600, 900, columns, rows);
+    CHECK_EQ(columns, 2);
+    CHECK_EQ(rows, 2);
+    LayoutEngine::ChooseGrid(3, 16.0 / 9.0, 1600, 300, columns, rows);
+    CHECK_EQ(columns, 3);
+    CHECK_EQ(rows, 1);
+    LayoutEngine::ChooseGrid(1, 16.0 / 9.0, 1600, 900, columns, rows);
+    CHECK_EQ(columns * rows, 1);
+}
+
+TEST_CASE(LayoutEngine, SpeakerFilmstripPutsTheStripBelow) {
+    LayoutSpec spec = LayoutSpec::SpeakerFilmstrip(5);
+    spec.gap = 0;
+    Layout layout = LayoutEngine::Compute(spec, LayoutRect(0, 0, 400, 500));
+    CHECK_EQ(layout.tiles.size(), 5u);
+    CHECK(layout.tiles[0].large);
+    CHECK(layout.tiles[0].rect == LayoutRect(0, 0, 400, 400));
+    CHECK(layout.tiles[1].rect == LayoutRect(0, 400, 100, 500));
+    CHECK(layout.tiles[4].rect == LayoutRect(300, 400, 400, 500));
+}
+
+TEST_CASE(LayoutEngine, DiffReportsOnlyChangedTiles) {
+    LayoutRect container(0, 0, 400, 400);
+    Layout before = LayoutEngine::Compute(LayoutSpec::Grid(2, 2), container);
+    CHECK(LayoutEngine::Diff(before, before).empty());
+
+    LayoutSpec pinned = LayoutSpec::Grid(2, 2);
+    pinned.pinnedTiles = { 0 };
+    Layout after = LayoutEngine::Compute(pinned, container);
+    std::vector<LayoutChange> changes = LayoutEngine::Diff(before, after);
+    CHECK_EQ(changes.size(), 4u);
+    CHECK(changes[0].type == LayoutChangeType::Resized);
+    CHECK(changes[1].type == LayoutChangeType::Removed);
+    CHECK(changes[3].type == LayoutChangeType::Removed);
+
+    Layout moved = LayoutEngine::Compute(LayoutSpec::Grid(2, 2), LayoutRect(10, 0, 410, 400));
+    changes = LayoutEngine::Diff(before, moved);
+    CHECK_EQ(changes.size(), 4u);
+    CHECK(changes[2].type == LayoutChangeType::Moved);
+}
@@ -0,0 +1,232 @@
+#include "TestHarness.h"
+#include "LogSink.h"
+#include "Lz4Decode.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+const uint64_t kSegmentBytes = 64 * 1024;
+
+// An empty directory of its own for each test
+std::string TestDirectory(const char* name) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "thouschannel_tests" / name;
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+    std::filesystem::create_directories(directory, error);
+    return directory.string();
+}
+
+// Segment files of the log, oldest first
+std::vector<std::string> Segments(const std::string& directory) {
+    std::vector<std::string> paths;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        paths.push_back(entry.path().string());
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+uint64_t TotalBytes(const std::vector<std::string>& paths) {
+    uint64_t total = 0;
+    for (const std::string& path : paths) {
+        total += std::filesystem::file_size(path);
+    }
+    return total;
+}
+
+// Lines long enough to fill several frames
+std::string SessionText(int lines) {
+    std::string text;
+    char line[128];
+    for (int i = 0; i < lines; ++i) {
+        snprintf(line, sizeof(line), "[INFO] [rte] Remote stream added: stream_%d of user_%d\n", i, i * 37 % 1000);
+        text += line;
+    }
+    return text;
+}
+
+// Line by line, as the logger writes
+void WriteLines(ILogSink& sink, const std::string& text) {
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start) + 1;
+        sink.Write(text.data() + start, end - start);
+        start = end;
+    }
+}
+
+// The text of a compressed log file: index frames and LZ4 frames in turn,
+// each index matching the frame after it
+bool DecodeCompressed(const std::string& path, std::string& text, int& frames) {
+    std::string data = ReadFile(path);
+    size_t pos = 0;
+    frames = 0;
+    while (pos < data.size()) {
+        CompressedLogSink::FrameIndex index;
+        if (pos + 8 + sizeof(index) > data.size() || Lz4Decode::Le32(data, pos) != Lz4::kSkippableMagic ||
+            Lz4Decode::Le32(data, pos + 4) != sizeof(index)) {
+            return false;
+        }
+        memcpy(&index, &data[pos + 8], sizeof(index));
+        pos += 8 + sizeof(index);
+        size_t frameStart = pos;
+        size_t textStart = text.size();
+        if (!Lz4Decode::Frame(data, pos, text) || pos - frameStart != index.frameBytes ||
+            text.size() - textStart != index.rawBytes || index.firstUs > index.lastUs) {
+            return false;
+        }
+        ++frames;
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE(LogSink, MappedSegmentsKeepRecordsWhole) {
+    std::string directory = TestDirectory("mapped_records");
+    std::string record(100, 'r');
+    {
+        MappedLogSink sink(kSegmentBytes, 64 * kSegmentBytes);
+        CHECK(sink.Open(directory + "/test.log"));
+        for (int i = 0; i < 2000; ++i) {
+            sink.Write(record.data(), record.size());
+        }
+        CHECK_EQ(sink.GetDroppedBytes(), 0u);
+    }
+
+    // 655 records fit in a segment; Close trims the last one
+    std::vector<std::string> segments = Segments(directory);
+    CHECK_EQ(segments.size(), 4u);
+    CHECK(segments.front().find("test.000001.log") != std::string::npos);
+    CHECK_EQ(TotalBytes(segments), 200000u);
+    for (const std::string& path : segments) {
+        CHECK_EQ(std::filesystem::file_size(path) % 100, 0u);
+    }
+}
+
+TEST_CASE(LogSink, SegmentHandlerStartsEverySegment) {
+    std::string directory = TestDirectory("mapped_handler");
+    std::string record(1000, 'r');
+    {
+        MappedLogSink sink(kSegmentBytes, 64 * kSegmentBytes);
+        sink.SetSegmentHandler([&sink]() { sink.Write("HDR", 3); });
+        CHECK(sink.Open(directory + "/test.log"));
+        for (int i = 0; i < 200; ++i) {
+            sink.Write(record.data(), record.size());
+        }
+    }
+    std::vector<std::string> segments = Segments(directory);
+    CHECK_EQ(segments.size(), 4u);
+    for (const std::string& path : segments) {
+        CHECK_EQ(ReadFile(path).substr(0, 4), std::string("HDRr"));
+    }
+}
+
+TEST_CASE(LogSink, ShortSessionsAreKept) {
+    // Every session starts a segment; small ones must not push out the rest
+    std::string directory = TestDirectory("mapped_sessions");
+    for (int session = 0; session < 20; ++session) {
+        MappedLogSink sink(kSegmentBytes, 16 * kSegmentBytes);
+        CHECK(sink.Open(directory + "/test.log"));
+        sink.Write("session\n", 8);
+    }
+    std::vector<std::string> segments = Segments(directory);
+    CHECK_EQ(segments.size(), 20u);
+    CHECK(segments.back().find("test.000020.log") != std::string::npos);
+}
+
+TEST_CASE(LogSink, RetentionCountsBytes) {
+    std::string directory = TestDirectory("mapped_retention");
+    std::string record(1000, 'r');
+    {
+        MappedLogSink sink(kSegmentBytes, 200 * 1024);
+        CHECK(sink.Open(directory + "/test.log"));
+        for (int i = 0; i < 1000; ++i) {
+            sink.Write(record.data(), record.size());
+        }
+    }
+    // The open segment counts at its mapped size: three of 64KB fit in 200KB
+    std::vector<std::string> segments = Segments(directory);
+    CHECK_EQ(segments.size(), 3u);
+    CHECK(TotalBytes(segments) <= 200u * 1024);
+    CHECK(segments.back().find("test.000016.log") != std::string::npos);
+
+    // Less than a segment still keeps the one being written
+    MappedLogSink sink(kSegmentBytes, 0);
+    CHECK(sink.Open(directory + "/test.log"));
+    CHECK_EQ(Segments(directory).size(), 1u);
+}
+
+TEST_CASE(LogSink, CompressedFramesDecodeWithTheirIndex) {
+    std::string directory = TestDirectory("compressed_single");
+    std::string text = SessionText(20000);
+    {
+        CompressedLogSink sink(64 * 1024, 0, 0);
+        CHECK(sink.Open(directory + "/test.log"));
+        CHECK(!sink.IsContinuingFile());
+        WriteLines(sink, text);
+        sink.Flush();
+        sink.Write("flushed\n", 8);
+        sink.Close();
+        CHECK_EQ(sink.GetRawBytes(), static_cast<uint64_t>(text.size() + 8));
+        CHECK(sink.GetCompressedBytes() < text.size() / 3);
+    }
+
+    std::string decoded;
+    int frames = 0;
+    CHECK(DecodeCompressed(directory + "/test.log.lz4", decoded, frames));
+    CHECK(decoded == text + "flushed\n");
+    CHECK(frames > 2);
+
+    // A second session appends its frames to the same file
+    CompressedLogSink sink(64 * 1024, 0, 0);
+    CHECK(sink.Open(directory + "/test.log"));
+    CHECK(sink.IsContinuingFile());
+    sink.Write("more\n", 5);
+    sink.Close();
+    decoded.clear();
+    CHECK(DecodeCompressed(directory + "/test.log.lz4", decoded, frames));
+    CHECK(decoded == text + "flushed\nmore\n");
+}
+
+TEST_CASE(LogSink, CompressedSegmentsStartWithTheirHeader) {
+    std::string directory = TestDirectory("compressed_segments");
+    std::string text = SessionText(5000);
+    uint64_t written = 0;
+    {
+        CompressedLogSink sink(16 * 1024, 64 * 1024, 64 * 1024 * 1024);
+        sink.SetSegmentHandler([&sink]() { sink.Write("HDR\n", 4); });
+        CHECK(sink.Open(directory + "/test.log"));
+        WriteLines(sink, text);
+        sink.Close();
+        written = sink.GetRawBytes();
+    }
+
+    std::vector<std::string> segments = Segments(directory);
+    CHECK(segments.size() > 2);
+    std::string joined;
+    for (const std::string& path : segments) {
+        std::string decoded;
+        int frames = 0;
+        CHECK(DecodeCompressed(path, decoded, frames));
+        CHECK_EQ(decoded.substr(0, 4), std::string("HDR\n"));
+        CHECK(decoded.size() <= 64u * 1024);
+        CHECK_EQ(decoded.back(), '\n');
+        joined += decoded.substr(4);
+    }
+    CHECK(joined == text);
+    CHECK_EQ(written, static_cast<uint64_t>(text.size() + 4 * segments.size()));
+}
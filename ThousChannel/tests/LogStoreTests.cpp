@@ -0,0 +1,149 @@
+#include "TestHarness.h"
+#include "LogStore.h"
+
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void AppendLine(LogStore& store, LogLevel level, LogCategory category, UserHandle user, const std::string& text) {
+    store.Append(0, 1, level, category, user, text);
+}
+
+std::vector<uint64_t> Matching(const LogStore& store, const LogFilter& filter, uint64_t fromSeq = 0) {
+    std::vector<uint64_t> rows;
+    store.Query(filter, fromSeq, rows);
+    return rows;
+}
+
+} // namespace
+
+TEST_CASE(LogStore, QueriesCombineFilters) {
+    LogStore store;
+    AppendLine(store, LogLevel::Info, LogCategory::Rte, 7, "joined");            // 0
+    AppendLine(store, LogLevel::Warn, LogCategory::Rte, 7, "stream stalled");    // 1
+    AppendLine(store, LogLevel::Warn, LogCategory::General, 8, "stream stalled"); // 2
+    AppendLine(store, LogLevel::Debug, LogCategory::Rte, kInvalidUserHandle, "tick"); // 3
+    AppendLine(store, LogLevel::Error, LogCategory::Rte, 8, "stream lost");      // 4
+
+    LogFilter all;
+    CHECK_EQ(Matching(store, all).size(), 5u);
+
+    LogFilter user;
+    user.user = 7;
+    CHECK(Matching(store, user) == std::vector<uint64_t>({ 0, 1 }));
+
+    LogFilter warnings;
+    warnings.minLevel = LogLevel::Warn;
+    warnings.categoryMask = 1u << static_cast<int>(LogCategory::Rte);
+    CHECK(Matching(store, warnings) == std::vector<uint64_t>({ 1, 4 }));
+
+    LogFilter text;
+    text.text = "stream";
+    text.user = 8;
+    CHECK(Matching(store, text) == std::vector<uint64_t>({ 2, 4 }));
+    CHECK(Matching(store, text, 3) == std::vector<uint64_t>({ 4 }));
+
+    LogFilter unknown;
+    unknown.user = 99;
+    CHECK(Matching(store, unknown).empty());
+}
+
+TEST_CASE(LogStore, OldestLinesAreEvicted) {
+    LogStore store(3);
+    for (int i = 0; i < 5; ++i) {
+        AppendLine(store, LogLevel::Info, LogCategory::General, 1, "line " + std::to_string(i));
+    }
+    CHECK_EQ(store.GetFirstSeq(), 2u);
+    CHECK_EQ(store.GetNextSeq(), 5u);
+
+    LogStoreRecord record;
+    CHECK(!store.GetRecord(1, record));
+    CHECK(store.GetRecord(2, record));
+    CHECK_EQ(record.text, std::string("line 2"));
+
+    LogFilter user;
+    user.user = 1;
+    CHECK(Matching(store, user) == std::vector<uint64_t>({ 2, 3, 4 }));
+
+    // Sequence numbers carry on after a clear
+    store.Clear();
+    CHECK_EQ(store.GetFirstSeq(), 5u);
+    AppendLine(store, LogLevel::Info, LogCategory::General, 1, "after");
+    CHECK(Matching(store, user) == std::vector<uint64_t>({ 5 }));
+}
+
+TEST_CASE(LogStore, TextRingWraps) {
+    // The smallest text budget holds 16 lines of 1000 bytes
+    LogStore store(1000, 0);
+    for (int i = 0; i < 40; ++i) {
+        AppendLine(store, LogLevel::Info, LogCategory::General, kInvalidUserHandle,
+            std::string(1000 - 3, static_cast<char>('a' + i % 26)) + std::to_string(100 + i));
+    }
+    CHECK(store.GetFirstSeq() > 20u);
+    CHECK_EQ(store.GetNextSeq(), 40u);
+    for (uint64_t seq = store.GetFirstSeq(); seq < store.GetNextSeq(); ++seq) {
+        LogStoreRecord record;
+        CHECK(store.GetRecord(seq, record));
+        CHECK_EQ(record.text.size(), 1000u);
+        CHECK_EQ(record.text.substr(997), std::to_string(100 + seq));
+        CHECK_EQ(record.text[0], static_cast<char>('a' + seq % 26));
+    }
+
+    LogFilter text;
+    text.text = "139";
+    CHECK(Matching(store, text) == std::vector<uint64_t>({ 39 }));
+}
+
+TEST_CASE(LogStore, LoggerFeedsLinesWithTheirCallSiteUser) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "thouschannel_tests" / "logstore_feed";
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+    UserHandle alice = UserIdInterner::instance().Intern("logstore-alice");
+    UserIdInterner::instance().Intern("logstore-bob");
+
+    Logger& logger = Logger::instance();
+    LogStore store;
+    std::thread::id handlerThread;
+    store.SetChangeHandler([&handlerThread]() { handlerThread = std::this_thread::get_id(); });
+    CHECK(logger.setBinaryLogFile((directory / "feed.tclog").string()));
+    logger.setLogStore(&store);
+    LOG_INFO_FMT("Video on for user {}, fps={}", LogUser(alice), 15);
+    // Only LogUser arguments count, not ids in the text
+    LOG_INFO_FMT("Video on for user {}", "logstore-bob");
+    logger.log(LogCategory::Rte, LogLevel::Warn, "Passed through log()", alice);
+    logger.setLogStore(nullptr);
+    // Detached: logged, but not to the store
+    LOG_INFO_FMT("After detach {}", LogUser(alice));
+    logger.setBinaryLogFile("");
+
+    CHECK_EQ(store.GetNextSeq(), 3ull);
+    CHECK(handlerThread != std::thread::id());
+    CHECK(handlerThread != std::this_thread::get_id());
+    LogStoreRecord record;
+    CHECK(store.GetRecord(0, record));
+    CHECK_EQ(record.user, alice);
+    CHECK_EQ(record.text, std::string("Video on for user logstore-alice, fps=15"));
+    CHECK(store.GetRecord(1, record));
+    CHECK_EQ(record.user, kInvalidUserHandle);
+    CHECK_EQ(record.text, std::string("Video on for user logstore-bob"));
+    CHECK(store.GetRecord(2, record));
+    CHECK_EQ(record.user, alice);
+    CHECK(record.level == LogLevel::Warn);
+    CHECK(record.category == LogCategory::Rte);
+    std::filesystem::remove_all(directory, error);
+}
+
+TEST_CASE(LogStore, ChangeHandlerWaitsForAcknowledge) {
+    LogStore store;
+    int calls = 0;
+    store.SetChangeHandler([&calls]() { ++calls; });
+    AppendLine(store, LogLevel::Info, LogCategory::General, kInvalidUserHandle, "one");
+    AppendLine(store, LogLevel::Info, LogCategory::General, kInvalidUserHandle, "two");
+    CHECK_EQ(calls, 1);
+    store.AcknowledgeChange();
+    AppendLine(store, LogLevel::Info, LogCategory::General, kInvalidUserHandle, "three");
+    CHECK_EQ(calls, 2);
+}
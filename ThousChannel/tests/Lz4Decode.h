@@ -0,0 +1,112 @@
+#pragma once
+
+#include "Lz4.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Reader for the files the compressed log sink writes, written from the LZ4
+// frame and block specifications separately from the writer, so the tests do
+// not check the writer against itself. Returns false on anything malformed.
+namespace Lz4Decode {
+
+inline uint32_t Le32(const std::string& data, size_t pos) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) {
+        value = (value << 8) | static_cast<uint8_t>(data[pos + i]);
+    }
+    return value;
+}
+
+inline bool Block(const std::string& data, size_t pos, size_t end, std::string& out) {
+    size_t start = out.size();
+    while (pos < end) {
+        uint8_t token = static_cast<uint8_t>(data[pos++]);
+        size_t literals = token >> 4;
+        if (literals == 15) {
+            uint8_t more;
+            do {
+                if (pos >= end) {
+                    return false;
+                }
+                more = static_cast<uint8_t>(data[pos++]);
+                literals += more;
+            } while (more == 255);
+        }
+        if (pos + literals > end) {
+            return false;
+        }
+        out.append(data, pos, literals);
+        pos += literals;
+        if (pos == end) {
+            return true;    // The last sequence has no match
+        }
+        if (pos + 2 > end) {
+            return false;
+        }
+        size_t offset = static_cast<uint8_t>(data[pos]) | (static_cast<uint8_t>(data[pos + 1]) << 8);
+        pos += 2;
+        size_t length = (token & 15) + 4;
+        if ((token & 15) == 15) {
+            uint8_t more;
+            do {
+                if (pos >= end) {
+                    return false;
+                }
+                more = static_cast<uint8_t>(data[pos++]);
+                length += more;
+            } while (more == 255);
+        }
+        if (offset == 0 || offset > out.size() - start) {
+            return false;
+        }
+        // Byte by byte: a match may overlap what it copies
+        size_t from = out.size() - offset;
+        for (size_t i = 0; i < length; ++i) {
+            out.push_back(out[from + i]);
+        }
+    }
+    return false;
+}
+
+// One LZ4 frame at `pos`; `pos` moves past it
+inline bool Frame(const std::string& data, size_t& pos, std::string& out) {
+    if (pos + 7 > data.size() || Le32(data, pos) != Lz4::kFrameMagic) {
+        return false;
+    }
+    uint8_t flags = static_cast<uint8_t>(data[pos + 4]);
+    // Version 01 and nothing this reader does not handle: no content size,
+    // checksums or dictionary
+    if ((flags >> 6) != 1 || (flags & 0x0F) != 0) {
+        return false;
+    }
+    uint8_t check = static_cast<uint8_t>(Lz4::XxHash32(&data[pos + 4], 2, 0) >> 8);
+    if (static_cast<uint8_t>(data[pos + 6]) != check) {
+        return false;
+    }
+    pos += 7;
+    while (true) {
+        if (pos + 4 > data.size()) {
+            return false;
+        }
+        uint32_t size = Le32(data, pos);
+        pos += 4;
+        if (size == 0) {
+            return true;
+        }
+        bool stored = (size & 0x80000000u) != 0;
+        size &= 0x7FFFFFFFu;
+        if (size > Lz4::kMaxBlockBytes || pos + size > data.size()) {
+            return false;
+        }
+        if (stored) {
+            out.append(data, pos, size);
+        } else if (!Block(data, pos, pos + size, out)) {
+            return false;
+        }
+        pos += size;
+    }
+}
+
+} // namespace Lz4Decode
@@ -0,0 +1,97 @@
+#include "TestHarness.h"
+#include "Lz4Decode.h"
+
+#include <cstdio>
+#include <random>
+#include <string>
+
+namespace {
+
+// Compresses `text` into one frame and reads it back
+bool RoundTrips(const std::string& text, size_t* frameBytes = nullptr) {
+    std::string frame;
+    std::string scratch;
+    Lz4::AppendFrame(frame, text.data(), text.size(), scratch);
+    size_t pos = 0;
+    std::string decoded;
+    bool ok = Lz4Decode::Frame(frame, pos, decoded) && pos == frame.size() && decoded == text;
+    if (frameBytes) {
+        *frameBytes = frame.size();
+    }
+    return ok;
+}
+
+std::string SessionLines(int count) {
+    std::string text;
+    char line[160];
+    for (int i = 0; i < count; ++i) {
+        snprintf(line, sizeof(line), "[2024-05-01 12:30:%02d.%03d] [INFO] [rte] Remote stream added: stream_%d of user_%d\n",
+            i / 1000 % 60, i % 1000, (i * 7919) % 5000, i * 37 % 10000);
+        text += line;
+    }
+    return text;
+}
+
+std::string RandomBytes(size_t size) {
+    std::mt19937 random(12345);
+    std::string bytes(size, '\0');
+    for (char& c : bytes) {
+        c = static_cast<char>(random());
+    }
+    return bytes;
+}
+
+} // namespace
+
+// Reference values from the lz4 tool's content checksums
+TEST_CASE(Lz4, XxHash32KnownValues) {
+    CHECK_EQ(Lz4::XxHash32("", 0, 0), 0x02CC5D05u);
+    CHECK_EQ(Lz4::XxHash32("abc", 3, 0), 0x32D153FFu);
+    const std::string longer = "Nobody inspects the spammish repetition";
+    CHECK_EQ(Lz4::XxHash32(longer.data(), longer.size(), 0), 0xE2293B2Fu);
+}
+
+TEST_CASE(Lz4, LogTextRoundTripsSmaller) {
+    std::string text = SessionLines(5000);
+    size_t frameBytes = 0;
+    CHECK(RoundTrips(text, &frameBytes));
+    CHECK(frameBytes < text.size() / 3);
+}
+
+TEST_CASE(Lz4, ShortInputsRoundTrip) {
+    // Around the block format's end limits: the last 5 bytes are literals and
+    // no match starts in the last 12
+    for (size_t size : { 0, 1, 5, 12, 13, 17, 64 }) {
+        CHECK(RoundTrips(std::string(size, 'a')));
+        CHECK(RoundTrips(RandomBytes(size)));
+    }
+}
+
+TEST_CASE(Lz4, LongMatchesAndLiterals) {
+    // Lengths past 15 + 255 use the extra length bytes
+    std::string text = RandomBytes(1000) + std::string(5000, 'x') + RandomBytes(300) + RandomBytes(300);
+    CHECK(RoundTrips(text));
+}
+
+TEST_CASE(Lz4, IncompressibleBlocksAreStored) {
+    std::string bytes = RandomBytes(100000);
+    size_t frameBytes = 0;
+    CHECK(RoundTrips(bytes, &frameBytes));
+    // Magic, descriptor, one block size, the end mark
+    CHECK_EQ(frameBytes, bytes.size() + 4 + 3 + 4 + 4);
+}
+
+TEST_CASE(Lz4, LargeInputSplitsIntoBlocks) {
+    std::string text = SessionLines(60000);
+    CHECK(text.size() > Lz4::kMaxBlockBytes);
+    CHECK(RoundTrips(text));
+}
+
+TEST_CASE(Lz4, SkippableFrameLayout) {
+    std::string out;
+    Lz4::AppendSkippableFrame(out, "meta", 4);
+    CHECK_EQ(out.size(), 12u);
+    CHECK_EQ(Lz4Decode::Le32(out, 0), Lz4::kSkippableMagic);
+    CHECK_EQ(Lz4Decode::Le32(out, 4), 4u);
+    CHECK_EQ(out.substr(8), std::string("meta"));
+}
@@ -0,0 +1,176 @@
+#include "TestHarness.h"
+#include "ReconnectController.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace {
+
+ReconnectPolicy Policy(int initialDelayMs, int maxDelayMs, double multiplier, int maxAttempts) {
+    ReconnectPolicy policy;
+    policy.initialDelayMs = initialDelayMs;
+    policy.maxDelayMs = maxDelayMs;
+    policy.multiplier = multiplier;
+    policy.maxAttempts = maxAttempts;
+    return policy;
+}
+
+// Records how the one outage under test ended
+struct Outcome {
+    std::mutex mutex;
+    std::condition_variable cv;
+    int restored = 0;
+    int gaveUp = 0;
+    int attempts = -1;
+
+    void Set(bool ok, int attemptCount) {
+        std::lock_guard<std::mutex> lock(mutex);
+        (ok ? restored : gaveUp)++;
+        attempts = attemptCount;
+        cv.notify_all();
+    }
+
+    bool Wait(int timeoutMs) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+            [this]() { return restored + gaveUp > 0; });
+    }
+};
+
+void Watch(ReconnectController& controller, Outcome& outcome, ReconnectController::AttemptFunc attempt) {
+    controller.SetCallbacks(attempt,
+        [&outcome](long long, int attempts) { outcome.Set(true, attempts); },
+        [&outcome](long long, int attempts) { outcome.Set(false, attempts); });
+}
+
+} // namespace
+
+TEST_CASE(ReconnectController, BackoffGrowsUntilTheCap) {
+    ReconnectPolicy policy = Policy(100, 1000, 2.0, 0);
+    std::mt19937 rng(7);
+    const int caps[] = { 100, 200, 400, 800, 1000, 1000, 1000 };
+    for (int attempt = 0; attempt < 7; ++attempt) {
+        for (int i = 0; i < 200; ++i) {
+            int delayMs = ReconnectController::ComputeDelayMs(policy, attempt, rng);
+            CHECK(delayMs >= caps[attempt] / 2);
+            CHECK(delayMs <= caps[attempt]);
+        }
+    }
+    // Far past the cap the power must not overflow into a tiny delay
+    int delayMs = ReconnectController::ComputeDelayMs(policy, 5000, rng);
+    CHECK(delayMs >= 500);
+    CHECK(delayMs <= 1000);
+}
+
+TEST_CASE(ReconnectController, JitterSpreadsOverTheUpperHalf) {
+    ReconnectPolicy policy = Policy(1000, 30000, 2.0, 0);
+    std::mt19937 rng(11);
+    int lowest = 1000;
+    int highest = 0;
+    for (int i = 0; i < 2000; ++i) {
+        int delayMs = ReconnectController::ComputeDelayMs(policy, 0, rng);
+        lowest = std::min(lowest, delayMs);
+        highest = std::max(highest, delayMs);
+    }
+    CHECK(lowest >= 500);
+    CHECK(highest <= 1000);
+    // Not a fixed delay: the clients must not retry in lockstep
+    CHECK(lowest < 600);
+    CHECK(highest > 900);
+
+    // A zero delay still waits at least a millisecond
+    ReconnectPolicy zero = Policy(0, 0, 2.0, 0);
+    CHECK_EQ(ReconnectController::ComputeDelayMs(zero, 3, rng), 1);
+}
+
+TEST_CASE(ReconnectController, SucceedsAfterFailedAttempts) {
+    std::atomic<int> calls(0);
+    Outcome outcome;
+    ReconnectController controller;
+    controller.SetPolicy(Policy(1, 4, 2.0, 0));
+    Watch(controller, outcome, [&calls](int attempt) {
+        ++calls;
+        return attempt == 2;
+    });
+
+    controller.OnLinkLost(false);
+    CHECK(controller.IsInOutage());
+    CHECK(outcome.Wait(5000));
+    CHECK_EQ(outcome.restored, 1);
+    CHECK_EQ(outcome.gaveUp, 0);
+    CHECK_EQ(outcome.attempts, 3);
+    CHECK_EQ(calls.load(), 3);
+    CHECK(!controller.IsInOutage());
+}
+
+TEST_CASE(ReconnectController, GivesUpAfterMaxAttempts) {
+    std::atomic<int> calls(0);
+    Outcome outcome;
+    ReconnectController controller;
+    controller.SetPolicy(Policy(1, 2, 2.0, 4));
+    Watch(controller, outcome, [&calls](int) {
+        ++calls;
+        return false;
+    });
+
+    controller.OnLinkLost(false);
+    CHECK(outcome.Wait(5000));
+    CHECK_EQ(outcome.gaveUp, 1);
+    CHECK_EQ(outcome.restored, 0);
+    CHECK_EQ(outcome.attempts, 4);
+    CHECK(!controller.IsInOutage());
+
+    // No attempt runs after giving up
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK_EQ(calls.load(), 4);
+}
+
+TEST_CASE(ReconnectController, SdkRetryOnlyRestoresOnce) {
+    std::atomic<int> calls(0);
+    Outcome outcome;
+    ReconnectController controller;
+    controller.SetPolicy(Policy(1, 2, 2.0, 0));
+    Watch(controller, outcome, [&calls](int) { ++calls; return true; });
+
+    controller.OnLinkLost(true);
+    CHECK(controller.IsInOutage());
+    controller.OnLinkRestored();
+    controller.OnLinkRestored();
+    CHECK_EQ(outcome.restored, 1);
+    CHECK_EQ(outcome.attempts, 0);
+    CHECK_EQ(calls.load(), 0);
+    CHECK(!controller.IsInOutage());
+}
+
+TEST_CASE(ReconnectController, StopCancelsTheWait) {
+    std::atomic<int> calls(0);
+    Outcome outcome;
+    ReconnectController controller;
+    controller.SetPolicy(Policy(60000, 60000, 2.0, 0));
+    Watch(controller, outcome, [&calls](int) { ++calls; return true; });
+
+    controller.OnLinkLost(false);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    auto start = std::chrono::steady_clock::now();
+    controller.Stop();
+    auto stopMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    CHECK(stopMs < 1000);
+    CHECK_EQ(calls.load(), 0);
+    CHECK_EQ(outcome.restored + outcome.gaveUp, 0);
+    CHECK(!controller.IsInOutage());
+
+    // The controller is usable again after Stop
+    controller.SetPolicy(Policy(1, 1, 2.0, 0));
+    controller.OnLinkLost(false);
+    CHECK(outcome.Wait(5000));
+    CHECK_EQ(outcome.restored, 1);
+    CHECK_EQ(calls.load(), 1);
+}
@@ -0,0 +1,100 @@
+#include "TestHarness.h"
+#include "RenderFpsPolicy.h"
+
+#include <vector>
+
+namespace {
+
+std::vector<RenderFpsTile> Tiles(int focused, int visible, int offscreen) {
+    std::vector<RenderFpsTile> tiles;
+    UserHandle user = 1;
+    for (int i = 0; i < focused; ++i) {
+        tiles.push_back(RenderFpsTile{ user++, true, true });
+    }
+    for (int i = 0; i < visible; ++i) {
+        tiles.push_back(RenderFpsTile{ user++, true, false });
+    }
+    for (int i = 0; i < offscreen; ++i) {
+        tiles.push_back(RenderFpsTile{ user++, false, false });
+    }
+    return tiles;
+}
+
+int Sum(const std::vector<int>& targets) {
+    int sum = 0;
+    for (int target : targets) {
+        sum += target;
+    }
+    return sum;
+}
+
+} // namespace
+
+TEST_CASE(RenderFpsPolicy, GridFpsByDensity) {
+    RenderFpsConfig config;
+    CHECK_EQ(RenderFpsPolicy::GridFps(config, 1), config.smallGridFps);
+    CHECK_EQ(RenderFpsPolicy::GridFps(config, 4), config.smallGridFps);
+    CHECK_EQ(RenderFpsPolicy::GridFps(config, 9), config.mediumGridFps);
+    CHECK_EQ(RenderFpsPolicy::GridFps(config, 25), config.largeGridFps);
+    CHECK_EQ(RenderFpsPolicy::GridFps(config, 26), config.denseGridFps);
+}
+
+TEST_CASE(RenderFpsPolicy, UnderBudgetGetsFullRates) {
+    RenderFpsConfig config;
+    std::vector<int> targets;
+    int total = RenderFpsPolicy::Compute(config, 9, Tiles(1, 8, 3), targets);
+    CHECK_EQ(targets[0], config.focusFps);
+    CHECK_EQ(targets[1], config.mediumGridFps);
+    CHECK_EQ(targets[9], config.minFps);
+    CHECK_EQ(total, config.focusFps + 8 * config.mediumGridFps + 3 * config.minFps);
+    CHECK_EQ(total, Sum(targets));
+}
+
+TEST_CASE(RenderFpsPolicy, UnfocusedTilesGiveWayFirst) {
+    RenderFpsConfig config;
+    config.budgetFps = 100;
+    std::vector<int> targets;
+    int total = RenderFpsPolicy::Compute(config, 25, Tiles(1, 20, 2), targets);
+    CHECK_EQ(total, 100);
+    CHECK_EQ(total, Sum(targets));
+    CHECK_EQ(targets[0], config.focusFps);
+    for (size_t i = 1; i <= 20; ++i) {
+        CHECK(targets[i] >= config.minFps);
+        CHECK(targets[i] <= config.largeGridFps);
+    }
+    CHECK_EQ(targets[21], config.minFps);
+}
+
+TEST_CASE(RenderFpsPolicy, FocusedTilesShareWhatIsLeft) {
+    RenderFpsConfig config;
+    config.budgetFps = 60;
+    std::vector<int> targets;
+    int total = RenderFpsPolicy::Compute(config, 4, Tiles(4, 4, 0), targets);
+    CHECK(total <= 60);
+    for (size_t i = 4; i < 8; ++i) {
+        CHECK_EQ(targets[i], config.minFps);
+    }
+    CHECK(targets[0] < config.focusFps);
+    CHECK(targets[0] > config.minFps);
+}
+
+TEST_CASE(RenderFpsPolicy, MinFpsFloorMayExceedTheBudget) {
+    RenderFpsConfig config;
+    config.budgetFps = 10;
+    std::vector<int> targets;
+    int total = RenderFpsPolicy::Compute(config, 100, Tiles(0, 100, 0), targets);
+    CHECK_EQ(total, 100 * config.minFps);
+}
+
+TEST_CASE(RenderFpsPolicy, FrameChangeCounterCountsChanges) {
+    FrameChangeCounter counter;
+    CHECK_EQ(counter.GetFps(0), 0.0);
+    counter.Reset(0);
+    const uint32_t samples[] = { 7, 7, 8, 9, 9, 7 };
+    for (int i = 0; i < 6; ++i) {
+        counter.AddSample(samples[i], i * 100);
+    }
+    CHECK_EQ(counter.GetSamples(), 6);
+    CHECK_EQ(counter.GetFrames(), 3);
+    CHECK_EQ(counter.GetFps(1000), 3.0);
+}
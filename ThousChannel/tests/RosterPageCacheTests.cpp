@@ -0,0 +1,90 @@
+#include "TestHarness.h"
+#include "RosterPageCache.h"
+
+#include <string>
+
+namespace {
+
+// Rows 0..count-1 with interned ids "roster-<n>"
+void FillTable(ChannelUserTable& table, int count) {
+    for (int i = 0; i < count; ++i) {
+        UserHandle user = UserIdInterner::instance().Intern("roster-" + std::to_string(i));
+        table.Add(user, i % 4 == 3 ? 0 : kNewRemoteUserFlags);
+    }
+}
+
+} // namespace
+
+TEST_CASE(RosterPageCache, PrefetchBuildsTheWindow) {
+    ChannelUserTable table;
+    FillTable(table, 100);
+    RosterPageCache cache(5);
+    cache.Prefetch(table, 10, 4, 2);
+    CHECK_EQ(cache.GetPageCount(), 5);
+
+    // Clipped at the first page
+    cache.Prefetch(table, 10, 0, 2);
+    CHECK_EQ(cache.GetPageCount(), 5);
+    cache.Clear();
+    cache.Prefetch(table, 10, 0, 2);
+    CHECK_EQ(cache.GetPageCount(), 3);
+}
+
+TEST_CASE(RosterPageCache, EntriesMatchTheTable) {
+    ChannelUserTable table;
+    FillTable(table, 25);
+    RosterPageCache cache;
+    cache.Prefetch(table, 10, 1, 0);
+
+    const RosterEntry& entry = cache.Get(table, 12);
+    CHECK_EQ(entry.user, table.GetUser(12));
+    CHECK_EQ(entry.displayName, std::string("roster-12"));
+    CHECK(entry.connected);
+
+    CHECK_EQ(cache.Get(table, 15).displayName, std::string("roster-15 (Offline)"));
+    CHECK(!cache.Get(table, 15).connected);
+
+    // Past the last row of a partial page
+    CHECK_EQ(cache.Get(table, 27).user, kInvalidUserHandle);
+    CHECK(cache.Get(table, 27).displayName.empty());
+}
+
+TEST_CASE(RosterPageCache, LeastRecentlyUsedPageIsEvicted) {
+    ChannelUserTable table;
+    FillTable(table, 100);
+    RosterPageCache cache(2);
+    cache.Get(table, 0);
+    cache.Get(table, 1);        // Row 1 is on page 0 at the default page size
+    cache.Get(table, 50);
+    CHECK_EQ(cache.GetPageCount(), 2);
+    cache.Get(table, 0);
+    cache.Get(table, 70);
+    CHECK_EQ(cache.GetPageCount(), 2);
+    CHECK(cache.GetMemoryUsage() > 0);
+}
+
+TEST_CASE(RosterPageCache, EditedTableRebuildsThePage) {
+    ChannelUserTable table;
+    FillTable(table, 20);
+    RosterPageCache cache;
+    cache.Prefetch(table, 10, 0, 0);
+    CHECK(cache.Get(table, 3).displayName != std::string("roster-3"));
+
+    table.Set(3, kUserConnected, true);
+    CHECK_EQ(cache.Get(table, 3).displayName, std::string("roster-3"));
+
+    table.InsertAt(0, UserIdInterner::instance().Intern("roster-new"), kNewRemoteUserFlags);
+    CHECK_EQ(cache.Get(table, 0).displayName, std::string("roster-new"));
+    CHECK_EQ(cache.Get(table, 4).displayName, std::string("roster-3"));
+}
+
+TEST_CASE(RosterPageCache, NewPageSizeDropsEverything) {
+    ChannelUserTable table;
+    FillTable(table, 100);
+    RosterPageCache cache;
+    cache.Prefetch(table, 10, 3, 1);
+    CHECK_EQ(cache.GetPageCount(), 3);
+    cache.Prefetch(table, 25, 0, 0);
+    CHECK_EQ(cache.GetPageCount(), 1);
+    CHECK_EQ(cache.Get(table, 24).displayName, table.GetDisplayName(24));
+}
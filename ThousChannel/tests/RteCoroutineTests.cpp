@@ -0,0 +1,164 @@
+#include "TestHarness.h"
+#include "RteCoroutine.h"
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace {
+
+// Holds the completion the SDK would have kept, so the test can fire it later
+struct PendingCall {
+    std::mutex mutex;
+    std::optional<RteCompletion<bool>> completion;
+    int starts = 0;
+
+    RteCallbackAwaiter<bool>::Starter Starter() {
+        return [this](RteCompletion<bool> done) {
+            std::lock_guard<std::mutex> lock(mutex);
+            completion.emplace(done);
+            ++starts;
+        };
+    }
+};
+
+struct Awaited {
+    RteAwaitResult<bool> result;
+    bool resumedOnLoop = false;
+};
+
+RteTask<Awaited> AwaitCall(std::string name, int timeoutMs, RteCancellationToken token,
+                           RteCallbackAwaiter<bool>::Starter starter) {
+    Awaited awaited;
+    awaited.result = co_await RteCallbackAwaiter<bool>(name, timeoutMs, token, starter);
+    RteEventLoop* loop = RteEventLoop::Current();
+    awaited.resumedOnLoop = loop && loop->IsCurrentThread();
+    co_return awaited;
+}
+
+RteTask<int> Answer() {
+    co_return 42;
+}
+
+} // namespace
+
+TEST_CASE(RteCoroutine, ResolvesFromAnotherThread) {
+    RteEventLoop loop("coro_test");
+    loop.Start();
+
+    RteTask<Awaited> task = AwaitCall("resolve", 5000, RteCancellationToken(), [](RteCompletion<bool> done) {
+        // Like an SDK callback: completes later on a thread of its own
+        std::thread([done]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            done.Resolve(true);
+        }).detach();
+    });
+    Awaited awaited = RteSyncWait(loop, std::move(task));
+
+    CHECK(awaited.result.status == RteOpStatus::Succeeded);
+    CHECK(awaited.result.value);
+    CHECK(awaited.resumedOnLoop);
+    loop.Stop();
+}
+
+TEST_CASE(RteCoroutine, TimesOutOnTheLoopDeadline) {
+    RteEventLoop loop("coro_test");
+    loop.Start();
+    PendingCall call;
+
+    auto start = std::chrono::steady_clock::now();
+    Awaited awaited = RteSyncWait(loop, AwaitCall("never", 20, RteCancellationToken(), call.Starter()));
+    auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    CHECK(awaited.result.status == RteOpStatus::TimedOut);
+    CHECK(!awaited.result.Succeeded());
+    CHECK(awaited.resumedOnLoop);
+    CHECK(elapsedMs >= 20);
+    CHECK(elapsedMs < 2000);
+    CHECK_EQ(call.starts, 1);
+    loop.Stop();
+}
+
+TEST_CASE(RteCoroutine, CancelWakesTheAwaiter) {
+    RteEventLoop loop("coro_test");
+    loop.Start();
+    RteCancellationSource source;
+    PendingCall call;
+
+    std::thread canceller([&source]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        source.Cancel();
+    });
+    Awaited awaited = RteSyncWait(loop, AwaitCall("cancelled", 60000, source.GetToken(), call.Starter()));
+    canceller.join();
+
+    CHECK(awaited.result.status == RteOpStatus::Cancelled);
+    CHECK(awaited.resumedOnLoop);
+    CHECK_EQ(call.starts, 1);
+
+    // An already cancelled token finishes without starting the call
+    Awaited again = RteSyncWait(loop, AwaitCall("pre_cancelled", 60000, source.GetToken(), call.Starter()));
+    CHECK(again.result.status == RteOpStatus::Cancelled);
+    CHECK_EQ(call.starts, 1);
+    loop.Stop();
+}
+
+TEST_CASE(RteCoroutine, LateCallbackIsDropped) {
+    RteEventLoop loop("coro_test");
+    loop.Start();
+    PendingCall call;
+
+    Awaited awaited = RteSyncWait(loop, AwaitCall("late", 10, RteCancellationToken(), call.Starter()));
+    CHECK(awaited.result.status == RteOpStatus::TimedOut);
+
+    // The awaiting frame is gone; the callback must only touch the shared state
+    std::optional<RteCompletion<bool>> completion;
+    {
+        std::lock_guard<std::mutex> lock(call.mutex);
+        completion = call.completion;
+    }
+    CHECK(completion.has_value());
+    if (completion) {
+        CHECK(!completion->Resolve(true));
+        CHECK(!completion->Fail(5));
+    }
+    CHECK(awaited.result.status == RteOpStatus::TimedOut);
+    loop.Stop();
+}
+
+TEST_CASE(RteCoroutine, FirstCompletionWins) {
+    RteEventLoop loop("coro_test");
+    loop.Start();
+
+    Awaited awaited = RteSyncWait(loop, AwaitCall("twice", 5000, RteCancellationToken(), [](RteCompletion<bool> done) {
+        CHECK(done.Fail(7));
+        CHECK(!done.Resolve(true));
+    }));
+
+    CHECK(awaited.result.status == RteOpStatus::Failed);
+    CHECK_EQ(awaited.result.errorCode, 7);
+    loop.Stop();
+}
+
+TEST_CASE(RteCoroutine, SyncWaitRefusesTheLoopThread) {
+    RteEventLoop loop("coro_test");
+    loop.Start();
+
+    CHECK_EQ(RteSyncWait(loop, Answer()), 42);
+
+    // Waiting on the loop from its own thread would deadlock; it returns a default instead
+    std::promise<int> fromLoop;
+    std::future<int> result = fromLoop.get_future();
+    CHECK(loop.Post([&loop, &fromLoop]() {
+        fromLoop.set_value(RteSyncWait(loop, Answer()));
+    }));
+    CHECK(result.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    CHECK_EQ(result.get(), 0);
+
+    loop.Stop();
+    CHECK_EQ(RteSyncWait(loop, Answer()), 0);
+}
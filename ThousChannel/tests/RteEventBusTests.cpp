@@ -0,0 +1,142 @@
+#include "TestHarness.h"
+#include "RteEventBus.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace {
+
+RteEventSubscriberOptions Inline(unsigned int typeMask = kRteEventMaskAll) {
+    RteEventSubscriberOptions options;
+    options.delivery = RteEventDelivery::Inline;
+    options.typeMask = typeMask;
+    return options;
+}
+
+bool WaitFor(const std::atomic<int>& value, int expected) {
+    for (int i = 0; i < 2000 && value.load() < expected; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return value.load() == expected;
+}
+
+} // namespace
+
+TEST_CASE(RteEventBus, DeliversByTypeMask) {
+    RteEventBus bus;
+    std::atomic<int> all(0);
+    std::atomic<int> joins(0);
+    std::atomic<int> queued(0);
+    bus.Subscribe("all", [&](const RteEvent&) { ++all; }, Inline());
+    bus.Subscribe("joins", [&](const RteEvent& event) {
+        CHECK(event.type == RteEventType::UserJoined);
+        ++joins;
+    }, Inline(RteEventMask(RteEventType::UserJoined)));
+    bus.Subscribe("queued", [&](const RteEvent&) { ++queued; });
+
+    bus.Publish(RteEvent::UserJoined(7));
+    bus.Publish(RteEvent::UserLeft(7));
+    bus.Publish(RteEvent::Error(1));
+    CHECK_EQ(all.load(), 3);
+    CHECK_EQ(joins.load(), 1);
+    CHECK(WaitFor(queued, 3));
+}
+
+TEST_CASE(RteEventBus, UnsubscribeStopsDelivery) {
+    RteEventBus bus;
+    std::atomic<int> calls(0);
+    int id = bus.Subscribe("inline", [&](const RteEvent&) { ++calls; }, Inline());
+    bus.Publish(RteEvent::UserListChanged());
+    bus.Unsubscribe(id);
+    bus.Publish(RteEvent::UserListChanged());
+    CHECK_EQ(calls.load(), 1);
+    bus.Unsubscribe(id);
+    CHECK(bus.GetStats().empty());
+}
+
+TEST_CASE(RteEventBus, InlineCallbackCanUnsubscribeItself) {
+    RteEventBus bus;
+    std::atomic<int> calls(0);
+    std::atomic<int> other(0);
+    int id = 0;
+    id = bus.Subscribe("once", [&](const RteEvent&) {
+        ++calls;
+        bus.Unsubscribe(id);
+    }, Inline());
+    bus.Subscribe("other", [&](const RteEvent&) { ++other; }, Inline());
+
+    bus.Publish(RteEvent::UserListChanged());
+    bus.Publish(RteEvent::UserListChanged());
+    CHECK_EQ(calls.load(), 1);
+    CHECK_EQ(other.load(), 2);
+    CHECK_EQ(bus.GetStats().size(), 1u);
+}
+
+TEST_CASE(RteEventBus, InlineCallbackCanUnsubscribeAnother) {
+    RteEventBus bus;
+    std::atomic<int> later(0);
+    int laterId = 0;
+    bus.Subscribe("first", [&](const RteEvent&) { bus.Unsubscribe(laterId); }, Inline());
+    laterId = bus.Subscribe("later", [&](const RteEvent&) { ++later; }, Inline());
+
+    // Removed before its turn in the same publish
+    bus.Publish(RteEvent::UserListChanged());
+    CHECK_EQ(later.load(), 0);
+    CHECK_EQ(bus.GetStats().size(), 1u);
+}
+
+TEST_CASE(RteEventBus, QueuedCallbackCanUnsubscribeItself) {
+    RteEventBus bus;
+    std::atomic<int> calls(0);
+    std::atomic<int> done(0);
+    int id = 0;
+    id = bus.Subscribe("queued", [&](const RteEvent&) {
+        if (++calls == 1) {
+            bus.Unsubscribe(id);
+            ++done;
+        }
+    });
+    bus.Publish(RteEvent::UserListChanged());
+    CHECK(WaitFor(done, 1));
+    bus.Publish(RteEvent::UserListChanged());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK_EQ(calls.load(), 1);
+    CHECK(bus.GetStats().empty());
+}
+
+TEST_CASE(RteEventBus, FullQueueDropsAndCounts) {
+    RteEventBus bus;
+    std::atomic<bool> release(false);
+    RteEventSubscriberOptions options;
+    options.queueCapacity = 4;
+    bus.Subscribe("slow", [&](const RteEvent&) {
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }, options);
+
+    for (int i = 0; i < 20; ++i) {
+        bus.Publish(RteEvent::UserListChanged());
+    }
+    std::vector<RteEventSubscriberStats> stats = bus.GetStats();
+    CHECK_EQ(stats.size(), 1u);
+    CHECK(stats[0].dropped >= 20u - 4u - 1u);
+    release.store(true);
+}
+
+TEST_CASE(RteEventBus, UserSnapshotCarriesTheRoster) {
+    RteEventBus bus;
+    std::atomic<int> received(0);
+    std::shared_ptr<const std::vector<UserHandle>> seen;
+    bus.Subscribe("queued", [&](const RteEvent& event) {
+        seen = event.roster;
+        ++received;
+    });
+
+    auto roster = std::make_shared<const std::vector<UserHandle>>(std::vector<UserHandle>{ 3, 4, 5 });
+    bus.Publish(RteEvent::UserSnapshot(roster));
+    CHECK(WaitFor(received, 1));
+    CHECK(seen == roster);
+    CHECK_EQ(RteEvent::UserSnapshot(roster).state, 3);
+}
@@ -0,0 +1,183 @@
+#include "TestHarness.h"
+#include "RteEventLoop.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Appends from the loop thread, read by the test thread after Stop
+struct Trace {
+    std::mutex mutex;
+    std::vector<std::string> entries;
+
+    void Add(const std::string& entry) {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.push_back(entry);
+    }
+
+    std::vector<std::string> Get() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries;
+    }
+};
+
+long long MillisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+TEST_CASE(RteEventLoop, PostRunsInOrder) {
+    RteEventLoop loop("loop_test");
+    std::vector<int> order;
+
+    // Posted before Start: queued until the worker runs
+    for (int i = 0; i < 100; ++i) {
+        CHECK(loop.Post([&order, i]() { order.push_back(i); }));
+    }
+    loop.Start();
+    for (int i = 100; i < 1000; ++i) {
+        CHECK(loop.Post([&order, i]() { order.push_back(i); }));
+    }
+    loop.Stop();
+
+    std::vector<int> expected;
+    for (int i = 0; i < 1000; ++i) {
+        expected.push_back(i);
+    }
+    CHECK_EQ(order.size(), 1000u);
+    CHECK(order == expected);
+}
+
+TEST_CASE(RteEventLoop, TasksRunOnTheLoopThread) {
+    RteEventLoop loop("loop_test");
+    loop.Start();
+    CHECK(!loop.IsCurrentThread());
+    CHECK(RteEventLoop::Current() == nullptr);
+
+    std::promise<bool> onLoop;
+    std::future<bool> result = onLoop.get_future();
+    loop.Post([&loop, &onLoop]() {
+        onLoop.set_value(loop.IsCurrentThread() && RteEventLoop::Current() == &loop);
+    });
+    CHECK(result.get());
+    loop.Stop();
+}
+
+TEST_CASE(RteEventLoop, DelayedTasksRunByDueTime) {
+    RteEventLoop loop("loop_test");
+    loop.Start();
+    Trace trace;
+    std::promise<long long> lastRan;
+    std::future<long long> lastMs = lastRan.get_future();
+
+    auto start = std::chrono::steady_clock::now();
+    loop.PostDelayed(60, [&trace, &lastRan, start]() {
+        trace.Add("late");
+        lastRan.set_value(MillisSince(start));
+    });
+    loop.PostDelayed(30, [&trace]() { trace.Add("mid_a"); });
+    loop.PostDelayed(30, [&trace]() { trace.Add("mid_b"); });
+    loop.PostDelayed(0, [&trace]() { trace.Add("now"); });
+    loop.Post([&trace]() { trace.Add("posted"); });
+
+    CHECK(lastMs.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    CHECK(lastMs.get() >= 60);
+    loop.Stop();
+
+    // Equal due times keep post order; a plain post is not held back by delayed ones
+    std::vector<std::string> entries = trace.Get();
+    CHECK_EQ(entries.size(), 5u);
+    if (entries.size() == 5) {
+        CHECK(entries[0] == "now" || entries[0] == "posted");
+        CHECK(entries[1] == "now" || entries[1] == "posted");
+        CHECK_EQ(entries[2], std::string("mid_a"));
+        CHECK_EQ(entries[3], std::string("mid_b"));
+        CHECK_EQ(entries[4], std::string("late"));
+    }
+}
+
+TEST_CASE(RteEventLoop, StopDrainsAndRefusesPosts) {
+    RteEventLoop loop("loop_test");
+    loop.Start();
+    Trace trace;
+    std::promise<void> blocked;
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+
+    loop.Post([&]() {
+        blocked.set_value();
+        released.wait();
+        trace.Add("first");
+        // Posted by a task during the drain: still runs
+        CHECK(loop.Post([&trace]() { trace.Add("from_loop"); }));
+    });
+    loop.Post([&trace]() { trace.Add("queued"); });
+    bool delayedPosted = loop.PostDelayed(10000, [&trace]() { trace.Add("delayed"); });
+    blocked.get_future().wait();
+
+    std::thread stopper([&loop]() { loop.Stop(); });
+    for (int i = 0; i < 2000 && !loop.IsStopped(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(loop.IsStopped());
+    CHECK(!loop.Post([&trace]() { trace.Add("refused"); }));
+    CHECK(!loop.PostDelayed(0, [&trace]() { trace.Add("refused_delayed"); }));
+
+    release.set_value();
+    stopper.join();
+
+    CHECK(delayedPosted);
+    std::vector<std::string> entries = trace.Get();
+    std::vector<std::string> expected = { "first", "queued", "from_loop" };
+    CHECK(entries == expected);
+    CHECK_EQ(loop.GetStats().queueDepth, 0u);
+
+    // Stopping twice and starting after a stop are harmless
+    loop.Stop();
+    loop.Start();
+    CHECK(!loop.Post([]() {}));
+}
+
+TEST_CASE(RteEventLoop, StatsTrackDepthAndSlowTasks) {
+    RteEventLoop loop("loop_test");
+    for (int i = 0; i < 8; ++i) {
+        loop.Post([]() {}, "quick");
+    }
+    CHECK_EQ(loop.GetStats().queueDepth, 8u);
+    CHECK_EQ(loop.GetStats().maxQueueDepth, 8u);
+
+    loop.SetSlowTaskThresholdMs(5);
+    loop.Post([]() { std::this_thread::sleep_for(std::chrono::milliseconds(20)); }, "slow");
+    loop.Start();
+    loop.Stop();
+
+    RteEventLoopStats stats = loop.GetStats();
+    CHECK_EQ(stats.executed, 9ull);
+    CHECK_EQ(stats.queueDepth, 0u);
+    CHECK_EQ(stats.maxQueueDepth, 9u);
+    CHECK_EQ(stats.maxRunLabel, std::string("slow"));
+    CHECK(stats.maxRunUs >= 20000);
+    CHECK(stats.totalRunUs >= stats.maxRunUs);
+    // Queued before Start, so every task waited at least until the worker ran
+    CHECK(stats.maxWaitUs > 0);
+}
+
+TEST_CASE(RteEventLoop, ThrowingTaskDoesNotStopTheLoop) {
+    RteEventLoop loop("loop_test");
+    loop.Start();
+    std::atomic<int> ran(0);
+    loop.Post([]() { throw std::runtime_error("task failed"); }, "throws");
+    loop.Post([&ran]() { ++ran; });
+    loop.Stop();
+    CHECK_EQ(ran.load(), 1);
+    CHECK_EQ(loop.GetStats().executed, 2ull);
+}
@@ -0,0 +1,151 @@
+#include "TestHarness.h"
+#include "RteStreamCatalog.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> UserStreamIds(const RteStreamCatalog& catalog, UserHandle user) {
+    std::vector<RteRemoteStreamRecord> records;
+    catalog.GetUserStreams(user, records);
+    std::vector<std::string> ids;
+    for (const RteRemoteStreamRecord& record : records) {
+        ids.push_back(record.streamId);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+// Both indexes agree with the dense record array
+bool IsConsistent(const RteStreamCatalog& catalog, UserHandle maxUser) {
+    for (const RteRemoteStreamRecord& record : catalog.GetRecords()) {
+        const RteRemoteStreamRecord* found = catalog.Find(record.streamId);
+        if (!found || found->streamId != record.streamId) {
+            return false;
+        }
+    }
+    for (UserHandle user = 1; user <= maxUser; ++user) {
+        std::vector<std::string> expected;
+        for (const RteRemoteStreamRecord& record : catalog.GetRecords()) {
+            if (record.user == user) {
+                expected.push_back(record.streamId);
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+        if (UserStreamIds(catalog, user) != expected) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE(RteStreamCatalog, RemoveMiddleRecordRelinksTheLast) {
+    RteStreamCatalog catalog;
+    CHECK(catalog.Update("s1", 1, true, true));
+    CHECK(catalog.Update("s2", 2, true, true));
+    CHECK(catalog.Update("s3", 3, true, false));
+    CHECK(catalog.Update("s4", 3, false, true));
+    CHECK(catalog.SetVideoSubscribed("s4", true));
+
+    CHECK(catalog.Remove("s2"));
+    CHECK(!catalog.Remove("s2"));
+    CHECK_EQ(catalog.Size(), 3u);
+    CHECK(catalog.Find("s2") == nullptr);
+    CHECK(UserStreamIds(catalog, 2).empty());
+
+    // s4 moved into the hole; both of its index entries must follow it
+    const RteRemoteStreamRecord* moved = catalog.Find("s4");
+    CHECK(moved != nullptr);
+    if (moved) {
+        CHECK_EQ(moved->user, 3u);
+        CHECK(moved->videoSubscribed);
+    }
+    const RteRemoteStreamRecord* video = catalog.FindUserVideoStream(3);
+    CHECK(video != nullptr);
+    if (video) {
+        CHECK_EQ(video->streamId, std::string("s4"));
+    }
+    CHECK(IsConsistent(catalog, 3));
+
+    // Removing the last record needs no move
+    CHECK(catalog.Remove("s3"));
+    CHECK(IsConsistent(catalog, 3));
+    CHECK(UserStreamIds(catalog, 3) == (std::vector<std::string>{ "s4" }));
+}
+
+TEST_CASE(RteStreamCatalog, RemoveUserDropsEveryStream) {
+    RteStreamCatalog catalog;
+    catalog.Update("a1", 1, true, true);
+    catalog.Update("b1", 2, true, true);
+    catalog.Update("a2", 1, false, true);
+    catalog.Update("b2", 2, true, false);
+    catalog.Update("a3", 1, true, false);
+    catalog.Update("c1", 3, true, true);
+
+    CHECK_EQ(catalog.RemoveUser(1), 3);
+    CHECK_EQ(catalog.Size(), 3u);
+    CHECK(UserStreamIds(catalog, 1).empty());
+    CHECK(catalog.FindUserVideoStream(1) == nullptr);
+    CHECK(UserStreamIds(catalog, 2) == (std::vector<std::string>{ "b1", "b2" }));
+    CHECK(IsConsistent(catalog, 3));
+
+    CHECK_EQ(catalog.RemoveUser(1), 0);
+    CHECK_EQ(catalog.RemoveUser(kInvalidUserHandle), 0);
+    CHECK_EQ(catalog.RemoveUser(99), 0);
+    CHECK_EQ(catalog.RemoveUser(3), 1);
+    CHECK_EQ(catalog.RemoveUser(2), 2);
+    CHECK_EQ(catalog.Size(), 0u);
+}
+
+TEST_CASE(RteStreamCatalog, UpdateMovesStreamToNewUser) {
+    RteStreamCatalog catalog;
+    CHECK(catalog.Update("s1", 1, true, true));
+    CHECK(catalog.Update("s2", 1, true, false));
+    CHECK(catalog.SetAudioSubscribed("s1", true));
+
+    CHECK(!catalog.Update("s1", 2, true, true));
+    CHECK(UserStreamIds(catalog, 1) == (std::vector<std::string>{ "s2" }));
+    CHECK(UserStreamIds(catalog, 2) == (std::vector<std::string>{ "s1" }));
+    CHECK(catalog.FindUserVideoStream(1) == nullptr);
+    CHECK(catalog.FindUserVideoStream(2) != nullptr);
+    CHECK(catalog.Find("s1")->audioSubscribed);
+    CHECK(IsConsistent(catalog, 2));
+
+    // A publisher the SDK did not name is in no user list
+    CHECK(!catalog.Update("s1", kInvalidUserHandle, true, true));
+    CHECK(UserStreamIds(catalog, 2).empty());
+    CHECK(catalog.Find("s1") != nullptr);
+    CHECK_EQ(catalog.RemoveUser(1), 1);
+    CHECK_EQ(catalog.Size(), 1u);
+}
+
+TEST_CASE(RteStreamCatalog, LosingMediaClearsSubscription) {
+    RteStreamCatalog catalog;
+    catalog.Update("s1", 1, true, true);
+    CHECK(catalog.SetAudioSubscribed("s1", true));
+    CHECK(catalog.SetVideoSubscribed("s1", true));
+
+    // Same media again keeps both subscriptions
+    catalog.Update("s1", 1, true, true);
+    CHECK(catalog.Find("s1")->audioSubscribed);
+    CHECK(catalog.Find("s1")->videoSubscribed);
+
+    catalog.Update("s1", 1, true, false);
+    CHECK(catalog.Find("s1")->audioSubscribed);
+    CHECK(!catalog.Find("s1")->videoSubscribed);
+
+    // Regaining the media does not resubscribe by itself
+    catalog.Update("s1", 1, true, true);
+    CHECK(!catalog.Find("s1")->videoSubscribed);
+
+    // Cannot subscribe media a stream does not carry; unsubscribing is always allowed
+    catalog.Update("s1", 1, false, true);
+    CHECK(!catalog.Find("s1")->audioSubscribed);
+    CHECK(!catalog.SetAudioSubscribed("s1", true));
+    CHECK(catalog.SetAudioSubscribed("s1", false));
+    CHECK(!catalog.SetVideoSubscribed("missing", false));
+}
@@ -0,0 +1,184 @@
+#include "TestHarness.h"
+#include "RteSubscriptionQueue.h"
+
+#include <map>
+#include <vector>
+
+namespace {
+
+// Views are only compared, never dereferenced
+void* View(int n) {
+    return reinterpret_cast<void*>(static_cast<uintptr_t>(0x1000 + n * 16));
+}
+
+RteSubscriptionTarget Target(UserHandle user, int view, bool visible = true) {
+    return RteSubscriptionTarget{ user, View(view), visible };
+}
+
+// Stands in for the SDK: which user renders into which view. A subscribe into
+// a view another user still renders into is a conflict.
+struct FakeSdk {
+    std::map<void*, UserHandle> renders;
+    int conflicts = 0;
+
+    void Apply(const RteSubscriptionCommand& command) {
+        for (auto it = renders.begin(); it != renders.end(); ++it) {
+            if (it->second == command.user) {
+                renders.erase(it);
+                break;
+            }
+        }
+        if (command.op == RteSubscriptionOp::Subscribe) {
+            if (renders.count(command.view)) {
+                ++conflicts;
+            }
+            renders[command.view] = command.user;
+        }
+    }
+};
+
+// Issue and complete commands until nothing is left; returns the number of rounds
+int Drain(RteSubscriptionQueue& queue, FakeSdk& sdk) {
+    int rounds = 0;
+    while (!queue.IsIdle() && rounds < 100) {
+        std::vector<RteSubscriptionCommand> commands;
+        queue.TakeReady(commands);
+        for (const RteSubscriptionCommand& command : commands) {
+            sdk.Apply(command);
+            queue.Complete(command.ticket, true);
+        }
+        ++rounds;
+    }
+    return rounds;
+}
+
+} // namespace
+
+TEST_CASE(RteSubscriptionQueue, IssuesAtMostMaxInFlight) {
+    RteSubscriptionQueue queue(2);
+    std::vector<uint64_t> cancel;
+    queue.SetDesired({ Target(1, 1), Target(2, 2), Target(3, 3) }, cancel);
+    CHECK(cancel.empty());
+
+    std::vector<RteSubscriptionCommand> commands;
+    queue.TakeReady(commands);
+    CHECK_EQ(commands.size(), 2u);
+    CHECK_EQ(commands[0].user, 1u);
+    CHECK_EQ(commands[1].user, 2u);
+    queue.TakeReady(commands);
+    CHECK_EQ(commands.size(), 2u);
+    CHECK_EQ(queue.GetStats().inFlight, 2);
+    CHECK_EQ(queue.GetStats().pending, 1);
+
+    CHECK(queue.Complete(commands[0].ticket, true));
+    CHECK(!queue.Complete(commands[0].ticket, true));
+    CHECK(queue.GetView(1) == View(1));
+    commands.clear();
+    queue.TakeReady(commands);
+    CHECK_EQ(commands.size(), 1u);
+    CHECK_EQ(commands[0].user, 3u);
+}
+
+TEST_CASE(RteSubscriptionQueue, VisibleBeforeOverscanBeforeTeardown) {
+    RteSubscriptionQueue queue(1);
+    FakeSdk sdk;
+    std::vector<uint64_t> cancel;
+    queue.SetDesired({ Target(9, 9) }, cancel);
+    Drain(queue, sdk);
+
+    queue.SetDesired({ Target(1, 1, false), Target(2, 2, true) }, cancel);
+    std::vector<UserHandle> order;
+    while (!queue.IsIdle()) {
+        std::vector<RteSubscriptionCommand> commands;
+        queue.TakeReady(commands);
+        for (const RteSubscriptionCommand& command : commands) {
+            order.push_back(command.user);
+            sdk.Apply(command);
+            queue.Complete(command.ticket, true);
+        }
+    }
+    CHECK(order == std::vector<UserHandle>({ 2, 1, 9 }));
+    CHECK(queue.GetView(9) == nullptr);
+}
+
+TEST_CASE(RteSubscriptionQueue, PageFlipsSupersedeAndCancel) {
+    RteSubscriptionQueue queue(1);
+    FakeSdk sdk;
+    std::vector<uint64_t> cancel;
+    queue.SetDesired({ Target(1, 1), Target(2, 2), Target(3, 3), Target(4, 4) }, cancel);
+    std::vector<RteSubscriptionCommand> commands;
+    queue.TakeReady(commands);
+    CHECK_EQ(commands.size(), 1u);
+
+    // Flip twice before the first subscribe comes back
+    queue.SetDesired({ Target(5, 1), Target(6, 2), Target(7, 3), Target(8, 4) }, cancel);
+    queue.SetDesired({ Target(9, 1), Target(10, 2), Target(11, 3), Target(12, 4) }, cancel);
+    CHECK_EQ(cancel.size(), 1u);
+    CHECK_EQ(cancel[0], commands[0].ticket);
+    CHECK(queue.GetStats().superseded >= 7u);
+
+    sdk.Apply(commands[0]);
+    queue.Complete(commands[0].ticket, true);
+    Drain(queue, sdk);
+    CHECK_EQ(sdk.conflicts, 0);
+    for (UserHandle user = 9; user <= 12; ++user) {
+        CHECK(queue.GetView(user) == View(static_cast<int>(user) - 8));
+    }
+    CHECK(queue.GetView(1) == nullptr);
+    CHECK_EQ(sdk.renders.size(), 4u);
+    // One cancelled subscribe, one unsubscribe for it, and the last page
+    CHECK_EQ(queue.GetStats().issued, 6u);
+}
+
+TEST_CASE(RteSubscriptionQueue, SwappedViewsNeverRenderTwice) {
+    RteSubscriptionQueue queue(4);
+    FakeSdk sdk;
+    std::vector<uint64_t> cancel;
+    queue.SetDesired({ Target(1, 1), Target(2, 2), Target(3, 3) }, cancel);
+    Drain(queue, sdk);
+
+    // Rotate the three users one view along
+    queue.SetDesired({ Target(1, 2), Target(2, 3), Target(3, 1) }, cancel);
+    Drain(queue, sdk);
+    CHECK(queue.IsIdle());
+    CHECK_EQ(sdk.conflicts, 0);
+    CHECK(queue.GetView(1) == View(2));
+    CHECK(queue.GetView(2) == View(3));
+    CHECK(queue.GetView(3) == View(1));
+}
+
+TEST_CASE(RteSubscriptionQueue, FailedSubscribeWaitsForRefresh) {
+    RteSubscriptionQueue queue(1);
+    std::vector<uint64_t> cancel;
+    queue.SetDesired({ Target(1, 1) }, cancel);
+    std::vector<RteSubscriptionCommand> commands;
+    queue.TakeReady(commands);
+    CHECK(queue.Complete(commands[0].ticket, false));
+    CHECK_EQ(queue.GetStats().failed, 1u);
+    CHECK(queue.IsIdle());
+    CHECK(queue.GetView(1) == nullptr);
+
+    commands.clear();
+    queue.TakeReady(commands);
+    CHECK(commands.empty());
+    queue.Refresh(1);
+    queue.TakeReady(commands);
+    CHECK_EQ(commands.size(), 1u);
+    CHECK(commands[0].view == View(1));
+}
+
+TEST_CASE(RteSubscriptionQueue, RemovedUserCompletionIsRefused) {
+    RteSubscriptionQueue queue(1);
+    std::vector<uint64_t> cancel;
+    queue.SetDesired({ Target(1, 1), Target(2, 1) }, cancel);
+    std::vector<RteSubscriptionCommand> commands;
+    queue.TakeReady(commands);
+    CHECK_EQ(commands.size(), 1u);
+    CHECK_EQ(commands[0].user, 1u);
+
+    CHECK_EQ(queue.RemoveUser(1), commands[0].ticket);
+    CHECK(!queue.Complete(commands[0].ticket, true));
+    CHECK(queue.GetView(1) == nullptr);
+    CHECK(queue.IsIdle());
+    CHECK_EQ(queue.RemoveUser(1), 0u);
+}
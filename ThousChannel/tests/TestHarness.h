@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdio>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Minimal self-registering test cases, so the tests need nothing beyond the
+// standard library. A case is named "<Suite>.<Name>"; the runner takes an
+// optional suite name and runs only that suite, one ctest entry per suite.
+namespace TestHarness {
+
+struct TestCase {
+    std::string suite;
+    std::string name;
+    std::function<void()> body;
+};
+
+std::vector<TestCase>& Registry();
+void ReportFailure(const char* file, int line, const std::string& message);
+
+struct Registrar {
+    Registrar(const char* suite, const char* name, std::function<void()> body) {
+        Registry().push_back(TestCase{ suite, name, body });
+    }
+};
+
+template<typename A, typename B>
+std::string Describe(const A& actual, const B& expected) {
+    std::ostringstream text;
+    text << "got " << actual << ", expected " << expected;
+    return text.str();
+}
+
+} // namespace TestHarness
+
+#define TEST_CASE(suite, name)                                                          \
+    static void suite##_##name();                                                       \
+    static TestHarness::Registrar suite##_##name##_registrar(#suite, #name, suite##_##name); \
+    static void suite##_##name()
+
+#define CHECK(condition)                                                                \
+    do {                                                                                \
+        if (!(condition)) {                                                             \
+            TestHarness::ReportFailure(__FILE__, __LINE__, "CHECK(" #condition ")");    \
+        }                                                                               \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                      \
+    do {                                                                                \
+        auto&& checkActual = (actual);                                                  \
+        auto&& checkExpected = (expected);                                              \
+        if (!(checkActual == checkExpected)) {                                          \
+            TestHarness::ReportFailure(__FILE__, __LINE__, #actual " == " #expected ": " + \
+                TestHarness::Describe(checkActual, checkExpected));                     \
+        }                                                                               \
+    } while (0)
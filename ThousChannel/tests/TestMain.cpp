@@ -0,0 +1,47 @@
+#include "TestHarness.h"
+
+#include <cstring>
+
+namespace TestHarness {
+
+namespace {
+int g_failures = 0;
+}
+
+std::vector<TestCase>& Registry() {
+    static std::vector<TestCase> registry;
+    return registry;
+}
+
+void ReportFailure(const char* file, int line, const std::string& message) {
+    ++g_failures;
+    fprintf(stderr, "%s:%d: %s\n", file, line, message.c_str());
+}
+
+} // namespace TestHarness
+
+// thouschannel_tests [suite]
+int main(int argc, char** argv) {
+    const char* suite = argc > 1 ? argv[1] : nullptr;
+    int run = 0;
+    int failed = 0;
+    for (const TestHarness::TestCase& test : TestHarness::Registry()) {
+        if (suite && test.suite != suite) {
+            continue;
+        }
+        int failuresBefore = TestHarness::g_failures;
+        test.body();
+        ++run;
+        bool ok = TestHarness::g_failures == failuresBefore;
+        if (!ok) {
+            ++failed;
+        }
+        printf("[%s] %s.%s\n", ok ? "  OK  " : " FAIL ", test.suite.c_str(), test.name.c_str());
+    }
+    if (run == 0) {
+        fprintf(stderr, "no tests%s%s\n", suite ? " in suite " : "", suite ? suite : "");
+        return 1;
+    }
+    printf("%d tests, %d failed\n", run, failed);
+    return failed == 0 ? 0 : 1;
+}
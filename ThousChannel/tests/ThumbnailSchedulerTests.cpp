@@ -0,0 +1,141 @@
+#include "TestHarness.h"
+#include "ThumbnailScheduler.h"
+
+#include <vector>
+
+namespace {
+
+ThumbnailSchedulerConfig TwoSlots() {
+    ThumbnailSchedulerConfig config;
+    config.slotCount = 2;
+    config.maxStartsPerSecond = 1;
+    config.refreshIntervalMs = 5000;
+    config.grabDelayMs = 400;
+    config.captureTimeoutMs = 2500;
+    return config;
+}
+
+int CountActions(const std::vector<ThumbnailAction>& actions, ThumbnailActionType type) {
+    int count = 0;
+    for (const ThumbnailAction& action : actions) {
+        count += action.type == type ? 1 : 0;
+    }
+    return count;
+}
+
+} // namespace
+
+TEST_CASE(ThumbnailScheduler, FillsSlotsThenGrabsAndReleases) {
+    ThumbnailScheduler scheduler(TwoSlots());
+    scheduler.SetUsers({ 1, 2, 3 });
+
+    std::vector<ThumbnailAction> actions;
+    scheduler.Tick(0, actions);
+    CHECK_EQ(actions.size(), 2u);
+    CHECK(actions[0].type == ThumbnailActionType::Start);
+    CHECK_EQ(actions[0].user, 1u);
+    CHECK_EQ(actions[1].user, 2u);
+    CHECK_EQ(scheduler.GetBusySlots(), 2);
+
+    actions.clear();
+    scheduler.Tick(100, actions);
+    CHECK(actions.empty());
+
+    actions.clear();
+    scheduler.Tick(400, actions);
+    CHECK_EQ(CountActions(actions, ThumbnailActionType::Grab), 2);
+
+    scheduler.OnFrameCaptured(1, 450);
+    CHECK_EQ(scheduler.GetLastCaptureMs(1), 450);
+    actions.clear();
+    scheduler.Tick(500, actions);
+    CHECK_EQ(CountActions(actions, ThumbnailActionType::Stop), 1);
+    CHECK_EQ(CountActions(actions, ThumbnailActionType::Start), 0);
+    CHECK_EQ(scheduler.GetBusySlots(), 1);
+}
+
+TEST_CASE(ThumbnailScheduler, StartsAreRateLimited) {
+    ThumbnailScheduler scheduler(TwoSlots());
+    scheduler.SetUsers({ 1, 2, 3, 4 });
+    std::vector<ThumbnailAction> actions;
+    scheduler.Tick(0, actions);
+    scheduler.OnFrameCaptured(1, 100);
+    scheduler.OnFrameCaptured(2, 100);
+
+    // Both slots free at 200ms, but the bucket refills at one start per second
+    actions.clear();
+    scheduler.Tick(200, actions);
+    CHECK_EQ(CountActions(actions, ThumbnailActionType::Start), 0);
+    actions.clear();
+    scheduler.Tick(1000, actions);
+    CHECK_EQ(CountActions(actions, ThumbnailActionType::Start), 1);
+    CHECK_EQ(actions.back().user, 3u);
+    CHECK_EQ(scheduler.GetStats().starts, 3u);
+}
+
+TEST_CASE(ThumbnailScheduler, SlotWithoutFrameTimesOut) {
+    ThumbnailScheduler scheduler(TwoSlots());
+    scheduler.SetUsers({ 1 });
+    std::vector<ThumbnailAction> actions;
+    scheduler.Tick(0, actions);
+    actions.clear();
+    scheduler.Tick(2500, actions);
+    CHECK_EQ(CountActions(actions, ThumbnailActionType::Stop), 1);
+    CHECK_EQ(scheduler.GetStats().timeouts, 1u);
+    CHECK_EQ(scheduler.GetLastCaptureMs(1), -1);
+}
+
+TEST_CASE(ThumbnailScheduler, FreshThumbnailIsNotRefreshed) {
+    ThumbnailScheduler scheduler(TwoSlots());
+    scheduler.SetUsers({ 1 });
+    std::vector<ThumbnailAction> actions;
+    scheduler.Tick(0, actions);
+    scheduler.OnFrameCaptured(1, 500);
+    scheduler.Tick(600, actions);
+
+    actions.clear();
+    scheduler.Tick(4999, actions);
+    CHECK_EQ(CountActions(actions, ThumbnailActionType::Start), 0);
+    scheduler.Tick(5000, actions);
+    CHECK_EQ(CountActions(actions, ThumbnailActionType::Start), 1);
+
+    scheduler.OnFrameCaptured(1, 5500);
+    CHECK_EQ(scheduler.GetStats().meanRefreshAgeMs, 5000.0);
+}
+
+TEST_CASE(ThumbnailScheduler, ActiveUsersComeFirst) {
+    ThumbnailSchedulerConfig config = TwoSlots();
+    config.slotCount = 1;
+    ThumbnailScheduler scheduler(config);
+    scheduler.SetUsers({ 1, 2, 3 });
+    scheduler.MarkActive(3, 0);
+    std::vector<ThumbnailAction> actions;
+    scheduler.Tick(0, actions);
+    CHECK_EQ(actions.size(), 1u);
+    CHECK_EQ(actions[0].user, 3u);
+}
+
+TEST_CASE(ThumbnailScheduler, RemovedUserAndSurplusSlotAreStopped) {
+    ThumbnailScheduler scheduler(TwoSlots());
+    scheduler.SetUsers({ 1, 2 });
+    std::vector<ThumbnailAction> actions;
+    scheduler.Tick(0, actions);
+
+    scheduler.SetUsers({ 2 });
+    actions.clear();
+    scheduler.Tick(100, actions);
+    CHECK_EQ(CountActions(actions, ThumbnailActionType::Stop), 1);
+    CHECK_EQ(actions[0].user, 1u);
+
+    ThumbnailSchedulerConfig config = TwoSlots();
+    config.slotCount = 0;
+    scheduler.SetConfig(config);
+    actions.clear();
+    scheduler.Tick(200, actions);
+    CHECK_EQ(CountActions(actions, ThumbnailActionType::Stop), 1);
+    CHECK_EQ(scheduler.GetBusySlots(), 0);
+
+    actions.clear();
+    scheduler.StopAll(actions);
+    CHECK(actions.empty());
+}
@@ -0,0 +1,107 @@
+#include "TestHarness.h"
+#include "UserIdInterner.h"
+
+#include <atomic>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The interner is process-wide and other suites intern ids too, so every case
+// uses its own id prefix and never assumes absolute handle values.
+
+TEST_CASE(UserIdInterner, RepeatedInternReturnsSameHandle) {
+    UserIdInterner& interner = UserIdInterner::instance();
+    UserHandle first = interner.Intern("interner_repeat_a");
+    UserHandle second = interner.Intern("interner_repeat_b");
+
+    CHECK(first != kInvalidUserHandle);
+    CHECK(second != kInvalidUserHandle);
+    CHECK(first != second);
+    CHECK_EQ(interner.Intern("interner_repeat_a"), first);
+    CHECK_EQ(interner.Intern(std::string("interner_repeat_") + "b"), second);
+    CHECK_EQ(interner.Find("interner_repeat_a"), first);
+    CHECK_EQ(interner.GetString(first), std::string("interner_repeat_a"));
+    CHECK_EQ(UserIdString(second), std::string("interner_repeat_b"));
+}
+
+TEST_CASE(UserIdInterner, EmptyAndUnknown) {
+    UserIdInterner& interner = UserIdInterner::instance();
+    size_t before = interner.Size();
+
+    CHECK_EQ(interner.Intern(""), kInvalidUserHandle);
+    CHECK_EQ(interner.Find(""), kInvalidUserHandle);
+    CHECK_EQ(interner.Find("interner_never_interned"), kInvalidUserHandle);
+    CHECK_EQ(interner.Size(), before);
+
+    CHECK(interner.GetString(kInvalidUserHandle).empty());
+    CHECK(interner.GetString(static_cast<UserHandle>(interner.Size() + 1)).empty());
+    CHECK(interner.GetString(0xFFFFFFFFu).empty());
+}
+
+TEST_CASE(UserIdInterner, HandlesPastTheFirstChunk) {
+    UserIdInterner& interner = UserIdInterner::instance();
+    const int count = 3000;     // Spans at least three 1024-entry chunks
+    std::vector<UserHandle> handles;
+    for (int i = 0; i < count; ++i) {
+        handles.push_back(interner.Intern("interner_chunk_" + std::to_string(i)));
+    }
+
+    CHECK(interner.Size() >= static_cast<size_t>(count));
+    std::set<UserHandle> distinct(handles.begin(), handles.end());
+    CHECK_EQ(distinct.size(), static_cast<size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        CHECK(handles[i] != kInvalidUserHandle);
+        CHECK_EQ(interner.GetString(handles[i]), "interner_chunk_" + std::to_string(i));
+        CHECK_EQ(interner.Intern("interner_chunk_" + std::to_string(i)), handles[i]);
+    }
+    // Nothing else interns while this case runs, so the handles are dense
+    CHECK_EQ(handles.back() - handles.front(), static_cast<UserHandle>(count - 1));
+}
+
+TEST_CASE(UserIdInterner, ConcurrentInternAndGetString) {
+    UserIdInterner& interner = UserIdInterner::instance();
+    const int threadCount = 8;
+    const int idCount = 2500;
+    std::vector<std::vector<UserHandle>> seen(threadCount, std::vector<UserHandle>(idCount));
+    std::atomic<int> mismatches(0);
+    std::atomic<bool> go(false);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t]() {
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+            // Half the threads walk the ids backwards so they race on both ends
+            for (int n = 0; n < idCount; ++n) {
+                int i = (t % 2 == 0) ? n : idCount - 1 - n;
+                std::string id = "interner_race_" + std::to_string(i);
+                UserHandle handle = interner.Intern(id);
+                seen[t][i] = handle;
+                if (interner.GetString(handle) != id) {
+                    ++mismatches;
+                }
+                // Read a handle another thread may have just published
+                UserHandle latest = static_cast<UserHandle>(interner.Size());
+                if (latest != kInvalidUserHandle && interner.GetString(latest).empty()) {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+    go = true;
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    CHECK_EQ(mismatches.load(), 0);
+    std::set<UserHandle> distinct;
+    for (int i = 0; i < idCount; ++i) {
+        distinct.insert(seen[0][i]);
+        for (int t = 1; t < threadCount; ++t) {
+            CHECK_EQ(seen[t][i], seen[0][i]);
+        }
+    }
+    CHECK_EQ(distinct.size(), static_cast<size_t>(idCount));
+}
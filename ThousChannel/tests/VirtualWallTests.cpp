@@ -0,0 +1,134 @@
+#include "TestHarness.h"
+#include "VirtualWall.h"
+
+#include <vector>
+
+namespace {
+
+// Four 100x100 tiles per band, a 250 pixel viewport and one band of overscan
+void SetUpWall(VirtualWall& wall, int items) {
+    std::vector<LayoutRect> band;
+    for (int column = 0; column < 4; ++column) {
+        band.push_back(LayoutRect(column * 100, 0, column * 100 + 98, 98));
+    }
+    wall.SetGeometry(band, 100, 250, 1);
+    wall.SetItemCount(items);
+}
+
+} // namespace
+
+TEST_CASE(VirtualWall, RangesFollowTheOffset) {
+    VirtualWall wall;
+    SetUpWall(wall, 1000);
+    CHECK_EQ(wall.GetContentHeight(), 25000);
+    CHECK_EQ(wall.GetMaxOffset(), 24750);
+    CHECK(wall.GetVisibleRange() == WallRange(0, 12));
+    CHECK(wall.GetLiveRange() == WallRange(0, 16));
+
+    CHECK(wall.ScrollTo(150, 0));
+    CHECK(wall.GetVisibleRange() == WallRange(4, 16));
+    CHECK(wall.GetLiveRange() == WallRange(0, 20));
+
+    // Clamped to the end; the last band is partly filled
+    wall.SetItemCount(1002);
+    CHECK(wall.ScrollTo(1000000, 10));
+    CHECK_EQ(wall.GetOffset(), 25100 - 250);
+    CHECK(wall.GetVisibleRange() == WallRange(992, 1002));
+    CHECK(wall.GetLiveRange() == WallRange(988, 1002));
+    CHECK(!wall.ScrollBy(10, 20));
+}
+
+TEST_CASE(VirtualWall, LiveRangeNeverExceedsCellCapacity) {
+    VirtualWall wall;
+    SetUpWall(wall, 1000);
+    CHECK_EQ(wall.GetCellCapacity(), 24);
+    for (int offset = 0; offset <= wall.GetMaxOffset(); offset += 7) {
+        wall.ScrollTo(offset, offset);
+        CHECK(wall.GetLiveRange().Count() <= wall.GetCellCapacity());
+    }
+}
+
+TEST_CASE(VirtualWall, ItemRectIsRelativeToTheViewport) {
+    VirtualWall wall;
+    SetUpWall(wall, 1000);
+    wall.ScrollTo(150, 0);
+    CHECK(wall.GetItemRect(5) == LayoutRect(100, -50, 198, 48));
+    CHECK(wall.GetItemRect(-1) == LayoutRect());
+}
+
+TEST_CASE(VirtualWall, AssignCellsKeepsCellsOfItemsStillLive) {
+    VirtualWall wall;
+    SetUpWall(wall, 1000);
+    std::vector<int> cells(wall.GetCellCapacity(), -1);
+    std::vector<int> rebound;
+    wall.AssignCells(cells, rebound, false);
+    CHECK_EQ(rebound.size(), 16u);
+    CHECK_EQ(cells[0], 0);
+    CHECK_EQ(cells[15], 15);
+    CHECK_EQ(cells[16], -1);
+
+    // One band down: items 16..19 enter and take the free cells
+    wall.ScrollTo(100, 0);
+    rebound.clear();
+    wall.AssignCells(cells, rebound, false);
+    CHECK_EQ(rebound.size(), 4u);
+    CHECK_EQ(cells[0], 0);
+    CHECK_EQ(cells[16], 16);
+
+    // Three bands further items 0..11 leave, and their cells go to 20..31
+    wall.ScrollTo(400, 0);
+    rebound.clear();
+    wall.AssignCells(cells, rebound, false);
+    CHECK(wall.GetLiveRange() == WallRange(12, 32));
+    CHECK_EQ(cells[12], 12);
+    std::vector<char> seen(32, 0);
+    for (int item : cells) {
+        if (item >= 0) {
+            CHECK(wall.GetLiveRange().Contains(item));
+            CHECK(!seen[item]);
+            seen[item] = 1;
+        }
+    }
+
+    rebound.clear();
+    wall.AssignCells(cells, rebound, true);
+    CHECK_EQ(rebound.size(), cells.size());
+    CHECK_EQ(cells[0], 12);
+}
+
+TEST_CASE(VirtualWall, FastScrollIsNotSettled) {
+    VirtualWall wall;
+    SetUpWall(wall, 1000);
+    wall.SetSettlePolicy(1000.0, 150);
+
+    // The first scroll has nothing to measure against
+    wall.ScrollTo(100, 1000);
+    CHECK(wall.IsSettled(1000));
+
+    // 100 pixels in 10ms is 10000 px/s
+    wall.ScrollTo(200, 1010);
+    CHECK(wall.GetVelocity(1010) > 1000.0);
+    CHECK(!wall.IsSettled(1010));
+    CHECK(wall.IsSettled(1010 + 150));
+    CHECK_EQ(wall.GetVelocity(1010 + 150), 0.0);
+}
+
+TEST_CASE(VirtualWall, BandFromLayout) {
+    LayoutRect container(0, 50, 400, 350);
+    std::vector<LayoutRect> band;
+    int bandHeight = 0;
+
+    Layout grid = LayoutEngine::Compute(LayoutSpec::Grid(4, 3), container);
+    VirtualWall::BandFromLayout(grid, container, band, bandHeight);
+    CHECK_EQ(band.size(), 4u);
+    CHECK_EQ(bandHeight, 100);
+    CHECK_EQ(band[0].top, 0);
+
+    // A layout with a large tile repeats whole
+    LayoutSpec pinned = LayoutSpec::Grid(3, 3);
+    pinned.pinnedTiles = { 0 };
+    Layout stage = LayoutEngine::Compute(pinned, container);
+    VirtualWall::BandFromLayout(stage, container, band, bandHeight);
+    CHECK_EQ(band.size(), 6u);
+    CHECK_EQ(bandHeight, 300);
+}
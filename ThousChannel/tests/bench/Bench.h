@@ -0,0 +1,29 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Self-registering timing runs for thouschannel_bench. Each prints its own
+// results; the runner takes an optional benchmark name.
+namespace Bench {
+
+struct Benchmark {
+    std::string name;
+    std::function<void()> body;
+};
+
+std::vector<Benchmark>& Registry();
+
+struct Registrar {
+    Registrar(const char* name, std::function<void()> body) {
+        Registry().push_back(Benchmark{ name, body });
+    }
+};
+
+} // namespace Bench
+
+#define BENCHMARK(name)                                                     \
+    static void Bench_##name();                                             \
+    static Bench::Registrar Bench_##name##_registrar(#name, Bench_##name);  \
+    static void Bench_##name()
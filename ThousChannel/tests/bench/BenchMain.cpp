@@ -0,0 +1,31 @@
+#include "Bench.h"
+
+#include <cstdio>
+
+namespace Bench {
+
+std::vector<Benchmark>& Registry() {
+    static std::vector<Benchmark> registry;
+    return registry;
+}
+
+} // namespace Bench
+
+// thouschannel_bench [name]
+int main(int argc, char** argv) {
+    const char* name = argc > 1 ? argv[1] : nullptr;
+    int run = 0;
+    for (const Bench::Benchmark& benchmark : Bench::Registry()) {
+        if (name && benchmark.name != name) {
+            continue;
+        }
+        printf("== %s\n", benchmark.name.c_str());
+        benchmark.body();
+        ++run;
+    }
+    if (run == 0) {
+        fprintf(stderr, "no benchmark%s%s\n", name ? " named " : "", name ? name : "");
+        return 1;
+    }
+    return 0;
+}
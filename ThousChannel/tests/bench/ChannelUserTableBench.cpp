@@ -0,0 +1,57 @@
+#include "Bench.h"
+#include "ChannelUserTable.h"
+#include "RosterPageCache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// Memory per user in the table, against the former heap-allocated ChannelUser
+BENCHMARK(ChannelUserTableMemory) {
+    static const int kUserCounts[] = { 1000, 10000, 50000, 100000 };
+    static const int kFindSamples = 1000;
+
+    // Layout of the former ChannelUser, plus its CArray slot
+    struct LegacyChannelUser {
+        std::string userId;
+        bool isLocal, isRobot, isConnected, isVideoSubscribed, isAudioSubscribed, isCurrentlyVisible;
+        int lastVisiblePage;
+    };
+    size_t legacyBytes = sizeof(LegacyChannelUser) + sizeof(void*);
+    printf("per-object layout was >= %zu bytes/user\n", legacyBytes);
+
+    for (int users : kUserCounts) {
+        ChannelUserTable table;
+        for (int i = 0; i < users; ++i) {
+            // Handles are not interned here, only the columns are measured
+            ChannelUserFlags flags = kNewRemoteUserFlags;
+            if (i % 3 == 0) {
+                flags |= UserFlag(kUserVideoOn);
+            }
+            table.Add(static_cast<UserHandle>(i + 1), flags);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        volatile int matched = table.Count(UserFlag(kUserConnected) | UserFlag(kUserVideoOn));
+        auto end = std::chrono::steady_clock::now();
+        (void)matched;
+
+        auto findStart = std::chrono::steady_clock::now();
+        volatile int found = 0;
+        for (int i = 0; i < kFindSamples; ++i) {
+            found = found + table.Find(static_cast<UserHandle>(1 + (i * 7919) % users));
+        }
+        auto findEnd = std::chrono::steady_clock::now();
+
+        // The view in the middle of the audience, with its neighbours
+        RosterPageCache cache;
+        cache.Prefetch(table, 25, users / 50, 2);
+
+        size_t tableBytes = table.GetMemoryUsage();
+        printf("%6d users: %8zu bytes, %5.2f bytes/user, count scan %7.2fus, find %6.1fns, page cache %zu bytes\n",
+            users, tableBytes, static_cast<double>(tableBytes) / users,
+            std::chrono::duration<double, std::micro>(end - start).count(),
+            std::chrono::duration<double, std::nano>(findEnd - findStart).count() / kFindSamples,
+            cache.GetMemoryUsage());
+    }
+}
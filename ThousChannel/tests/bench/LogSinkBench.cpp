@@ -0,0 +1,126 @@
+#include "Bench.h"
+#include "LogSink.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* const kBenchDirectory = "bench_logs";
+
+// A line as long as a typical formatted one
+const std::string kLine =
+    "[2024-05-01 12:30:00.123] [ThousChannel] [INFO] [rte] Remote stream added: stream_1234 of user_5678, audio=1, video=1\n";
+
+// `lines` lines from `threads` threads behind one mutex, as the logger
+// writes them, then a flush
+double WriteLines(ILogSink& sink, int threads, int lines) {
+    std::mutex mutex;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            int count = lines / threads + (t < lines % threads ? 1 : 0);
+            for (int i = 0; i < count; ++i) {
+                std::lock_guard<std::mutex> lock(mutex);
+                sink.Write(kLine.data(), kLine.size());
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    sink.Flush();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+// An unbuffered FileLogSink (the old flush-per-line path) against mapped
+// segments, at several thread counts
+BENCHMARK(MappedLogSink) {
+    const int kLines = 200000;
+    std::string path = std::string(kBenchDirectory) + "/log_benchmark.log";
+    for (int threads : { 1, 4, 8 }) {
+        double fileMs;
+        double mappedMs;
+        {
+            FileLogSink file(0);
+            file.Open(path, true);
+            fileMs = WriteLines(file, threads, kLines);
+        }
+        {
+            MappedLogSink mapped(16 * 1024 * 1024, 64 * 1024 * 1024);
+            mapped.Open(path);
+            mappedMs = WriteLines(mapped, threads, kLines);
+        }
+        printf("%d lines, %d threads: ofstream %.1fms, mapped %.1fms\n", kLines, threads, fileMs, mappedMs);
+        std::error_code error;
+        std::filesystem::remove_all(kBenchDirectory, error);
+    }
+}
+
+// Producer time and bytes on disk for templated session lines, through an
+// unbuffered FileLogSink and through the compressed sink. Lines are formatted
+// up front, only the sink is timed.
+BENCHMARK(CompressedLogSink) {
+    const int kLines = 200000;
+    static const char* const kTemplates[] = {
+        "[2024-05-01 12:%02d:%02d.%03d] [ThousChannel] [INFO] [rte] Remote stream added: stream_%d of user_%d, audio=1, video=%d\n",
+        "[2024-05-01 12:%02d:%02d.%03d] [ThousChannel] [DEBUG] [ui] Video subscription for user user_%d set to %d (page %d)\n",
+        "[2024-05-01 12:%02d:%02d.%03d] [ThousChannel] [INFO] [rte] RteEventLoop rte_manager: %d tasks, queue depth %d (max %d)\n",
+        "[2024-05-01 12:%02d:%02d.%03d] [ThousChannel] [WARN] [layout] Render probe: %d cells drawn in %dus, budget %dus\n",
+    };
+
+    std::vector<std::string> lines;
+    lines.reserve(kLines);
+    uint64_t rawBytes = 0;
+    char line[256];
+    for (int i = 0; i < kLines; ++i) {
+        int ms = i * 7;
+        snprintf(line, sizeof(line), kTemplates[i % 4], ms / 60000 % 60, ms / 1000 % 60, ms % 1000,
+            (i * 7919) % 5000, i * 37 % 10000, i % 2);
+        lines.push_back(line);
+        rawBytes += lines.back().size();
+    }
+
+    std::string path = std::string(kBenchDirectory) + "/log_benchmark.log";
+    for (int pass = 0; pass < 2; ++pass) {
+        FileLogSink file(0);
+        CompressedLogSink compressed(CompressedLogSink::kDefaultFrameBytes, 0, 0);
+        ILogSink* sink;
+        if (pass == 0) {
+            file.Open(path, true);
+            sink = &file;
+        } else {
+            compressed.Open(path);
+            sink = &compressed;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string& text : lines) {
+            sink->Write(text.data(), text.size());
+        }
+        sink->Flush();
+        auto end = std::chrono::steady_clock::now();
+
+        uint64_t diskBytes;
+        if (pass == 0) {
+            diskBytes = file.GetSize();
+            file.Close();
+        } else {
+            compressed.Close();
+            diskBytes = compressed.GetCompressedBytes();
+        }
+        printf("%d lines, %s: %.1fms on the logging thread, %llu bytes on disk for %llu bytes of log\n",
+            kLines, pass == 0 ? "ofstream" : "lz4", std::chrono::duration<double, std::milli>(end - start).count(),
+            static_cast<unsigned long long>(diskBytes), static_cast<unsigned long long>(rawBytes));
+        std::error_code error;
+        std::filesystem::remove_all(kBenchDirectory, error);
+    }
+}
@@ -0,0 +1,50 @@
+#include "Bench.h"
+#include "LogStore.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// A session of 1M lines over 1000 users, then a filter on one user (the log
+// pane's common case) and a warnings-with-text filter (a scan)
+BENCHMARK(LogStore) {
+    const int kLines = 1000000;
+    const int kUsers = 1000;
+    const int kCategoryCount = static_cast<int>(LogCategory::Count);
+
+    // Handles are not interned here, the store only compares them
+    LogStore store(kLines, LogStore::kDefaultMaxTextBytes);
+    const LogLevel levels[] = { LogLevel::Debug, LogLevel::Info, LogLevel::Info, LogLevel::Info, LogLevel::Warn };
+    std::string text;
+    auto fillStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < kLines; ++i) {
+        UserHandle user = (i % 4 == 0) ? kInvalidUserHandle : static_cast<UserHandle>(1 + (i * 7919) % kUsers);
+        text = "Remote video state changed for user bench_" + std::to_string(user) + ", state=" + std::to_string(i % 5);
+        store.Append(i, 1, levels[i % 5], static_cast<LogCategory>(i % kCategoryCount), user, text);
+    }
+    auto fillEnd = std::chrono::steady_clock::now();
+
+    std::vector<uint64_t> rows;
+    LogFilter byUser;
+    byUser.user = 42;
+    auto userStart = std::chrono::steady_clock::now();
+    store.Query(byUser, 0, rows);
+    auto userEnd = std::chrono::steady_clock::now();
+    size_t userRows = rows.size();
+
+    rows.clear();
+    LogFilter byText;
+    byText.minLevel = LogLevel::Warn;
+    byText.text = "bench_42,";
+    auto textStart = std::chrono::steady_clock::now();
+    store.Query(byText, 0, rows);
+    auto textEnd = std::chrono::steady_clock::now();
+
+    printf("%d lines: filled in %.1fms, %zu bytes\n",
+        kLines, std::chrono::duration<double, std::milli>(fillEnd - fillStart).count(), store.GetMemoryUsage());
+    printf("%d lines: one user, %zu rows in %.2fms\n",
+        kLines, userRows, std::chrono::duration<double, std::milli>(userEnd - userStart).count());
+    printf("%d lines: warnings with text, %zu rows in %.2fms\n",
+        kLines, rows.size(), std::chrono::duration<double, std::milli>(textEnd - textStart).count());
+}
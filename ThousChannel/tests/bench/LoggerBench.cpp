@@ -0,0 +1,91 @@
+#define LOG_CATEGORY LogCategory::Rte
+#include "Bench.h"
+#include "Logger.h"
+#include "LogStore.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* const kBenchDirectory = "bench_logs";
+
+// 4 threads writing `lines` lines with mixed arguments, then a flush
+double WriteLines(int lines) {
+    const LogUser user(UserIdInterner::instance().Intern("user_12345"));
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&user, lines]() {
+            for (int i = 0; i < lines / 4; ++i) {
+                LOG_INFO_FMT("Remote stream added: {} of {}, audio={}, video={}", i, user, true, 0.5 * i);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    Logger::instance().flush();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// All segments under `directory`
+double DirectoryMegabytes(const std::string& directory) {
+    uintmax_t bytes = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        bytes += entry.file_size();
+    }
+    return bytes / 1e6;
+}
+
+} // namespace
+
+// Formatted text lines to a plain file flushed per line (the log before
+// binary records and rotation) against binary records to the default mapped
+// segments. The text log is opened by the first line, so this must be the
+// first thing in the process that logs.
+BENCHMARK(BinaryLog) {
+    const int kLines = 200000;
+    std::string textDirectory = std::string(kBenchDirectory) + "/text";
+    std::string binaryDirectory = std::string(kBenchDirectory) + "/binary";
+
+    Logger& logger = Logger::instance();
+    logger.setLogRotation(0, 1);
+    logger.setLogFile(textDirectory + "/bench.log");
+    double textMs = WriteLines(kLines);
+    logger.setLogRotation(16 * 1024 * 1024, 256 * 1024 * 1024);
+    logger.setBinaryLogFile(binaryDirectory + "/bench.tclog");
+    double binaryMs = WriteLines(kLines);
+    logger.setBinaryLogFile("");
+
+    printf("%d lines, 4 threads: text file %.1fms %.1fMB, binary segments %.1fms %.1fMB\n", kLines,
+        textMs, DirectoryMegabytes(textDirectory), binaryMs, DirectoryMegabytes(binaryDirectory));
+    std::error_code error;
+    std::filesystem::remove_all(kBenchDirectory, error);
+}
+
+// Binary records with the log pane's store attached, as the app runs: the
+// cost on the logging threads, and how long the store takes to catch up
+BENCHMARK(BinaryLogToStore) {
+    const int kLines = 200000;
+    std::string binaryDirectory = std::string(kBenchDirectory) + "/store";
+    Logger& logger = Logger::instance();
+    LogStore store;
+    logger.setLogRotation(16 * 1024 * 1024, 256 * 1024 * 1024);
+    logger.setBinaryLogFile(binaryDirectory + "/bench.tclog");
+    logger.setLogStore(&store);
+    double binaryMs = WriteLines(kLines);
+    auto detachStart = std::chrono::steady_clock::now();
+    logger.setLogStore(nullptr);
+    double drainMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - detachStart).count();
+    logger.setBinaryLogFile("");
+
+    printf("%d lines, 4 threads: binary segments with the store %.1fms, store caught up %.1fms later, %llu lines\n",
+        kLines, binaryMs, drainMs, static_cast<unsigned long long>(store.GetNextSeq()));
+    std::error_code error;
+    std::filesystem::remove_all(kBenchDirectory, error);
+}